@@ -106,6 +106,8 @@ CaptureSettings::operator QVariant() const
   opts[lit("refAllResources")] = options.refAllResources;
   opts[lit("captureAllCmdLists")] = options.captureAllCmdLists;
   opts[lit("debugOutputMute")] = options.debugOutputMute;
+  opts[lit("hashMappedMemory")] = options.hashMappedMemory;
+  opts[lit("captureMemoryBudgetMB")] = options.captureMemoryBudgetMB;
   ret[lit("options")] = opts;
 
   ret[lit("queuedFrameCap")] = queuedFrameCap;
@@ -149,6 +151,8 @@ CaptureSettings::CaptureSettings(const QVariant &v)
   options.refAllResources = opts[lit("refAllResources")].toBool();
   options.captureAllCmdLists = opts[lit("captureAllCmdLists")].toBool();
   options.debugOutputMute = opts[lit("debugOutputMute")].toBool();
+  options.hashMappedMemory = opts[lit("hashMappedMemory")].toBool();
+  options.captureMemoryBudgetMB = opts[lit("captureMemoryBudgetMB")].toUInt();
 
   if(data.contains(lit("queuedFrameCap")))
     queuedFrameCap = data[lit("queuedFrameCap")].toUInt();
@@ -156,6 +156,7 @@ DEFINE_SAFE_EQUALITY(APIEvent)
 DEFINE_SAFE_EQUALITY(Bindpoint)
 DEFINE_SAFE_EQUALITY(BufferDescription)
 DEFINE_SAFE_EQUALITY(CaptureFileFormat)
+DEFINE_SAFE_EQUALITY(ChunkOverheadStats)
 DEFINE_SAFE_EQUALITY(ConstantBlock)
 DEFINE_SAFE_EQUALITY(DebugMessage)
 DEFINE_SAFE_EQUALITY(EnvironmentModification)
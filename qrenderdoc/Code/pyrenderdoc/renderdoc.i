@@ -259,10 +259,13 @@ TEMPLATE_ARRAY_INSTANTIATE(rdcarray, APIEvent)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, Bindpoint)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, BufferDescription)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, CaptureFileFormat)
+TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ChunkOverheadStats)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ConstantBlock)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, DebugMessage)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, EnvironmentModification)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, EventUsage)
+TEMPLATE_ARRAY_INSTANTIATE(rdcarray, MeshFormat)
+TEMPLATE_ARRAY_INSTANTIATE(rdcarray, bytebuf)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, PathEntry)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, PixelModification)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ResourceDescription)
@@ -213,6 +213,33 @@ typedef enum RENDERDOC_CaptureOption {
   // necessary as directed by a RenderDoc developer.
   eRENDERDOC_Option_AllowUnsupportedVendorExtensions = 12,
 
+  // Detect changes to persistently mapped memory by keeping a hash of each page,
+  // instead of a full copy of the mapped memory. This greatly reduces memory
+  // overhead for applications with very large mappings, at the cost of some CPU
+  // time.
+  //
+  // NOTE: This is only used by Vulkan for coherent memory mapped across a submit.
+  //
+  // Default - disabled
+  //
+  // 1 - Each page of mapped memory is hashed, and only changed pages are saved
+  // 0 - A copy of mapped memory is kept and compared against to find changes
+  //
+  // Available from API version 1.5.0 onwards.
+  eRENDERDOC_Option_HashMappedMemory = 13,
+
+  // Limit in MB on the memory held by chunks recorded during a frame capture.
+  // Once the limit is exceeded, further chunks are moved out to a temporary
+  // file on disk and only read back when the capture is written.
+  //
+  // Default - 0
+  //
+  // 0 - All capture chunks are kept in memory
+  // N - Chunks beyond N MB in total are spilled to disk
+  //
+  // Available from API version 1.5.0 onwards.
+  eRENDERDOC_Option_CaptureMemoryBudgetMB = 14,
+
 } RENDERDOC_CaptureOption;
 
 // Sets an option that controls how RenderDoc behaves on capture.
@@ -543,6 +570,7 @@ typedef enum RENDERDOC_Version {
   eRENDERDOC_API_Version_1_2_0 = 10200,    // RENDERDOC_API_1_2_0 = 1 02 00
   eRENDERDOC_API_Version_1_3_0 = 10300,    // RENDERDOC_API_1_3_0 = 1 03 00
   eRENDERDOC_API_Version_1_4_0 = 10400,    // RENDERDOC_API_1_4_0 = 1 04 00
+  eRENDERDOC_API_Version_1_5_0 = 10500,    // RENDERDOC_API_1_5_0 = 1 05 00
 } RENDERDOC_Version;
 
 // API version changelog:
@@ -568,8 +596,12 @@ typedef enum RENDERDOC_Version {
 //         0xdddddddd of uninitialised buffer contents.
 // 1.4.0 - Added feature: DiscardFrameCapture() to discard a frame capture in progress and stop
 //         capturing without saving anything to disk.
+// 1.5.0 - Added feature: New capture option eRENDERDOC_Option_HashMappedMemory which tracks changes
+//         to persistently mapped memory with a hash per page instead of a full shadow copy.
+//         New capture option eRENDERDOC_Option_CaptureMemoryBudgetMB which spills capture
+//         chunks to disk beyond a memory limit.
 
-typedef struct RENDERDOC_API_1_4_0
+typedef struct RENDERDOC_API_1_5_0
 {
   pRENDERDOC_GetAPIVersion GetAPIVersion;
 
@@ -635,16 +667,17 @@ typedef struct RENDERDOC_API_1_4_0
 
   // new function in 1.4.0
   pRENDERDOC_DiscardFrameCapture DiscardFrameCapture;
-} RENDERDOC_API_1_4_0;
-
-typedef RENDERDOC_API_1_4_0 RENDERDOC_API_1_0_0;
-typedef RENDERDOC_API_1_4_0 RENDERDOC_API_1_0_1;
-typedef RENDERDOC_API_1_4_0 RENDERDOC_API_1_0_2;
-typedef RENDERDOC_API_1_4_0 RENDERDOC_API_1_1_0;
-typedef RENDERDOC_API_1_4_0 RENDERDOC_API_1_1_1;
-typedef RENDERDOC_API_1_4_0 RENDERDOC_API_1_1_2;
-typedef RENDERDOC_API_1_4_0 RENDERDOC_API_1_2_0;
-typedef RENDERDOC_API_1_4_0 RENDERDOC_API_1_3_0;
+} RENDERDOC_API_1_5_0;
+
+typedef RENDERDOC_API_1_5_0 RENDERDOC_API_1_0_0;
+typedef RENDERDOC_API_1_5_0 RENDERDOC_API_1_0_1;
+typedef RENDERDOC_API_1_5_0 RENDERDOC_API_1_0_2;
+typedef RENDERDOC_API_1_5_0 RENDERDOC_API_1_1_0;
+typedef RENDERDOC_API_1_5_0 RENDERDOC_API_1_1_1;
+typedef RENDERDOC_API_1_5_0 RENDERDOC_API_1_1_2;
+typedef RENDERDOC_API_1_5_0 RENDERDOC_API_1_2_0;
+typedef RENDERDOC_API_1_5_0 RENDERDOC_API_1_3_0;
+typedef RENDERDOC_API_1_5_0 RENDERDOC_API_1_4_0;
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 // RenderDoc API entry point
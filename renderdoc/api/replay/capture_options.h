@@ -199,6 +199,34 @@ Default - enabled
 ``False`` - API debugging is displayed as normal.
 )");
   bool debugOutputMute;
+
+  DOCUMENT(R"(Detect changes to persistently mapped memory by keeping a hash of each page,
+instead of a full copy of the mapped memory. This greatly reduces memory overhead while
+capturing applications with very large mappings, at the cost of some extra CPU time and
+less precise change detection.
+
+.. note:: This is only used by Vulkan for coherent memory that's mapped across a submit.
+
+Default - disabled
+
+``True`` - Each page of mapped memory is hashed, and only pages with changed hashes are
+serialised.
+
+``False`` - A copy of mapped memory is kept and compared against to find changes.
+)");
+  bool hashMappedMemory;
+
+  DOCUMENT(R"(Limit in MB on the memory held by chunks recorded while capturing a frame. Beyond
+this, chunks are moved out to a temporary file on disk and only read back when the capture is
+written.
+
+Default - 0
+
+``0`` - All capture chunks are kept in memory.
+
+``N`` - Chunks beyond N MB in total are spilled to disk.
+)");
+  uint32_t captureMemoryBudgetMB;
 };
 
 DECLARE_REFLECTION_STRUCT(CaptureOptions);
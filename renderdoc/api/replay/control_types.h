@@ -523,6 +523,72 @@ struct NewChildData
 
 DECLARE_REFLECTION_STRUCT(NewChildData);
 
+DOCUMENT("The aggregated cost of recording a single type of chunk in the target.");
+struct ChunkOverheadStats
+{
+  DOCUMENT("");
+  ChunkOverheadStats() = default;
+  ChunkOverheadStats(const ChunkOverheadStats &) = default;
+
+  bool operator==(const ChunkOverheadStats &o) const
+  {
+    return chunkID == o.chunkID && name == o.name && count == o.count &&
+           byteSize == o.byteSize && serialiseMicroseconds == o.serialiseMicroseconds;
+  }
+  bool operator<(const ChunkOverheadStats &o) const
+  {
+    if(!(chunkID == o.chunkID))
+      return chunkID < o.chunkID;
+    if(!(name == o.name))
+      return name < o.name;
+    if(!(count == o.count))
+      return count < o.count;
+    if(!(byteSize == o.byteSize))
+      return byteSize < o.byteSize;
+    if(!(serialiseMicroseconds == o.serialiseMicroseconds))
+      return serialiseMicroseconds < o.serialiseMicroseconds;
+    return false;
+  }
+
+  DOCUMENT("The API-specific chunk ID.");
+  uint32_t chunkID = 0;
+  DOCUMENT("The name of the chunk, if the target was able to look it up.");
+  rdcstr name;
+  DOCUMENT("The number of chunks of this type that were recorded.");
+  uint64_t count = 0;
+  DOCUMENT("The total number of bytes serialised for chunks of this type.");
+  uint64_t byteSize = 0;
+  DOCUMENT("The total time spent serialising chunks of this type, in microseconds.");
+  double serialiseMicroseconds = 0.0;
+};
+
+DECLARE_REFLECTION_STRUCT(ChunkOverheadStats);
+
+DOCUMENT(R"(Statistics about the overhead of background capturing in the target.
+
+Counts and times are accumulated since the previous overhead message was sent on this connection,
+so dividing by :data:`frameCount` gives the average per-frame cost.
+)");
+struct CaptureOverheadData
+{
+  DOCUMENT("");
+  CaptureOverheadData() = default;
+  CaptureOverheadData(const CaptureOverheadData &) = default;
+
+  DOCUMENT("The number of frames presented during this period.");
+  uint32_t frameCount = 0;
+  DOCUMENT("The number of bytes currently held in recorded chunks.");
+  uint64_t chunkMemory = 0;
+  DOCUMENT("The number of recorded chunks currently alive.");
+  uint64_t liveChunks = 0;
+  DOCUMENT("The total time threads spent waiting on contended locks, in microseconds.");
+  double lockWaitMicroseconds = 0.0;
+  DOCUMENT("The per-chunk statistics, only for chunk types that were recorded in this period.");
+  rdcarray<ChunkOverheadStats> chunks;
+};
+
+DECLARE_REFLECTION_STRUCT(CaptureOverheadData);
+
 DOCUMENT("A message from a target control connection.");
 struct TargetControlMessage
 {
@@ -550,6 +616,9 @@ or has finished, it will be -1.0
 
   DOCUMENT("The number of the capturable windows");
   uint32_t capturableWindowCount = 0;
+
+  DOCUMENT("The :class:`capture overhead statistics <CaptureOverheadData>`.");
+  CaptureOverheadData overhead;
 };
 
 DECLARE_REFLECTION_STRUCT(TargetControlMessage);
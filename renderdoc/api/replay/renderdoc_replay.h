@@ -1217,6 +1217,27 @@ texture to something compatible with the target file format.
 )");
   virtual MeshFormat GetPostVSData(uint32_t instance, uint32_t view, MeshDataStage stage) = 0;
 
+  DOCUMENT(R"(Retrieve the generated data from one of the geometry processing shader stages, for
+many drawcalls at once.
+
+This is much faster than selecting each event in turn and calling :meth:`GetPostVSData`, as the
+data for all drawcalls in the same pass is fetched in a single replay. The current event is not
+changed.
+
+:param list eventIds: The event IDs of the drawcalls to retrieve data for. Any that aren't
+  drawcalls will have an empty :class:`MeshFormat` returned.
+:param int instance: The index of the instance to retrieve data for, or 0 for non-instanced draws.
+  This will be clamped to the number of instances in each drawcall.
+:param int view: The index of the multiview view to retrieve data for, or 0 if multiview is disabled.
+:param MeshDataStage stage: The stage of the geometry processing pipeline to retrieve data from.
+:return: The information describing where the post-transform data is stored, one for each event in
+  ``eventIds``.
+:rtype: ``list`` of :class:`MeshFormat`
+)");
+  virtual rdcarray<MeshFormat> GetPostVSDataForEvents(const rdcarray<uint32_t> &eventIds,
+                                                      uint32_t instance, uint32_t view,
+                                                      MeshDataStage stage) = 0;
+
   DOCUMENT(R"(Retrieve the contents of a range of a buffer as a ``bytes``.
 
 :param ResourceId buff: The id of the buffer to retrieve data from.
@@ -1241,6 +1262,21 @@ sample 0, etc.
 )");
   virtual bytebuf GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip) = 0;
 
+  DOCUMENT(R"(Retrieve the contents of the same subresource from several textures at once.
+
+This returns the same data as calling :meth:`GetTextureData` for each texture in turn, but allows
+the readbacks to be overlapped with each other where the API supports it.
+
+:param List[ResourceId] textures: The ids of the textures to retrieve data from.
+:param int arrayIdx: The slice of an array or 3D texture, or face of a cubemap texture.
+:param int mip: The mip level to pick from.
+:return: The contents of each texture, in the same order as ``textures``. Any texture that could
+  not be read back has empty contents.
+:rtype: ``list`` of ``bytes``
+)");
+  virtual rdcarray<bytebuf> GetTextureDataBatch(const rdcarray<ResourceId> &textures,
+                                                uint32_t arrayIdx, uint32_t mip) = 0;
+
   static const uint32_t NoPreference = ~0U;
 
 protected:
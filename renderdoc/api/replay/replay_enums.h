@@ -3257,6 +3257,14 @@ DOCUMENT(R"(The type of message received from or sent to an application target c
 .. data:: CaptureProgress
 
   Progress update on an on-going frame capture.
+
+.. data:: CapturableWindowCount
+
+  The number of capturable windows has changed.
+
+.. data:: CaptureOverhead
+
+  Periodic statistics about the overhead of background capturing in the target.
 )");
 enum class TargetControlMessageType : uint32_t
 {
@@ -3269,7 +3277,8 @@ enum class TargetControlMessageType : uint32_t
   RegisterAPI,
   NewChild,
   CaptureProgress,
-  CapturableWindowCount
+  CapturableWindowCount,
+  CaptureOverhead,
 };
 
 DECLARE_REFLECTION_ENUM(TargetControlMessageType);
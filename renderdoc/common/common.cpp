@@ -26,10 +26,13 @@
 #include "common.h"
 #include <stdarg.h>
 #include <string.h>
+#include <functional>
 #include <string>
+#include <unordered_map>
 #include "common/threading.h"
 #include "os/os_specific.h"
 #include "strings/string_utils.h"
+#include "zstd/xxhash.h"
 
 using std::string;
 
@@ -224,6 +227,233 @@ bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &
   return diffStart < bufSize;
 }
 
+// the granularity that FindDiffRanges checks at
+static const size_t diffPageSize = 4096;
+// dirty pages with fewer than this many clean bytes between them are coalesced into one range, as
+// serialising a few unchanged pages is cheaper than the overhead of another range
+static const size_t diffCoalesceGap = 4 * diffPageSize;
+// buffers larger than this are split across several threads
+static const size_t diffParallelThreshold = 64 * 1024 * 1024;
+static const size_t diffParallelThreads = 4;
+
+// hash values of 0 are reserved to mean the page's contents aren't known
+static const uint64_t unknownPageHash = 0;
+
+typedef std::function<bool(size_t offs, size_t len)> PageChangedCallback;
+
+static void FindChangedPages(size_t begin, size_t end, const PageChangedCallback &pageChanged,
+                             rdcarray<rdcpair<size_t, size_t>> &ranges)
+{
+  for(size_t offs = begin; offs < end; offs += diffPageSize)
+  {
+    size_t len = RDCMIN(diffPageSize, end - offs);
+
+    if(!pageChanged(offs, len))
+      continue;
+
+    if(!ranges.empty() && offs - ranges.back().second < diffCoalesceGap)
+      ranges.back().second = offs + len;
+    else
+      ranges.push_back(make_rdcpair(offs, offs + len));
+  }
+}
+
+// calls pageChanged for every page in the buffer, splitting large buffers over several threads, and
+// returns the coalesced ranges of pages that changed.
+static void FindChangedPages(size_t bufSize, const PageChangedCallback &pageChanged,
+                             rdcarray<rdcpair<size_t, size_t>> &ranges)
+{
+  ranges.clear();
+
+  if(bufSize < diffParallelThreshold)
+  {
+    FindChangedPages(0, bufSize, pageChanged, ranges);
+    return;
+  }
+
+  // split into page-aligned slices, with the last thread's slice done on this thread
+  size_t sliceSize = AlignUp(bufSize / diffParallelThreads, diffPageSize);
+
+  rdcarray<rdcpair<size_t, size_t>> sliceRanges[diffParallelThreads];
+  Threading::ThreadHandle threads[diffParallelThreads - 1] = {};
+
+  for(size_t i = 0; i < diffParallelThreads - 1; i++)
+  {
+    size_t begin = i * sliceSize;
+    size_t end = RDCMIN(begin + sliceSize, bufSize);
+    rdcarray<rdcpair<size_t, size_t>> *dst = &sliceRanges[i];
+
+    threads[i] = Threading::CreateThread(
+        [begin, end, &pageChanged, dst]() { FindChangedPages(begin, end, pageChanged, *dst); });
+  }
+
+  FindChangedPages((diffParallelThreads - 1) * sliceSize, bufSize, pageChanged,
+                   sliceRanges[diffParallelThreads - 1]);
+
+  for(size_t i = 0; i < diffParallelThreads - 1; i++)
+  {
+    Threading::JoinThread(threads[i]);
+    Threading::CloseThread(threads[i]);
+  }
+
+  // merge the slices, coalescing across slice boundaries the same as within a slice
+  for(size_t i = 0; i < diffParallelThreads; i++)
+  {
+    for(const rdcpair<size_t, size_t> &r : sliceRanges[i])
+    {
+      if(!ranges.empty() && r.first - ranges.back().second < diffCoalesceGap)
+        ranges.back().second = r.second;
+      else
+        ranges.push_back(r);
+    }
+  }
+}
+
+bool FindDiffRanges(const void *a, const void *b, size_t bufSize,
+                    rdcarray<rdcpair<size_t, size_t>> &ranges)
+{
+  const byte *abyte = (const byte *)a;
+  const byte *bbyte = (const byte *)b;
+
+  // memcmp is vectorised in every CRT we use, with the widest instructions available on the
+  // running CPU selected at runtime, so there's no benefit to doing our own SIMD here.
+  FindChangedPages(bufSize,
+                   [abyte, bbyte](size_t offs, size_t len) {
+                     return memcmp(abyte + offs, bbyte + offs, len) != 0;
+                   },
+                   ranges);
+
+  // make each range byte-accurate, to comply with WRITE_NO_OVERWRITE. The start and end are in
+  // pages we know differ, but a could be written to concurrently so don't rely on that.
+  for(size_t i = 0; i < ranges.size();)
+  {
+    size_t &start = ranges[i].first;
+    size_t &end = ranges[i].second;
+
+    while(start < end && abyte[start] == bbyte[start])
+      start++;
+
+    while(end > start && abyte[end - 1] == bbyte[end - 1])
+      end--;
+
+    if(start == end)
+      ranges.erase(i);
+    else
+      i++;
+  }
+
+  return !ranges.empty();
+}
+
+static uint64_t HashPage(const byte *data, size_t len)
+{
+  uint64_t ret = XXH64(data, len, 0);
+  return ret == unknownPageHash ? ret + 1 : ret;
+}
+
+size_t NumHashedPages(size_t bufSize)
+{
+  return AlignUp(bufSize, diffPageSize) / diffPageSize;
+}
+
+void HashPages(const void *data, size_t offset, size_t size, size_t bufSize, uint64_t *hashes)
+{
+  const byte *src = (const byte *)data;
+
+  size_t end = offset + size;
+
+  for(size_t page = offset / diffPageSize; page < NumHashedPages(bufSize); page++)
+  {
+    size_t pageStart = page * diffPageSize;
+    size_t pageEnd = RDCMIN(pageStart + diffPageSize, bufSize);
+
+    if(pageStart >= end)
+      break;
+
+    // we can only hash pages entirely within the data we have. Others are reset so that they're
+    // always considered changed next time.
+    if(pageStart >= offset && pageEnd <= end)
+      hashes[page] = HashPage(src + (pageStart - offset), pageEnd - pageStart);
+    else
+      hashes[page] = unknownPageHash;
+  }
+}
+
+bool FindChangedPages(const void *buf, size_t bufSize, const uint64_t *hashes,
+                      rdcarray<rdcpair<size_t, size_t>> &ranges)
+{
+  const byte *bufbyte = (const byte *)buf;
+
+  FindChangedPages(bufSize,
+                   [bufbyte, hashes](size_t offs, size_t len) {
+                     uint64_t hash = hashes[offs / diffPageSize];
+                     return hash == unknownPageHash || HashPage(bufbyte + offs, len) != hash;
+                   },
+                   ranges);
+
+  return !ranges.empty();
+}
+
+size_t CompactPages(byte *buf, size_t bufSize, size_t pageSize, rdcarray<uint32_t> &pageRefs)
+{
+  const size_t numPages = AlignUp(bufSize, pageSize) / pageSize;
+
+  pageRefs.resize(numPages);
+
+  // the first unique page seen with each hash. If two different pages collide the later one is just
+  // stored again, which is rare enough not to be worth chaining for.
+  std::unordered_map<uint64_t, uint32_t> uniquePages;
+
+  uint32_t numUnique = 0;
+
+  for(size_t page = 0; page < numPages; page++)
+  {
+    const size_t pageStart = page * pageSize;
+    const size_t len = RDCMIN(pageStart + pageSize, bufSize) - pageStart;
+    byte *src = buf + pageStart;
+
+    // the page is all zero if the first byte is, and every byte matches the one after it
+    if(src[0] == 0 && memcmp(src, src + 1, len - 1) == 0)
+    {
+      pageRefs[page] = CompactedZeroPage;
+      continue;
+    }
+
+    const uint64_t hash = XXH64(src, len, 0);
+
+    auto it = uniquePages.find(hash);
+
+    // unique pages are packed in order, so only the last one can be a partial page
+    if(it != uniquePages.end() && len == pageSize &&
+       memcmp(buf + it->second * pageSize, src, len) == 0)
+    {
+      pageRefs[page] = it->second;
+      continue;
+    }
+
+    // move the page down into place. It never moves forward, so pages still to be processed aren't
+    // overwritten.
+    byte *dst = buf + numUnique * pageSize;
+    if(dst != src)
+      memmove(dst, src, len);
+
+    if(it == uniquePages.end())
+      uniquePages[hash] = numUnique;
+
+    pageRefs[page] = numUnique++;
+  }
+
+  if(numUnique == 0)
+    return 0;
+
+  // the last unique page may be the partial page at the end of the buffer
+  const size_t lastPage = numPages - 1;
+  if(pageRefs[lastPage] == numUnique - 1)
+    return (numUnique - 1) * pageSize + (bufSize - lastPage * pageSize);
+
+  return numUnique * pageSize;
+}
+
 uint32_t CalcNumMips(int w, int h, int d)
 {
   int mipLevels = 1;
@@ -297,6 +527,14 @@ uint64_t Log2Floor(uint64_t value)
 static string logfile;
 static bool logfileOpened = false;
 
+// serialises everything that consumes queued log records or changes the log file. This is a
+// function-local static so it's valid even if we log during static initialisation.
+static Threading::CriticalSection &rdclog_consumelock()
+{
+  static Threading::CriticalSection lock;
+  return lock;
+}
+
 const char *rdclog_getfilename()
 {
   return logfile.c_str();
@@ -304,6 +542,8 @@ const char *rdclog_getfilename()
 
 void rdclog_filename(const char *filename)
 {
+  SCOPED_LOCK(rdclog_consumelock());
+
   string previous = logfile;
 
   logfile = "";
@@ -338,16 +578,6 @@ void rdclog_enableoutput()
   log_output_enabled = true;
 }
 
-void rdclog_closelog(const char *filename)
-{
-  log_output_enabled = false;
-  FileIO::logfile_close(filename);
-}
-
-void rdclog_flush()
-{
-}
-
 void rdclogprint_int(LogType type, const char *fullMsg, const char *msg)
 {
   static Threading::CriticalSection lock;
@@ -376,28 +606,12 @@ void rdclogprint_int(LogType type, const char *fullMsg, const char *msg)
 #endif
 }
 
-const int rdclog_outBufSize = 4 * 1024;
-static char rdclog_outputBuffer[rdclog_outBufSize + 3];
-
-static void write_newline(char *output)
-{
-#if ENABLED(RDOC_WIN32)
-  *(output++) = '\r';
-#endif
-  *(output++) = '\n';
-  *output = 0;
-}
-
-void rdclog_direct(time_t utcTime, uint32_t pid, LogType type, const char *project,
-                   const char *file, unsigned int line, const char *fmt, ...)
+// formats the prefix for an already-formatted message and prints it line by line, so that newlines
+// are in native format and every line is prefixed. With asynchronous logging this happens on the
+// flushing thread, so only the message itself is formatted by the thread that logged it.
+static void rdclog_printrecord(time_t utcTime, uint32_t pid, LogType type, const char *project,
+                               const char *file, unsigned int line, const char *message)
 {
-  va_list args;
-  va_start(args, fmt);
-
-  // this copy is just for in case we need to print again if the buffer is oversized
-  va_list args2;
-  va_copy(args2, args);
-
   char timestamp[64] = {0};
 #if ENABLED(INCLUDE_TIMESTAMP_IN_LOG)
   StringFormat::sntimef(utcTime, timestamp, 63, "[%H:%M:%S] ");
@@ -414,128 +628,404 @@ void rdclog_direct(time_t utcTime, uint32_t pid, LogType type, const char *proje
       "Debug  ", "Log    ", "Warning", "Error  ", "Fatal  ",
   };
 
-  static Threading::CriticalSection lock;
-
-  SCOPED_LOCK(lock);
+  char prefix[256] = {0};
+  StringFormat::snprintf(prefix, 255, "% 4s %06u: %s%s%s - ", project, pid, timestamp, location,
+                         typestr[(uint32_t)type]);
 
-  rdclog_outputBuffer[rdclog_outBufSize] = rdclog_outputBuffer[0] = 0;
+  // the message without a prefix starts from the type, so it's the last 10 characters
+  const size_t noPrefixLength = sizeof("Warning - ") - 1;
+  const size_t prefixLength = strlen(prefix);
 
-  char *output = rdclog_outputBuffer;
-  size_t available = rdclog_outBufSize;
+#if ENABLED(RDOC_WIN32)
+  const char newline[] = "\r\n";
+#else
+  const char newline[] = "\n";
+#endif
 
-  char *base = output;
+  string output;
 
-  int numWritten = StringFormat::snprintf(output, available, "% 4s %06u: %s%s%s - ", project, pid,
-                                          timestamp, location, typestr[(uint32_t)type]);
+  bool first = true;
+  const char *base = message;
 
-  if(numWritten < 0)
+  for(;;)
   {
-    va_end(args);
-    va_end(args2);
-    return;
+    const char *nl = strchr(base, '\n');
+
+    output.assign(prefix, prefixLength);
+    output.append(base, nl ? size_t(nl - base) : strlen(base));
+    output.append(newline);
+
+    // only the first line includes the type when printing without the prefix
+    if(first)
+      rdclogprint_int(type, output.c_str(), output.c_str() + prefixLength - noPrefixLength);
+    else
+      rdclogprint_int(type, output.c_str(), output.c_str() + prefixLength);
+
+    if(nl == NULL)
+      break;
+
+    base = nl + 1;
+    first = false;
   }
+}
 
-  output += numWritten;
-  available -= numWritten;
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// Asynchronous logging
+//
+// In capturing applications the log is written by a background thread, so that logging from the
+// application's threads (e.g. in a submit or present) never waits on disk I/O. Log records are
+// pushed into a bounded lock-free multi-producer ring (based on Dmitry Vyukov's bounded MPMC
+// queue), where each slot's sequence number says whether it's free for the producer with that
+// position or holds a record ready for the consumer.
+//
+// Only one thread consumes at once, under rdclog_consumelock(). Normally that's the flushing thread but
+// rdclog_flush() will drain the ring synchronously on the calling thread. Errors and fatal errors
+// are never queued, they drain the ring and print directly so that they're always on disk before we
+// crash or break, and the crash handler drains whatever is queued with rdclog_crashflush().
+//
+// If the ring is full or a message doesn't fit in a record, the producer drains the ring itself
+// and prints directly, so messages are never dropped and each thread's messages stay in order.
+//
+// Positions are unsigned and wrap around, they're only ever compared by their signed difference
+// and masked to index the ring, so a long-running process can't overflow them.
 
-  // -3 is for the " - " after the type.
-  const char *noPrefixOutput = (output - 3 - (sizeof(typestr[(uint32_t)type]) - 1));
-  const char *prefixEnd = output;
+struct LogRecord
+{
+  volatile uint32_t sequence;
+  bool skip;
+  LogType type;
+  uint32_t pid;
+  unsigned int line;
+  time_t utcTime;
+  const char *project;
+  const char *file;
+  char message[456];
+};
 
-  int totalWritten = numWritten;
+static const uint32_t logRingSize = 512;
+static LogRecord *logRing = NULL;
+static volatile uint32_t logEnqueuePos = 0;
+static uint32_t logDequeuePos = 0;
 
-  numWritten = StringFormat::vsnprintf(output, available, fmt, args);
+static Threading::ThreadHandle logFlushThread = 0;
+static volatile int32_t logFlushThreadShutdown = 0;
+static volatile bool logAsync = false;
+static volatile bool logRateLimited = false;
 
-  totalWritten += numWritten;
+static uint32_t rdclog_loadsequence(volatile uint32_t *seq)
+{
+  // compare-exchange with the same value as a full barrier load
+  return (uint32_t)Atomic::CmpExch32((volatile int32_t *)seq, 0, 0);
+}
 
-  va_end(args);
+static bool rdclog_cmpexchsequence(volatile uint32_t *seq, uint32_t oldVal, uint32_t newVal)
+{
+  return (uint32_t)Atomic::CmpExch32((volatile int32_t *)seq, (int32_t)oldVal, (int32_t)newVal) ==
+         oldVal;
+}
 
-  if(numWritten < 0)
-  {
-    va_end(args2);
+static void rdclog_storesequence(volatile uint32_t *seq, uint32_t oldVal, uint32_t newVal)
+{
+  // the sequence can only be modified by the owner of the slot, so this always succeeds. Using an
+  // atomic gives us the barrier to ensure the record contents are visible before the sequence.
+  rdclog_cmpexchsequence(seq, oldVal, newVal);
+}
+
+// must be called with rdclog_consumelock() held
+static void rdclog_drainrecords()
+{
+  if(logRing == NULL)
     return;
+
+  for(;;)
+  {
+    LogRecord &rec = logRing[logDequeuePos & (logRingSize - 1)];
+
+    if(rdclog_loadsequence(&rec.sequence) != logDequeuePos + 1)
+      break;
+
+    if(!rec.skip)
+      rdclog_printrecord(rec.utcTime, rec.pid, rec.type, rec.project, rec.file, rec.line,
+                         rec.message);
+
+    rdclog_storesequence(&rec.sequence, logDequeuePos + 1, logDequeuePos + logRingSize);
+    logDequeuePos++;
   }
+}
 
-  output += numWritten;
+// returns the record to fill, or NULL if the ring is full
+static LogRecord *rdclog_reserverecord(uint32_t &pos)
+{
+  pos = rdclog_loadsequence(&logEnqueuePos);
 
-  // we overran the static buffer. This is a 4k buffer so we won't be hitting this case often - just
-  // do the simple thing of allocating a temporary, print again, and re-assigning.
-  char *oversizedBuffer = NULL;
-  if(totalWritten > rdclog_outBufSize)
+  for(;;)
   {
-    available = totalWritten + 3;
-    oversizedBuffer = output = new char[available + 3];
-    base = output;
+    LogRecord &rec = logRing[pos & (logRingSize - 1)];
+    int32_t diff = int32_t(rdclog_loadsequence(&rec.sequence) - pos);
 
-    numWritten = StringFormat::snprintf(output, available, "% 4s %06u: %s%s%s - ", project,
-                                        Process::GetCurrentPID(), timestamp, location,
-                                        typestr[(uint32_t)type]);
+    if(diff == 0)
+    {
+      // the slot is free for this position, try to claim it
+      if(rdclog_cmpexchsequence(&logEnqueuePos, pos, pos + 1))
+        return &rec;
+    }
+    else if(diff < 0)
+    {
+      // the consumer hasn't freed this slot yet
+      return NULL;
+    }
 
-    output += numWritten;
-    available -= numWritten;
+    // another producer claimed this position, try again from the latest one
+    pos = rdclog_loadsequence(&logEnqueuePos);
+  }
+}
+
+static void rdclog_flushthread()
+{
+  Threading::KeepModuleAlive();
 
-    prefixEnd = output;
+  while(Atomic::CmpExch32(&logFlushThreadShutdown, 0, 0) == 0)
+  {
+    {
+      SCOPED_LOCK(rdclog_consumelock());
+      rdclog_drainrecords();
+    }
 
-    noPrefixOutput = (output - 3 - (sizeof(typestr[(uint32_t)type]) - 1));
+    Threading::Sleep(10);
+  }
 
-    numWritten = StringFormat::vsnprintf(output, available, fmt, args2);
+  Threading::ReleaseModuleExitThread();
+}
 
-    output += numWritten;
+void rdclog_enableasync()
+{
+  SCOPED_LOCK(rdclog_consumelock());
 
-    va_end(args2);
+  if(logAsync)
+    return;
+
+  if(logRing == NULL)
+  {
+    logRing = new LogRecord[logRingSize];
+    for(uint32_t i = 0; i < logRingSize; i++)
+      logRing[i].sequence = i;
+    logEnqueuePos = logDequeuePos = 0;
   }
 
-  // likely path - string contains no newlines
-  char *nl = strchr(base, '\n');
-  if(nl == NULL)
+  logFlushThreadShutdown = 0;
+  logFlushThread = Threading::CreateThread(&rdclog_flushthread);
+  logAsync = true;
+  logRateLimited = true;
+}
+
+void rdclog_flush()
+{
+  SCOPED_LOCK(rdclog_consumelock());
+  rdclog_drainrecords();
+}
+
+void rdclog_crashflush()
+{
+  // the crashing thread could be the one holding the lock, or another thread could be killed while
+  // holding it, so don't wait forever. If we can't get it we lose whatever is still queued.
+  for(int i = 0; i < 100; i++)
   {
-    // append newline
-    write_newline(output);
+    if(rdclog_consumelock().Trylock())
+    {
+      rdclog_drainrecords();
+      rdclog_consumelock().Unlock();
+      return;
+    }
 
-    rdclogprint_int(type, base, noPrefixOutput);
+    Threading::Sleep(1);
   }
-  else
+}
+
+void rdclog_closelog(const char *filename)
+{
   {
-    char backup[2];
+    SCOPED_LOCK(rdclog_consumelock());
 
-    std::string prefixText(base, size_t(prefixEnd - base));
+    // stop queueing, then flush everything already queued. We don't join the flushing thread as we
+    // could be in the middle of module unloading - it will see the shutdown flag and exit without
+    // consuming, since it can't get the lock until we've finished draining.
+    logAsync = false;
+    Atomic::CmpExch32(&logFlushThreadShutdown, 0, 1);
 
-    bool first = true;
+    rdclog_drainrecords();
 
-    // otherwise, print the string in sections to ensure newlines are in native format
-    while(nl)
+    if(logFlushThread)
     {
-      // backup the two characters after the \n, to allow for DOS newlines ('\r' '\n' '\0')
-      backup[0] = nl[1];
-      backup[1] = nl[2];
+      Threading::CloseThread(logFlushThread);
+      logFlushThread = 0;
+    }
+
+    log_output_enabled = false;
+    FileIO::logfile_close(filename);
+  }
+}
 
-      write_newline(nl);
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// Per-callsite rate limiting
+//
+// Callsites are identified by their file pointer (always a string literal) and line, hashed into a
+// small table of token buckets. Each callsite may log a burst of messages before being limited to a
+// steady rate, so one-off loops like printing extension lists are unaffected but per-frame or
+// per-submit logging can't flood the log. Errors are never limited, and only capturing applications
+// are limited at all - the replay host and UI log everything.
+//
+// The buckets are updated without synchronisation - a race only makes the limit slightly
+// inaccurate. Each bucket remembers the callsite that owns it, and a callsite that hashes to a
+// bucket owned by another takes it over with a fresh budget. Two colliding callsites that log in
+// turn will keep resetting each other, so they can exceed the limit but are never wrongly
+// suppressed.
 
-      if(first)
-        rdclogprint_int(type, base, noPrefixOutput);
-      else
-        rdclogprint_int(type, (prefixText + base).c_str(), noPrefixOutput);
+struct LogCallsite
+{
+  const char *file;
+  unsigned int line;
+  int32_t tokens;
+  uint32_t suppressed;
+  uint64_t lastRefill;
+};
+
+static const int32_t logCallsiteBurst = 500;
+static const int32_t logCallsiteRatePerSecond = 20;
+static LogCallsite logCallsites[256] = {};
+
+// returns false if the message should be suppressed. If messages were previously suppressed and
+// this one is allowed, numSuppressed is set to how many were dropped.
+static bool rdclog_ratelimit(LogType type, const char *file, unsigned int line,
+                             uint32_t &numSuppressed)
+{
+  numSuppressed = 0;
+
+  if(!logRateLimited || type == LogType::Error || type == LogType::Fatal)
+    return true;
+
+  uintptr_t hash = (uintptr_t(file) >> 3) ^ (uintptr_t(line) * 2654435761U);
+  LogCallsite &site = logCallsites[hash % ARRAY_COUNT(logCallsites)];
+
+  uint64_t now = Timing::GetTick();
+  static const uint64_t ticksPerToken =
+      uint64_t(Timing::GetTickFrequency() * 1000.0) / logCallsiteRatePerSecond;
 
-      // restore the characters
-      nl[1] = backup[0];
-      nl[2] = backup[1];
+  if(site.file != file || site.line != line)
+  {
+    site.file = file;
+    site.line = line;
+    site.tokens = logCallsiteBurst;
+    site.suppressed = 0;
+    site.lastRefill = now;
+  }
+  else if(now - site.lastRefill >= ticksPerToken)
+  {
+    uint64_t refill = (now - site.lastRefill) / ticksPerToken;
+    site.tokens = (int32_t)RDCMIN(uint64_t(logCallsiteBurst), uint64_t(site.tokens) + refill);
+    site.lastRefill += refill * ticksPerToken;
+  }
+
+  if(site.tokens <= 0)
+  {
+    site.suppressed++;
+    return false;
+  }
+
+  site.tokens--;
+  numSuppressed = site.suppressed;
+  site.suppressed = 0;
+  return true;
+}
 
-      base = nl + 1;
-      noPrefixOutput = nl + 1;
+void rdclog_direct(time_t utcTime, uint32_t pid, LogType type, const char *project,
+                   const char *file, unsigned int line, const char *fmt, ...)
+{
+  uint32_t numSuppressed = 0;
+  if(!rdclog_ratelimit(type, file, line, numSuppressed))
+    return;
 
-      first = false;
+  va_list args;
+  va_start(args, fmt);
 
-      nl = strchr(base, '\n');
+  // this copy is just for in case we need to print again if the record is too small
+  va_list args2;
+  va_copy(args2, args);
+
+  // errors are printed synchronously, so they're on disk before any break or crash that follows
+  bool error = (type == LogType::Error || type == LogType::Fatal);
+
+  uint32_t pos = 0;
+  LogRecord *rec = (logAsync && !error) ? rdclog_reserverecord(pos) : NULL;
+
+  if(rec)
+  {
+    rec->type = type;
+    rec->pid = pid;
+    rec->line = line;
+    rec->utcTime = utcTime;
+    rec->project = project;
+    rec->file = file;
+
+    int len = 0;
+    if(numSuppressed > 0)
+      len = StringFormat::snprintf(rec->message, sizeof(rec->message),
+                                   "(%u similar messages suppressed) ", numSuppressed);
+
+    int numWritten =
+        StringFormat::vsnprintf(rec->message + len, sizeof(rec->message) - len, fmt, args);
+
+    // if the message fit, publish it. Otherwise we publish a record to be skipped (we can't
+    // un-claim our slot) and print the message directly below.
+    bool fit = numWritten >= 0 && len + numWritten < (int)sizeof(rec->message);
+    rec->skip = !fit;
+
+    rdclog_storesequence(&rec->sequence, pos, pos + 1);
+
+    if(fit)
+    {
+      va_end(args);
+      va_end(args2);
+      return;
     }
+  }
 
-    // append final newline and write the last line
-    write_newline(output);
+  va_end(args);
 
-    if(first)
-      rdclogprint_int(type, base, noPrefixOutput);
-    else
-      rdclogprint_int(type, (prefixText + base).c_str(), noPrefixOutput);
+  // synchronous path - either we're not logging asynchronously, this is an error, the ring is full,
+  // or the message is too long for a record. Format the whole message and print it after anything that's queued.
+  string message;
+
+  if(numSuppressed > 0)
+    message = StringFormat::Fmt("(%u similar messages suppressed) ", numSuppressed);
+
+  char buf[1024];
+  int numWritten = StringFormat::vsnprintf(buf, sizeof(buf), fmt, args2);
+
+  if(numWritten < 0)
+  {
+    va_end(args2);
+    return;
   }
 
-  SAFE_DELETE_ARRAY(oversizedBuffer);
+  if(numWritten < (int)sizeof(buf))
+  {
+    message += buf;
+  }
+  else
+  {
+    // we overran the stack buffer. This is rare so just do the simple thing and allocate a
+    // temporary to print again.
+    char *oversizedBuffer = new char[numWritten + 1];
+    StringFormat::vsnprintf(oversizedBuffer, numWritten + 1, fmt, args2);
+    message += oversizedBuffer;
+    SAFE_DELETE_ARRAY(oversizedBuffer);
+  }
+
+  va_end(args2);
+
+  {
+    SCOPED_LOCK(rdclog_consumelock());
+    rdclog_drainrecords();
+    rdclog_printrecord(utcTime, pid, type, project, file, line, message.c_str());
+  }
 }
@@ -156,6 +156,29 @@ inline T AlignUpPtr(T x, A a)
   (((uint32_t)(d) << 24) | ((uint32_t)(c) << 16) | ((uint32_t)(b) << 8) | (uint32_t)(a))
 
 bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &diffEnd);
+// finds every [start, end) byte range that differs between a and b. Differences are found a page at a
+// time, nearby dirty pages are coalesced into one range, and then each range is trimmed to be
+// byte-accurate. Returns true if any differences were found.
+bool FindDiffRanges(const void *a, const void *b, size_t bufSize,
+                    rdcarray<rdcpair<size_t, size_t>> &ranges);
+// an alternative to FindDiffRanges that keeps a 64-bit hash per page instead of a full copy. The
+// changed ranges are only page-accurate.
+//
+// returns how many hashes are needed for a buffer of the given size
+size_t NumHashedPages(size_t bufSize);
+// updates the hashes for [offset, offset+size) of a buffer, from data containing just that range.
+// Pages only partly within the range will always be found as changed until they're hashed again.
+void HashPages(const void *data, size_t offset, size_t size, size_t bufSize, uint64_t *hashes);
+// finds the [start, end) byte ranges of pages in buf that don't match their hashes, coalesced the
+// same as FindDiffRanges. Returns true if any changes were found.
+bool FindChangedPages(const void *buf, size_t bufSize, const uint64_t *hashes,
+                      rdcarray<rdcpair<size_t, size_t>> &ranges);
+// the page reference CompactPages uses for pages that are entirely zero
+static const uint32_t CompactedZeroPage = ~0U;
+// de-duplicates a buffer in place at pageSize granularity. Each page is given an entry in pageRefs,
+// either CompactedZeroPage or the index of the page it's identical to among the unique pages, which
+// are moved to the start of the buffer in order. Returns the number of bytes of unique pages.
+size_t CompactPages(byte *buf, size_t bufSize, size_t pageSize, rdcarray<uint32_t> &pageRefs);
 uint32_t CalcNumMips(int Width, int Height, int Depth);
 
 byte *AllocAlignedBuffer(uint64_t size, uint64_t alignment = 64);
@@ -254,6 +277,14 @@ struct BucketForRecord<T, BucketRecordType::Pow2>
   do                   \
   {                    \
   } while((void)0, 0)
+#define RDCLOGASYNC() \
+  do                  \
+  {                   \
+  } while((void)0, 0)
+#define RDCLOGCRASHFLUSH() \
+  do                       \
+  {                        \
+  } while((void)0, 0)
 
 #define RDCDEBUG(...) \
   do                  \
@@ -306,12 +337,19 @@ void rdclog_direct(time_t utcTime, uint32_t pid, LogType type, const char *proje
 const char *rdclog_getfilename();
 void rdclog_filename(const char *filename);
 void rdclog_enableoutput();
+void rdclog_enableasync();
+void rdclog_crashflush();
 void rdclog_closelog(const char *filename);
 
 #define RDCLOGFILE(fn) rdclog_filename(fn)
 #define RDCGETLOGFILE() rdclog_getfilename()
 
 #define RDCLOGOUTPUT() rdclog_enableoutput()
+// write the log from a background thread from now on, until logging is stopped, and rate limit
+// repeated messages. Only used in capturing applications
+#define RDCLOGASYNC() rdclog_enableasync()
+// drain any queued log messages from a crash handler, without blocking indefinitely
+#define RDCLOGCRASHFLUSH() rdclog_crashflush()
 #define RDCSTOPLOGGING(filename) rdclog_closelog(filename)
 
 #if(ENABLED(RDOC_DEVEL) || ENABLED(FORCE_DEBUG_LOGS)) && DISABLED(STRIP_DEBUG_LOGS)
@@ -349,8 +387,8 @@ void rdclog_closelog(const char *filename);
 #define RDCDUMPMSG(message)                            \
   do                                                   \
   {                                                    \
-    rdclogprint_int(LogType::Fatal, message, message); \
     rdclog_flush();                                    \
+    rdclogprint_int(LogType::Fatal, message, message); \
     RDCDUMP();                                         \
     exit(0);                                           \
   } while((void)0, 0)
@@ -0,0 +1,231 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "common/common.h"
+#include <string.h>
+#include <vector>
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Test FindDiffRanges", "[common]")
+{
+  const size_t size = 1024 * 1024 + 7;
+
+  std::vector<byte> a, b;
+  a.resize(size);
+  for(size_t i = 0; i < size; i++)
+    a[i] = byte(i * 7);
+  b = a;
+
+  rdcarray<rdcpair<size_t, size_t>> ranges;
+
+  SECTION("Identical buffers")
+  {
+    CHECK_FALSE(FindDiffRanges(a.data(), b.data(), size, ranges));
+    CHECK(ranges.empty());
+  };
+
+  SECTION("Single byte differences are byte accurate")
+  {
+    b[0]++;
+
+    REQUIRE(FindDiffRanges(a.data(), b.data(), size, ranges));
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].first == 0);
+    CHECK(ranges[0].second == 1);
+
+    b[0]--;
+    b[size - 1]++;
+
+    REQUIRE(FindDiffRanges(a.data(), b.data(), size, ranges));
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].first == size - 1);
+    CHECK(ranges[0].second == size);
+  };
+
+  SECTION("Distant differences are separate ranges")
+  {
+    b[100]++;
+    b[102]++;
+    b[size - 100]++;
+
+    REQUIRE(FindDiffRanges(a.data(), b.data(), size, ranges));
+    REQUIRE(ranges.size() == 2);
+    CHECK(ranges[0].first == 100);
+    CHECK(ranges[0].second == 103);
+    CHECK(ranges[1].first == size - 100);
+    CHECK(ranges[1].second == size - 99);
+  };
+
+  SECTION("Nearby differences are coalesced")
+  {
+    b[5000]++;
+    b[9000]++;
+
+    REQUIRE(FindDiffRanges(a.data(), b.data(), size, ranges));
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].first == 5000);
+    CHECK(ranges[0].second == 9001);
+  };
+
+  SECTION("Large buffers are checked in parallel")
+  {
+    const size_t largeSize = 96 * 1024 * 1024 + 3;
+
+    a.resize(largeSize);
+    b.resize(largeSize);
+    memset(a.data(), 0, largeSize);
+    memset(b.data(), 0, largeSize);
+
+    // one difference each side of where the buffer is split between threads, which should be
+    // coalesced into one range, and one right at the end.
+    b[largeSize / 4 - 10] = 1;
+    b[largeSize / 4 + 10] = 1;
+    b[largeSize - 1] = 1;
+
+    REQUIRE(FindDiffRanges(a.data(), b.data(), largeSize, ranges));
+    REQUIRE(ranges.size() == 2);
+    CHECK(ranges[0].first == largeSize / 4 - 10);
+    CHECK(ranges[0].second == largeSize / 4 + 11);
+    CHECK(ranges[1].first == largeSize - 1);
+    CHECK(ranges[1].second == largeSize);
+  };
+};
+
+TEST_CASE("Test page hashing", "[common]")
+{
+  const size_t size = 256 * 1024 + 7;
+
+  std::vector<byte> buf;
+  buf.resize(size);
+  for(size_t i = 0; i < size; i++)
+    buf[i] = byte(i * 13);
+
+  std::vector<uint64_t> hashes;
+  hashes.resize(NumHashedPages(size));
+  CHECK(hashes.size() == 65);
+
+  HashPages(buf.data(), 0, size, size, hashes.data());
+
+  rdcarray<rdcpair<size_t, size_t>> ranges;
+
+  SECTION("Unchanged buffer")
+  {
+    CHECK_FALSE(FindChangedPages(buf.data(), size, hashes.data(), ranges));
+    CHECK(ranges.empty());
+  };
+
+  SECTION("Changes are page granular")
+  {
+    buf[5000]++;
+    buf[size - 1]++;
+
+    REQUIRE(FindChangedPages(buf.data(), size, hashes.data(), ranges));
+    REQUIRE(ranges.size() == 2);
+    CHECK(ranges[0].first == 4096);
+    CHECK(ranges[0].second == 8192);
+    CHECK(ranges[1].first == 64 * 4096);
+    CHECK(ranges[1].second == size);
+
+    // re-hashing just the changed ranges brings the hashes up to date
+    for(const rdcpair<size_t, size_t> &r : ranges)
+      HashPages(buf.data() + r.first, r.first, r.second - r.first, size, hashes.data());
+
+    CHECK_FALSE(FindChangedPages(buf.data(), size, hashes.data(), ranges));
+  };
+
+  SECTION("Partially hashed pages are always changed")
+  {
+    HashPages(buf.data() + 100, 100, 8000, size, hashes.data());
+
+    REQUIRE(FindChangedPages(buf.data(), size, hashes.data(), ranges));
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].first == 0);
+    CHECK(ranges[0].second == 8192);
+  };
+};
+
+TEST_CASE("Test page compaction", "[common]")
+{
+  const size_t pageSize = 4096;
+  const size_t size = 6 * pageSize + 100;
+
+  std::vector<byte> buf;
+  buf.resize(size);
+
+  // pages: 0 unique, 1 zero, 2 = copy of 0, 3 unique, 4 zero, 5 = copy of 3, then a partial page
+  for(size_t i = 0; i < pageSize; i++)
+  {
+    buf[i] = byte(i * 13 + 1);
+    buf[2 * pageSize + i] = buf[i];
+    buf[3 * pageSize + i] = byte(i * 7 + 3);
+    buf[5 * pageSize + i] = buf[3 * pageSize + i];
+  }
+  for(size_t i = 6 * pageSize; i < size; i++)
+    buf[i] = byte(i);
+
+  const std::vector<byte> orig = buf;
+
+  rdcarray<uint32_t> pageRefs;
+  size_t compacted = CompactPages(buf.data(), size, pageSize, pageRefs);
+
+  CHECK(compacted == 2 * pageSize + 100);
+
+  REQUIRE(pageRefs.size() == 7);
+  CHECK(pageRefs[0] == 0);
+  CHECK(pageRefs[1] == CompactedZeroPage);
+  CHECK(pageRefs[2] == 0);
+  CHECK(pageRefs[3] == 1);
+  CHECK(pageRefs[4] == CompactedZeroPage);
+  CHECK(pageRefs[5] == 1);
+  CHECK(pageRefs[6] == 2);
+
+  // expanding the pages again gives back the original data
+  for(size_t page = 0; page < pageRefs.size(); page++)
+  {
+    size_t len = RDCMIN(size - page * pageSize, pageSize);
+
+    std::vector<byte> expected(orig.begin() + page * pageSize,
+                               orig.begin() + page * pageSize + len);
+    std::vector<byte> actual(len, 0);
+
+    if(pageRefs[page] != CompactedZeroPage)
+      memcpy(actual.data(), buf.data() + pageRefs[page] * pageSize, len);
+
+    CHECK(actual == expected);
+  }
+
+  SECTION("All zero buffer")
+  {
+    std::vector<byte> zeroes(size, 0);
+    CHECK(CompactPages(zeroes.data(), size, pageSize, pageRefs) == 0);
+    CHECK(pageRefs.size() == 7);
+    for(uint32_t ref : pageRefs)
+      CHECK(ref == CompactedZeroPage);
+  };
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
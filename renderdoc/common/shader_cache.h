@@ -26,9 +26,9 @@
 
 #include "os/os_specific.h"
 
-template <typename ResultType, typename ShaderCallbacks>
+template <typename KeyType, typename ResultType, typename ShaderCallbacks>
 bool LoadShaderCache(const char *filename, const uint32_t magicNumber, const uint32_t versionNumber,
-                     std::map<uint32_t, ResultType> &resultCache, const ShaderCallbacks &callbacks)
+                     std::map<KeyType, ResultType> &resultCache, const ShaderCallbacks &callbacks)
 {
   string shadercache = FileIO::GetAppFolderFilename(filename);
 
@@ -68,9 +68,8 @@ bool LoadShaderCache(const char *filename, const uint32_t magicNumber, const uin
     {
       uint32_t numentries = header[2];
 
-      // assume at least 16 bytes for any cache entry. 8 bytes for hash and length, and 8 bytes
-      // data.
-      if(numentries > cachelen / 16LLU)
+      // assume at least 8 bytes of data for any cache entry, on top of the hash and length.
+      if(numentries > cachelen / (sizeof(KeyType) + sizeof(uint32_t) + 8LLU))
       {
         RDCERR("Invalid shader cache - more entries %u than are feasible in a %llu byte cache",
                numentries, cachelen);
@@ -84,16 +83,17 @@ bool LoadShaderCache(const char *filename, const uint32_t magicNumber, const uin
 
         for(uint32_t i = 0; i < numentries; i++)
         {
-          if((size_t)bufsize < sizeof(uint32_t))
+          if((size_t)bufsize < sizeof(KeyType))
           {
             RDCERR("Invalid shader cache - truncated, not enough data for shader hash");
             ret = false;
             break;
           }
 
-          uint32_t hash = *(uint32_t *)ptr;
-          ptr += sizeof(uint32_t);
-          bufsize -= sizeof(uint32_t);
+          KeyType hash;
+          memcpy(&hash, ptr, sizeof(KeyType));
+          ptr += sizeof(KeyType);
+          bufsize -= sizeof(KeyType);
 
           if((size_t)bufsize < sizeof(uint32_t))
           {
@@ -148,9 +148,9 @@ bool LoadShaderCache(const char *filename, const uint32_t magicNumber, const uin
   return ret;
 }
 
-template <typename ResultType, typename ShaderCallbacks>
+template <typename KeyType, typename ResultType, typename ShaderCallbacks>
 void SaveShaderCache(const char *filename, uint32_t magicNumber, uint32_t versionNumber,
-                     const std::map<uint32_t, ResultType> &cache, const ShaderCallbacks &callbacks)
+                     const std::map<KeyType, ResultType> &cache, const ShaderCallbacks &callbacks)
 {
   string shadercache = FileIO::GetAppFolderFilename(filename);
 
@@ -169,7 +169,7 @@ void SaveShaderCache(const char *filename, uint32_t magicNumber, uint32_t versio
 
   for(auto it = cache.begin(); it != cache.end(); ++it)
   {
-    uint32_t hash = it->first;
+    KeyType hash = it->first;
     uint32_t len = callbacks.GetSize(it->second);
     const byte *data = callbacks.GetData(it->second);
     FileIO::fwrite(&hash, 1, sizeof(hash), f);
@@ -34,8 +34,13 @@ class ScopedLock
 public:
   ScopedLock(CriticalSection *cs) : m_CS(cs)
   {
-    if(m_CS)
+    // only time the lock when it's contended, so the common case costs no more than a Trylock
+    if(m_CS && !m_CS->Trylock())
+    {
+      uint64_t start = Timing::GetTick();
       m_CS->Lock();
+      RecordLockWait(Timing::GetTick() - start);
+    }
   }
   ~ScopedLock()
   {
@@ -227,6 +227,9 @@ RenderDoc::RenderDoc()
 
   m_TargetControlThreadShutdown = false;
   m_ControlClientThreadShutdown = false;
+
+  m_ChunkOverhead[(int)RDCDriver::Unknown].resize(NumOverheadChunks);
+  m_ChunkOverheadReady[(int)RDCDriver::Unknown] = 1;
 }
 
 void RenderDoc::Initialise()
@@ -292,6 +295,10 @@ void RenderDoc::Initialise()
     RDCLOGFILE(m_LoggingFilename.c_str());
   }
 
+  // in capturing applications, don't make the application's threads wait on log file I/O
+  if(!IsReplayApp())
+    RDCLOGASYNC();
+
   const char *platform =
 #if ENABLED(RDOC_WIN32)
       "Windows";
@@ -342,6 +349,17 @@ void RenderDoc::Initialise()
     RDCLOGOUTPUT();
 }
 
+struct RenderDoc::CaptureWrite
+{
+  RDCFile *rdc;
+  SectionProperties props;
+  std::vector<Chunk *> chunks;
+  uint64_t size;
+  uint32_t frameNumber;
+  Threading::ThreadHandle thread;
+  bool finished;
+};
+
 RenderDoc::~RenderDoc()
 {
   if(m_ExHandler)
@@ -352,6 +370,30 @@ RenderDoc::~RenderDoc()
   for(auto it = m_ShutdownFunctions.begin(); it != m_ShutdownFunctions.end(); ++it)
     (*it)();
 
+  // give any captures still being written a chance to finish. We can't wait indefinitely as on some
+  // platforms other threads have already been killed by the time we get here, so after that cancel
+  // what's left and wait for the writing threads to stop before they can touch a destroyed object.
+  if(!FlushCaptureWriting(5000))
+  {
+    RDCWARN("Captures still being written at shutdown, they will be incomplete");
+
+    Atomic::Inc32(&m_CancelCaptureWrites);
+
+    std::vector<CaptureWrite *> writes;
+
+    {
+      SCOPED_LOCK(m_CaptureWriteLock);
+      writes.swap(m_CaptureWrites);
+    }
+
+    for(CaptureWrite *write : writes)
+    {
+      Threading::JoinThread(write->thread);
+      Threading::CloseThread(write->thread);
+      delete write;
+    }
+  }
+
   for(size_t i = 0; i < m_Captures.size(); i++)
   {
     if(m_Captures[i].retrieved)
@@ -565,6 +607,8 @@ void RenderDoc::Tick()
 
   m_FrameTimer.UpdateTimers();
 
+  Atomic::Inc64(&m_PresentedFrames);
+
   if(!prev_focus && cur_focus)
   {
     CycleActiveWindow();
@@ -1182,6 +1226,123 @@ std::map<RDCDriver, bool> RenderDoc::GetActiveDrivers()
   return ret;
 }
 
+void RenderDoc::RegisterChunkLookup(RDCDriver driver, std::string (*lookup)(uint32_t chunkType))
+{
+  SCOPED_LOCK(m_DriverLock);
+  m_ChunkLookups[driver] = lookup;
+
+  if(driver < RDCDriver::MaxBuiltin && m_ChunkOverhead[(int)driver].empty())
+  {
+    m_ChunkOverhead[(int)driver].resize(NumOverheadChunks);
+
+    // the exchange is a full barrier, so the table is visible before the flag
+    Atomic::CmpExch32(&m_ChunkOverheadReady[(int)driver], 0, 1);
+  }
+}
+
+RenderDoc::ChunkOverhead *RenderDoc::GetChunkOverheadTable(RDCDriver driver)
+{
+  if(driver >= RDCDriver::MaxBuiltin)
+    return NULL;
+
+  // compare-exchange with the same value as a full barrier load, pairing with the publish above
+  if(Atomic::CmpExch32(&m_ChunkOverheadReady[(int)driver], 0, 0) == 0)
+    return NULL;
+
+  return m_ChunkOverhead[(int)driver].data();
+}
+
+void RenderDoc::AddChunkOverhead(RDCDriver driver, uint32_t chunkID, uint64_t byteLength,
+                                 uint64_t ticks)
+{
+  ChunkOverhead *overheads = GetChunkOverheadTable(driver);
+
+  if(overheads == NULL)
+    overheads = m_ChunkOverhead[(int)RDCDriver::Unknown].data();
+
+  if(chunkID >= NumOverheadChunks)
+    chunkID = 0;
+
+  ChunkOverhead &overhead = overheads[chunkID];
+
+  Atomic::Inc64(&overhead.count);
+  Atomic::ExchAdd64(&overhead.bytes, int64_t(byteLength));
+  Atomic::ExchAdd64(&overhead.ticks, int64_t(ticks));
+}
+
+CaptureOverheadData RenderDoc::GetCaptureOverhead(OverheadSnapshot &since)
+{
+  CaptureOverheadData ret;
+
+  const double microsPerTick = 1000.0 / Timing::GetTickFrequency();
+
+  std::map<RDCDriver, std::string (*)(uint32_t)> lookups;
+  {
+    SCOPED_LOCK(m_DriverLock);
+    lookups = m_ChunkLookups;
+  }
+
+  int64_t frames = m_PresentedFrames;
+  ret.frameCount = uint32_t(frames - since.frames);
+  since.frames = frames;
+
+  uint64_t lockWait = Threading::GetTotalLockWait();
+  ret.lockWaitMicroseconds = double(lockWait - since.lockWait) * microsPerTick;
+  since.lockWait = lockWait;
+
+  ret.chunkMemory = Chunk::TotalMem();
+  ret.liveChunks = Chunk::NumLiveChunks();
+
+  for(int d = 0; d < (int)RDCDriver::MaxBuiltin; d++)
+  {
+    const ChunkOverhead *overheads = GetChunkOverheadTable((RDCDriver)d);
+
+    if(overheads == NULL)
+      continue;
+
+    RDCDriver driver = (RDCDriver)d;
+
+    std::vector<ChunkOverhead> &prev = since.chunks[driver];
+    prev.resize(NumOverheadChunks);
+
+    auto lookup = lookups.find(driver);
+
+    for(uint32_t i = 0; i < NumOverheadChunks; i++)
+    {
+      // read the counter first - the other values may be slightly ahead of it if a chunk is being
+      // recorded concurrently, which is fine since it will be accounted for in the next delta.
+      int64_t count = overheads[i].count;
+
+      if(count == prev[i].count)
+        continue;
+
+      int64_t bytes = overheads[i].bytes;
+      int64_t ticks = overheads[i].ticks;
+
+      ChunkOverheadStats stats;
+      stats.chunkID = i;
+      stats.count = uint64_t(count - prev[i].count);
+      stats.byteSize = uint64_t(bytes - prev[i].bytes);
+      stats.serialiseMicroseconds = double(ticks - prev[i].ticks) * microsPerTick;
+
+      if(i == 0)
+        stats.name = "<Other Chunks>";
+      else if(i < (uint32_t)SystemChunk::FirstDriverChunk)
+        stats.name = ToStr((SystemChunk)i);
+      else if(lookup != lookups.end())
+        stats.name = lookup->second(i);
+
+      ret.chunks.push_back(stats);
+
+      prev[i].count = count;
+      prev[i].bytes = bytes;
+      prev[i].ticks = ticks;
+    }
+  }
+
+  return ret;
+}
+
 map<RDCDriver, string> RenderDoc::GetReplayDrivers()
 {
   map<RDCDriver, string> ret;
@@ -1272,10 +1433,201 @@ void RenderDoc::SetCaptureFileTemplate(const char *pathtemplate)
   FileIO::CreateParentDirectory(m_CaptureFileTemplate);
 }
 
+// the most capture data we'll hold on to waiting to be written out. Past this, reserving room for
+// another capture blocks until earlier ones have finished writing.
+static const uint64_t MaxPendingCaptureWriteBytes = 1024ULL * 1024 * 1024;
+
+void RenderDoc::ReserveCaptureWriting(uint64_t size)
+{
+  // wait until there's room in the budget. A capture bigger than the whole budget is still allowed
+  // through once nothing else is pending, so it's at least not held in memory alongside others.
+  for(;;)
+  {
+    {
+      SCOPED_LOCK(m_CaptureWriteLock);
+      if(m_PendingCaptureWrites == 0 ||
+         m_PendingCaptureWriteBytes + size <= MaxPendingCaptureWriteBytes)
+      {
+        m_PendingCaptureWrites++;
+        m_PendingCaptureWriteBytes += size;
+        return;
+      }
+    }
+
+    Threading::Sleep(10);
+  }
+}
+
+void RenderDoc::QueueCaptureWriting(RDCFile *rdc, const SectionProperties &props,
+                                    std::vector<Chunk *> &chunks, uint64_t reservedSize,
+                                    uint32_t frameNumber)
+{
+  if(rdc == NULL)
+  {
+    for(Chunk *chunk : chunks)
+      chunk->Release();
+    chunks.clear();
+
+    {
+      SCOPED_LOCK(m_CaptureWriteLock);
+      m_PendingCaptureWrites--;
+      m_PendingCaptureWriteBytes -= reservedSize;
+    }
+
+    FinishCaptureWriting(NULL, frameNumber);
+    return;
+  }
+
+  CaptureWrite *write = new CaptureWrite;
+  write->rdc = rdc;
+  write->props = props;
+  write->chunks.swap(chunks);
+  write->size = 0;
+  write->frameNumber = frameNumber;
+  write->finished = false;
+
+  for(Chunk *chunk : write->chunks)
+    write->size += chunk->GetLength();
+
+  RDCLOG("Queued %llu bytes in %zu chunks of capture data for writing to %s", write->size,
+         write->chunks.size(), rdc->GetFilename().c_str());
+
+  SCOPED_LOCK(m_CaptureWriteLock);
+
+  // the reservation was made before the frame's initial contents were serialised, so settle it
+  // against what we're actually holding on to now.
+  m_PendingCaptureWriteBytes += write->size;
+  m_PendingCaptureWriteBytes -= reservedSize;
+
+  ReapCaptureWrites();
+
+  m_CaptureWrites.push_back(write);
+
+  write->thread = Threading::CreateThread([this, write]() { WriteCapture(write); });
+}
+
+void RenderDoc::WriteCapture(CaptureWrite *write)
+{
+  Threading::KeepModuleAlive();
+
+  SetProgress(CaptureProgress::FileWriting, 0.0f);
+
+  StreamWriter *w = write->rdc->WriteSection(write->props);
+
+  bool cancelled = false;
+
+  {
+    WriteSerialiser ser(w, Ownership::Nothing);
+
+    uint64_t written = 0;
+
+    for(Chunk *chunk : write->chunks)
+    {
+      if(!cancelled)
+        cancelled = Atomic::CmpExch32(&m_CancelCaptureWrites, 1, 1) == 1;
+
+      if(!cancelled)
+      {
+        // spilled chunks are streamed straight from the spill file
+        chunk->Write(ser);
+        written += chunk->GetLength();
+
+        // leave a little of the progress for the remaining sections
+        SetProgress(CaptureProgress::FileWriting, 0.9f * float(written) / float(write->size));
+      }
+
+      chunk->Release();
+    }
+
+    write->chunks.clear();
+  }
+
+  if(cancelled)
+  {
+    RDCWARN("Writing capture to %s was cancelled, it will be incomplete",
+            write->rdc->GetFilename().c_str());
+
+    delete w;
+    delete write->rdc;
+  }
+  else
+  {
+    w->Finish();
+
+    delete w;
+
+    FinishCaptureFile(write->rdc, write->frameNumber);
+
+    SetProgress(CaptureProgress::FileWriting, 1.0f);
+  }
+
+  write->rdc = NULL;
+
+  {
+    SCOPED_LOCK(m_CaptureWriteLock);
+    m_PendingCaptureWrites--;
+    m_PendingCaptureWriteBytes -= write->size;
+    write->finished = true;
+  }
+
+  Threading::ReleaseModuleExitThread();
+}
+
+void RenderDoc::ReapCaptureWrites()
+{
+  // must be called with m_CaptureWriteLock held. Finished threads only have to exit, so joining
+  // them won't block for long.
+  for(auto it = m_CaptureWrites.begin(); it != m_CaptureWrites.end();)
+  {
+    CaptureWrite *write = *it;
+
+    if(write->finished)
+    {
+      Threading::JoinThread(write->thread);
+      Threading::CloseThread(write->thread);
+      delete write;
+      it = m_CaptureWrites.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+bool RenderDoc::FlushCaptureWriting(uint32_t timeoutMS)
+{
+  PerformanceTimer timer;
+
+  for(;;)
+  {
+    {
+      SCOPED_LOCK(m_CaptureWriteLock);
+      if(m_PendingCaptureWrites == 0)
+      {
+        ReapCaptureWrites();
+        return true;
+      }
+    }
+
+    if(timer.GetMilliseconds() > (double)timeoutMS)
+      return false;
+
+    Threading::Sleep(10);
+  }
+}
+
 void RenderDoc::FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber)
 {
   RenderDoc::Inst().SetProgress(CaptureProgress::FileWriting, 0.0f);
 
+  FinishCaptureFile(rdc, frameNumber);
+
+  RenderDoc::Inst().SetProgress(CaptureProgress::FileWriting, 1.0f);
+}
+
+void RenderDoc::FinishCaptureFile(RDCFile *rdc, uint32_t frameNumber)
+{
   if(rdc)
   {
     // add the resolve database if we were capturing callstacks.
@@ -1323,9 +1675,9 @@ void RenderDoc::FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber)
       delete w;
     }
 
-    RDCLOG("Written to disk: %s", m_CurrentLogFile.c_str());
+    RDCLOG("Written to disk: %s", rdc->GetFilename().c_str());
 
-    CaptureData cap(m_CurrentLogFile, Timing::GetUnixTimestamp(), rdc->GetDriver(), frameNumber);
+    CaptureData cap(rdc->GetFilename(), Timing::GetUnixTimestamp(), rdc->GetDriver(), frameNumber);
     {
       SCOPED_LOCK(m_CaptureLock);
       m_Captures.push_back(cap);
@@ -1337,8 +1689,6 @@ void RenderDoc::FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber)
   {
     RDCLOG("Discarded capture, Frame %u", frameNumber);
   }
-
-  RenderDoc::Inst().SetProgress(CaptureProgress::FileWriting, 1.0f);
 }
 
 void RenderDoc::AddDeviceFrameCapturer(void *dev, IFrameCapturer *cap)
@@ -1361,6 +1711,10 @@ void RenderDoc::RemoveDeviceFrameCapturer(void *dev)
   }
 
   m_DeviceFrameCapturers.erase(dev);
+
+  // applications usually destroy their device shortly before exiting, and on some platforms our
+  // writing thread won't survive until the module is unloaded.
+  FlushCaptureWriting();
 }
 
 void RenderDoc::AddFrameCapturer(void *dev, void *wnd, IFrameCapturer *cap)
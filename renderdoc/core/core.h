@@ -322,6 +322,7 @@ class IRemoteDriver;
 class IReplayDriver;
 
 class StreamReader;
+class StreamWriter;
 class RDCFile;
 
 typedef ReplayStatus (*RemoteDriverProvider)(RDCFile *rdc, IRemoteDriver **driver);
@@ -379,7 +380,12 @@ public:
   template <typename ProgressType>
   void SetProgress(ProgressType section, float delta)
   {
-    RENDERDOC_ProgressCallback cb = m_ProgressCallbacks[TypeName<ProgressType>()];
+    // this can be called from the capture writing thread, so don't insert into the map
+    auto it = m_ProgressCallbacks.find(TypeName<ProgressType>());
+    if(it == m_ProgressCallbacks.end())
+      return;
+
+    RENDERDOC_ProgressCallback cb = it->second;
     if(!cb || section < ProgressType::First || section >= ProgressType::Count)
       return;
 
@@ -437,6 +443,20 @@ public:
   RDCFile *CreateRDC(RDCDriver driver, uint32_t frameNum, const FramePixels &fp);
   void FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber);
 
+  // blocks until there's room in the budget for a frame of about the given size to be held in
+  // memory waiting to be written, then charges it. Must be followed by QueueCaptureWriting.
+  void ReserveCaptureWriting(uint64_t size);
+  // takes ownership of rdc and of a reference on each of the frame's chunks, and writes the chunks
+  // in order as a section with the given properties before finishing the capture, all on a
+  // background thread so the application can carry on. The reserved size is settled against the
+  // real size of the chunks.
+  void QueueCaptureWriting(RDCFile *rdc, const SectionProperties &props,
+                           std::vector<Chunk *> &chunks, uint64_t reservedSize,
+                           uint32_t frameNumber);
+  // blocks until all captures queued for writing are on disk, or the timeout expires. Returns
+  // true if nothing is left pending.
+  bool FlushCaptureWriting(uint32_t timeoutMS = ~0U);
+
   void AddChildProcess(uint32_t pid, uint32_t ident)
   {
     SCOPED_LOCK(m_ChildLock);
@@ -517,6 +537,30 @@ public:
   void AddActiveDriver(RDCDriver driver, bool present);
   std::map<RDCDriver, bool> GetActiveDrivers();
 
+  // capture overhead tracking. Chunk overhead is accumulated lock-free from any thread recording
+  // API calls, and is periodically reported over target control as a delta from the last report.
+  struct ChunkOverhead
+  {
+    int64_t count = 0;
+    int64_t bytes = 0;
+    int64_t ticks = 0;
+  };
+
+  static const uint32_t NumOverheadChunks = 1 << 12;
+
+  struct OverheadSnapshot
+  {
+    int64_t frames = 0;
+    uint64_t lockWait = 0;
+    // indexed by the driver that recorded the chunks, then by chunk ID
+    std::map<RDCDriver, std::vector<ChunkOverhead> > chunks;
+  };
+
+  void RegisterChunkLookup(RDCDriver driver, std::string (*lookup)(uint32_t chunkType));
+  void AddChunkOverhead(RDCDriver driver, uint32_t chunkID, uint64_t byteLength, uint64_t ticks);
+  // returns the overhead accumulated since the given snapshot, then updates the snapshot
+  CaptureOverheadData GetCaptureOverhead(OverheadSnapshot &since);
+
   uint32_t GetTargetControlIdent() const { return m_RemoteIdent; }
   bool IsTargetControlConnected();
   string GetTargetControlUsername();
@@ -614,12 +658,37 @@ private:
   int32_t m_MarkerIndentLevel;
   Threading::CriticalSection m_DriverLock;
   std::map<RDCDriver, uint64_t> m_ActiveDrivers;
+  std::map<RDCDriver, std::string (*)(uint32_t)> m_ChunkLookups;
+
+  volatile int64_t m_PresentedFrames = 0;
+  // indexed by driver then chunk ID, since driver chunk IDs overlap between drivers. A driver's
+  // table is allocated under m_DriverLock when it registers its chunk lookup and never resized
+  // after, then published by setting its ready flag so it can be read without the lock. Chunks from
+  // any other driver go in the Unknown table, and chunks with IDs out of range are accumulated in
+  // index 0, which is never a valid chunk ID.
+  std::vector<ChunkOverhead> m_ChunkOverhead[(int)RDCDriver::MaxBuiltin];
+  volatile int32_t m_ChunkOverheadReady[(int)RDCDriver::MaxBuiltin] = {};
+
+  ChunkOverhead *GetChunkOverheadTable(RDCDriver driver);
 
   std::map<std::string, RENDERDOC_ProgressCallback> m_ProgressCallbacks;
 
   Threading::CriticalSection m_CaptureLock;
   vector<CaptureData> m_Captures;
 
+  void FinishCaptureFile(RDCFile *rdc, uint32_t frameNumber);
+
+  // captures that are still being written to disk, each on its own thread
+  struct CaptureWrite;
+  void WriteCapture(CaptureWrite *write);
+  void ReapCaptureWrites();
+
+  Threading::CriticalSection m_CaptureWriteLock;
+  std::vector<CaptureWrite *> m_CaptureWrites;
+  uint32_t m_PendingCaptureWrites = 0;
+  uint64_t m_PendingCaptureWriteBytes = 0;
+  int32_t m_CancelCaptureWrites = 0;
+
   Threading::CriticalSection m_ChildLock;
   vector<pair<uint32_t, uint32_t> > m_Children;
 
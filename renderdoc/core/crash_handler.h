@@ -90,8 +90,8 @@ public:
     RDCLOG("Connecting to server %ls", m_PipeName.c_str());
 
     m_ExHandler = new google_breakpad::ExceptionHandler(
-        dumpFolder.c_str(), NULL, NULL, NULL, google_breakpad::ExceptionHandler::HANDLER_ALL,
-        dumpType, m_PipeName.c_str(), &custom);
+        dumpFolder.c_str(), &FlushLogFilter, NULL, NULL,
+        google_breakpad::ExceptionHandler::HANDLER_ALL, dumpType, m_PipeName.c_str(), &custom);
 
     if(!m_ExHandler->IsOutOfProcess())
     {
@@ -104,8 +104,8 @@ public:
       CreateCrashHandlingServer();
 
       m_ExHandler = new google_breakpad::ExceptionHandler(
-          dumpFolder.c_str(), NULL, NULL, NULL, google_breakpad::ExceptionHandler::HANDLER_ALL,
-          dumpType, m_PipeName.c_str(), &custom);
+          dumpFolder.c_str(), &FlushLogFilter, NULL, NULL,
+          google_breakpad::ExceptionHandler::HANDLER_ALL, dumpType, m_PipeName.c_str(), &custom);
 
       if(!m_ExHandler->IsOutOfProcess())
         RDCERR("Couldn't launch and connect to new breakpad server");
@@ -182,6 +182,15 @@ private:
   std::wstring m_PipeName;
   google_breakpad::ExceptionHandler *m_ExHandler;
 
+  // called before the dump is written. Make sure anything still queued for the log is on disk, since
+  // the last messages before a crash are the most useful ones.
+  static bool FlushLogFilter(void *context, EXCEPTION_POINTERS *exinfo,
+                             MDRawAssertionInfo *assertion)
+  {
+    RDCLOGCRASHFLUSH();
+    return true;
+  }
+
   std::wstring NewPipeName()
   {
     return StringFormat::UTF82Wide(
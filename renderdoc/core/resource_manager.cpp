@@ -183,3 +183,113 @@ void ResourceRecord::Delete(ResourceRecordHandler *mgr)
     mgr->DestroyResourceRecord(this);
   }
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "serialise/rdcfile.h"
+#include "3rdparty/catch/catch.hpp"
+
+static Chunk *MakeTestChunk(byte fill, size_t size)
+{
+  WriteSerialiser ser(new StreamWriter(StreamWriter::DefaultScratchSize), Ownership::Stream);
+
+  SCOPED_SERIALISE_CHUNK(5);
+
+  std::vector<byte> contents(size, fill);
+  SERIALISE_ELEMENT(contents);
+
+  return scope.Get();
+}
+
+TEST_CASE("Verify queued captures aren't affected by later changes to their records",
+          "[resourcemanager][chunks]")
+{
+  const size_t chunkSize = 256 * 1024;
+
+  // a buffer whose backing store points into its creation chunk, as GL and D3D11 do, so that
+  // orphaning it later overwrites the chunk's data directly
+  ResourceRecord *bufRecord = new ResourceRecord(ResourceIDGen::GetNewUniqueID(), true);
+  bufRecord->AddChunk(MakeTestChunk(0x11, chunkSize));
+  bufRecord->Length = bufRecord->GetLastChunk()->GetLength();
+  bufRecord->SetDataPtr(bufRecord->GetLastChunk()->GetData());
+
+  // and a record with plain chunks, which will be freed while the write is in flight
+  ResourceRecord *record = new ResourceRecord(ResourceIDGen::GetNewUniqueID(), true);
+  for(byte i = 0; i < 16; i++)
+    record->AddChunk(MakeTestChunk(0x20 + i, chunkSize));
+
+  // gather the chunks the same way InsertReferencedChunks does
+  std::map<int32_t, Chunk *> sortedChunks;
+  bufRecord->Insert(sortedChunks);
+  record->Insert(sortedChunks);
+
+  std::vector<Chunk *> chunks;
+  for(auto it = sortedChunks.begin(); it != sortedChunks.end(); ++it)
+    chunks.push_back(it->second->Share());
+
+  // this is what should be in the capture, regardless of what happens to the records after queueing
+  std::vector<byte> expected;
+  {
+    StreamWriter *writer = new StreamWriter(StreamWriter::DefaultScratchSize);
+    WriteSerialiser ser(writer, Ownership::Stream);
+
+    for(Chunk *chunk : chunks)
+      chunk->Write(ser);
+
+    expected.assign(writer->GetData(), writer->GetData() + writer->GetOffset());
+  }
+
+  std::string filename = FileIO::GetTempFolderFilename() + "renderdoc_queued_capture_test.rdc";
+
+  RDCFile *rdc = new RDCFile;
+  rdc->SetData(RDCDriver::Unknown, "Test", 0, NULL);
+  rdc->Create(filename.c_str());
+
+  REQUIRE((rdc->ErrorCode() == ContainerError::NoError));
+
+  SectionProperties props;
+  props.type = SectionType::FrameCapture;
+  props.version = 1;
+
+  RenderDoc::Inst().ReserveCaptureWriting(expected.size());
+  RenderDoc::Inst().QueueCaptureWriting(rdc, props, chunks, expected.size(), 0);
+
+  CHECK(chunks.empty());
+
+  // while the capture is being written, orphan the buffer and free the other record
+  memset(bufRecord->GetDataPtr(), 0xcc, (size_t)bufRecord->Length);
+
+  record->DeleteChunks();
+  delete record;
+
+  CHECK(RenderDoc::Inst().FlushCaptureWriting());
+
+  bufRecord->DeleteChunks();
+  delete bufRecord;
+
+  {
+    RDCFile written;
+    written.Open(filename.c_str());
+
+    REQUIRE((written.ErrorCode() == ContainerError::NoError));
+
+    int idx = written.SectionIndex(SectionType::FrameCapture);
+
+    REQUIRE(idx >= 0);
+
+    StreamReader *reader = written.ReadSection(idx);
+
+    std::vector<byte> contents;
+    contents.resize((size_t)reader->GetSize());
+    reader->Read(contents.data(), contents.size());
+
+    delete reader;
+
+    CHECK(contents.size() == expected.size());
+    CHECK((contents == expected));
+  }
+
+  FileIO::Delete(filename.c_str());
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -310,6 +310,11 @@ struct ResourceRecord
     LockChunks();
     m_Chunks.push_back(std::make_pair(ID, chunk));
     UnlockChunks();
+
+    // chunks recorded while capturing a frame are only needed again when the capture is written, so
+    // they can go to disk if we're over the memory budget.
+    if(RenderDoc::Inst().IsFrameCapturing())
+      chunk->SpillIfOverBudget();
   }
 
   void LockChunks()
@@ -354,7 +359,7 @@ struct ResourceRecord
   {
     LockChunks();
     for(auto it = m_Chunks.begin(); it != m_Chunks.end(); ++it)
-      SAFE_DELETE(it->second);
+      SAFE_RELEASE(it->second);
     m_Chunks.clear();
     UnlockChunks();
   }
@@ -479,6 +484,9 @@ public:
 
   // insert the chunks for the resources referenced in the frame
   void InsertReferencedChunks(WriteSerialiser &ser);
+  // as above, but append the chunks to a list with a reference held on each (see Chunk::Share), to
+  // be written later
+  void InsertReferencedChunks(std::vector<Chunk *> &chunks);
 
   // mark resource records as unwritten, ready to be written to a new logfile.
   void MarkUnwrittenResources();
@@ -512,6 +520,9 @@ public:
 
   // generate chunks for initial contents and insert.
   void InsertInitialContentsChunks(WriteSerialiser &ser);
+  // as above, but each resource's initial contents are serialised into ser and then taken as their
+  // own chunk appended to the list, so they can be written later.
+  void InsertInitialContentsChunks(WriteSerialiser &ser, std::vector<Chunk *> &chunks);
 
   // for initial contents that don't need a chunk - apply them here. This allows any patching to
   // creation-time chunks to happen before they're written to disk.
@@ -580,6 +591,9 @@ protected:
   virtual void Apply_InitialState(WrappedResourceType live, InitialContentData initial) = 0;
   virtual std::vector<ResourceId> InitialContentResources();
 
+  void SerialiseInitialContentsChunks(WriteSerialiser &ser, std::vector<Chunk *> *chunks);
+  void InsertReferencedChunks(WriteSerialiser *ser, std::vector<Chunk *> *chunks);
+
   // very coarse lock, protects EVERYTHING. This could certainly be improved and it may be a
   // bottleneck
   // for performance. Given that the main use cases are write-rarely read-often the lock should be
@@ -780,7 +794,7 @@ void ResourceManager<Configuration>::SetInitialChunk(ResourceId id, Chunk *chunk
   if(it != m_InitialChunks.end())
   {
     RDCERR("Initial chunk set for ID %llu twice", id);
-    delete chunk;
+    chunk->Release();
     return;
   }
 
@@ -874,7 +888,7 @@ void ResourceManager<Configuration>::FreeInitialContents()
   }
 
   for(auto it = m_InitialChunks.begin(); it != m_InitialChunks.end(); ++it)
-    delete it->second;
+    it->second->Release();
 
   m_InitialChunks.clear();
 }
@@ -960,6 +974,21 @@ void ResourceManager<Configuration>::MarkUnwrittenResources()
 
 template <typename Configuration>
 void ResourceManager<Configuration>::InsertReferencedChunks(WriteSerialiser &ser)
+{
+  InsertReferencedChunks(&ser, NULL);
+
+  RDCDEBUG("inserted to serialiser");
+}
+
+template <typename Configuration>
+void ResourceManager<Configuration>::InsertReferencedChunks(std::vector<Chunk *> &chunks)
+{
+  InsertReferencedChunks(NULL, &chunks);
+}
+
+template <typename Configuration>
+void ResourceManager<Configuration>::InsertReferencedChunks(WriteSerialiser *ser,
+                                                            std::vector<Chunk *> *chunks)
 {
   map<int32_t, Chunk *> sortedChunks;
 
@@ -1002,10 +1031,18 @@ void ResourceManager<Configuration>::InsertReferencedChunks(WriteSerialiser &ser
 
   RDCDEBUG("%u frame resource chunks", (uint32_t)sortedChunks.size());
 
-  for(auto it = sortedChunks.begin(); it != sortedChunks.end(); it++)
-    it->second->Write(ser);
+  if(chunks)
+  {
+    chunks->reserve(chunks->size() + sortedChunks.size());
 
-  RDCDEBUG("inserted to serialiser");
+    for(auto it = sortedChunks.begin(); it != sortedChunks.end(); it++)
+      chunks->push_back(it->second->Share());
+  }
+  else
+  {
+    for(auto it = sortedChunks.begin(); it != sortedChunks.end(); it++)
+      it->second->Write(*ser);
+  }
 }
 
 template <typename Configuration>
@@ -1065,9 +1102,46 @@ void ResourceManager<Configuration>::PrepareInitialContents()
 
 template <typename Configuration>
 void ResourceManager<Configuration>::InsertInitialContentsChunks(WriteSerialiser &ser)
+{
+  SerialiseInitialContentsChunks(ser, NULL);
+}
+
+template <typename Configuration>
+void ResourceManager<Configuration>::InsertInitialContentsChunks(WriteSerialiser &ser,
+                                                                 std::vector<Chunk *> &chunks)
+{
+  SerialiseInitialContentsChunks(ser, &chunks);
+}
+
+template <typename Configuration>
+void ResourceManager<Configuration>::SerialiseInitialContentsChunks(WriteSerialiser &ser,
+                                                                    std::vector<Chunk *> *chunks)
 {
   SCOPED_LOCK(m_Lock);
 
+  // when gathering chunks, whatever was serialised for a resource is taken out as its own chunk
+  auto gather = [&ser, chunks]() {
+    if(chunks && ser.GetWriter()->GetOffset() > 0)
+    {
+      Chunk *chunk = new Chunk(ser, (uint32_t)SystemChunk::InitialContents);
+      chunk->SpillIfOverBudget();
+      chunks->push_back(chunk);
+    }
+  };
+
+  // prepared chunks are handed over as-is when gathering
+  auto insert = [&ser, chunks](Chunk *chunk) {
+    if(chunks)
+    {
+      chunks->push_back(chunk);
+    }
+    else
+    {
+      chunk->Write(ser);
+      chunk->Release();
+    }
+  };
+
   uint32_t dirty = 0;
   uint32_t skipped = 0;
 
@@ -1135,22 +1209,27 @@ void ResourceManager<Configuration>::InsertInitialContentsChunks(WriteSerialiser
     {
       // just need to grab data, don't create chunk
       Serialise_InitialState(ser, id, res);
+      gather();
       continue;
     }
 
     auto preparedChunk = m_InitialChunks.find(id);
     if(preparedChunk != m_InitialChunks.end())
     {
-      preparedChunk->second->Write(ser);
+      insert(preparedChunk->second);
       m_InitialChunks.erase(preparedChunk);
     }
     else
     {
       uint32_t size = GetSize_InitialState(id, res);
 
-      SCOPED_SERIALISE_CHUNK(SystemChunk::InitialContents, size);
+      {
+        SCOPED_SERIALISE_CHUNK(SystemChunk::InitialContents, size);
+
+        Serialise_InitialState(ser, id, res);
+      }
 
-      Serialise_InitialState(ser, id, res);
+      gather();
     }
   }
 
@@ -1170,16 +1249,20 @@ void ResourceManager<Configuration>::InsertInitialContentsChunks(WriteSerialiser
       auto preparedChunk = m_InitialChunks.find(it->first);
       if(preparedChunk != m_InitialChunks.end())
       {
-        preparedChunk->second->Write(ser);
+        insert(preparedChunk->second);
         m_InitialChunks.erase(preparedChunk);
       }
       else
       {
         uint32_t size = GetSize_InitialState(it->first, it->second);
 
-        SCOPED_SERIALISE_CHUNK(SystemChunk::InitialContents, size);
+        {
+          SCOPED_SERIALISE_CHUNK(SystemChunk::InitialContents, size);
+
+          Serialise_InitialState(ser, it->first, it->second);
+        }
 
-        Serialise_InitialState(ser, it->first, it->second);
+        gather();
       }
     }
   }
@@ -1189,7 +1272,7 @@ void ResourceManager<Configuration>::InsertInitialContentsChunks(WriteSerialiser
   // delete/cleanup any chunks that weren't used (maybe the resource was not
   // referenced).
   for(auto it = m_InitialChunks.begin(); it != m_InitialChunks.end(); ++it)
-    delete it->second;
+    it->second->Release();
 
   m_InitialChunks.clear();
 }
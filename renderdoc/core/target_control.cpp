@@ -30,7 +30,7 @@
 #include "os/os_specific.h"
 #include "serialise/serialiser.h"
 
-static const uint32_t TargetControlProtocolVersion = 5;
+static const uint32_t TargetControlProtocolVersion = 6;
 
 static bool IsProtocolVersionSupported(const uint32_t protocolVersion)
 {
@@ -46,6 +46,10 @@ static bool IsProtocolVersionSupported(const uint32_t protocolVersion)
   if(protocolVersion == 4)
     return true;
 
+  // 5 -> 6 added periodic capture overhead packets
+  if(protocolVersion == 5)
+    return true;
+
   if(protocolVersion == TargetControlProtocolVersion)
     return true;
 
@@ -66,7 +70,8 @@ enum PacketType : uint32_t
   ePacket_NewChild,
   ePacket_CaptureProgress,
   ePacket_CycleActiveWindow,
-  ePacket_CapturableWindowCount
+  ePacket_CapturableWindowCount,
+  ePacket_CaptureOverhead,
 };
 
 DECLARE_REFLECTION_ENUM(PacketType);
@@ -89,6 +94,7 @@ std::string DoStringise(const PacketType &el)
     STRINGISE_ENUM_NAMED(ePacket_CaptureProgress, "Capture Progress");
     STRINGISE_ENUM_NAMED(ePacket_CycleActiveWindow, "Cycle Active Window");
     STRINGISE_ENUM_NAMED(ePacket_CapturableWindowCount, "Capturable Window Count");
+    STRINGISE_ENUM_NAMED(ePacket_CaptureOverhead, "Capture Overhead");
   }
   END_ENUM_STRINGISE();
 }
@@ -137,7 +143,13 @@ void RenderDoc::TargetControlClientThread(uint32_t version, Network::Socket *cli
   const int pingtime = 1000;       // ping every 1000ms
   const int ticktime = 10;         // tick every 10ms
   const int progresstime = 100;    // update capture progress every 100ms
+  const int overheadtime = 1000;   // send capture overhead statistics every 1000ms
   int curtime = 0;
+  int curoverheadtime = 0;
+
+  // the overhead is sent as a delta since the last one we sent, so start from the current totals.
+  RenderDoc::OverheadSnapshot *overheadSnapshot = new RenderDoc::OverheadSnapshot;
+  RenderDoc::Inst().GetCaptureOverhead(*overheadSnapshot);
 
   std::vector<CaptureData> captures;
   std::vector<pair<uint32_t, uint32_t> > children;
@@ -155,6 +167,7 @@ void RenderDoc::TargetControlClientThread(uint32_t version, Network::Socket *cli
 
     Threading::Sleep(ticktime);
     curtime += ticktime;
+    curoverheadtime += ticktime;
 
     std::map<RDCDriver, bool> curdrivers = RenderDoc::Inst().GetActiveDrivers();
 
@@ -270,6 +283,24 @@ void RenderDoc::TargetControlClientThread(uint32_t version, Network::Socket *cli
       }
     }
 
+    if(version >= 6 && curoverheadtime > overheadtime)
+    {
+      curoverheadtime = 0;
+
+      // don't send anything while a frame is being captured, the overhead there isn't
+      // representative of background capturing.
+      if(!RenderDoc::Inst().IsFrameCapturing())
+      {
+        CaptureOverheadData overhead = RenderDoc::Inst().GetCaptureOverhead(*overheadSnapshot);
+
+        WRITE_DATA_SCOPE();
+        {
+          SCOPED_SERIALISE_CHUNK(ePacket_CaptureOverhead);
+          SERIALISE_ELEMENT(overhead);
+        }
+      }
+    }
+
     if(curtime > pingtime)
     {
       WRITE_DATA_SCOPE();
@@ -362,6 +393,8 @@ void RenderDoc::TargetControlClientThread(uint32_t version, Network::Socket *cli
 
   RenderDoc::Inst().SetProgressCallback<CaptureProgress>(RENDERDOC_ProgressCallback());
 
+  SAFE_DELETE(overheadSnapshot);
+
   // give up our connection
   {
     SCOPED_LOCK(RenderDoc::Inst().m_SingleClientLock);
@@ -840,6 +873,14 @@ public:
       reader.EndChunk();
       return msg;
     }
+    else if(type == ePacket_CaptureOverhead)
+    {
+      msg.type = TargetControlMessageType::CaptureOverhead;
+      READ_DATA_SCOPE();
+      SERIALISE_ELEMENT(msg.overhead).Named("Capture Overhead");
+      reader.EndChunk();
+      return msg;
+    }
     else
     {
       RDCERR("Unexpected packed received: %d", type);
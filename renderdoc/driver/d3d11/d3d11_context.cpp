@@ -154,6 +154,7 @@ WrappedID3D11DeviceContext::WrappedID3D11DeviceContext(WrappedID3D11Device *real
     m_ContextRecord->SubResources = NULL;
   }
 
+  m_ScratchSerialiser.SetChunkDriver(RDCDriver::D3D11);
   m_ScratchSerialiser.SetUserData(GetResourceManager());
   m_ScratchSerialiser.SetVersion(D3D11InitParams::CurrentVersion);
 
@@ -510,7 +511,7 @@ void WrappedID3D11DeviceContext::AttemptCapture()
     {
       Chunk *chunk = m_ContextRecord->GetLastChunk();
 
-      SAFE_DELETE(chunk);
+      SAFE_RELEASE(chunk);
       m_ContextRecord->PopChunk();
     }
     m_ContextRecord->UnlockChunks();
@@ -614,7 +615,7 @@ void WrappedID3D11DeviceContext::CleanupCapture()
   {
     Chunk *chunk = m_ContextRecord->GetLastChunk();
 
-    SAFE_DELETE(chunk);
+    SAFE_RELEASE(chunk);
     m_ContextRecord->PopChunk();
   }
   m_ContextRecord->UnlockChunks();
@@ -5449,7 +5449,7 @@ HRESULT WrappedID3D11DeviceContext::FinishCommandList(BOOL RestoreDeferredContex
         while(m_ContextRecord->HasChunks())
         {
           Chunk *chunk = m_ContextRecord->GetLastChunk();
-          SAFE_DELETE(chunk);
+          SAFE_RELEASE(chunk);
           m_ContextRecord->PopChunk();
         }
         m_ContextRecord->UnlockChunks();
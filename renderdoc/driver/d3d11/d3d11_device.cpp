@@ -71,6 +71,7 @@ WrappedID3D11Device::WrappedID3D11Device(ID3D11Device *realDevice, D3D11InitPara
     flags |= WriteSerialiser::ChunkCallstack;
 
   m_ScratchSerialiser.SetChunkMetadataRecording(flags);
+  m_ScratchSerialiser.SetChunkDriver(RDCDriver::D3D11);
   m_ScratchSerialiser.SetVersion(D3D11InitParams::CurrentVersion);
 
   m_StructuredFile = &m_StoredStructuredData;
@@ -124,6 +125,8 @@ WrappedID3D11Device::WrappedID3D11Device(ID3D11Device *realDevice, D3D11InitPara
   else
   {
     m_State = CaptureState::BackgroundCapturing;
+
+    RenderDoc::Inst().RegisterChunkLookup(RDCDriver::D3D11, &GetChunkName);
   }
 
   m_ResourceManager = new D3D11ResourceManager(this);
@@ -2369,7 +2372,7 @@ void WrappedID3D11Device::SetResourceName(ID3D11DeviceChild *pResource, const ch
 
         if(end->GetChunkType<D3D11Chunk>() == D3D11Chunk::SetResourceName)
         {
-          SAFE_DELETE(end);
+          SAFE_RELEASE(end);
           record->PopChunk();
           continue;
         }
@@ -391,13 +391,15 @@ std::string WrappedID3D12CommandQueue::GetChunkName(uint32_t idx)
 
 const APIEvent &WrappedID3D12CommandQueue::GetEvent(uint32_t eventId)
 {
-  for(const APIEvent &e : m_Cmd.m_Events)
-  {
-    if(e.eventId >= eventId)
-      return e;
-  }
+  // events are sorted by eventId once loading is finished. This is called for every event in a
+  // partial replay so it needs to be better than a linear search.
+  auto it = std::lower_bound(m_Cmd.m_Events.begin(), m_Cmd.m_Events.end(), eventId,
+                             [](const APIEvent &e, uint32_t id) { return e.eventId < id; });
 
-  return m_Cmd.m_Events.back();
+  if(it == m_Cmd.m_Events.end())
+    return m_Cmd.m_Events.back();
+
+  return *it;
 }
 
 bool WrappedID3D12CommandQueue::ProcessChunk(ReadSerialiser &ser, D3D12Chunk chunk)
@@ -806,9 +808,11 @@ ReplayStatus WrappedID3D12CommandQueue::ReplayLog(CaptureState readType, uint32_
     if(!success)
       return m_FailedReplayStatus;
 
-    RenderDoc::Inst().SetProgress(
-        LoadProgress::FrameEventsRead,
-        float(m_Cmd.m_CurChunkOffset - startOffset) / float(ser.GetReader()->GetSize()));
+    // progress is only reported while loading, no need to pay for it on every replay
+    if(IsLoading(m_State))
+      RenderDoc::Inst().SetProgress(
+          LoadProgress::FrameEventsRead,
+          float(m_Cmd.m_CurChunkOffset - startOffset) / float(ser.GetReader()->GetSize()));
 
     if((SystemChunk)context == SystemChunk::CaptureEnd)
       break;
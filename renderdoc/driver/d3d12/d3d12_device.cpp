@@ -275,6 +275,8 @@ WrappedID3D12Device::WrappedID3D12Device(ID3D12Device *realDevice, D3D12InitPara
     m_State = CaptureState::BackgroundCapturing;
 
     WrappedID3D12Resource1::m_List = NULL;
+
+    RenderDoc::Inst().RegisterChunkLookup(RDCDriver::D3D12, &GetChunkName);
   }
 
   m_ResourceManager = new D3D12ResourceManager(m_State, this);
@@ -1844,7 +1846,7 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
 
   RenderDoc::Inst().FinishCaptureWriting(rdc, m_CapturedFrames.back().frameNumber);
 
-  SAFE_DELETE(m_HeaderChunk);
+  SAFE_RELEASE(m_HeaderChunk);
 
   for(auto it = queues.begin(); it != queues.end(); ++it)
     (*it)->ClearAfterCapture();
@@ -1890,7 +1892,7 @@ bool WrappedID3D12Device::DiscardFrameCapture(void *dev, void *wnd)
     queues = m_Queues;
   }
 
-  SAFE_DELETE(m_HeaderChunk);
+  SAFE_RELEASE(m_HeaderChunk);
 
   for(auto it = queues.begin(); it != queues.end(); ++it)
     (*it)->ClearAfterCapture();
@@ -2248,7 +2250,7 @@ void WrappedID3D12Device::SetName(ID3D12DeviceChild *pResource, const char *Name
 
         if(end->GetChunkType<D3D12Chunk>() == D3D12Chunk::SetName)
         {
-          SAFE_DELETE(end);
+          SAFE_RELEASE(end);
           record->PopChunk();
           continue;
         }
@@ -2311,6 +2313,7 @@ WriteSerialiser &WrappedID3D12Device::GetThreadSerialiser()
     flags |= WriteSerialiser::ChunkCallstack;
 
   ser->SetChunkMetadataRecording(flags);
+  ser->SetChunkDriver(RDCDriver::D3D12);
   ser->SetUserData(GetResourceManager());
   ser->SetVersion(D3D12InitParams::CurrentVersion);
 
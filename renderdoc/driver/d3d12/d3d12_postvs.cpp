@@ -1334,17 +1334,20 @@ struct D3D12InitPostVSCallback : public D3D12DrawcallCallback
 
 void D3D12Replay::InitPostVSBuffers(const vector<uint32_t> &events)
 {
-  // first we must replay up to the first event without replaying it. This ensures any
-  // non-command buffer calls like memory unmaps etc all happen correctly before this
-  // command buffer
-  m_pDevice->ReplayLog(0, events.front(), eReplay_WithoutDraw);
+  for(const std::vector<uint32_t> &pass : SplitEventsByPass(this, events))
+  {
+    // first we must replay up to the first event without replaying it. This ensures any
+    // non-command buffer calls like memory unmaps etc all happen correctly before this
+    // command buffer
+    m_pDevice->ReplayLog(0, pass.front(), eReplay_WithoutDraw);
 
-  D3D12InitPostVSCallback cb(m_pDevice, this, events);
+    D3D12InitPostVSCallback cb(m_pDevice, this, pass);
 
-  // now we replay the events, which are guaranteed (because we generated them in
-  // GetPassEvents above) to come from the same command buffer, so the event IDs are
-  // still locally continuous, even if we jump into replaying.
-  m_pDevice->ReplayLog(events.front(), events.back(), eReplay_Full);
+    // now we replay the events, which are guaranteed (because we generated them in
+    // GetPassEvents above) to come from the same command buffer, so the event IDs are
+    // still locally continuous, even if we jump into replaying.
+    m_pDevice->ReplayLog(pass.front(), pass.back(), eReplay_Full);
+  }
 }
 
 MeshFormat D3D12Replay::GetPostVSBuffers(uint32_t eventId, uint32_t instID, uint32_t viewID,
@@ -514,6 +514,7 @@ WrappedOpenGL::WrappedOpenGL(GLPlatform &platform)
     flags |= WriteSerialiser::ChunkCallstack;
 
   m_ScratchSerialiser.SetChunkMetadataRecording(flags);
+  m_ScratchSerialiser.SetChunkDriver(RDCDriver::OpenGL);
   m_ScratchSerialiser.SetVersion(GLInitParams::CurrentVersion);
 
   m_SectionVersion = GLInitParams::CurrentVersion;
@@ -558,6 +559,8 @@ WrappedOpenGL::WrappedOpenGL(GLPlatform &platform)
   else
   {
     m_State = CaptureState::BackgroundCapturing;
+
+    RenderDoc::Inst().RegisterChunkLookup(RDCDriver::OpenGL, &GetChunkName);
   }
 
   m_DeviceRecord = NULL;
@@ -1934,26 +1937,73 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
       delete it->second;
     m_BackbufferImages.clear();
 
-    StreamWriter *captureWriter = NULL;
+    SectionProperties props;
 
-    if(rdc)
-    {
-      SectionProperties props;
+    // Compress with LZ4 so that it's fast
+    props.flags = SectionFlags::LZ4Compressed;
+    props.version = m_SectionVersion;
+    props.type = SectionType::FrameCapture;
 
-      // Compress with LZ4 so that it's fast
-      props.flags = SectionFlags::LZ4Compressed;
-      props.version = m_SectionVersion;
-      props.type = SectionType::FrameCapture;
+    // gather up the frame's chunks and hand them over to be written out on a background thread, so
+    // we can return to the application sooner. Chunks that were already recorded are shared rather
+    // than copied, and only the initial contents and a few small chunks are serialised here.
+    std::vector<Chunk *> referencedChunks, frameChunks;
+
+    RDCDEBUG("Inserting Resource Serialisers");
+
+    GetResourceManager()->InsertReferencedChunks(referencedChunks);
 
-      captureWriter = rdc->WriteSection(props);
-    }
-    else
     {
-      captureWriter = new StreamWriter(StreamWriter::InvalidStream);
+      RDCDEBUG("Accumulating context resource list");
+
+      map<int32_t, Chunk *> recordlist;
+      m_ContextRecord->Insert(recordlist);
+
+      for(auto it = m_ContextData.begin(); it != m_ContextData.end(); ++it)
+      {
+        if(m_AcceptedCtx.empty() || m_AcceptedCtx.find(it->first) != m_AcceptedCtx.end())
+        {
+          GLResourceRecord *record = it->second.m_ContextDataRecord;
+          if(record)
+          {
+            RDCDEBUG("Getting Resource Record for context ID %llu with %zu chunks",
+                     it->second.m_ContextDataResourceID, record->NumChunks());
+            record->Insert(recordlist);
+          }
+        }
+      }
+
+      RDCDEBUG("Flushing %u records to file serialiser", (uint32_t)recordlist.size());
+
+      float num = float(recordlist.size());
+      float idx = 0.0f;
+
+      frameChunks.reserve(recordlist.size());
+
+      for(auto it = recordlist.begin(); it != recordlist.end(); ++it)
+      {
+        RenderDoc::Inst().SetProgress(CaptureProgress::SerialiseFrameContents, idx / num);
+        idx += 1.0f;
+        frameChunks.push_back(it->second->Share());
+      }
+
+      RDCDEBUG("Done");
     }
 
+    // wait for room to hold this frame before serialising anything more
+    uint64_t reservedSize = 0;
+
+    for(Chunk *chunk : referencedChunks)
+      reservedSize += chunk->GetLength();
+    for(Chunk *chunk : frameChunks)
+      reservedSize += chunk->GetLength();
+
+    RenderDoc::Inst().ReserveCaptureWriting(reservedSize);
+
+    std::vector<Chunk *> chunks;
+
     {
-      WriteSerialiser ser(captureWriter, Ownership::Stream);
+      WriteSerialiser ser(new StreamWriter(1024 * 1024), Ownership::Stream);
 
       ser.SetChunkMetadataRecording(m_ScratchSerialiser.GetChunkMetadataRecording());
 
@@ -1981,11 +2031,14 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
         SERIALISE_ELEMENT(fbo);
       }
 
-      RDCDEBUG("Inserting Resource Serialisers");
+      chunks.push_back(new Chunk(ser, (uint32_t)SystemChunk::DriverInit));
+
+      chunks.insert(chunks.end(), referencedChunks.begin(), referencedChunks.end());
 
-      GetResourceManager()->InsertReferencedChunks(ser);
+      GetResourceManager()->InsertInitialContentsChunks(ser, chunks);
 
-      GetResourceManager()->InsertInitialContentsChunks(ser);
+      // free any readbacks that weren't consumed
+      GetResourceManager()->FreeTextureReadbacks();
 
       RDCDEBUG("Creating Capture Scope");
 
@@ -1997,43 +2050,13 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
         Serialise_CaptureScope(ser);
       }
 
-      {
-        RDCDEBUG("Accumulating context resource list");
-
-        map<int32_t, Chunk *> recordlist;
-        m_ContextRecord->Insert(recordlist);
-
-        for(auto it = m_ContextData.begin(); it != m_ContextData.end(); ++it)
-        {
-          if(m_AcceptedCtx.empty() || m_AcceptedCtx.find(it->first) != m_AcceptedCtx.end())
-          {
-            GLResourceRecord *record = it->second.m_ContextDataRecord;
-            if(record)
-            {
-              RDCDEBUG("Getting Resource Record for context ID %llu with %zu chunks",
-                       it->second.m_ContextDataResourceID, record->NumChunks());
-              record->Insert(recordlist);
-            }
-          }
-        }
-
-        RDCDEBUG("Flushing %u records to file serialiser", (uint32_t)recordlist.size());
+      chunks.push_back(new Chunk(ser, (uint32_t)SystemChunk::CaptureScope));
 
-        float num = float(recordlist.size());
-        float idx = 0.0f;
-
-        for(auto it = recordlist.begin(); it != recordlist.end(); ++it)
-        {
-          RenderDoc::Inst().SetProgress(CaptureProgress::SerialiseFrameContents, idx / num);
-          idx += 1.0f;
-          it->second->Write(ser);
-        }
-
-        RDCDEBUG("Done");
-      }
+      chunks.insert(chunks.end(), frameChunks.begin(), frameChunks.end());
     }
 
-    RenderDoc::Inst().FinishCaptureWriting(rdc, m_CapturedFrames.back().frameNumber);
+    RenderDoc::Inst().QueueCaptureWriting(rdc, props, chunks, reservedSize,
+                                          m_CapturedFrames.back().frameNumber);
 
     m_State = CaptureState::BackgroundCapturing;
 
@@ -2091,6 +2114,7 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
 
     GetResourceManager()->ClearReferencedResources();
 
+    GetResourceManager()->FreeTextureReadbacks();
     GetResourceManager()->FreeInitialContents();
 
     for(auto it = m_CoherentMaps.begin(); it != m_CoherentMaps.end(); ++it)
@@ -2158,6 +2182,7 @@ bool WrappedOpenGL::DiscardFrameCapture(void *dev, void *wnd)
 
   GetResourceManager()->ClearReferencedResources();
 
+  GetResourceManager()->FreeTextureReadbacks();
   GetResourceManager()->FreeInitialContents();
 
   FinishCapture();
@@ -2318,7 +2343,7 @@ void WrappedOpenGL::CleanupResourceRecord(GLResourceRecord *record, bool freePar
     {
       Chunk *chunk = record->GetLastChunk();
 
-      SAFE_DELETE(chunk);
+      SAFE_RELEASE(chunk);
       record->PopChunk();
     }
     record->UnlockChunks();
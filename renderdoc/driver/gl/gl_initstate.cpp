@@ -734,6 +734,155 @@ void GLResourceManager::CreateTextureImage(GLuint tex, GLenum internalFormat,
   }
 }
 
+// returns the size of one target's data in the given mip, as it's serialised in
+// Serialise_InitialState()
+static uint32_t GetTextureInitialStateMipSize(const TextureStateInitialData &state, int mip)
+{
+  uint32_t w = RDCMAX(state.width >> mip, 1U);
+  uint32_t h = RDCMAX(state.height >> mip, 1U);
+  uint32_t d = RDCMAX(state.depth >> mip, 1U);
+
+  if(state.type == eGL_TEXTURE_CUBE_MAP_ARRAY || state.type == eGL_TEXTURE_1D_ARRAY ||
+     state.type == eGL_TEXTURE_2D_ARRAY)
+    d = state.depth;
+
+  if(IsCompressedFormat(state.internalformat))
+    return (uint32_t)GetCompressedByteSize(w, h, d, state.internalformat);
+
+  return (uint32_t)GetByteSize(w, h, d, GetBaseFormat(state.internalformat),
+                               GetDataType(state.internalformat));
+}
+
+// don't keep more than this much texture data in readback buffers at once. Anything past it is
+// fetched synchronously while serialising, as before.
+static const uint64_t MaxTextureReadbackBytes = 512 * 1024 * 1024;
+
+void GLResourceManager::ReadbackTextureInitialContents(ResourceId id,
+                                                       const GLInitialContents &initContents)
+{
+  // a texture that's prepared again drops the readback of its earlier copy
+  FreeTextureReadback(id);
+
+  const TextureStateInitialData &state = initContents.tex;
+
+  // on GLES glGetTexImage is emulated and compressed data comes from a CPU-side shadow copy, so
+  // there's nothing to gain from pixel-pack buffers.
+  if(IsGLES || initContents.resource.name == 0)
+    return;
+
+  if(state.internalformat == eGL_NONE || state.type == eGL_TEXTURE_BUFFER || state.isView ||
+     state.samples > 1 || state.type == eGL_TEXTURE_2D_MULTISAMPLE ||
+     state.type == eGL_TEXTURE_2D_MULTISAMPLE_ARRAY)
+    return;
+
+  GLenum targets[] = {
+      eGL_TEXTURE_CUBE_MAP_POSITIVE_X, eGL_TEXTURE_CUBE_MAP_NEGATIVE_X,
+      eGL_TEXTURE_CUBE_MAP_POSITIVE_Y, eGL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
+      eGL_TEXTURE_CUBE_MAP_POSITIVE_Z, eGL_TEXTURE_CUBE_MAP_NEGATIVE_Z,
+  };
+
+  int targetcount = ARRAY_COUNT(targets);
+
+  if(state.type != eGL_TEXTURE_CUBE_MAP)
+  {
+    targets[0] = state.type;
+    targetcount = 1;
+  }
+
+  uint32_t size = 0;
+  for(int i = 0; i < state.mips; i++)
+    size += GetTextureInitialStateMipSize(state, i) * targetcount;
+
+  if(size == 0 || m_TextureReadbackBytes + size > MaxTextureReadbackBytes)
+    return;
+
+  m_TextureReadbackBytes += size;
+
+  GLuint ppb = 0;
+  PixelPackState pack;
+
+  GL.glGetIntegerv(eGL_PIXEL_PACK_BUFFER_BINDING, (GLint *)&ppb);
+  pack.Fetch(false);
+
+  ResetPixelPackState(false, 1);
+
+  TextureReadback readback = {};
+  readback.size = size;
+
+  GL.glGenBuffers(1, &readback.buffer);
+  GL.glBindBuffer(eGL_PIXEL_PACK_BUFFER, readback.buffer);
+  GL.glBufferData(eGL_PIXEL_PACK_BUFFER, size, NULL, eGL_STREAM_READ);
+
+  GLuint prevtex = 0;
+  GL.glGetIntegerv(TextureBinding(state.type), (GLint *)&prevtex);
+
+  GL.glBindTexture(state.type, initContents.resource.name);
+
+  bool isCompressed = IsCompressedFormat(state.internalformat);
+  GLenum fmt = eGL_NONE, type = eGL_NONE;
+
+  if(!isCompressed)
+  {
+    fmt = GetBaseFormat(state.internalformat);
+    type = GetDataType(state.internalformat);
+  }
+
+  // lay out the data in the same order as it's serialised
+  size_t offs = 0;
+
+  for(int i = 0; i < state.mips; i++)
+  {
+    uint32_t mipSize = GetTextureInitialStateMipSize(state, i);
+
+    for(int trg = 0; trg < targetcount; trg++)
+    {
+      if(isCompressed)
+        GL.glGetCompressedTextureImageEXT(initContents.resource.name, targets[trg], i,
+                                          (void *)offs);
+      else
+        GL.glGetTexImage(targets[trg], i, fmt, type, (void *)offs);
+
+      offs += mipSize;
+    }
+  }
+
+  GL.glBindTexture(state.type, prevtex);
+
+  // no flush here, the frame's own commands will submit this long before we wait on it at the end
+  // of the frame, and the wait flushes anyway
+  readback.fence = GL.glFenceSync(eGL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  GL.glBindBuffer(eGL_PIXEL_PACK_BUFFER, ppb);
+  pack.Apply(false);
+
+  m_TextureReadbacks[id] = readback;
+}
+
+void GLResourceManager::FreeTextureReadback(ResourceId id)
+{
+  auto it = m_TextureReadbacks.find(id);
+  if(it == m_TextureReadbacks.end())
+    return;
+
+  GL.glDeleteSync(it->second.fence);
+  GL.glDeleteBuffers(1, &it->second.buffer);
+
+  m_TextureReadbackBytes -= it->second.size;
+  m_TextureReadbacks.erase(it);
+}
+
+void GLResourceManager::FreeTextureReadbacks()
+{
+  for(auto it = m_TextureReadbacks.begin(); it != m_TextureReadbacks.end(); ++it)
+  {
+    GL.glDeleteSync(it->second.fence);
+    GL.glDeleteBuffers(1, &it->second.buffer);
+  }
+
+  m_TextureReadbacks.clear();
+  m_TextureReadbackBytes = 0;
+}
+
 void GLResourceManager::PrepareTextureInitialContents(ResourceId liveid, ResourceId origid,
                                                       GLResource res)
 {
@@ -1034,6 +1183,11 @@ void GLResourceManager::PrepareTextureInitialContents(ResourceId liveid, Resourc
                                        (GLint *)&state.texBufSize);
   }
 
+  // start reading the copy back now, so it's done in the background while the frame is captured
+  // and only needs to be mapped when it's serialised
+  if(IsCaptureMode(m_State))
+    ReadbackTextureInitialContents(origid, initContents);
+
   SetInitialContents(origid, initContents);
 }
 
@@ -1623,6 +1777,44 @@ bool GLResourceManager::Serialise_InitialState(SerialiserType &ser, ResourceId r
           // to avoid repeated new/free.
           byte *scratchBuf = AllocAlignedBuffer(size);
 
+          // if the contents were already read back asynchronously, serialise straight out of the
+          // mapped pixel-pack buffer instead.
+          byte *readbackData = NULL;
+          TextureReadback readback = {};
+
+          if(ser.IsWriting())
+          {
+            auto rb = m_TextureReadbacks.find(Id);
+            if(rb != m_TextureReadbacks.end())
+            {
+              readback = rb->second;
+              m_TextureReadbackBytes -= readback.size;
+              m_TextureReadbacks.erase(rb);
+
+              GLenum status = eGL_TIMEOUT_EXPIRED;
+              while(status == eGL_TIMEOUT_EXPIRED)
+                status = GL.glClientWaitSync(readback.fence, eGL_SYNC_FLUSH_COMMANDS_BIT,
+                                             1000000000ULL);
+
+              GL.glDeleteSync(readback.fence);
+
+              GL.glBindBuffer(eGL_PIXEL_PACK_BUFFER, readback.buffer);
+              readbackData = (byte *)GL.glMapBufferRange(eGL_PIXEL_PACK_BUFFER, 0, readback.size,
+                                                         eGL_MAP_READ_BIT);
+              GL.glBindBuffer(eGL_PIXEL_PACK_BUFFER, 0);
+
+              if(readbackData == NULL)
+              {
+                RDCERR("Couldn't map readback buffer for texture %s, fetching synchronously",
+                       ToStr(Id).c_str());
+                GL.glDeleteBuffers(1, &readback.buffer);
+                readback.buffer = 0;
+              }
+            }
+          }
+
+          byte *readbackPtr = readbackData;
+
           // loop over all the available mips
           for(int i = 0; i < TextureState.mips; i++)
           {
@@ -1635,14 +1827,18 @@ bool GLResourceManager::Serialise_InitialState(SerialiserType &ser, ResourceId r
               d = TextureState.depth;
 
             // calculate the actual byte size of this mip
-            if(isCompressed)
-              size = (uint32_t)GetCompressedByteSize(w, h, d, TextureState.internalformat);
-            else
-              size = (uint32_t)GetByteSize(w, h, d, fmt, type);
+            size = GetTextureInitialStateMipSize(TextureState, i);
 
             // loop over the number of targets (this will only ever be >1 for cubemaps)
             for(int trg = 0; trg < targetcount; trg++)
             {
+              if(readbackPtr)
+              {
+                ser.Serialise("SubresourceContents", readbackPtr, size, SerialiserFlags::NoFlags);
+                readbackPtr += size;
+                continue;
+              }
+
               // when writing, fetch the source data out of the texture
               if(ser.IsWriting())
               {
@@ -1705,6 +1901,14 @@ bool GLResourceManager::Serialise_InitialState(SerialiserType &ser, ResourceId r
             }
           }
 
+          if(readbackData)
+          {
+            GL.glBindBuffer(eGL_PIXEL_PACK_BUFFER, readback.buffer);
+            GL.glUnmapBuffer(eGL_PIXEL_PACK_BUFFER);
+            GL.glBindBuffer(eGL_PIXEL_PACK_BUFFER, 0);
+            GL.glDeleteBuffers(1, &readback.buffer);
+          }
+
           // free our scratch buffer
           FreeAlignedBuffer(scratchBuf);
         }
@@ -101,6 +101,16 @@ public:
     ResourceManager::Shutdown();
   }
 
+  void FreeInitialContents()
+  {
+    // every path that frees initial contents must free the texture readbacks first, otherwise their
+    // pixel-pack buffers and fences leak and stale data could be picked up by the next capture.
+    RDCASSERT(m_TextureReadbacks.empty() && m_TextureReadbackBytes == 0, m_TextureReadbacks.size(),
+              m_TextureReadbackBytes);
+
+    ResourceManager::FreeInitialContents();
+  }
+
   void DeleteContext(void *context)
   {
     size_t count = 0;
@@ -250,6 +260,9 @@ public:
 
   void SetInternalResource(GLResource res);
 
+  // free any texture readbacks that weren't consumed by Serialise_InitialState
+  void FreeTextureReadbacks();
+
 private:
   bool ResourceTypeRelease(GLResource res);
   bool Force_InitialState(GLResource res, bool prepare);
@@ -262,6 +275,11 @@ private:
                           GLint samples, int mips);
   void PrepareTextureInitialContents(ResourceId liveid, ResourceId origid, GLResource res);
 
+  // issue a pixel-pack readback of a prepared texture's copy, so it's in flight during the frame
+  // instead of stalling in Serialise_InitialState
+  void ReadbackTextureInitialContents(ResourceId id, const GLInitialContents &initContents);
+  void FreeTextureReadback(ResourceId id);
+
   void Create_InitialState(ResourceId id, GLResource live, bool hasData);
   void Apply_InitialState(GLResource live, GLInitialContents initial);
 
@@ -276,6 +294,16 @@ private:
   map<ResourceId, std::string> m_Names;
   volatile int64_t m_SyncName;
 
+  struct TextureReadback
+  {
+    GLuint buffer;
+    GLsync fence;
+    uint32_t size;
+  };
+
+  map<ResourceId, TextureReadback> m_TextureReadbacks;
+  uint64_t m_TextureReadbackBytes = 0;
+
   CaptureState m_State;
   WrappedOpenGL *m_Driver;
 };
@@ -302,7 +302,7 @@ void WrappedOpenGL::glBindBuffer(GLenum target, GLuint buffer)
         if(end->GetChunkType<GLChunk>() == GLChunk::glBindBuffer ||
            end->GetChunkType<GLChunk>() == GLChunk::glBindBufferARB)
         {
-          SAFE_DELETE(end);
+          SAFE_RELEASE(end);
 
           r->PopChunk();
 
@@ -618,21 +618,21 @@ void WrappedOpenGL::glNamedBufferDataEXT(GLuint buffer, GLsizeiptr size, const v
       while(record->NumChunks() > 2)
       {
         Chunk *c = record->GetLastChunk();
-        SAFE_DELETE(c);
+        SAFE_RELEASE(c);
         record->PopChunk();
       }
 
       int32_t id2 = record->GetLastChunkID();
       {
         Chunk *c = record->GetLastChunk();
-        SAFE_DELETE(c);
+        SAFE_RELEASE(c);
         record->PopChunk();
       }
 
       int32_t id1 = record->GetLastChunkID();
       {
         Chunk *c = record->GetLastChunk();
-        SAFE_DELETE(c);
+        SAFE_RELEASE(c);
         record->PopChunk();
       }
 
@@ -762,21 +762,21 @@ void WrappedOpenGL::glBufferData(GLenum target, GLsizeiptr size, const void *dat
       while(record->NumChunks() > 2)
       {
         Chunk *c = record->GetLastChunk();
-        SAFE_DELETE(c);
+        SAFE_RELEASE(c);
         record->PopChunk();
       }
 
       int32_t id2 = record->GetLastChunkID();
       {
         Chunk *c = record->GetLastChunk();
-        SAFE_DELETE(c);
+        SAFE_RELEASE(c);
         record->PopChunk();
       }
 
       int32_t id1 = record->GetLastChunkID();
       {
         Chunk *c = record->GetLastChunk();
-        SAFE_DELETE(c);
+        SAFE_RELEASE(c);
         record->PopChunk();
       }
 
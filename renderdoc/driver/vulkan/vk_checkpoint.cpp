@@ -0,0 +1,780 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "vk_core.h"
+#include "vk_debug.h"
+
+// Replay checkpoints.
+//
+// Selecting an event late in a long frame means every full replay executes all the submits before
+// it again. While doing full replays we periodically snapshot, at the end of a queue submit,
+// everything the frame has written so far: the written ranges of each memory allocation, any
+// image written up to that point, and the tracked image layouts. A later full replay to an event
+// past a checkpoint applies initial contents for everything else, restores the snapshot on top and
+// then only executes the submits after it. Command buffers submitted entirely before the
+// checkpoint aren't re-recorded and CPU writes to mapped memory before it are skipped.
+//
+// This is opt-in, the Vulkan_ReplayCheckpointBudgetMB config setting gives the GPU memory in MB
+// that checkpoints may use. Once the budget is exhausted the least recently used checkpoints are
+// evicted to make room, so the ones kept are those near events that were recently replayed to.
+
+// never take checkpoints closer than this many milliseconds of replay apart
+static const double MinCheckpointInterval = 100.0;
+
+// the replay time between checkpoints is kept to at least this multiple of the time it took to
+// take the last one
+static const double CheckpointCostRatio = 4.0;
+
+static bool IsWriteUsage(ResourceUsage usage)
+{
+  switch(usage)
+  {
+    case ResourceUsage::StreamOut:
+    case ResourceUsage::VS_RWResource:
+    case ResourceUsage::HS_RWResource:
+    case ResourceUsage::DS_RWResource:
+    case ResourceUsage::GS_RWResource:
+    case ResourceUsage::PS_RWResource:
+    case ResourceUsage::CS_RWResource:
+    case ResourceUsage::All_RWResource:
+    case ResourceUsage::ColorTarget:
+    case ResourceUsage::DepthStencilTarget:
+    case ResourceUsage::Clear:
+    case ResourceUsage::GenMips:
+    case ResourceUsage::Resolve:
+    case ResourceUsage::ResolveDst:
+    case ResourceUsage::Copy:
+    case ResourceUsage::CopyDst:
+    // layout transitions can discard contents, so count them as writes too
+    case ResourceUsage::Barrier: return true;
+    default: break;
+  }
+
+  return false;
+}
+
+static VkImageAspectFlags GetImageAspects(VkFormat fmt)
+{
+  if(IsStencilOnlyFormat(fmt))
+    return VK_IMAGE_ASPECT_STENCIL_BIT;
+
+  if(IsDepthOnlyFormat(fmt))
+    return VK_IMAGE_ASPECT_DEPTH_BIT;
+
+  if(IsDepthOrStencilFormat(fmt))
+    return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+
+  return VK_IMAGE_ASPECT_COLOR_BIT;
+}
+
+// returns the size of buffer needed to hold every subresource of the image. If regions is
+// non-NULL, also returns the copies in the same layout that Apply_InitialState expects for
+// non-MSAA images.
+static VkDeviceSize GetSnapshotRegions(const VulkanCreationInfo::Image &c, uint32_t numLayers,
+                                       std::vector<VkBufferImageCopy> *regions)
+{
+  VkFormat fmt = c.format;
+  VkFormat sizeFormat = GetDepthOnlyFormat(fmt);
+
+  // depth and stencil are copied separately
+  VkImageAspectFlags aspectFlags = GetImageAspects(fmt);
+  if(aspectFlags != VK_IMAGE_ASPECT_STENCIL_BIT)
+    aspectFlags &= ~VK_IMAGE_ASPECT_STENCIL_BIT;
+
+  // must ensure offset remains valid. Must be multiple of block size, or 4, depending on format
+  VkDeviceSize bufAlignment = 4;
+  if(IsBlockFormat(fmt))
+    bufAlignment = (VkDeviceSize)GetByteSize(1, 1, 1, fmt, 0);
+
+  VkDeviceSize bufOffset = 0;
+
+  for(uint32_t a = 0; a < numLayers; a++)
+  {
+    VkExtent3D extent = c.extent;
+
+    for(int m = 0; m < c.mipLevels; m++)
+    {
+      VkBufferImageCopy region = {
+          0, 0, 0, {aspectFlags, (uint32_t)m, a, 1}, {0, 0, 0}, extent,
+      };
+
+      bufOffset = AlignUp(bufOffset, bufAlignment);
+
+      region.bufferOffset = bufOffset;
+
+      bufOffset += GetByteSize(extent.width, extent.height, extent.depth, sizeFormat, 0);
+
+      if(regions)
+        regions->push_back(region);
+
+      if(sizeFormat != fmt)
+      {
+        bufOffset = AlignUp(bufOffset, bufAlignment);
+
+        region.bufferOffset = bufOffset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_STENCIL_BIT;
+
+        bufOffset += GetByteSize(extent.width, extent.height, extent.depth, VK_FORMAT_S8_UINT, 0);
+
+        if(regions)
+          regions->push_back(region);
+      }
+
+      extent.width = RDCMAX(extent.width >> 1, 1U);
+      extent.height = RDCMAX(extent.height >> 1, 1U);
+      extent.depth = RDCMAX(extent.depth >> 1, 1U);
+    }
+  }
+
+  return bufOffset;
+}
+
+static bool IntersectSubresourceRanges(const ImageLayouts &layouts, VkImageSubresourceRange a,
+                                       VkImageSubresourceRange b, VkImageSubresourceRange &out)
+{
+  if(a.levelCount == VK_REMAINING_MIP_LEVELS)
+    a.levelCount = layouts.levelCount - a.baseMipLevel;
+  if(a.layerCount == VK_REMAINING_ARRAY_LAYERS)
+    a.layerCount = layouts.layerCount - a.baseArrayLayer;
+  if(b.levelCount == VK_REMAINING_MIP_LEVELS)
+    b.levelCount = layouts.levelCount - b.baseMipLevel;
+  if(b.layerCount == VK_REMAINING_ARRAY_LAYERS)
+    b.layerCount = layouts.layerCount - b.baseArrayLayer;
+
+  out.aspectMask = a.aspectMask & b.aspectMask;
+  out.baseMipLevel = RDCMAX(a.baseMipLevel, b.baseMipLevel);
+  out.baseArrayLayer = RDCMAX(a.baseArrayLayer, b.baseArrayLayer);
+
+  uint32_t mipEnd = RDCMIN(a.baseMipLevel + a.levelCount, b.baseMipLevel + b.levelCount);
+  uint32_t layerEnd = RDCMIN(a.baseArrayLayer + a.layerCount, b.baseArrayLayer + b.layerCount);
+
+  if(out.aspectMask == 0 || mipEnd <= out.baseMipLevel || layerEnd <= out.baseArrayLayer)
+    return false;
+
+  out.levelCount = mipEnd - out.baseMipLevel;
+  out.layerCount = layerEnd - out.baseArrayLayer;
+
+  return true;
+}
+
+void WrappedVulkan::InitReplayCheckpoints()
+{
+  const std::string &setting =
+      RenderDoc::Inst().GetConfigSetting("Vulkan_ReplayCheckpointBudgetMB");
+
+  uint64_t mb = setting.empty() ? 0 : strtoull(setting.c_str(), NULL, 10);
+
+  if(mb == 0)
+    return;
+
+  if(m_ReplayCheckpoints.sparseBinds)
+  {
+    RDCLOG("Replay checkpoints disabled - frame contains sparse binding operations");
+    return;
+  }
+
+  bool hasMemRefs = false;
+
+  for(auto it = m_CreationInfo.m_Memory.begin(); it != m_CreationInfo.m_Memory.end(); ++it)
+  {
+    MemRefs *memRefs =
+        GetResourceManager()->FindMemRefs(GetResourceManager()->GetOriginalID(it->first));
+
+    if(!memRefs)
+      continue;
+
+    hasMemRefs = true;
+
+    CheckpointMemory mem;
+    mem.id = it->first;
+    mem.wholeMemBuf = it->second.wholeMemBuf;
+    mem.size = 0;
+
+    // only the ranges written in the frame can differ from the initial contents
+    for(auto r = memRefs->rangeRefs.begin(); r != memRefs->rangeRefs.end(); r++)
+    {
+      InitReqType req = InitReq(r->value());
+      if(req != eInitReq_Clear && req != eInitReq_Reset)
+        continue;
+
+      if(r->start() >= it->second.size)
+        continue;
+
+      VkDeviceSize finish = RDCMIN(r->finish(), it->second.size);
+
+      mem.ranges.push_back({r->start(), mem.size, finish - r->start()});
+      mem.size += finish - r->start();
+    }
+
+    if(mem.ranges.empty())
+      continue;
+
+    if(mem.wholeMemBuf == VK_NULL_HANDLE)
+    {
+      RDCLOG("Replay checkpoints disabled - memory %s is written without a whole memory buffer",
+             ToStr(GetResourceManager()->GetOriginalID(mem.id)).c_str());
+      m_ReplayCheckpoints.memory.clear();
+      return;
+    }
+
+    m_ReplayCheckpoints.memory.push_back(mem);
+  }
+
+  if(!hasMemRefs && !m_CreationInfo.m_Memory.empty())
+  {
+    RDCLOG("Replay checkpoints disabled - capture has no memory reference information");
+    return;
+  }
+
+  for(auto it = m_ResourceUses.begin(); it != m_ResourceUses.end(); ++it)
+  {
+    auto imit = m_CreationInfo.m_Image.find(it->first);
+    if(imit == m_CreationInfo.m_Image.end())
+      continue;
+
+    uint32_t firstWrite = ~0U;
+    for(const EventUsage &use : it->second)
+      if(IsWriteUsage(use.usage))
+        firstWrite = RDCMIN(firstWrite, use.eventId);
+
+    if(firstWrite == ~0U)
+      continue;
+
+    const VulkanCreationInfo::Image &c = imit->second;
+
+    bool unsupported = false;
+
+    if(GetYUVPlaneCount(c.format) > 1)
+    {
+      RDCLOG("Replay checkpoints disabled - multi-planar image %s is written in the frame",
+             ToStr(GetResourceManager()->GetOriginalID(it->first)).c_str());
+      unsupported = true;
+    }
+    else if(c.samples != VK_SAMPLE_COUNT_1_BIT &&
+            (!GetDeviceFeatures().shaderStorageImageMultisample ||
+             !GetDeviceFeatures().shaderStorageImageWriteWithoutFormat))
+    {
+      RDCLOG("Replay checkpoints disabled - MSAA image %s is written in the frame",
+             ToStr(GetResourceManager()->GetOriginalID(it->first)).c_str());
+      unsupported = true;
+    }
+
+    if(unsupported)
+    {
+      m_ReplayCheckpoints.memory.clear();
+      m_ReplayCheckpoints.images.clear();
+      return;
+    }
+
+    m_ReplayCheckpoints.images.push_back(std::make_pair(it->first, firstWrite));
+  }
+
+  m_ReplayCheckpoints.budget = mb * 1024 * 1024;
+  m_ReplayCheckpoints.interval = MinCheckpointInterval;
+  m_ReplayCheckpoints.supported = true;
+
+  RDCLOG("Replay checkpoints enabled with a %llu MB budget, tracking %zu memory and %zu images", mb,
+         m_ReplayCheckpoints.memory.size(), m_ReplayCheckpoints.images.size());
+}
+
+WrappedVulkan::ReplayCheckpoint *WrappedVulkan::FindReplayCheckpoint(uint32_t endEventID)
+{
+  // drawcall callbacks need to see every event, so they always replay from the start
+  if(!m_ReplayCheckpoints.supported || m_DrawcallCallback)
+    return NULL;
+
+  ReplayCheckpoint *ret = NULL;
+
+  for(ReplayCheckpoint &checkpoint : m_ReplayCheckpoints.checkpoints)
+  {
+    if(checkpoint.eventId > endEventID)
+      break;
+
+    ret = &checkpoint;
+  }
+
+  return ret;
+}
+
+void WrappedVulkan::UpdateReplayCheckpoints()
+{
+  if(!m_ReplayCheckpoints.supported || m_ReplayCheckpoints.full || m_DrawcallCallback)
+    return;
+
+  uint32_t eventId = m_RootEventID;
+
+  bool existing = IsCheckpointedEvent(eventId);
+  for(const ReplayCheckpoint &checkpoint : m_ReplayCheckpoints.checkpoints)
+    existing |= (checkpoint.eventId == eventId);
+
+  if(existing)
+  {
+    m_ReplayCheckpoints.timer.Restart();
+    return;
+  }
+
+  if(m_ReplayCheckpoints.timer.GetMilliseconds() < m_ReplayCheckpoints.interval)
+    return;
+
+  ObjDisp(GetDev())->DeviceWaitIdle(Unwrap(GetDev()));
+
+  PerformanceTimer timer;
+
+  if(CreateReplayCheckpoint(eventId))
+    m_ReplayCheckpoints.interval =
+        RDCMAX(MinCheckpointInterval, timer.GetMilliseconds() * CheckpointCostRatio);
+
+  m_ReplayCheckpoints.timer.Restart();
+}
+
+bool WrappedVulkan::CreateReplayCheckpoint(uint32_t eventId)
+{
+  ReplayCheckpoint checkpoint;
+  checkpoint.eventId = eventId;
+
+  std::vector<ResourceId> images;
+
+  for(const std::pair<ResourceId, uint32_t> &im : m_ReplayCheckpoints.images)
+  {
+    if(im.second > eventId)
+      continue;
+
+    if(m_ImageLayouts[im.first].queueFamilyIndex != m_QueueFamilyIdx)
+    {
+      RDCLOG("Replay checkpoints disabled - image %s is owned by another queue family",
+             ToStr(GetResourceManager()->GetOriginalID(im.first)).c_str());
+      m_ReplayCheckpoints.supported = false;
+      return false;
+    }
+
+    const VulkanCreationInfo::Image &c = m_CreationInfo.m_Image[im.first];
+
+    checkpoint.size += GetSnapshotRegions(c, c.arrayLayers * (uint32_t)c.samples, NULL);
+
+    images.push_back(im.first);
+  }
+
+  for(const CheckpointMemory &mem : m_ReplayCheckpoints.memory)
+    checkpoint.size += mem.size;
+
+  if(checkpoint.size > m_ReplayCheckpoints.budget)
+  {
+    RDCLOG("Replay checkpoint at event %u needs %llu MB, more than the whole budget", eventId,
+           checkpoint.size / (1024 * 1024));
+    m_ReplayCheckpoints.full = true;
+    return false;
+  }
+
+  // evict the least recently used checkpoints until this one fits
+  while(m_ReplayCheckpoints.used + checkpoint.size > m_ReplayCheckpoints.budget)
+  {
+    auto victim = m_ReplayCheckpoints.checkpoints.begin();
+    for(auto it = victim; it != m_ReplayCheckpoints.checkpoints.end(); ++it)
+      if(it->lastUsed < victim->lastUsed)
+        victim = it;
+
+    RDCDEBUG("Evicting replay checkpoint at event %u, %llu bytes", victim->eventId, victim->size);
+
+    DestroyReplayCheckpoint(*victim);
+    m_ReplayCheckpoints.checkpoints.erase(victim);
+  }
+
+  checkpoint.lastUsed = ++m_ReplayCheckpoints.useCounter;
+
+  VkDevice d = GetDev();
+  VkResult vkr = VK_SUCCESS;
+
+  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+  VkCommandBuffer cmd = GetNextCmd();
+
+  vkr = ObjDisp(d)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  // make sure everything the frame wrote is available before we copy it
+  VkMemoryBarrier memBarrier = {
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, NULL, VK_ACCESS_ALL_WRITE_BITS, VK_ACCESS_TRANSFER_READ_BIT,
+  };
+
+  DoPipelineBarrier(cmd, 1, &memBarrier);
+
+  VkBufferCreateInfo bufInfo = {
+      VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+      NULL,
+      0,
+      0,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+  };
+
+  // these aren't part of the capture, so we manually create & then just wrap.
+  auto createBuffer = [&](VkDeviceSize size, MemoryAllocation &alloc) -> VkBuffer {
+    VkBuffer buf = VK_NULL_HANDLE;
+
+    bufInfo.size = size;
+
+    vkr = ObjDisp(d)->CreateBuffer(Unwrap(d), &bufInfo, NULL, &buf);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    GetResourceManager()->WrapResource(Unwrap(d), buf);
+
+    alloc = AllocateMemoryForResource(buf, MemoryScope::ReplayCheckpoints, MemoryType::GPULocal);
+
+    vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), Unwrap(buf), Unwrap(alloc.mem), alloc.offs);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    return buf;
+  };
+
+  for(const CheckpointMemory &mem : m_ReplayCheckpoints.memory)
+  {
+    MemoryAllocation alloc;
+    VkBuffer buf = createBuffer(mem.size, alloc);
+
+    ObjDisp(d)->CmdCopyBuffer(Unwrap(cmd), Unwrap(mem.wholeMemBuf), Unwrap(buf),
+                              (uint32_t)mem.ranges.size(), mem.ranges.data());
+
+    checkpoint.memory.push_back(buf);
+    checkpoint.memoryAllocs.push_back(alloc);
+    checkpoint.contents.insert(GetResourceManager()->GetOriginalID(mem.id));
+  }
+
+  for(ResourceId id : images)
+  {
+    const VulkanCreationInfo::Image &c = m_CreationInfo.m_Image[id];
+    ImageLayouts &layouts = m_ImageLayouts[id];
+
+    VkImage liveIm = Unwrap(GetResourceManager()->GetCurrentHandle<VkImage>(id));
+
+    VkImage arrayIm = VK_NULL_HANDLE;
+    MemoryAllocation alloc;
+
+    if(c.samples != VK_SAMPLE_COUNT_1_BIT)
+    {
+      VkImageCreateInfo arrayInfo = {
+          VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+          NULL,
+          VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT,
+          VK_IMAGE_TYPE_2D,
+          c.format,
+          c.extent,
+          (uint32_t)c.mipLevels,
+          (uint32_t)c.arrayLayers * (uint32_t)c.samples,
+          VK_SAMPLE_COUNT_1_BIT,
+          VK_IMAGE_TILING_OPTIMAL,
+          VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+              VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+          VK_SHARING_MODE_EXCLUSIVE,
+          0,
+          NULL,
+          VK_IMAGE_LAYOUT_UNDEFINED,
+      };
+
+      if(IsDepthOrStencilFormat(c.format))
+        arrayInfo.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+      else
+        arrayInfo.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+
+      vkr = ObjDisp(d)->CreateImage(Unwrap(d), &arrayInfo, NULL, &arrayIm);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      GetResourceManager()->WrapResource(Unwrap(d), arrayIm);
+
+      alloc = AllocateMemoryForResource(arrayIm, MemoryScope::ReplayCheckpoints,
+                                        MemoryType::GPULocal);
+
+      vkr = ObjDisp(d)->BindImageMemory(Unwrap(d), Unwrap(arrayIm), Unwrap(alloc.mem), alloc.offs);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    }
+
+    VkImageMemoryBarrier srcimBarrier = {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        NULL,
+        VK_ACCESS_ALL_WRITE_BITS,
+        VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        arrayIm != VK_NULL_HANDLE ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                                  : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        liveIm,
+        {GetImageAspects(c.format), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS},
+    };
+
+    for(const ImageRegionState &state : layouts.subresourceStates)
+    {
+      srcimBarrier.subresourceRange = state.subresourceRange;
+      srcimBarrier.oldLayout = state.newLayout;
+      DoPipelineBarrier(cmd, 1, &srcimBarrier);
+    }
+
+    VkInitialContents contents(eResImage, alloc);
+
+    if(arrayIm != VK_NULL_HANDLE)
+    {
+      VkImageMemoryBarrier arrayimBarrier = {
+          VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+          NULL,
+          0,
+          0,
+          VK_IMAGE_LAYOUT_UNDEFINED,
+          VK_IMAGE_LAYOUT_GENERAL,
+          VK_QUEUE_FAMILY_IGNORED,
+          VK_QUEUE_FAMILY_IGNORED,
+          Unwrap(arrayIm),
+          {GetImageAspects(c.format), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS},
+      };
+
+      DoPipelineBarrier(cmd, 1, &arrayimBarrier);
+
+      vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      GetDebugManager()->CopyTex2DMSToArray(Unwrap(arrayIm), liveIm, c.extent,
+                                            (uint32_t)c.arrayLayers, (uint32_t)c.samples, c.format);
+
+      cmd = GetNextCmd();
+
+      vkr = ObjDisp(d)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      // Apply_InitialState expects the array image to be ready to read from
+      arrayimBarrier.srcAccessMask =
+          VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+      arrayimBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+      arrayimBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+      arrayimBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+      DoPipelineBarrier(cmd, 1, &arrayimBarrier);
+
+      contents.img = arrayIm;
+    }
+    else
+    {
+      std::vector<VkBufferImageCopy> regions;
+      VkDeviceSize size = GetSnapshotRegions(c, (uint32_t)c.arrayLayers, &regions);
+
+      VkBuffer buf = createBuffer(size, alloc);
+
+      ObjDisp(d)->CmdCopyImageToBuffer(Unwrap(cmd), liveIm, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                       Unwrap(buf), (uint32_t)regions.size(), regions.data());
+
+      contents.mem = alloc;
+      contents.buf = buf;
+    }
+
+    // transfer back to whatever it was. Subresources with undefined contents are left as they are,
+    // the next transition in the frame discards them anyway.
+    srcimBarrier.oldLayout = srcimBarrier.newLayout;
+    srcimBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+    for(const ImageRegionState &state : layouts.subresourceStates)
+    {
+      if(state.newLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
+         state.newLayout == VK_IMAGE_LAYOUT_PREINITIALIZED)
+        continue;
+
+      srcimBarrier.subresourceRange = state.subresourceRange;
+      srcimBarrier.newLayout = state.newLayout;
+      srcimBarrier.dstAccessMask = MakeAccessMask(srcimBarrier.newLayout);
+      DoPipelineBarrier(cmd, 1, &srcimBarrier);
+    }
+
+    checkpoint.images.push_back(std::make_pair(id, contents));
+    checkpoint.contents.insert(GetResourceManager()->GetOriginalID(id));
+  }
+
+  vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  SubmitCmds();
+  FlushQ();
+
+  checkpoint.imageLayouts = m_ImageLayouts;
+
+  m_ReplayCheckpoints.used += checkpoint.size;
+
+  RDCDEBUG("Created replay checkpoint at event %u, %llu bytes", eventId, checkpoint.size);
+
+  auto it = std::lower_bound(
+      m_ReplayCheckpoints.checkpoints.begin(), m_ReplayCheckpoints.checkpoints.end(), eventId,
+      [](const ReplayCheckpoint &a, uint32_t eid) { return a.eventId < eid; });
+  m_ReplayCheckpoints.checkpoints.insert(it, std::move(checkpoint));
+
+  return true;
+}
+
+void WrappedVulkan::RestoreReplayCheckpoint(const ReplayCheckpoint &checkpoint)
+{
+  VkDevice d = GetDev();
+  VkResult vkr = VK_SUCCESS;
+
+  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+  VkCommandBuffer cmd = GetNextCmd();
+
+  vkr = ObjDisp(d)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  VkMemoryBarrier memBarrier = {
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, NULL, VK_ACCESS_ALL_WRITE_BITS,
+      VK_ACCESS_ALL_READ_BITS | VK_ACCESS_ALL_WRITE_BITS,
+  };
+
+  DoPipelineBarrier(cmd, 1, &memBarrier);
+
+  for(size_t i = 0; i < m_ReplayCheckpoints.memory.size(); i++)
+  {
+    const CheckpointMemory &mem = m_ReplayCheckpoints.memory[i];
+
+    std::vector<VkBufferCopy> regions = mem.ranges;
+    for(VkBufferCopy &region : regions)
+      std::swap(region.srcOffset, region.dstOffset);
+
+    ObjDisp(d)->CmdCopyBuffer(Unwrap(cmd), Unwrap(checkpoint.memory[i]), Unwrap(mem.wholeMemBuf),
+                              (uint32_t)regions.size(), regions.data());
+  }
+
+  // move every image into the layout it had at the checkpoint. We do this by hand rather than via
+  // ApplyBarriers since we know the exact previous layout of each subresource.
+  std::vector<VkImageMemoryBarrier> barriers;
+
+  for(auto it = checkpoint.imageLayouts.begin(); it != checkpoint.imageLayouts.end(); ++it)
+  {
+    auto cur = m_ImageLayouts.find(it->first);
+    if(cur == m_ImageLayouts.end() || !GetResourceManager()->HasCurrentResource(it->first))
+      continue;
+
+    VkImage im = Unwrap(GetResourceManager()->GetCurrentHandle<VkImage>(it->first));
+
+    for(const ImageRegionState &dst : it->second.subresourceStates)
+    {
+      if(dst.newLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
+         dst.newLayout == VK_IMAGE_LAYOUT_PREINITIALIZED ||
+         dst.newLayout == UNKNOWN_PREV_IMG_LAYOUT)
+        continue;
+
+      for(const ImageRegionState &src : cur->second.subresourceStates)
+      {
+        VkImageSubresourceRange range;
+
+        if(src.newLayout == dst.newLayout ||
+           !IntersectSubresourceRanges(it->second, src.subresourceRange, dst.subresourceRange,
+                                       range))
+          continue;
+
+        VkImageMemoryBarrier barrier = {
+            VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            NULL,
+            VK_ACCESS_ALL_WRITE_BITS,
+            MakeAccessMask(dst.newLayout),
+            src.newLayout == UNKNOWN_PREV_IMG_LAYOUT ? VK_IMAGE_LAYOUT_UNDEFINED : src.newLayout,
+            dst.newLayout,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            im,
+            range,
+        };
+
+        barriers.push_back(barrier);
+      }
+    }
+
+    cur->second = it->second;
+  }
+
+  if(!barriers.empty())
+    DoPipelineBarrier(cmd, (uint32_t)barriers.size(), barriers.data());
+
+  vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  // images are restored the same way as their initial contents, on top of the layouts above
+  for(const std::pair<ResourceId, VkInitialContents> &im : checkpoint.images)
+    Apply_InitialState(GetResourceManager()->GetCurrentResource(im.first), im.second);
+
+  cmd = GetNextCmd();
+
+  vkr = ObjDisp(d)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  DoPipelineBarrier(cmd, 1, &memBarrier);
+
+  vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  SubmitCmds();
+  FlushQ();
+}
+
+void WrappedVulkan::DestroyReplayCheckpoint(ReplayCheckpoint &checkpoint)
+{
+  VkDevice d = GetDev();
+
+  ObjDisp(d)->DeviceWaitIdle(Unwrap(d));
+
+  for(VkBuffer buf : checkpoint.memory)
+  {
+    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(buf), NULL);
+    GetResourceManager()->ReleaseWrappedResource(buf);
+  }
+
+  for(const MemoryAllocation &alloc : checkpoint.memoryAllocs)
+    FreeMemoryAllocation(alloc);
+
+  for(std::pair<ResourceId, VkInitialContents> &im : checkpoint.images)
+  {
+    if(im.second.buf != VK_NULL_HANDLE)
+    {
+      ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(im.second.buf), NULL);
+      GetResourceManager()->ReleaseWrappedResource(im.second.buf);
+    }
+
+    if(im.second.img != VK_NULL_HANDLE)
+    {
+      ObjDisp(d)->DestroyImage(Unwrap(d), Unwrap(im.second.img), NULL);
+      GetResourceManager()->ReleaseWrappedResource(im.second.img);
+    }
+
+    FreeMemoryAllocation(im.second.mem);
+  }
+
+  m_ReplayCheckpoints.used -= checkpoint.size;
+}
+
+void WrappedVulkan::ClearReplayCheckpoints()
+{
+  if(m_ReplayCheckpoints.checkpoints.empty())
+    return;
+
+  for(ReplayCheckpoint &checkpoint : m_ReplayCheckpoints.checkpoints)
+    DestroyReplayCheckpoint(checkpoint);
+
+  FreeAllMemory(MemoryScope::ReplayCheckpoints);
+
+  m_ReplayCheckpoints.checkpoints.clear();
+  m_ReplayCheckpoints.used = 0;
+  m_ReplayCheckpoints.full = false;
+}
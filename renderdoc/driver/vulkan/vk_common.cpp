@@ -267,6 +267,11 @@ bool VkInitParams::IsSupportedVersion(uint64_t ver)
   if(ver == CurrentVersion)
     return true;
 
+  // 0xF -> 0x10 - sparse initial contents store all-zero and duplicate pages as references, and
+  // serialise the page table for them
+  if(ver == 0xF)
+    return true;
+
   // 0xE -> 0xF - serialisation of VkPhysicalDeviceVulkanMemoryModelFeaturesKHR changed in vulkan
   // 1.1.99, adding a new field
   if(ver == 0xE)
@@ -889,7 +894,7 @@ void DescriptorSetSlot::AddBindRefs(VkResourceRecord *record, FrameRefType ref)
                             GetRecord(imageInfo.imageView)->resInfo != NULL);
     record->AddBindFrameRef(GetRecord(imageInfo.imageView)->baseResource, ref);
     if(GetRecord(imageInfo.imageView)->baseResourceMem != ResourceId())
-      record->AddBindFrameRef(GetRecord(imageInfo.imageView)->baseResourceMem, eFrameRef_Read);
+      record->AddBindMemoryRef(GetRecord(imageInfo.imageView)->baseResourceMem, eFrameRef_Read);
   }
   if(imageInfo.sampler != VK_NULL_HANDLE)
   {
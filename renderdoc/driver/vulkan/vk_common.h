@@ -319,6 +319,9 @@ enum class MemoryScope : uint8_t
   InitialContents,
   First = InitialContents,
   IndirectReadback,
+  ReplayCheckpoints,
+  PostVS,
+  TextureReadback,
   Count,
 };
 
@@ -345,6 +348,19 @@ struct MemoryAllocation
   bool buffer = false;
 };
 
+struct MemoryStatistics
+{
+  // how many blocks have been allocated from the driver, and their total size
+  uint32_t blockCount = 0;
+  VkDeviceSize blockBytes = 0;
+  // how much of that is currently handed out
+  VkDeviceSize usedBytes = 0;
+  // the free space is split over this many ranges, the largest being this big. Compared to the
+  // total free space this shows how fragmented the memory is.
+  uint32_t freeRangeCount = 0;
+  VkDeviceSize largestFreeRange = 0;
+};
+
 #define IMPLEMENT_FUNCTION_SERIALISED(ret, func, ...) \
   ret func(__VA_ARGS__);                              \
   template <typename SerialiserType>                  \
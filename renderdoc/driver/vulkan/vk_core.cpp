@@ -104,6 +104,13 @@ WrappedVulkan::WrappedVulkan() : m_RenderState(this, &m_CreationInfo)
   else
   {
     m_State = CaptureState::BackgroundCapturing;
+
+    RenderDoc::Inst().RegisterChunkLookup(RDCDriver::Vulkan, &GetChunkName);
+
+    // this is opt-in since it's process-wide - every page in the process is write-protected each
+    // submit while capturing - and writes from other threads racing with a submit can be missed.
+    const char *trackWrites = Process::GetEnvVariable("RENDERDOC_VULKAN_TRACK_MAP_WRITES");
+    m_TrackMapWrites = trackWrites && trackWrites[0] == '1';
   }
 
   m_StructuredFile = &m_StoredStructuredData;
@@ -253,6 +260,33 @@ void WrappedVulkan::AddPendingCommandBuffer(VkCommandBuffer cmd)
   m_InternalCmds.pendingcmds.push_back(cmd);
 }
 
+void WrappedVulkan::AddCoherentMap(VkResourceRecord *memrecord)
+{
+  m_CoherentMapIndex[memrecord->GetResourceID()] = m_CoherentMaps.size();
+  m_CoherentMaps.push_back(memrecord);
+}
+
+bool WrappedVulkan::RemoveCoherentMap(VkResourceRecord *memrecord)
+{
+  auto it = m_CoherentMapIndex.find(memrecord->GetResourceID());
+  if(it == m_CoherentMapIndex.end())
+    return false;
+
+  // the order of maps doesn't matter, so move the last one into this slot
+  size_t idx = it->second;
+  m_CoherentMapIndex.erase(it);
+
+  if(idx + 1 < m_CoherentMaps.size())
+  {
+    m_CoherentMaps[idx] = m_CoherentMaps.back();
+    m_CoherentMapIndex[m_CoherentMaps[idx]->GetResourceID()] = idx;
+  }
+
+  m_CoherentMaps.pop_back();
+
+  return true;
+}
+
 void WrappedVulkan::SubmitCmds(VkSemaphore *unwrappedWaitSemaphores,
                                VkPipelineStageFlags *waitStageMask, uint32_t waitSemaphoreCount)
 {
@@ -517,6 +551,25 @@ byte *WrappedVulkan::GetTempMemory(size_t s)
   return newmem->memory;
 }
 
+void WrappedVulkan::FreeTempMemory()
+{
+  TempMem *mem = (TempMem *)Threading::GetTLSValue(tempMemoryTLSSlot);
+  if(!mem)
+    return;
+
+  Threading::SetTLSValue(tempMemoryTLSSlot, NULL);
+
+  {
+    SCOPED_LOCK(m_ThreadTempMemLock);
+    auto it = std::find(m_ThreadTempMem.begin(), m_ThreadTempMem.end(), mem);
+    if(it != m_ThreadTempMem.end())
+      m_ThreadTempMem.erase(it);
+  }
+
+  delete[] mem->memory;
+  delete mem;
+}
+
 WriteSerialiser &WrappedVulkan::GetThreadSerialiser()
 {
   WriteSerialiser *ser = (WriteSerialiser *)Threading::GetTLSValue(threadSerialiserTLSSlot);
@@ -533,6 +586,7 @@ WriteSerialiser &WrappedVulkan::GetThreadSerialiser()
     flags |= WriteSerialiser::ChunkCallstack;
 
   ser->SetChunkMetadataRecording(flags);
+  ser->SetChunkDriver(RDCDriver::Vulkan);
   ser->SetUserData(GetResourceManager());
   ser->SetVersion(VkInitParams::CurrentVersion);
 
@@ -1388,6 +1442,9 @@ void WrappedVulkan::StartFrameCapture(void *dev, void *wnd)
 
     GetResourceManager()->PrepareInitialContents();
 
+    // wait for all the readbacks at once, rather than once per resource
+    FlushInitialStateCopies();
+
     RDCDEBUG("Attempting capture");
     m_FrameCaptureRecord->DeleteChunks();
 
@@ -1492,6 +1549,9 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
         FreeAlignedBuffer((*it)->memMapState->refData);
         (*it)->memMapState->refData = NULL;
         (*it)->memMapState->needRefData = false;
+        (*it)->memMapState->refHashes.clear();
+        (*it)->memMapState->writeTracked = false;
+        (*it)->memMapState->writtenRanges.clear();
       }
     }
   }
@@ -1692,26 +1752,76 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
   RDCFile *rdc =
       RenderDoc::Inst().CreateRDC(RDCDriver::Vulkan, m_CapturedFrames.back().frameNumber, fp);
 
-  StreamWriter *captureWriter = NULL;
+  SectionProperties props;
 
-  if(rdc)
-  {
-    SectionProperties props;
+  // Compress with LZ4 so that it's fast
+  props.flags = SectionFlags::LZ4Compressed;
+  props.version = m_SectionVersion;
+  props.type = SectionType::FrameCapture;
 
-    // Compress with LZ4 so that it's fast
-    props.flags = SectionFlags::LZ4Compressed;
-    props.version = m_SectionVersion;
-    props.type = SectionType::FrameCapture;
+  // gather up the frame's chunks and hand them over to be written out on a background thread, so we
+  // can return to the application sooner. Chunks that were already recorded are shared rather than
+  // copied, and only the initial contents and a few small chunks are serialised here.
+  std::vector<Chunk *> referencedChunks, frameChunks;
+
+  RDCDEBUG("Inserting Resource Serialisers");
+
+  GetResourceManager()->InsertReferencedChunks(referencedChunks);
+
+  // don't need to lock access to m_CmdBufferRecords as we are no longer
+  // in capframe (the transition is thread-protected) so nothing will be
+  // pushed to the vector
 
-    captureWriter = rdc->WriteSection(props);
-  }
-  else
   {
-    captureWriter = new StreamWriter(StreamWriter::InvalidStream);
+    RDCDEBUG("Flushing %u command buffer records to file serialiser",
+             (uint32_t)m_CmdBufferRecords.size());
+
+    std::map<int32_t, Chunk *> recordlist;
+
+    // ensure all command buffer records within the frame evne if recorded before, but
+    // otherwise order must be preserved (vs. queue submits and desc set updates)
+    for(size_t i = 0; i < m_CmdBufferRecords.size(); i++)
+    {
+      m_CmdBufferRecords[i]->Insert(recordlist);
+
+      RDCDEBUG("Adding %u chunks to file serialiser from command buffer %llu",
+               (uint32_t)recordlist.size(), m_CmdBufferRecords[i]->GetResourceID());
+    }
+
+    m_FrameCaptureRecord->Insert(recordlist);
+
+    RDCDEBUG("Flushing %u chunks to file serialiser from context record",
+             (uint32_t)recordlist.size());
+
+    float num = float(recordlist.size());
+    float idx = 0.0f;
+
+    frameChunks.reserve(recordlist.size());
+
+    for(auto it = recordlist.begin(); it != recordlist.end(); ++it)
+    {
+      RenderDoc::Inst().SetProgress(CaptureProgress::SerialiseFrameContents, idx / num);
+      idx += 1.0f;
+      frameChunks.push_back(it->second->Share());
+    }
+
+    RDCDEBUG("Done");
   }
 
+  // wait for room to hold this frame before serialising anything more
+  uint64_t reservedSize = 0;
+
+  for(Chunk *chunk : referencedChunks)
+    reservedSize += chunk->GetLength();
+  for(Chunk *chunk : frameChunks)
+    reservedSize += chunk->GetLength();
+
+  RenderDoc::Inst().ReserveCaptureWriting(reservedSize);
+
+  std::vector<Chunk *> chunks;
+
   {
-    WriteSerialiser ser(captureWriter, Ownership::Stream);
+    WriteSerialiser ser(new StreamWriter(1024 * 1024), Ownership::Stream);
 
     ser.SetChunkMetadataRecording(GetThreadSerialiser().GetChunkMetadataRecording());
 
@@ -1723,11 +1833,11 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
       SERIALISE_ELEMENT(m_InitParams);
     }
 
-    RDCDEBUG("Inserting Resource Serialisers");
+    chunks.push_back(new Chunk(ser, (uint32_t)SystemChunk::DriverInit));
 
-    GetResourceManager()->InsertReferencedChunks(ser);
+    chunks.insert(chunks.end(), referencedChunks.begin(), referencedChunks.end());
 
-    GetResourceManager()->InsertInitialContentsChunks(ser);
+    GetResourceManager()->InsertInitialContentsChunks(ser, chunks);
 
     RDCDEBUG("Creating Capture Scope");
 
@@ -1740,50 +1850,16 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
       Serialise_CaptureScope(ser);
     }
 
-    m_HeaderChunk->Write(ser);
-
-    // don't need to lock access to m_CmdBufferRecords as we are no longer
-    // in capframe (the transition is thread-protected) so nothing will be
-    // pushed to the vector
-
-    {
-      RDCDEBUG("Flushing %u command buffer records to file serialiser",
-               (uint32_t)m_CmdBufferRecords.size());
-
-      std::map<int32_t, Chunk *> recordlist;
-
-      // ensure all command buffer records within the frame evne if recorded before, but
-      // otherwise order must be preserved (vs. queue submits and desc set updates)
-      for(size_t i = 0; i < m_CmdBufferRecords.size(); i++)
-      {
-        m_CmdBufferRecords[i]->Insert(recordlist);
-
-        RDCDEBUG("Adding %u chunks to file serialiser from command buffer %llu",
-                 (uint32_t)recordlist.size(), m_CmdBufferRecords[i]->GetResourceID());
-      }
-
-      m_FrameCaptureRecord->Insert(recordlist);
-
-      RDCDEBUG("Flushing %u chunks to file serialiser from context record",
-               (uint32_t)recordlist.size());
+    chunks.push_back(new Chunk(ser, (uint32_t)SystemChunk::CaptureScope));
 
-      float num = float(recordlist.size());
-      float idx = 0.0f;
+    chunks.push_back(m_HeaderChunk);
+    m_HeaderChunk = NULL;
 
-      for(auto it = recordlist.begin(); it != recordlist.end(); ++it)
-      {
-        RenderDoc::Inst().SetProgress(CaptureProgress::SerialiseFrameContents, idx / num);
-        idx += 1.0f;
-        it->second->Write(ser);
-      }
-
-      RDCDEBUG("Done");
-    }
+    chunks.insert(chunks.end(), frameChunks.begin(), frameChunks.end());
   }
 
-  RenderDoc::Inst().FinishCaptureWriting(rdc, m_CapturedFrames.back().frameNumber);
-
-  SAFE_DELETE(m_HeaderChunk);
+  RenderDoc::Inst().QueueCaptureWriting(rdc, props, chunks, reservedSize,
+                                        m_CapturedFrames.back().frameNumber);
 
   m_State = CaptureState::BackgroundCapturing;
 
@@ -1834,11 +1910,14 @@ bool WrappedVulkan::DiscardFrameCapture(void *dev, void *wnd)
         FreeAlignedBuffer((*it)->memMapState->refData);
         (*it)->memMapState->refData = NULL;
         (*it)->memMapState->needRefData = false;
+        (*it)->memMapState->refHashes.clear();
+        (*it)->memMapState->writeTracked = false;
+        (*it)->memMapState->writtenRanges.clear();
       }
     }
   }
 
-  SAFE_DELETE(m_HeaderChunk);
+  SAFE_RELEASE(m_HeaderChunk);
 
   // delete cmd buffers now - had to keep them alive until after serialiser flush.
   for(size_t i = 0; i < m_CmdBufferRecords.size(); i++)
@@ -1918,6 +1997,24 @@ void WrappedVulkan::AddResourceCurChunk(ResourceId id)
   AddResourceCurChunk(GetReplay()->GetResourceDesc(id));
 }
 
+// chunks that can be processed while pipelines are still waiting to be created, because they
+// can't refer to a pipeline. Any other chunk waits for the pending pipelines first.
+static bool IsPipelineIndependentChunk(VulkanChunk chunk)
+{
+  switch(chunk)
+  {
+    case VulkanChunk::vkCreateGraphicsPipelines:
+    case VulkanChunk::vkCreateComputePipelines:
+    case VulkanChunk::vkCreateShaderModule:
+    case VulkanChunk::vkCreatePipelineLayout:
+    case VulkanChunk::vkCreateDescriptorSetLayout:
+    case VulkanChunk::vkCreateSampler:
+    case VulkanChunk::vkCreateRenderPass:
+    case VulkanChunk::vkCreateRenderPass2KHR: return true;
+    default: return false;
+  }
+}
+
 ReplayStatus WrappedVulkan::ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers)
 {
   int sectionIdx = rdc->SectionIndex(SectionType::FrameCapture);
@@ -1977,6 +2074,9 @@ ReplayStatus WrappedVulkan::ReadLogInitialisation(RDCFile *rdc, bool storeStruct
     if(reader->IsErrored())
       return ReplayStatus::APIDataCorrupted;
 
+    if(!IsPipelineIndependentChunk(context) && !FlushPendingPipelines())
+      return m_FailedReplayStatus;
+
     bool success = ProcessChunk(ser, context);
 
     ser.EndChunk();
@@ -2022,6 +2122,9 @@ ReplayStatus WrappedVulkan::ReadLogInitialisation(RDCFile *rdc, bool storeStruct
       break;
   }
 
+  if(!FlushPendingPipelines())
+    return m_FailedReplayStatus;
+
 #if ENABLED(RDOC_DEVEL)
   for(auto it = chunkInfos.begin(); it != chunkInfos.end(); ++it)
   {
@@ -2071,6 +2174,9 @@ ReplayStatus WrappedVulkan::ReadLogInitialisation(RDCFile *rdc, bool storeStruct
 
   FreeAllMemory(MemoryScope::IndirectReadback);
 
+  if(!IsStructuredExporting(m_State))
+    InitReplayCheckpoints();
+
   return ReplayStatus::Succeeded;
 }
 
@@ -2119,6 +2225,15 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
     FlushQ();
   }
 
+  if(IsActiveReplaying(m_State) && !partial)
+  {
+    // restore on top of the frame-start image layouts set up above
+    if(m_ReplayCheckpoints.resumeEventID > 0)
+      RestoreReplayCheckpoint(*FindReplayCheckpoint(m_ReplayCheckpoints.resumeEventID));
+
+    m_ReplayCheckpoints.timer.Restart();
+  }
+
   m_RootEvents.clear();
 
   if(IsActiveReplaying(m_State))
@@ -2140,6 +2255,8 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
     // that we ended up selecting (the one that was closest)
     if(startEventID == endEventID && m_RootEventID != m_FirstEventID)
       m_FirstEventID = m_LastEventID = m_RootEventID;
+
+    BeginRerecordCache(partial);
   }
   else
   {
@@ -2149,6 +2266,10 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
     m_LastEventID = ~0U;
   }
 
+  // only replays that read every chunk from the start of the frame see the same resource
+  // replacements that loading did, so only they can add to the decoded command cache
+  m_CacheDecodedCommands = !IsStructuredExporting(m_State) && !partial && startEventID <= 1;
+
   if(!partial && !IsStructuredExporting(m_State))
     AddFrameTerminator(AMDRGPControl::GetBeginTag());
 
@@ -2186,9 +2307,16 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
     if(!success)
       return m_FailedReplayStatus;
 
-    RenderDoc::Inst().SetProgress(
-        LoadProgress::FrameEventsRead,
-        float(m_CurChunkOffset - startOffset) / float(ser.GetReader()->GetSize()));
+    // only consider checkpoints after submits that were executed in full
+    if(IsActiveReplaying(m_State) && !partial && chunktype == VulkanChunk::vkQueueSubmit &&
+       m_RootEventID <= endEventID)
+      UpdateReplayCheckpoints();
+
+    // progress is only reported while loading, no need to pay for it on every replay
+    if(IsLoading(m_State))
+      RenderDoc::Inst().SetProgress(
+          LoadProgress::FrameEventsRead,
+          float(m_CurChunkOffset - startOffset) / float(ser.GetReader()->GetSize()));
 
     if((SystemChunk)chunktype == SystemChunk::CaptureEnd)
       break;
@@ -2280,10 +2408,17 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
   m_RerecordCmds.clear();
   m_RerecordCmdList.clear();
 
+  EndRerecordCache();
+
+  m_CurRerecordCache = NULL;
+  m_CachedRerecordCmds.clear();
+
+  m_CacheDecodedCommands = false;
+
   return ReplayStatus::Succeeded;
 }
 
-void WrappedVulkan::ApplyInitialContents()
+void WrappedVulkan::ApplyInitialContents(const std::set<ResourceId> *skip)
 {
   // check that we have all external queues necessary
   for(size_t i = 0; i < m_ExternalQueues.size(); i++)
@@ -2331,7 +2466,10 @@ void WrappedVulkan::ApplyInitialContents()
   FlushQ();
 
   // actually apply the initial contents here
-  GetResourceManager()->ApplyInitialContents();
+  if(skip)
+    GetResourceManager()->ApplyInitialContentsExcept(*skip);
+  else
+    GetResourceManager()->ApplyInitialContents();
 
   // likewise again to make sure the initial states are all applied
   cmd = GetNextCmd();
@@ -2403,6 +2541,17 @@ bool WrappedVulkan::ContextProcessChunk(ReadSerialiser &ser, VulkanChunk chunk)
 
 bool WrappedVulkan::ProcessChunk(ReadSerialiser &ser, VulkanChunk chunk)
 {
+  // commands that were already decoded are replayed directly and their data is skipped over
+  if(IsActiveReplaying(m_State) && !m_DecodedCommands.empty())
+  {
+    auto it = m_DecodedCommands.find(m_CurChunkOffset);
+    if(it != m_DecodedCommands.end() && it->second.chunk == chunk)
+    {
+      ser.SkipCurrentChunk();
+      return ReplayDecodedCommand(it->second);
+    }
+  }
+
   switch(chunk)
   {
     case VulkanChunk::vkEnumeratePhysicalDevices:
@@ -2947,12 +3096,21 @@ void WrappedVulkan::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
 
   if(!partial)
   {
+    // if we can resume from a checkpoint, anything it restores doesn't need its initial contents
+    ReplayCheckpoint *checkpoint = FindReplayCheckpoint(
+        replayType == eReplay_WithoutDraw ? RDCMAX(1U, endEventID) - 1 : endEventID);
+
+    if(checkpoint)
+      checkpoint->lastUsed = ++m_ReplayCheckpoints.useCounter;
+
     VkMarkerRegion::Begin("!!!!RenderDoc Internal: ApplyInitialContents");
-    ApplyInitialContents();
+    ApplyInitialContents(checkpoint ? &checkpoint->contents : NULL);
     VkMarkerRegion::End();
 
     SubmitCmds();
     FlushQ();
+
+    m_ReplayCheckpoints.resumeEventID = checkpoint ? checkpoint->eventId : 0;
   }
 
   m_State = CaptureState::ActiveReplaying;
@@ -3033,6 +3191,8 @@ void WrappedVulkan::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
 
     ReplayStatus status = ReplayStatus::Succeeded;
 
+    m_ReplayType = replayType;
+
     if(replayType == eReplay_Full)
       status = ContextReplayLog(m_State, startEventID, endEventID, partial);
     else if(replayType == eReplay_WithoutDraw)
@@ -3044,6 +3204,8 @@ void WrappedVulkan::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
 
     RDCASSERTEQUAL(status, ReplayStatus::Succeeded);
 
+    m_ReplayCheckpoints.resumeEventID = 0;
+
     if(m_OutsideCmdBuffer != VK_NULL_HANDLE)
     {
       VkCommandBuffer cmd = m_OutsideCmdBuffer;
@@ -3082,6 +3244,16 @@ void WrappedVulkan::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
 #endif
   }
 
+  // a full replay, or a replay without the draw followed by only that draw, leaves everything
+  // exactly as it was at that event. Any other partial replay might not.
+  if(!partial)
+    m_ReplayedEventID = replayType == eReplay_Full ? endEventID : RDCMAX(1U, endEventID) - 1;
+  else if(replayType == eReplay_OnlyDraw && m_ReplayedEventID != ~0U &&
+          m_ReplayedEventID + 1 == endEventID)
+    m_ReplayedEventID = endEventID;
+  else
+    m_ReplayedEventID = ~0U;
+
   VkMarkerRegion::Set("!!!!RenderDoc Internal: Done replay");
 }
 
@@ -3363,6 +3535,10 @@ bool WrappedVulkan::InRerecordRange(ResourceId cmdid)
   if(m_OutsideCmdBuffer != VK_NULL_HANDLE)
     return true;
 
+  // cached command buffers are already recorded, they're only submitted
+  if(m_CachedRerecordCmds.find(cmdid) != m_CachedRerecordCmds.end())
+    return false;
+
   // if not, check if we're one of the actual partial command buffers and check to see if we're in
   // the range for their partial replay.
   for(int p = 0; p < ePartialNum; p++)
@@ -3384,6 +3560,9 @@ bool WrappedVulkan::HasRerecordCmdBuf(ResourceId cmdid)
   if(m_OutsideCmdBuffer != VK_NULL_HANDLE)
     return true;
 
+  if(m_CachedRerecordCmds.find(cmdid) != m_CachedRerecordCmds.end())
+    return false;
+
   return m_RerecordCmds.find(cmdid) != m_RerecordCmds.end();
 }
 
@@ -3407,6 +3586,34 @@ bool WrappedVulkan::ShouldUpdateRenderState(ResourceId cmdid, bool forcePrimary)
   return cmdid == m_Partial[Primary].partialParent;
 }
 
+bool WrappedVulkan::CanContinuePartialReplay(uint32_t startEventId, uint32_t eventId)
+{
+  // if a secondary is partial the primary's state isn't tracked.
+  if(m_Partial[Secondary].partialParent != ResourceId())
+    return false;
+
+  // a partial replay only restores render pass and pipeline state when it begins, anything else
+  // still active would be lost.
+  if(m_Partial[Primary].renderPassActive || m_RenderState.IsConditionalRenderingEnabled() ||
+     !m_RenderState.xfbcounters.empty())
+    return false;
+
+  // partial replays can only carry on within the same submission of a primary command buffer
+  for(auto it = m_Partial[Primary].cmdBufferSubmits.begin();
+      it != m_Partial[Primary].cmdBufferSubmits.end(); ++it)
+  {
+    const uint32_t length = m_BakedCmdBufferInfo[it->first].eventCount;
+
+    for(const Submission &submit : it->second)
+    {
+      if(submit.baseEvent <= startEventId && startEventId < submit.baseEvent + length)
+        return submit.baseEvent <= eventId && eventId < submit.baseEvent + length;
+    }
+  }
+
+  return false;
+}
+
 VkCommandBuffer WrappedVulkan::RerecordCmdBuf(ResourceId cmdid, PartialReplayIndex partialType)
 {
   if(m_OutsideCmdBuffer != VK_NULL_HANDLE)
@@ -3423,6 +3630,284 @@ VkCommandBuffer WrappedVulkan::RerecordCmdBuf(ResourceId cmdid, PartialReplayInd
   return it->second;
 }
 
+// how many distinct replays keep their re-recorded command buffers around. Flipping between a
+// handful of events is the common case when inspecting a capture.
+static const size_t MaxRerecordCacheEvents = 4;
+
+void WrappedVulkan::BeginRerecordCache(bool partial)
+{
+  m_CurRerecordCache = NULL;
+  m_CachedPartialRerecord = false;
+  m_CachedRerecordCmds.clear();
+
+  // partial replays record into an outside command buffer, and drawcall callbacks add their own
+  // work into the re-recorded command buffers so those can't be shared with normal replays.
+  if(partial || m_DrawcallCallback || m_OutsideCmdBuffer != VK_NULL_HANDLE)
+    return;
+
+  size_t idx = 0;
+  for(; idx < m_RerecordCache.size(); idx++)
+    if(m_RerecordCache[idx]->eventId == m_LastEventID &&
+       m_RerecordCache[idx]->replayType == m_ReplayType)
+      break;
+
+  if(idx == m_RerecordCache.size())
+  {
+    // evict the least recently used replay
+    while(m_RerecordCache.size() >= MaxRerecordCacheEvents)
+    {
+      FreeRerecordCache(m_RerecordCache.front());
+      m_RerecordCache.erase(m_RerecordCache.begin());
+    }
+
+    RerecordCache *cache = new RerecordCache(this, &m_CreationInfo);
+    cache->eventId = m_LastEventID;
+    cache->replayType = m_ReplayType;
+    m_RerecordCache.push_back(cache);
+  }
+  else
+  {
+    std::rotate(m_RerecordCache.begin() + idx, m_RerecordCache.begin() + idx + 1,
+                m_RerecordCache.end());
+  }
+
+  m_CurRerecordCache = m_RerecordCache.back();
+}
+
+void WrappedVulkan::EndRerecordCache()
+{
+  RerecordCache *cache = m_CurRerecordCache;
+
+  if(!cache || cache->partialCmds.empty())
+    return;
+
+  // recording the partial command buffers is what sets up the replay state, so when they came from
+  // the cache put back the state they left behind.
+  if(m_CachedPartialRerecord && cache->hasState)
+  {
+    m_RenderState = cache->renderState;
+
+    for(int p = 0; p < ePartialNum; p++)
+    {
+      m_Partial[p].partialParent = cache->partial[p].partialParent;
+      m_Partial[p].baseEvent = cache->partial[p].baseEvent;
+      m_Partial[p].renderPassActive = cache->partial[p].renderPassActive;
+    }
+
+    for(auto it = cache->cmdState.begin(); it != cache->cmdState.end(); ++it)
+      m_BakedCmdBufferInfo[it->first].state = it->second;
+
+    for(auto it = cache->pushDescriptors.begin(); it != cache->pushDescriptors.end(); ++it)
+    {
+      DescriptorSetInfo &setInfo = m_DescriptorSetState[it->first];
+
+      setInfo.clear();
+      setInfo.push = true;
+      setInfo.layout = it->second.layout;
+
+      if(setInfo.layout == ResourceId())
+        continue;
+
+      m_CreationInfo.m_DescSetLayout[setInfo.layout].CreateBindingsArray(setInfo.currentBindings);
+
+      for(size_t b = 0; b < it->second.bindings.size() && b < setInfo.currentBindings.size(); b++)
+        memcpy(setInfo.currentBindings[b], it->second.bindings[b].data(),
+               it->second.bindings[b].size() * sizeof(DescriptorSetSlot));
+    }
+  }
+  else if(!m_CachedPartialRerecord)
+  {
+    cache->renderState = m_RenderState;
+
+    for(int p = 0; p < ePartialNum; p++)
+    {
+      cache->partial[p].partialParent = m_Partial[p].partialParent;
+      cache->partial[p].baseEvent = m_Partial[p].baseEvent;
+      cache->partial[p].renderPassActive = m_Partial[p].renderPassActive;
+    }
+
+    cache->cmdState.clear();
+    cache->pushDescriptors.clear();
+
+    for(ResourceId cmd : cache->partialCmds)
+    {
+      const BakedCmdBufferInfo &cmdInfo = m_BakedCmdBufferInfo[cmd];
+
+      cache->cmdState[cmd] = cmdInfo.state;
+
+      for(int p = 0; p < 2; p++)
+      {
+        for(size_t i = 0; i < ARRAY_COUNT(cmdInfo.pushDescriptorID[p]); i++)
+        {
+          ResourceId setId = cmdInfo.pushDescriptorID[p][i];
+          const DescriptorSetInfo &setInfo = m_DescriptorSetState[setId];
+
+          RerecordCache::PushDescriptorState &push = cache->pushDescriptors[setId];
+          push.layout = setInfo.layout;
+
+          if(setInfo.layout == ResourceId())
+            continue;
+
+          const DescSetLayout &layout = m_CreationInfo.m_DescSetLayout[setInfo.layout];
+
+          push.bindings.resize(setInfo.currentBindings.size());
+          for(size_t b = 0; b < setInfo.currentBindings.size(); b++)
+          {
+            const DescriptorSetSlot *slots = setInfo.currentBindings[b];
+            push.bindings[b].assign(slots, slots + layout.bindings[b].descriptorCount);
+          }
+        }
+      }
+    }
+
+    cache->hasState = true;
+  }
+}
+
+void WrappedVulkan::FreeRerecordCache(RerecordCache *cache)
+{
+  for(VkEvent ev : cache->events)
+    ObjDisp(GetDev())->DestroyEvent(Unwrap(GetDev()), ev, NULL);
+
+  for(const std::pair<VkCommandPool, VkCommandBuffer> &rerecord : cache->cmdList)
+    vkFreeCommandBuffers(GetDev(), rerecord.first, 1, &rerecord.second);
+
+  delete cache;
+}
+
+void WrappedVulkan::AddRerecordEvent(VkCommandBuffer cmd, VkEvent ev)
+{
+  // events referenced from a cached command buffer live as long as it does
+  if(cmd != VK_NULL_HANDLE && m_CurRerecordCache &&
+     m_CurRerecordCache->rerecords.find(GetResID(cmd)) != m_CurRerecordCache->rerecords.end())
+    m_CurRerecordCache->events.push_back(ev);
+  else
+    m_CleanupEvents.push_back(ev);
+}
+
+VkCommandPool WrappedVulkan::GetRerecordPool(VkCommandPool pool)
+{
+  // cached command buffers outlive the replay, so they can't come from the application's pool which
+  // might be reset or destroyed by a later replayed call. Use our own pool for the same family.
+  auto it = m_CommandPoolFamily.find(GetResID(pool));
+
+  if(it != m_CommandPoolFamily.end() && it->second < m_ExternalQueues.size() &&
+     m_ExternalQueues[it->second].pool != VK_NULL_HANDLE)
+    return m_ExternalQueues[it->second].pool;
+
+  return pool;
+}
+
+void WrappedVulkan::ClearRerecordCache()
+{
+  if(m_RerecordCache.empty())
+    return;
+
+  ObjDisp(GetDev())->DeviceWaitIdle(Unwrap(GetDev()));
+
+  for(RerecordCache *cache : m_RerecordCache)
+    FreeRerecordCache(cache);
+
+  m_RerecordCache.clear();
+  m_CurRerecordCache = NULL;
+}
+
+byte *WrappedVulkan::AllocDecoded(size_t size)
+{
+  const size_t blockSize = 256 * 1024;
+
+  size = AlignUp16(size);
+
+  // anything too big for a block gets its own, kept at the front so the current block stays last
+  if(size > blockSize)
+  {
+    byte *ret = AllocAlignedBuffer(size);
+    m_DecodedBlocks.insert(m_DecodedBlocks.begin(), ret);
+    return ret;
+  }
+
+  if(m_DecodedBlocks.empty() || m_DecodedBlockUsed + size > blockSize)
+  {
+    m_DecodedBlocks.push_back(AllocAlignedBuffer(blockSize));
+    m_DecodedBlockUsed = 0;
+  }
+
+  byte *ret = m_DecodedBlocks.back() + m_DecodedBlockUsed;
+  m_DecodedBlockUsed += size;
+  return ret;
+}
+
+void WrappedVulkan::ClearDecodedCommands()
+{
+  m_DecodedCommands.clear();
+
+  for(byte *block : m_DecodedBlocks)
+    FreeAlignedBuffer(block);
+
+  m_DecodedBlocks.clear();
+  m_DecodedBlockUsed = 0;
+}
+
+bool WrappedVulkan::ReplayDecodedCommand(const DecodedCommand &cmd)
+{
+  switch(cmd.chunk)
+  {
+    case VulkanChunk::vkCmdDraw:
+    {
+      const DecodedCmdDraw &p = *(const DecodedCmdDraw *)cmd.params;
+      return Replay_vkCmdDraw(p.commandBuffer, p.vertexCount, p.instanceCount, p.firstVertex,
+                              p.firstInstance);
+    }
+    case VulkanChunk::vkCmdDrawIndexed:
+    {
+      const DecodedCmdDrawIndexed &p = *(const DecodedCmdDrawIndexed *)cmd.params;
+      return Replay_vkCmdDrawIndexed(p.commandBuffer, p.indexCount, p.instanceCount, p.firstIndex,
+                                     p.vertexOffset, p.firstInstance);
+    }
+    case VulkanChunk::vkCmdDispatch:
+    {
+      const DecodedCmdDispatch &p = *(const DecodedCmdDispatch *)cmd.params;
+      return Replay_vkCmdDispatch(p.commandBuffer, p.x, p.y, p.z);
+    }
+    case VulkanChunk::vkCmdBindPipeline:
+    {
+      const DecodedCmdBindPipeline &p = *(const DecodedCmdBindPipeline *)cmd.params;
+      return Replay_vkCmdBindPipeline(p.commandBuffer, p.pipelineBindPoint, p.pipeline);
+    }
+    case VulkanChunk::vkCmdBindDescriptorSets:
+    {
+      const DecodedCmdBindDescriptorSets &p = *(const DecodedCmdBindDescriptorSets *)cmd.params;
+      return Replay_vkCmdBindDescriptorSets(p.commandBuffer, p.pipelineBindPoint, p.layout,
+                                            p.firstSet, p.setCount, p.pDescriptorSets,
+                                            p.dynamicOffsetCount, p.pDynamicOffsets);
+    }
+    case VulkanChunk::vkCmdBindVertexBuffers:
+    {
+      const DecodedCmdBindVertexBuffers &p = *(const DecodedCmdBindVertexBuffers *)cmd.params;
+      return Replay_vkCmdBindVertexBuffers(p.commandBuffer, p.firstBinding, p.bindingCount,
+                                           p.pBuffers, p.pOffsets);
+    }
+    case VulkanChunk::vkCmdBindIndexBuffer:
+    {
+      const DecodedCmdBindIndexBuffer &p = *(const DecodedCmdBindIndexBuffer *)cmd.params;
+      return Replay_vkCmdBindIndexBuffer(p.commandBuffer, p.buffer, p.offset, p.indexType);
+    }
+    case VulkanChunk::vkCmdPipelineBarrier:
+    {
+      const DecodedCmdPipelineBarrier &p = *(const DecodedCmdPipelineBarrier *)cmd.params;
+      return Replay_vkCmdPipelineBarrier(p.commandBuffer, p.srcStageMask, p.destStageMask,
+                                         p.dependencyFlags, p.memoryBarrierCount,
+                                         p.pMemoryBarriers, p.bufferMemoryBarrierCount,
+                                         p.pBufferMemoryBarriers, p.imageMemoryBarrierCount,
+                                         p.pImageMemoryBarriers);
+    }
+    default: break;
+  }
+
+  RDCERR("Unexpected decoded command %s", ToStr(cmd.chunk).c_str());
+  return false;
+}
+
 void WrappedVulkan::AddDrawcall(const DrawcallDescription &d, bool hasEvents)
 {
   m_AddedDrawcall = true;
@@ -3800,13 +4285,15 @@ void WrappedVulkan::AddEvent()
 
 const APIEvent &WrappedVulkan::GetEvent(uint32_t eventId)
 {
-  for(const APIEvent &e : m_Events)
-  {
-    if(e.eventId >= eventId)
-      return e;
-  }
+  // events are sorted by eventId once loading is finished. This is called for every event in a
+  // partial replay so it needs to be better than a linear search.
+  auto it = std::lower_bound(m_Events.begin(), m_Events.end(), eventId,
+                             [](const APIEvent &e, uint32_t id) { return e.eventId < id; });
+
+  if(it == m_Events.end())
+    return m_Events.back();
 
-  return m_Events.back();
+  return *it;
 }
 
 const DrawcallDescription *WrappedVulkan::GetDrawcall(uint32_t eventId)
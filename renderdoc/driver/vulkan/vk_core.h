@@ -55,7 +55,7 @@ struct VkInitParams
   uint32_t GetSerialiseSize();
 
   // check if a frame capture section version is supported
-  static const uint64_t CurrentVersion = 0xF;
+  static const uint64_t CurrentVersion = 0x10;
   static bool IsSupportedVersion(uint64_t ver);
 };
 
@@ -464,12 +464,107 @@ private:
     // -> FlushQ() ----back to freesems-------^
   } m_InternalCmds;
 
+  // initial state readbacks are recorded into their own command buffers but not waited on
+  // individually. They're submitted in groups, and the temporary objects used for the copies are
+  // destroyed once the whole batch has been flushed.
+  struct
+  {
+    uint32_t pendingCopies = 0;
+    uint32_t submittedCopies = 0;
+
+    vector<VkBuffer> buffers;
+    vector<VkImage> images;
+  } m_InitStateBatch;
+
+  // replay checkpoints, see vk_checkpoint.cpp. A checkpoint is a GPU-side snapshot of everything
+  // the frame has written up to the end of a queue submit, so that a later full replay can restore
+  // it and only execute the submits after it.
+  struct CheckpointMemory
+  {
+    ResourceId id;
+    VkBuffer wholeMemBuf;
+    // srcOffset is the offset in the memory, dstOffset the offset in the snapshot buffer
+    std::vector<VkBufferCopy> ranges;
+    VkDeviceSize size;
+  };
+
+  struct ReplayCheckpoint
+  {
+    uint32_t eventId = 0;
+    VkDeviceSize size = 0;
+    // when the checkpoint was last created or resumed from, for evicting the least recently used
+    uint64_t lastUsed = 0;
+
+    // original IDs of the resources restored from this checkpoint instead of initial contents
+    std::set<ResourceId> contents;
+    std::map<ResourceId, ImageLayouts> imageLayouts;
+    std::vector<std::pair<ResourceId, VkInitialContents> > images;
+    // one snapshot buffer and its allocation per entry in m_ReplayCheckpoints.memory
+    std::vector<VkBuffer> memory;
+    std::vector<MemoryAllocation> memoryAllocs;
+  };
+
+  struct
+  {
+    bool supported = false;
+    // set while loading if the frame changes sparse bindings, which we don't snapshot
+    bool sparseBinds = false;
+
+    VkDeviceSize budget = 0;
+    VkDeviceSize used = 0;
+    // set once a single checkpoint is bigger than the whole budget, no more are taken after that
+    // until they're cleared
+    bool full = false;
+    uint64_t useCounter = 0;
+
+    // the amount of replay time in milliseconds to allow between checkpoints. Adapted to the
+    // measured cost of taking a checkpoint so that snapshotting never dominates replay time.
+    double interval = 0.0;
+    PerformanceTimer timer;
+
+    // the checkpoint the current replay resumed from, submits up to and including this event are
+    // skipped.
+    uint32_t resumeEventID = 0;
+
+    std::vector<CheckpointMemory> memory;
+    // live image ID and the first event that writes to it
+    std::vector<std::pair<ResourceId, uint32_t> > images;
+
+    // sorted by eventId
+    std::vector<ReplayCheckpoint> checkpoints;
+  } m_ReplayCheckpoints;
+
+  void InitReplayCheckpoints();
+  ReplayCheckpoint *FindReplayCheckpoint(uint32_t endEventID);
+  void UpdateReplayCheckpoints();
+  bool CreateReplayCheckpoint(uint32_t eventId);
+  void DestroyReplayCheckpoint(ReplayCheckpoint &checkpoint);
+  void RestoreReplayCheckpoint(const ReplayCheckpoint &checkpoint);
+  bool IsCheckpointedEvent(uint32_t eventId) const
+  {
+    return eventId <= m_ReplayCheckpoints.resumeEventID;
+  }
+
   // Internal lumped/pooled memory allocations
 
-  // Each memory scope gets a separate vector of allocation objects. The vector contains the list of
-  // all 'base' allocations. The offset is used to indicate the current offset, and the size is the
-  // total size, thus the free space can be determined with size - offset.
-  std::vector<MemoryAllocation> m_MemoryBlocks[arraydim<MemoryScope>()];
+  // Each memory scope gets a separate list of 'base' allocations, which are sub-allocated from.
+  // Each block only holds buffers or only images, so that bufferImageGranularity never applies
+  // within a block.
+  struct MemoryBlock
+  {
+    // the whole block. offs is unused
+    MemoryAllocation alloc;
+    VkDeviceSize used = 0;
+    // the free ranges in the block, looked up by offset and by size. Adjacent free ranges are
+    // always merged together.
+    std::map<VkDeviceSize, VkDeviceSize> freeByOffset;
+    std::multimap<VkDeviceSize, VkDeviceSize> freeBySize;
+
+    void AddFreeRange(VkDeviceSize offs, VkDeviceSize size);
+    void RemoveFreeRange(std::map<VkDeviceSize, VkDeviceSize>::iterator it);
+    bool SubAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offs);
+  };
+  std::vector<MemoryBlock> m_MemoryBlocks[arraydim<MemoryScope>()];
 
   // Per memory scope, the size of the next allocation. This allows us to balance number of memory
   // allocation objects with size by incrementally allocating larger blocks.
@@ -479,6 +574,7 @@ private:
   MemoryAllocation AllocateMemoryForResource(VkBuffer buf, MemoryScope scope, MemoryType type);
   void FreeAllMemory(MemoryScope scope);
   void FreeMemoryAllocation(MemoryAllocation alloc);
+  MemoryStatistics GetMemoryStatistics(MemoryScope scope);
 
   // internal implementation - call one of the functions above
   MemoryAllocation AllocateMemoryForResource(bool buffer, VkMemoryRequirements mrq,
@@ -659,6 +755,73 @@ private:
   // above map
   std::vector<std::pair<VkCommandPool, VkCommandBuffer>> m_RerecordCmdList;
 
+  // re-recorded command buffers only depend on the event and type of replay, so they're kept for
+  // the last few replays and resubmitted as-is when we come back to one. Partially re-recorded
+  // command buffers also build up the replay state as they're recorded, so that's kept with them.
+  struct RerecordCache
+  {
+    RerecordCache(WrappedVulkan *driver, VulkanCreationInfo *creationInfo)
+        : renderState(driver, creationInfo)
+    {
+    }
+
+    uint32_t eventId = 0;
+    ReplayLogType replayType = eReplay_Full;
+    // baked command buffer ID -> re-recorded command buffer, as in m_RerecordCmds
+    std::map<ResourceId, VkCommandBuffer> cmds;
+    // the IDs of the re-recorded command buffers themselves
+    std::set<ResourceId> rerecords;
+    std::vector<std::pair<VkCommandPool, VkCommandBuffer>> cmdList;
+    // events waited on by the cached command buffers, see vkCmdPipelineBarrier
+    std::vector<VkEvent> events;
+
+    // baked IDs of the partially re-recorded command buffers
+    std::vector<ResourceId> partialCmds;
+
+    // the replay state as it was after recording the partial command buffers
+    bool hasState = false;
+    VulkanRenderState renderState;
+    struct
+    {
+      ResourceId partialParent;
+      uint32_t baseEvent = 0;
+      bool renderPassActive = false;
+    } partial[ePartialNum];
+    std::map<ResourceId, BakedCmdBufferInfo::CmdBufferState> cmdState;
+    struct PushDescriptorState
+    {
+      ResourceId layout;
+      std::vector<std::vector<DescriptorSetSlot>> bindings;
+    };
+    std::map<ResourceId, PushDescriptorState> pushDescriptors;
+  };
+
+  // most recently used at the back
+  std::vector<RerecordCache *> m_RerecordCache;
+
+  // the cache for the current replay, or NULL if this replay can't use it
+  RerecordCache *m_CurRerecordCache = NULL;
+
+  // whether a partial command buffer came from the cache this replay, so its state must be restored
+  bool m_CachedPartialRerecord = false;
+
+  // IDs (baked and non-baked, as in m_RerecordCmds) of cached command buffers that are being
+  // resubmitted this replay, and must not be recorded into
+  std::set<ResourceId> m_CachedRerecordCmds;
+
+  // the type of replay being done, for looking up the re-record cache
+  ReplayLogType m_ReplayType = eReplay_Full;
+
+  // live command pool ID -> the queue family it allocates for. Cached command buffers are allocated
+  // from our own pool for the family, so they aren't affected by the application's pool.
+  std::map<ResourceId, uint32_t> m_CommandPoolFamily;
+
+  void BeginRerecordCache(bool partial);
+  void EndRerecordCache();
+  void FreeRerecordCache(RerecordCache *cache);
+  void AddRerecordEvent(VkCommandBuffer cmd, VkEvent ev);
+  VkCommandPool GetRerecordPool(VkCommandPool pool);
+
   // There is only a state while currently partially replaying, it's
   // undefined/empty otherwise.
   // All IDs are original IDs, not live.
@@ -669,6 +832,142 @@ private:
   bool ShouldUpdateRenderState(ResourceId cmdid, bool forcePrimary = false);
   VkCommandBuffer RerecordCmdBuf(ResourceId cmdid, PartialReplayIndex partialType = ePartialNum);
 
+  // the most common commands are kept decoded after they're first read, keyed by the chunk's offset
+  // in the frame, so later replays can skip deserialising them. Decoded handles have resource
+  // replacements already applied, so the cache is dropped when those change and only refilled by
+  // replays that read the frame from the start. Anything else goes through the serialiser.
+  struct DecodedCmdDraw
+  {
+    VkCommandBuffer commandBuffer;
+    uint32_t vertexCount, instanceCount, firstVertex, firstInstance;
+  };
+
+  struct DecodedCmdDrawIndexed
+  {
+    VkCommandBuffer commandBuffer;
+    uint32_t indexCount, instanceCount, firstIndex;
+    int32_t vertexOffset;
+    uint32_t firstInstance;
+  };
+
+  struct DecodedCmdDispatch
+  {
+    VkCommandBuffer commandBuffer;
+    uint32_t x, y, z;
+  };
+
+  struct DecodedCmdBindPipeline
+  {
+    VkCommandBuffer commandBuffer;
+    VkPipelineBindPoint pipelineBindPoint;
+    VkPipeline pipeline;
+  };
+
+  struct DecodedCmdBindDescriptorSets
+  {
+    VkCommandBuffer commandBuffer;
+    VkPipelineBindPoint pipelineBindPoint;
+    VkPipelineLayout layout;
+    uint32_t firstSet, setCount;
+    const VkDescriptorSet *pDescriptorSets;
+    uint32_t dynamicOffsetCount;
+    const uint32_t *pDynamicOffsets;
+  };
+
+  struct DecodedCmdBindVertexBuffers
+  {
+    VkCommandBuffer commandBuffer;
+    uint32_t firstBinding, bindingCount;
+    const VkBuffer *pBuffers;
+    const VkDeviceSize *pOffsets;
+  };
+
+  struct DecodedCmdBindIndexBuffer
+  {
+    VkCommandBuffer commandBuffer;
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    VkIndexType indexType;
+  };
+
+  // only barriers without any pNext chains are cached
+  struct DecodedCmdPipelineBarrier
+  {
+    VkCommandBuffer commandBuffer;
+    VkPipelineStageFlags srcStageMask, destStageMask;
+    VkDependencyFlags dependencyFlags;
+    uint32_t memoryBarrierCount;
+    const VkMemoryBarrier *pMemoryBarriers;
+    uint32_t bufferMemoryBarrierCount;
+    const VkBufferMemoryBarrier *pBufferMemoryBarriers;
+    uint32_t imageMemoryBarrierCount;
+    const VkImageMemoryBarrier *pImageMemoryBarriers;
+  };
+
+  struct DecodedCommand
+  {
+    VulkanChunk chunk;
+    const void *params;
+  };
+
+  std::map<uint64_t, DecodedCommand> m_DecodedCommands;
+
+  // decoded parameters and their arrays are allocated linearly from these blocks, which are only
+  // freed when the whole cache is dropped
+  std::vector<byte *> m_DecodedBlocks;
+  size_t m_DecodedBlockUsed = 0;
+
+  // whether commands decoded in the current replay can be added to the cache
+  bool m_CacheDecodedCommands = false;
+
+  byte *AllocDecoded(size_t size);
+
+  template <typename T>
+  const T *CopyDecoded(const T *src, uint32_t count)
+  {
+    if(src == NULL || count == 0)
+      return NULL;
+
+    T *ret = (T *)AllocDecoded(sizeof(T) * count);
+    memcpy(ret, src, sizeof(T) * count);
+    return ret;
+  }
+
+  template <typename T>
+  void CacheDecodedCommand(VulkanChunk chunk, const T &params)
+  {
+    T *copy = (T *)AllocDecoded(sizeof(T));
+    *copy = params;
+    m_DecodedCommands[m_CurChunkOffset] = {chunk, copy};
+  }
+
+  bool ReplayDecodedCommand(const DecodedCommand &cmd);
+
+  bool Replay_vkCmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount,
+                        uint32_t firstVertex, uint32_t firstInstance);
+  bool Replay_vkCmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount,
+                               uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset,
+                               uint32_t firstInstance);
+  bool Replay_vkCmdDispatch(VkCommandBuffer commandBuffer, uint32_t x, uint32_t y, uint32_t z);
+  bool Replay_vkCmdBindPipeline(VkCommandBuffer commandBuffer,
+                                VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline);
+  bool Replay_vkCmdBindDescriptorSets(VkCommandBuffer commandBuffer,
+                                      VkPipelineBindPoint pipelineBindPoint,
+                                      VkPipelineLayout layout, uint32_t firstSet, uint32_t setCount,
+                                      const VkDescriptorSet *pDescriptorSets,
+                                      uint32_t dynamicOffsetCount, const uint32_t *pDynamicOffsets);
+  bool Replay_vkCmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32_t firstBinding,
+                                     uint32_t bindingCount, const VkBuffer *pBuffers,
+                                     const VkDeviceSize *pOffsets);
+  bool Replay_vkCmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer,
+                                   VkDeviceSize offset, VkIndexType indexType);
+  bool Replay_vkCmdPipelineBarrier(
+      VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask,
+      VkPipelineStageFlags destStageMask, VkDependencyFlags dependencyFlags,
+      uint32_t memoryBarrierCount, const VkMemoryBarrier *pMemoryBarriers,
+      uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier *pBufferMemoryBarriers,
+      uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier *pImageMemoryBarriers);
+
   // this info is stored in the record on capture, but we
   // need it on replay too
   struct DescriptorSetInfo
@@ -693,10 +992,26 @@ private:
 
   ResourceId m_LastSwap;
 
-  // holds the current list of coherent mapped memory. Locked against concurrent use
+  // holds the current list of coherent mapped memory, and the index of each memory in the list so
+  // that submits can find the maps they reference without walking them all. Locked against
+  // concurrent use
   vector<VkResourceRecord *> m_CoherentMaps;
+  std::map<ResourceId, size_t> m_CoherentMapIndex;
   Threading::CriticalSection m_CoherentMapsLock;
 
+  // these must be called with m_CoherentMapsLock held
+  void AddCoherentMap(VkResourceRecord *memrecord);
+  bool RemoveCoherentMap(VkResourceRecord *memrecord);
+
+  // if enabled (with RENDERDOC_VULKAN_TRACK_MAP_WRITES=1) and supported by the OS, coherent maps use
+  // OS page write tracking to find what to serialise on submit instead of comparing to a copy.
+  bool m_TrackMapWrites = false;
+
+  // scratch ranges for flushing coherent maps on submit, kept to avoid an allocation per submit.
+  // Locked since submits can come from several threads
+  std::vector<VkMappedMemoryRange> m_CoherentFlushRanges;
+  Threading::CriticalSection m_CoherentFlushRangesLock;
+
   // used both on capture and replay side to track image layouts. Only locked
   // in capture
   map<ResourceId, ImageLayouts> m_ImageLayouts;
@@ -783,6 +1098,8 @@ private:
 
   bool Prepare_SparseInitialState(WrappedVkBuffer *buf);
   bool Prepare_SparseInitialState(WrappedVkImage *im);
+  void BatchInitialStateCopy();
+  void FlushInitialStateCopies();
   template <typename SerialiserType>
   bool Serialise_SparseBufferInitialState(SerialiserType &ser, ResourceId id,
                                           VkInitialContents contents);
@@ -791,8 +1108,11 @@ private:
                                          VkInitialContents contents);
   bool Apply_SparseInitialState(WrappedVkBuffer *buf, VkInitialContents contents);
   bool Apply_SparseInitialState(WrappedVkImage *im, VkInitialContents contents);
+  void Apply_SparseMemoryContents(VkCommandBuffer cmd, VkBuffer srcBuf,
+                                  const MemIDOffset *memDataOffs, uint32_t numUniqueMems,
+                                  const uint32_t *pageRefs, uint32_t numPageRefs);
 
-  void ApplyInitialContents();
+  void ApplyInitialContents(const std::set<ResourceId> *skip = NULL);
 
   vector<APIEvent> m_RootEvents, m_Events;
   bool m_AddedDrawcall;
@@ -802,8 +1122,39 @@ private:
   uint32_t m_RootEventID, m_RootDrawcallID;
   uint32_t m_FirstEventID, m_LastEventID;
 
+  // the event that resource contents currently match, if everything up to it has been replayed
+  // exactly once and in order. ~0U after any replay that leaves contents in some other state.
+  uint32_t m_ReplayedEventID = ~0U;
+
   ReplayStatus m_FailedReplayStatus = ReplayStatus::APIReplayFailed;
 
+  // while loading, pipelines are not created as their chunks are read. They're queued up here and
+  // created in parallel in FlushPendingPipelines, before any chunk that could use them.
+  struct PendingPipeline
+  {
+    ResourceId Pipeline;
+    VkDevice device = VK_NULL_HANDLE;
+    VkPipelineCache origCache = VK_NULL_HANDLE;
+    VkRenderPass origRP = VK_NULL_HANDLE;
+    VkRenderPass subpass0RP = VK_NULL_HANDLE;
+
+    bool compute = false;
+    // these own the deserialised data until the pipeline is finished
+    VkGraphicsPipelineCreateInfo graphicsInfo = {};
+    VkComputePipelineCreateInfo computeInfo = {};
+
+    VkResult ret = VK_SUCCESS;
+    VkPipeline pipe = VK_NULL_HANDLE;
+    VkPipeline subpass0pipe = VK_NULL_HANDLE;
+  };
+
+  std::vector<PendingPipeline> m_PendingPipelines;
+  bool m_PendingPipelinesFailed = false;
+
+  bool DeferPipelineCreation();
+  void CreatePendingPipeline(PendingPipeline &pending);
+  bool FinishPendingPipeline(PendingPipeline &pending);
+
   VulkanDrawcallTreeNode m_ParentDrawcall;
 
   bool m_ExtensionsEnabled[VkCheckExt_Max] = {};
@@ -893,6 +1244,17 @@ public:
   }
   void Shutdown();
   void ReplayLog(uint32_t startEventID, uint32_t endEventID, ReplayLogType replayType);
+  uint32_t GetReplayedEventID() { return m_ReplayedEventID; }
+  void ClearReplayCheckpoints();
+  void ClearRerecordCache();
+  void ClearDecodedCommands();
+  bool FlushPendingPipelines();
+  void FlushPendingReflections();
+  // whether a partial replay that ended just before eventId, having started at startEventId, can
+  // carry on from there without replaying from the start of the frame again
+  bool CanContinuePartialReplay(uint32_t startEventId, uint32_t eventId);
+  // frees the calling thread's temporary memory, for short-lived threads before they exit
+  void FreeTempMemory();
   ReplayStatus ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers);
 
   SDFile &GetStructuredFile() { return *m_StructuredFile; }
@@ -165,7 +165,8 @@ static void create(WrappedVulkan *driver, const char *objName, const int line, V
       0,
   };
 
-  VkResult vkr = driver->vkCreateComputePipelines(driver->GetDev(), VK_NULL_HANDLE, 1,
+  VkResult vkr = driver->vkCreateComputePipelines(driver->GetDev(),
+                                                  driver->GetShaderCache()->GetPipeCache(), 1,
                                                   &compPipeInfo, NULL, pipe);
   if(vkr != VK_SUCCESS)
     RDCERR("Failed creating object %s at line %i, vkr was %s", objName, line, ToStr(vkr).c_str());
@@ -208,8 +209,8 @@ static void create(WrappedVulkan *driver, const char *objName, const int line, V
       0,
   };
 
-  vkr = driver->vkCreateComputePipelines(driver->GetDev(), VK_NULL_HANDLE, 1, &compPipeInfo, NULL,
-                                         pipe);
+  vkr = driver->vkCreateComputePipelines(driver->GetDev(), driver->GetShaderCache()->GetPipeCache(),
+                                         1, &compPipeInfo, NULL, pipe);
   if(vkr != VK_SUCCESS)
     RDCERR("Failed creating object %s at line %i, vkr was %s", objName, line, ToStr(vkr).c_str());
 
@@ -384,7 +385,8 @@ static void create(WrappedVulkan *driver, const char *objName, const int line, V
       -1,                // base pipeline index
   };
 
-  VkResult vkr = driver->vkCreateGraphicsPipelines(driver->GetDev(), VK_NULL_HANDLE, 1,
+  VkResult vkr = driver->vkCreateGraphicsPipelines(driver->GetDev(),
+                                                   driver->GetShaderCache()->GetPipeCache(), 1,
                                                    &graphicsPipeInfo, NULL, pipe);
   if(vkr != VK_SUCCESS)
     RDCERR("Failed creating object %s at line %i, vkr was %s", objName, line, ToStr(vkr).c_str());
@@ -1634,6 +1636,14 @@ void VulkanReplay::DestroyResources()
 {
   ClearPostVSCache();
 
+  m_pDriver->FreeAllMemory(MemoryScope::PostVS);
+
+  for(VkFence fence : m_ReadbackFences)
+    ObjDisp(m_Device)->DestroyFence(Unwrap(m_Device), fence, NULL);
+  m_ReadbackFences.clear();
+
+  m_pDriver->FreeAllMemory(MemoryScope::TextureReadback);
+
   m_General.Destroy(m_pDriver);
   m_TexRender.Destroy(m_pDriver);
   m_Overlay.Destroy(m_pDriver);
@@ -2567,6 +2577,33 @@ void VulkanReplay::HistogramMinMax::Destroy(WrappedVulkan *driver)
   m_HistogramBuf.Destroy();
   m_HistogramReadback.Destroy();
   m_HistogramUBO.Destroy();
+
+  ClearCache();
+}
+
+void VulkanReplay::HistogramMinMax::ClearCache()
+{
+  m_MinMaxCache.clear();
+  m_HistogramCache.clear();
+}
+
+void VulkanReplay::HistogramMinMax::ClearCache(ResourceId texid)
+{
+  for(auto it = m_MinMaxCache.begin(); it != m_MinMaxCache.end();)
+  {
+    if(it->first.texid == texid)
+      it = m_MinMaxCache.erase(it);
+    else
+      ++it;
+  }
+
+  for(auto it = m_HistogramCache.begin(); it != m_HistogramCache.end();)
+  {
+    if(it->first.texid == texid)
+      it = m_HistogramCache.erase(it);
+    else
+      ++it;
+  }
 }
 
 void VulkanReplay::PostVS::Destroy(WrappedVulkan *driver)
@@ -233,8 +233,7 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
 
     ShaderModule::Reflection &reflData = info.m_ShaderModule[id].m_Reflections[shad.entryPoint];
 
-    reflData.Init(resourceMan, id, info.m_ShaderModule[id].spirv, shad.entryPoint,
-                  pCreateInfo->pStages[i].stage);
+    reflData.Init(info, id, shad.entryPoint, pCreateInfo->pStages[i].stage);
 
     if(pCreateInfo->pStages[i].pSpecializationInfo)
     {
@@ -528,8 +527,7 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
 
     ShaderModule::Reflection &reflData = info.m_ShaderModule[id].m_Reflections[shad.entryPoint];
 
-    reflData.Init(resourceMan, id, info.m_ShaderModule[id].spirv, shad.entryPoint,
-                  pCreateInfo->stage.stage);
+    reflData.Init(info, id, shad.entryPoint, pCreateInfo->stage.stage);
 
     if(pCreateInfo->stage.pSpecializationInfo)
     {
@@ -981,8 +979,7 @@ void VulkanCreationInfo::ShaderModule::Init(VulkanResourceManager *resourceMan,
   }
 }
 
-void VulkanCreationInfo::ShaderModule::Reflection::Init(VulkanResourceManager *resourceMan,
-                                                        ResourceId id, const SPVModule &spv,
+void VulkanCreationInfo::ShaderModule::Reflection::Init(VulkanCreationInfo &info, ResourceId id,
                                                         const std::string &entry,
                                                         VkShaderStageFlagBits stage)
 {
@@ -991,17 +988,9 @@ void VulkanCreationInfo::ShaderModule::Reflection::Init(VulkanResourceManager *r
     entryPoint = entry;
     stageIndex = StageIndex(stage);
 
-    spv.MakeReflection(GraphicsAPI::Vulkan, ShaderStage(stageIndex), entryPoint, refl, mapping,
-                       patchData);
-
-    refl.resourceId = resourceMan->GetOriginalID(id);
-    refl.entryPoint = entryPoint;
-
-    if(!spv.spirv.empty())
-    {
-      refl.encoding = ShaderEncoding::SPIRV;
-      refl.rawBytes.assign((byte *)spv.spirv.data(), spv.spirv.size() * sizeof(uint32_t));
-    }
+    // reflecting is expensive, so it's batched up to be done across threads and looked up in the
+    // on-disk cache.
+    info.m_PendingReflections.push_back({id, this});
   }
 }
 
@@ -471,13 +471,18 @@ struct VulkanCreationInfo
       ShaderBindpointMapping mapping;
       SPIRVPatchData patchData;
 
-      void Init(VulkanResourceManager *resourceMan, ResourceId id, const SPVModule &spv,
-                const std::string &entry, VkShaderStageFlagBits stage);
+      // only sets up the reflection, the data itself is filled in by
+      // WrappedVulkan::FlushPendingReflections
+      void Init(VulkanCreationInfo &info, ResourceId id, const std::string &entry,
+                VkShaderStageFlagBits stage);
     };
     map<string, Reflection> m_Reflections;
   };
   map<ResourceId, ShaderModule> m_ShaderModule;
 
+  // reflections which have been set up but not filled in yet, with the module they come from
+  std::vector<std::pair<ResourceId, ShaderModule::Reflection *>> m_PendingReflections;
+
   struct DescSetPool
   {
     void Init(VulkanResourceManager *resourceMan, VulkanCreationInfo &info,
@@ -34,13 +34,59 @@
 // VKTODOLOW The code pattern for creating a few contiguous arrays all in one
 // AllocAlignedBuffer for the initial contents buffer is ugly.
 
-// VKTODOLOW in general we do a lot of "create buffer, use it, flush/sync then destroy".
-// I don't know what the exact cost is, but it would be nice to batch up the buffers/etc
-// used across init state use, and only do a single flush. Also we could then get some
-// nice command buffer reuse (although need to be careful we don't create too large a
-// command buffer that stalls the GPU).
+// Preparing initial states doesn't sync per-resource. Each readback is recorded into its own
+// command buffer and handed to BatchInitialStateCopy(), which submits them in groups so the GPU
+// can copy while we record the rest. Temporary buffers/images are kept alive until the single
+// FlushInitialStateCopies() at the end of PrepareInitialContents().
 // See INITSTATEBATCH
 
+// number of readbacks to record before submitting them
+static const uint32_t InitStateSubmitBatch = 32;
+// number of submitted readbacks to allow in flight before waiting and recycling, to bound the
+// number of command buffers and temporary objects alive at once.
+static const uint32_t InitStateFlushBatch = 1024;
+
+void WrappedVulkan::BatchInitialStateCopy()
+{
+  m_InitStateBatch.pendingCopies++;
+
+  if(m_InitStateBatch.pendingCopies >= InitStateSubmitBatch)
+  {
+    SubmitCmds();
+
+    m_InitStateBatch.submittedCopies += m_InitStateBatch.pendingCopies;
+    m_InitStateBatch.pendingCopies = 0;
+
+    if(m_InitStateBatch.submittedCopies >= InitStateFlushBatch)
+      FlushInitialStateCopies();
+  }
+}
+
+void WrappedVulkan::FlushInitialStateCopies()
+{
+  SubmitCmds();
+  FlushQ();
+
+  VkDevice d = GetDev();
+
+  for(VkBuffer buf : m_InitStateBatch.buffers)
+  {
+    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(buf), NULL);
+    GetResourceManager()->ReleaseWrappedResource(buf);
+  }
+
+  for(VkImage im : m_InitStateBatch.images)
+  {
+    ObjDisp(d)->DestroyImage(Unwrap(d), Unwrap(im), NULL);
+    GetResourceManager()->ReleaseWrappedResource(im);
+  }
+
+  m_InitStateBatch.buffers.clear();
+  m_InitStateBatch.images.clear();
+  m_InitStateBatch.pendingCopies = 0;
+  m_InitStateBatch.submittedCopies = 0;
+}
+
 bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
 {
   ResourceId id = GetResourceManager()->GetID(res);
@@ -506,18 +552,18 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // INITSTATEBATCH
-    SubmitCmds();
-    FlushQ();
-
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(dstBuf), NULL);
-    GetResourceManager()->ReleaseWrappedResource(dstBuf);
+    m_InitStateBatch.buffers.push_back(dstBuf);
 
     if(arrayIm != VK_NULL_HANDLE)
-    {
-      ObjDisp(d)->DestroyImage(Unwrap(d), Unwrap(arrayIm), NULL);
-      GetResourceManager()->ReleaseWrappedResource(arrayIm);
-    }
+      m_InitStateBatch.images.push_back(arrayIm);
+
+    // INITSTATEBATCH
+    // if we had to transfer ownership from another queue family, flush immediately so the image
+    // isn't left in limbo between queues.
+    if(extQCmd != VK_NULL_HANDLE)
+      FlushInitialStateCopies();
+    else
+      BatchInitialStateCopy();
 
     GetResourceManager()->SetInitialContents(id, VkInitialContents(type, readbackmem));
 
@@ -605,14 +651,11 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // INITSTATEBATCH
-    SubmitCmds();
-    FlushQ();
+    m_InitStateBatch.buffers.push_back(srcBuf);
+    m_InitStateBatch.buffers.push_back(dstBuf);
 
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(srcBuf), NULL);
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(dstBuf), NULL);
-    GetResourceManager()->ReleaseWrappedResource(srcBuf);
-    GetResourceManager()->ReleaseWrappedResource(dstBuf);
+    // INITSTATEBATCH
+    BatchInitialStateCopy();
 
     GetResourceManager()->SetInitialContents(id, VkInitialContents(type, readbackmem));
 
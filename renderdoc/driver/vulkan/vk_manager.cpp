@@ -39,7 +39,10 @@ void VulkanResourceManager::RecordSingleBarrier(vector<pair<ResourceId, ImageReg
 {
   bool done = false;
 
-  auto it = dststates.begin();
+  // the states are sorted by ID, so skip straight to the ones for this image
+  auto it = std::lower_bound(
+      dststates.begin(), dststates.end(), id,
+      [](const pair<ResourceId, ImageRegionState> &a, ResourceId b) { return a.first < b; });
   for(; it != dststates.end(); ++it)
   {
     // image barriers are handled by initially inserting one subresource range for each aspect,
@@ -507,6 +510,10 @@ void VulkanResourceManager::ApplyBarriers(uint32_t queueFamilyIndex,
           t.subresourceRange.baseArrayLayer, t.subresourceRange.layerCount,
           ToStr(t.oldLayout).c_str(), ToStr(t.newLayout).c_str());
 
+    // the common case, where we can go straight to the affected subresources
+    if(stit->second.ApplyBarrier(t, nummips, numslices))
+      continue;
+
     bool done = false;
 
     TRDBG("Matching image has %u subresource states", stit->second.subresourceStates.size());
@@ -763,6 +770,26 @@ std::vector<ResourceId> VulkanResourceManager::InitialContentResources()
   return resources;
 }
 
+void VulkanResourceManager::ApplyInitialContentsExcept(const std::set<ResourceId> &skip)
+{
+  std::vector<ResourceId> resources = InitialContentResources();
+  for(auto it = resources.begin(); it != resources.end(); ++it)
+  {
+    ResourceId id = *it;
+
+    if(skip.find(id) != skip.end())
+      continue;
+
+    Apply_InitialState(GetLiveResource(id), m_InitialContents[id]);
+  }
+}
+
+void VulkanResourceManager::FlushPendingPipelines()
+{
+  // any failure is remembered and reported when loading next checks
+  m_Core->FlushPendingPipelines();
+}
+
 bool VulkanResourceManager::ResourceTypeRelease(WrappedVkRes *res)
 {
   return m_Core->ReleaseResource(res);
@@ -50,6 +50,10 @@ struct SparseBufferInitState
   uint32_t numUniqueMems;
 
   VkDeviceSize totalSize;
+
+  // available on replay - where each page of the contents comes from, see CompactPages
+  uint32_t *pageRefs;
+  uint32_t numPageRefs;
 };
 
 DECLARE_REFLECTION_STRUCT(SparseBufferInitState);
@@ -74,6 +78,10 @@ struct SparseImageInitState
   uint32_t numUniqueMems;
 
   VkDeviceSize totalSize;
+
+  // available on replay - where each page of the contents comes from, see CompactPages
+  uint32_t *pageRefs;
+  uint32_t numPageRefs;
 };
 
 DECLARE_REFLECTION_STRUCT(SparseImageInitState);
@@ -138,11 +146,13 @@ struct VkInitialContents
           SAFE_DELETE_ARRAY(sparseImage.pageBinds[i]);
         }
         SAFE_DELETE_ARRAY(sparseImage.memDataOffs);
+        SAFE_DELETE_ARRAY(sparseImage.pageRefs);
       }
       else if(type == eResBuffer)
       {
         SAFE_DELETE_ARRAY(sparseBuffer.binds);
         SAFE_DELETE_ARRAY(sparseBuffer.memDataOffs);
+        SAFE_DELETE_ARRAY(sparseBuffer.pageRefs);
       }
     }
   }
@@ -432,6 +442,12 @@ public:
   MemRefs *FindMemRefs(ResourceId mem);
 
   inline bool OptimizeInitialState() { return m_OptimizeInitialState; }
+  // as ApplyInitialContents() but leaving alone any resources (by original ID) in skip
+  void ApplyInitialContentsExcept(const std::set<ResourceId> &skip);
+
+  // while loading, create any pipelines still queued in WrappedVulkan so they can be looked up
+  void FlushPendingPipelines();
+
 private:
   bool ResourceTypeRelease(WrappedVkRes *res);
 
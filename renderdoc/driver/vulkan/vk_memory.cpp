@@ -175,158 +175,179 @@ void WrappedVulkan::RemapMemoryIndices(VkPhysicalDeviceMemoryProperties *memProp
   }
 }
 
-MemoryAllocation WrappedVulkan::AllocateMemoryForResource(bool buffer, VkMemoryRequirements mrq,
-                                                          MemoryScope scope, MemoryType type)
+void WrappedVulkan::MemoryBlock::AddFreeRange(VkDeviceSize offs, VkDeviceSize size)
 {
-  MemoryAllocation ret;
-  ret.scope = scope;
-  ret.type = type;
-  ret.buffer = buffer;
-  ret.size = AlignUp(mrq.size, mrq.alignment);
+  if(size == 0)
+    return;
 
-  RDCDEBUG("Allocating 0x%llx with alignment 0x%llx in 0x%x for a %s (%s in %s)", ret.size,
-           mrq.alignment, mrq.memoryTypeBits, buffer ? "buffer" : "image", ToStr(type).c_str(),
-           ToStr(scope).c_str());
+  // merge with the following range, if it's adjacent
+  auto next = freeByOffset.lower_bound(offs);
+  if(next != freeByOffset.end() && offs + size == next->first)
+  {
+    size += next->second;
+    auto erase = next++;
+    RemoveFreeRange(erase);
+  }
 
-  std::vector<MemoryAllocation> &blockList = m_MemoryBlocks[(size_t)scope];
+  // and with the preceding range
+  if(next != freeByOffset.begin())
+  {
+    auto prev = std::prev(next);
+    if(prev->first + prev->second == offs)
+    {
+      offs = prev->first;
+      size += prev->second;
+      RemoveFreeRange(prev);
+    }
+  }
+
+  freeByOffset[offs] = size;
+  freeBySize.insert({size, offs});
+}
 
-  // first try to find a match
-  int i = 0;
-  for(MemoryAllocation &block : blockList)
+void WrappedVulkan::MemoryBlock::RemoveFreeRange(std::map<VkDeviceSize, VkDeviceSize>::iterator it)
+{
+  auto range = freeBySize.equal_range(it->second);
+  for(auto s = range.first; s != range.second; ++s)
   {
-    RDCDEBUG(
-        "Considering block %d: memory type %u and type %s. Total size 0x%llx, current offset "
-        "0x%llx, last alloc was %s",
-        i, block.memoryTypeIndex, ToStr(block.type).c_str(), block.size, block.offs,
-        block.buffer ? "buffer" : "image");
-    i++;
-
-    // skip this block if it's not the memory type we want
-    if(ret.type != block.type || (mrq.memoryTypeBits & (1 << block.memoryTypeIndex)) == 0)
+    if(s->second == it->first)
     {
-      RDCDEBUG("block type %d or memory type %d is incompatible", block.type, block.memoryTypeIndex);
-      continue;
+      freeBySize.erase(s);
+      break;
     }
+  }
 
-    // offs is where we can put our next sub-allocation
-    VkDeviceSize offs = block.offs;
+  freeByOffset.erase(it);
+}
 
-    // if we are on a buffer/image, account for any alignment we might have to do
-    if(ret.buffer != block.buffer)
-      offs = AlignUp(offs, m_PhysicalDeviceData.props.limits.bufferImageGranularity);
+bool WrappedVulkan::MemoryBlock::SubAllocate(VkDeviceSize size, VkDeviceSize alignment,
+                                             VkDeviceSize &offs)
+{
+  // best fit - find the smallest free range that the allocation fits in once aligned
+  for(auto it = freeBySize.lower_bound(size); it != freeBySize.end(); ++it)
+  {
+    VkDeviceSize rangeOffs = it->second, rangeSize = it->first;
 
-    // align as required by the resource
-    offs = AlignUp(offs, mrq.alignment);
+    VkDeviceSize alignedOffs = AlignUp(rangeOffs, alignment);
 
-    if(offs > block.size)
-    {
-      RDCDEBUG("Next offset 0x%llx would be off the end of the memory (size 0x%llx).", offs,
-               block.size);
+    if(alignedOffs + size > rangeOffs + rangeSize)
       continue;
-    }
 
-    VkDeviceSize avail = block.size - offs;
+    RemoveFreeRange(freeByOffset.find(rangeOffs));
 
-    RDCDEBUG("At next offset 0x%llx, there's 0x%llx bytes available for 0x%llx bytes requested",
-             offs, avail, ret.size);
+    // return anything left either side of the allocation
+    AddFreeRange(rangeOffs, alignedOffs - rangeOffs);
+    AddFreeRange(alignedOffs + size, rangeOffs + rangeSize - (alignedOffs + size));
 
-    // if the allocation will fit, we've found our candidate.
-    if(ret.size <= avail)
-    {
-      // update the block offset and buffer/image bit
-      block.offs = offs + ret.size;
-      block.buffer = ret.buffer;
+    used += size;
+    offs = alignedOffs;
+    return true;
+  }
 
-      // update our return value
-      ret.offs = offs;
-      ret.mem = block.mem;
+  return false;
+}
 
-      RDCDEBUG("Allocating using this block: 0x%llx -> 0x%llx", ret.offs, block.offs);
+MemoryAllocation WrappedVulkan::AllocateMemoryForResource(bool buffer, VkMemoryRequirements mrq,
+                                                          MemoryScope scope, MemoryType type)
+{
+  MemoryAllocation ret;
+  ret.scope = scope;
+  ret.type = type;
+  ret.buffer = buffer;
+  ret.size = AlignUp(mrq.size, mrq.alignment);
 
-      // stop searching
-      break;
-    }
-  }
+  std::vector<MemoryBlock> &blockList = m_MemoryBlocks[(size_t)scope];
 
-  if(ret.mem == VK_NULL_HANDLE)
+  // first try to find a block with space
+  for(MemoryBlock &block : blockList)
   {
-    RDCDEBUG("No available block found - allocating new block");
+    // skip this block if it's not the memory type or resource type we want
+    if(ret.type != block.alloc.type || ret.buffer != block.alloc.buffer ||
+       (mrq.memoryTypeBits & (1 << block.alloc.memoryTypeIndex)) == 0)
+      continue;
 
-    VkDeviceSize &allocSize = m_MemoryBlockSize[(size_t)scope];
+    if(block.alloc.size - block.used < ret.size)
+      continue;
 
-    // we start allocating 32M, then increment each time we need a new block.
-    switch(allocSize)
+    if(block.SubAllocate(ret.size, mrq.alignment, ret.offs))
     {
-      case 0: allocSize = 32; break;
-      case 32: allocSize = 64; break;
-      case 64: allocSize = 128; break;
-      case 128:
-      case 256: allocSize = 256; break;
-      default:
-        RDCDEBUG("Unexpected previous allocation size 0x%llx bytes, allocating 256MB", allocSize);
-        allocSize = 256;
-        break;
+      ret.mem = block.alloc.mem;
+      ret.memoryTypeIndex = block.alloc.memoryTypeIndex;
+      return ret;
     }
+  }
 
-    uint32_t memoryTypeIndex = 0;
+  VkDeviceSize &allocSize = m_MemoryBlockSize[(size_t)scope];
 
-    switch(ret.type)
-    {
-      case MemoryType::Upload: memoryTypeIndex = GetUploadMemoryIndex(mrq.memoryTypeBits); break;
-      case MemoryType::GPULocal:
-        memoryTypeIndex = GetGPULocalMemoryIndex(mrq.memoryTypeBits);
-        break;
-      case MemoryType::Readback:
-        memoryTypeIndex = GetReadbackMemoryIndex(mrq.memoryTypeBits);
-        break;
-    }
+  // we start allocating 32M, then increment each time we need a new block. Keeping the sizes to a
+  // few powers of two means freed blocks are easily reused for later allocations.
+  switch(allocSize)
+  {
+    case 0: allocSize = 32; break;
+    case 32: allocSize = 64; break;
+    case 64: allocSize = 128; break;
+    case 128:
+    case 256: allocSize = 256; break;
+    default:
+      RDCDEBUG("Unexpected previous allocation size 0x%llx bytes, allocating 256MB", allocSize);
+      allocSize = 256;
+      break;
+  }
 
-    VkMemoryAllocateInfo info = {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, allocSize * 1024 * 1024, memoryTypeIndex,
-    };
+  uint32_t memoryTypeIndex = 0;
+
+  switch(ret.type)
+  {
+    case MemoryType::Upload: memoryTypeIndex = GetUploadMemoryIndex(mrq.memoryTypeBits); break;
+    case MemoryType::GPULocal: memoryTypeIndex = GetGPULocalMemoryIndex(mrq.memoryTypeBits); break;
+    case MemoryType::Readback: memoryTypeIndex = GetReadbackMemoryIndex(mrq.memoryTypeBits); break;
+  }
 
+  VkMemoryAllocateInfo info = {
+      VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, allocSize * 1024 * 1024, memoryTypeIndex,
+  };
+
+  if(ret.size > info.allocationSize)
+  {
+    // if we get an over-sized allocation, first try to immediately jump to the largest block
+    // size.
+    allocSize = 256;
+    info.allocationSize = allocSize * 1024 * 1024;
+
+    // if it's still over-sized, just allocate precisely enough and give it a dedicated allocation
     if(ret.size > info.allocationSize)
     {
-      // if we get an over-sized allocation, first try to immediately jump to the largest block
-      // size.
-      allocSize = 256;
-      info.allocationSize = allocSize * 1024 * 1024;
-
-      // if it's still over-sized, just allocate precisely enough and give it a dedicated allocation
-      if(ret.size > info.allocationSize)
-      {
-        RDCDEBUG("Over-sized allocation for 0x%llx bytes", ret.size);
-        info.allocationSize = ret.size;
-      }
+      RDCDEBUG("Over-sized allocation for 0x%llx bytes", ret.size);
+      info.allocationSize = ret.size;
     }
+  }
 
-    RDCDEBUG("Creating new allocation of 0x%llx bytes", info.allocationSize);
+  RDCDEBUG("Creating new %s allocation of 0x%llx bytes for %s in %s", buffer ? "buffer" : "image",
+           info.allocationSize, ToStr(type).c_str(), ToStr(scope).c_str());
 
-    MemoryAllocation chunk;
-    chunk.buffer = ret.buffer;
-    chunk.memoryTypeIndex = memoryTypeIndex;
-    chunk.scope = scope;
-    chunk.type = type;
-    chunk.size = info.allocationSize;
+  MemoryBlock block;
+  block.alloc.buffer = ret.buffer;
+  block.alloc.memoryTypeIndex = memoryTypeIndex;
+  block.alloc.scope = scope;
+  block.alloc.type = type;
+  block.alloc.size = info.allocationSize;
 
-    // the offset starts immediately after this allocation
-    chunk.offs = ret.size;
+  VkDevice d = GetDev();
 
-    VkDevice d = GetDev();
+  // do the actual allocation
+  VkResult vkr = ObjDisp(d)->AllocateMemory(Unwrap(d), &info, NULL, &block.alloc.mem);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // do the actual allocation
-    VkResult vkr = ObjDisp(d)->AllocateMemory(Unwrap(d), &info, NULL, &chunk.mem);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  GetResourceManager()->WrapResource(Unwrap(d), block.alloc.mem);
 
-    GetResourceManager()->WrapResource(Unwrap(d), chunk.mem);
+  // the start of a new allocation is always suitably aligned, so take the first bytes
+  block.AddFreeRange(0, block.alloc.size);
+  block.SubAllocate(ret.size, 1, ret.offs);
 
-    // push the new chunk
-    blockList.push_back(chunk);
+  ret.mem = block.alloc.mem;
+  ret.memoryTypeIndex = memoryTypeIndex;
 
-    // return the first bytes in the new chunk
-    ret.offs = 0;
-    ret.mem = chunk.mem;
-  }
+  blockList.push_back(block);
 
   return ret;
 }
@@ -355,23 +376,78 @@ MemoryAllocation WrappedVulkan::AllocateMemoryForResource(VkBuffer buf, MemorySc
 
 void WrappedVulkan::FreeAllMemory(MemoryScope scope)
 {
-  std::vector<MemoryAllocation> &allocList = m_MemoryBlocks[(size_t)scope];
+  std::vector<MemoryBlock> &blockList = m_MemoryBlocks[(size_t)scope];
 
-  if(allocList.empty())
+  if(blockList.empty())
     return;
 
+  MemoryStatistics stats = GetMemoryStatistics(scope);
+
+  RDCDEBUG("Freeing %u blocks (0x%llx bytes) of %s memory, 0x%llx bytes still in use",
+           stats.blockCount, stats.blockBytes, ToStr(scope).c_str(), stats.usedBytes);
+
   VkDevice d = GetDev();
 
-  for(MemoryAllocation alloc : allocList)
+  for(MemoryBlock &block : blockList)
   {
-    ObjDisp(d)->FreeMemory(Unwrap(d), Unwrap(alloc.mem), NULL);
-    GetResourceManager()->ReleaseWrappedResource(alloc.mem);
+    ObjDisp(d)->FreeMemory(Unwrap(d), Unwrap(block.alloc.mem), NULL);
+    GetResourceManager()->ReleaseWrappedResource(block.alloc.mem);
   }
 
-  allocList.clear();
+  blockList.clear();
 }
 
 void WrappedVulkan::FreeMemoryAllocation(MemoryAllocation alloc)
 {
-  // don't do anything at the moment, we only support freeing the whole scope at once.
+  if(alloc.mem == VK_NULL_HANDLE)
+    return;
+
+  std::vector<MemoryBlock> &blockList = m_MemoryBlocks[(size_t)alloc.scope];
+
+  for(auto it = blockList.begin(); it != blockList.end(); ++it)
+  {
+    MemoryBlock &block = *it;
+
+    if(block.alloc.mem != alloc.mem)
+      continue;
+
+    RDCASSERT(alloc.offs + alloc.size <= block.alloc.size && alloc.size <= block.used);
+
+    block.used -= alloc.size;
+    block.AddFreeRange(alloc.offs, alloc.size);
+
+    // blocks bigger than the largest normal size were dedicated to one allocation, return them to
+    // the driver as soon as they're empty. Others are kept around to be reused.
+    if(block.used == 0 && block.alloc.size > 256 * 1024 * 1024)
+    {
+      VkDevice d = GetDev();
+
+      ObjDisp(d)->FreeMemory(Unwrap(d), Unwrap(block.alloc.mem), NULL);
+      GetResourceManager()->ReleaseWrappedResource(block.alloc.mem);
+
+      blockList.erase(it);
+    }
+
+    return;
+  }
+
+  RDCERR("Freeing memory allocation that wasn't allocated in %s", ToStr(alloc.scope).c_str());
+}
+
+MemoryStatistics WrappedVulkan::GetMemoryStatistics(MemoryScope scope)
+{
+  MemoryStatistics ret;
+
+  for(const MemoryBlock &block : m_MemoryBlocks[(size_t)scope])
+  {
+    ret.blockCount++;
+    ret.blockBytes += block.alloc.size;
+    ret.usedBytes += block.used;
+    ret.freeRangeCount += (uint32_t)block.freeByOffset.size();
+
+    if(!block.freeBySize.empty())
+      ret.largestFreeRange = RDCMAX(ret.largestFreeRange, block.freeBySize.rbegin()->first);
+  }
+
+  return ret;
 }
@@ -205,8 +205,8 @@ struct VulkanQuadOverdrawCallback : public VulkanDrawcallCallback
         sh.pSpecializationInfo = NULL;
       }
 
-      vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
-                                                 &pipe.second);
+      vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_pDriver->GetShaderCache()->GetPipeCache(),
+                                                 1, &pipeCreateInfo, NULL, &pipe.second);
       RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
       ObjDisp(dev)->DestroyShaderModule(Unwrap(dev), Unwrap(module), NULL);
@@ -822,8 +822,9 @@ ResourceId VulkanReplay::RenderOverlay(ResourceId texid, CompType typeHint, Debu
 
     VkPipeline pipe = VK_NULL_HANDLE;
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
-                                               &pipe);
+    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device,
+                                               m_pDriver->GetShaderCache()->GetPipeCache(), 1,
+                                               &pipeCreateInfo, NULL, &pipe);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     // modify state
@@ -1149,15 +1150,17 @@ ResourceId VulkanReplay::RenderOverlay(ResourceId texid, CompType typeHint, Debu
     vkr = vt->EndCommandBuffer(Unwrap(cmd));
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
-                                               &pipe[0]);
+    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device,
+                                               m_pDriver->GetShaderCache()->GetPipeCache(), 1,
+                                               &pipeCreateInfo, NULL, &pipe[0]);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     fragShader->module = mod[1];
     rs->cullMode = origCullMode;
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
-                                               &pipe[1]);
+    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device,
+                                               m_pDriver->GetShaderCache()->GetPipeCache(), 1,
+                                               &pipeCreateInfo, NULL, &pipe[1]);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     // modify state
@@ -1436,8 +1439,9 @@ ResourceId VulkanReplay::RenderOverlay(ResourceId texid, CompType typeHint, Debu
       pipeCreateInfo.renderPass = m_Overlay.NoDepthRP;
     }
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
-                                               &passpipe);
+    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device,
+                                               m_pDriver->GetShaderCache()->GetPipeCache(), 1,
+                                               &pipeCreateInfo, NULL, &passpipe);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     fragShader->module = failmod;
@@ -1454,8 +1458,9 @@ ResourceId VulkanReplay::RenderOverlay(ResourceId texid, CompType typeHint, Debu
     if(m_pDriver->GetDeviceFeatures().depthClamp)
       rs->depthClampEnable = true;
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
-                                               &failpipe);
+    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device,
+                                               m_pDriver->GetShaderCache()->GetPipeCache(), 1,
+                                               &pipeCreateInfo, NULL, &failpipe);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     // modify state
@@ -2191,8 +2196,9 @@ ResourceId VulkanReplay::RenderOverlay(ResourceId texid, CompType typeHint, Debu
 
             if(pipe == VK_NULL_HANDLE)
             {
-              vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1,
-                                                         &pipeCreateInfo, NULL, &pipe);
+              vkr = m_pDriver->vkCreateGraphicsPipelines(
+                  m_Device, m_pDriver->GetShaderCache()->GetPipeCache(), 1, &pipeCreateInfo, NULL,
+                  &pipe);
               RDCASSERTEQUAL(vkr, VK_SUCCESS);
             }
 
@@ -2323,5 +2329,7 @@ ResourceId VulkanReplay::RenderOverlay(ResourceId texid, CompType typeHint, Debu
   m_pDriver->SubmitCmds();
 #endif
 
+  m_Histogram.ClearCache(GetResID(m_Overlay.Image));
+
   return GetResID(m_Overlay.Image);
 }
@@ -48,6 +48,21 @@ static const uint32_t MeshOutputTBufferArraySize = 16;
 // 4 = sint vbuffers
 static const uint32_t MeshOutputReservedBindings = 5;
 
+// how much memory fetched mesh output can use before the least recently used data is evicted, in
+// MB. Can be overridden with the Vulkan_PostVSCacheBudgetMB config setting.
+static const uint32_t DefaultPostVSBudgetMB = 512;
+
+static VkDeviceSize GetPostVSBudget()
+{
+  const std::string &setting = RenderDoc::Inst().GetConfigSetting("Vulkan_PostVSCacheBudgetMB");
+
+  uint32_t budgetMB = DefaultPostVSBudgetMB;
+  if(!setting.empty())
+    budgetMB = RDCMAX(16, atoi(setting.c_str()));
+
+  return VkDeviceSize(budgetMB) * 1024 * 1024;
+}
+
 static void ConvertToMeshOutputCompute(const ShaderReflection &refl, const SPIRVPatchData &patchData,
                                        const char *entryName, std::vector<uint32_t> instDivisor,
                                        const DrawcallDescription *draw, uint32_t numVerts,
@@ -1276,20 +1291,56 @@ static void AddXFBAnnotations(const ShaderReflection &refl, const SPIRVPatchData
   }
 }
 
-void VulkanReplay::ClearPostVSCache()
+void VulkanReplay::FreePostVSData(VulkanPostVSData &data)
 {
   VkDevice dev = m_Device;
 
-  for(auto it = m_PostVS.Data.begin(); it != m_PostVS.Data.end(); ++it)
+  for(VulkanPostVSData::StageData *stage : {&data.vsout, &data.gsout})
   {
-    if(it->second.vsout.idxbuf != VK_NULL_HANDLE)
+    if(stage->idxbuf != VK_NULL_HANDLE)
+      m_pDriver->vkDestroyBuffer(dev, stage->idxbuf, NULL);
+    if(stage->buf != VK_NULL_HANDLE)
+      m_pDriver->vkDestroyBuffer(dev, stage->buf, NULL);
+
+    // the memory is sub-allocated, so this just returns it to the pool for the next fetch
+    m_pDriver->FreeMemoryAllocation(stage->idxbufmem);
+    m_pDriver->FreeMemoryAllocation(stage->bufmem);
+
+    stage->idxbuf = stage->buf = VK_NULL_HANDLE;
+    stage->idxbufmem = stage->bufmem = MemoryAllocation();
+  }
+}
+
+void VulkanReplay::EvictPostVSData(VkDeviceSize budget)
+{
+  VkDeviceSize usedBytes = m_pDriver->GetMemoryStatistics(MemoryScope::PostVS).usedBytes;
+
+  while(usedBytes > budget)
+  {
+    // find the least recently used data. Anything used in this epoch is still needed
+    auto lru = m_PostVS.Data.end();
+    for(auto it = m_PostVS.Data.begin(); it != m_PostVS.Data.end(); ++it)
     {
-      m_pDriver->vkDestroyBuffer(dev, it->second.vsout.idxbuf, NULL);
-      m_pDriver->vkFreeMemory(dev, it->second.vsout.idxbufmem, NULL);
+      if(it->second.lastUse < m_PostVS.Epoch &&
+         (lru == m_PostVS.Data.end() || it->second.lastUse < lru->second.lastUse))
+        lru = it;
     }
-    m_pDriver->vkDestroyBuffer(dev, it->second.vsout.buf, NULL);
-    m_pDriver->vkFreeMemory(dev, it->second.vsout.bufmem, NULL);
+
+    // everything left is in use, go over budget rather than thrashing
+    if(lru == m_PostVS.Data.end())
+      break;
+
+    usedBytes -= RDCMIN(usedBytes, lru->second.GetMemorySize());
+
+    FreePostVSData(lru->second);
+    m_PostVS.Data.erase(lru);
   }
+}
+
+void VulkanReplay::ClearPostVSCache()
+{
+  for(auto it = m_PostVS.Data.begin(); it != m_PostVS.Data.end(); ++it)
+    FreePostVSData(it->second);
 
   m_PostVS.Data.clear();
 }
@@ -1315,7 +1366,7 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
     // empty vertex output signature
     m_PostVS.Data[eventId].vsin.topo = pipeInfo.topology;
     m_PostVS.Data[eventId].vsout.buf = VK_NULL_HANDLE;
-    m_PostVS.Data[eventId].vsout.bufmem = VK_NULL_HANDLE;
+    m_PostVS.Data[eventId].vsout.bufmem = MemoryAllocation();
     m_PostVS.Data[eventId].vsout.instStride = 0;
     m_PostVS.Data[eventId].vsout.vertStride = 0;
     m_PostVS.Data[eventId].vsout.numViews = 1;
@@ -1324,7 +1375,7 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
     m_PostVS.Data[eventId].vsout.useIndices = false;
     m_PostVS.Data[eventId].vsout.hasPosOut = false;
     m_PostVS.Data[eventId].vsout.idxbuf = VK_NULL_HANDLE;
-    m_PostVS.Data[eventId].vsout.idxbufmem = VK_NULL_HANDLE;
+    m_PostVS.Data[eventId].vsout.idxbufmem = MemoryAllocation();
 
     m_PostVS.Data[eventId].vsout.topo = pipeInfo.topology;
 
@@ -1665,14 +1716,15 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
   }
 
   VkBuffer meshBuffer = VK_NULL_HANDLE, readbackBuffer = VK_NULL_HANDLE;
-  VkDeviceMemory meshMem = VK_NULL_HANDLE, readbackMem = VK_NULL_HANDLE;
+  MemoryAllocation meshMem;
+  VkDeviceMemory readbackMem = VK_NULL_HANDLE;
 
   VkBuffer uniqIdxBuf = VK_NULL_HANDLE;
   VkDeviceMemory uniqIdxBufMem = VK_NULL_HANDLE;
   VkBufferView uniqIdxBufView = VK_NULL_HANDLE;
 
   VkBuffer rebasedIdxBuf = VK_NULL_HANDLE;
-  VkDeviceMemory rebasedIdxBufMem = VK_NULL_HANDLE;
+  MemoryAllocation rebasedIdxBufMem;
 
   uint32_t numVerts = drawcall->numIndices;
   VkDeviceSize bufSize = 0;
@@ -1901,30 +1953,28 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
     vkr = m_pDriver->vkCreateBuffer(dev, &bufInfo, NULL, &rebasedIdxBuf);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    m_pDriver->vkGetBufferMemoryRequirements(dev, rebasedIdxBuf, &mrq);
-
-    allocInfo.allocationSize = mrq.size;
-    allocInfo.memoryTypeIndex = m_pDriver->GetUploadMemoryIndex(mrq.memoryTypeBits);
+    rebasedIdxBufMem = m_pDriver->AllocateMemoryForResource(rebasedIdxBuf, MemoryScope::PostVS,
+                                                            MemoryType::Upload);
 
-    vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &rebasedIdxBufMem);
+    vkr = m_pDriver->vkBindBufferMemory(dev, rebasedIdxBuf, rebasedIdxBufMem.mem,
+                                        rebasedIdxBufMem.offs);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    vkr = m_pDriver->vkBindBufferMemory(dev, rebasedIdxBuf, rebasedIdxBufMem, 0);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    vkr = m_pDriver->vkMapMemory(m_Device, rebasedIdxBufMem, 0, VK_WHOLE_SIZE, 0, (void **)&idxData);
+    vkr = m_pDriver->vkMapMemory(m_Device, rebasedIdxBufMem.mem, rebasedIdxBufMem.offs,
+                                 rebasedIdxBufMem.size, 0, (void **)&idxData);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     memcpy(idxData, idxdata.data(), idxdata.size());
 
     VkMappedMemoryRange rebasedRange = {
-        VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL, rebasedIdxBufMem, 0, VK_WHOLE_SIZE,
+        VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL, rebasedIdxBufMem.mem, rebasedIdxBufMem.offs,
+        rebasedIdxBufMem.size,
     };
 
     vkr = m_pDriver->vkFlushMappedMemoryRanges(m_Device, 1, &rebasedRange);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    m_pDriver->vkUnmapMemory(m_Device, rebasedIdxBufMem);
+    m_pDriver->vkUnmapMemory(m_Device, rebasedIdxBufMem.mem);
   }
 
   uint32_t bufStride = 0;
@@ -2325,7 +2375,8 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
 
   // create new pipeline
   VkPipeline pipe;
-  vkr = m_pDriver->vkCreateComputePipelines(m_Device, VK_NULL_HANDLE, 1, &compPipeInfo, NULL, &pipe);
+  vkr = m_pDriver->vkCreateComputePipelines(m_Device, m_pDriver->GetShaderCache()->GetPipeCache(),
+                                            1, &compPipeInfo, NULL, &pipe);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   // make copy of state to draw from
@@ -2370,23 +2421,19 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
     vkr = m_pDriver->vkCreateBuffer(dev, &bufInfo, NULL, &readbackBuffer);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    VkMemoryRequirements mrq = {0};
-    m_pDriver->vkGetBufferMemoryRequirements(dev, meshBuffer, &mrq);
-
-    VkMemoryAllocateInfo allocInfo = {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
-        m_pDriver->GetGPULocalMemoryIndex(mrq.memoryTypeBits),
-    };
+    meshMem =
+        m_pDriver->AllocateMemoryForResource(meshBuffer, MemoryScope::PostVS, MemoryType::GPULocal);
 
-    vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &meshMem);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    vkr = m_pDriver->vkBindBufferMemory(dev, meshBuffer, meshMem, 0);
+    vkr = m_pDriver->vkBindBufferMemory(dev, meshBuffer, meshMem.mem, meshMem.offs);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
+    VkMemoryRequirements mrq = {0};
     m_pDriver->vkGetBufferMemoryRequirements(dev, readbackBuffer, &mrq);
 
-    allocInfo.memoryTypeIndex = m_pDriver->GetReadbackMemoryIndex(mrq.memoryTypeBits);
+    VkMemoryAllocateInfo allocInfo = {
+        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
+        m_pDriver->GetReadbackMemoryIndex(mrq.memoryTypeBits),
+    };
 
     vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &readbackMem);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
@@ -2684,7 +2731,7 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
   {
     // empty vertex output signature
     m_PostVS.Data[eventId].gsout.buf = VK_NULL_HANDLE;
-    m_PostVS.Data[eventId].gsout.bufmem = VK_NULL_HANDLE;
+    m_PostVS.Data[eventId].gsout.bufmem = MemoryAllocation();
     m_PostVS.Data[eventId].gsout.instStride = 0;
     m_PostVS.Data[eventId].gsout.vertStride = 0;
     m_PostVS.Data[eventId].gsout.numViews = 1;
@@ -2693,7 +2740,7 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
     m_PostVS.Data[eventId].gsout.useIndices = false;
     m_PostVS.Data[eventId].gsout.hasPosOut = false;
     m_PostVS.Data[eventId].gsout.idxbuf = VK_NULL_HANDLE;
-    m_PostVS.Data[eventId].gsout.idxbufmem = VK_NULL_HANDLE;
+    m_PostVS.Data[eventId].gsout.idxbufmem = MemoryAllocation();
     return;
   }
 
@@ -2773,8 +2820,8 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
   pipeCreateInfo.subpass = 0;
 
   VkPipeline pipe = VK_NULL_HANDLE;
-  vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
-                                             &pipe);
+  vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, m_pDriver->GetShaderCache()->GetPipeCache(),
+                                             1, &pipeCreateInfo, NULL, &pipe);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   state.graphics.pipeline = GetResID(pipe);
@@ -2810,7 +2857,7 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
   }
 
   VkBuffer meshBuffer = VK_NULL_HANDLE;
-  VkDeviceMemory meshMem = VK_NULL_HANDLE;
+  MemoryAllocation meshMem;
 
   // start with bare minimum size, which might be enough if no expansion happens
   VkDeviceSize bufferSize = 0;
@@ -2826,10 +2873,10 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
     if(meshBuffer != VK_NULL_HANDLE)
     {
       m_pDriver->vkDestroyBuffer(dev, meshBuffer, NULL);
-      m_pDriver->vkFreeMemory(dev, meshMem, NULL);
+      m_pDriver->FreeMemoryAllocation(meshMem);
 
       meshBuffer = VK_NULL_HANDLE;
-      meshMem = VK_NULL_HANDLE;
+      meshMem = MemoryAllocation();
     }
 
     VkBufferCreateInfo bufInfo = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
@@ -2844,18 +2891,10 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
     vkr = m_pDriver->vkCreateBuffer(dev, &bufInfo, NULL, &meshBuffer);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    VkMemoryRequirements mrq = {0};
-    m_pDriver->vkGetBufferMemoryRequirements(dev, meshBuffer, &mrq);
+    meshMem =
+        m_pDriver->AllocateMemoryForResource(meshBuffer, MemoryScope::PostVS, MemoryType::GPULocal);
 
-    VkMemoryAllocateInfo allocInfo = {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
-        m_pDriver->GetGPULocalMemoryIndex(mrq.memoryTypeBits),
-    };
-
-    vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &meshMem);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    vkr = m_pDriver->vkBindBufferMemory(dev, meshBuffer, meshMem, 0);
+    vkr = m_pDriver->vkBindBufferMemory(dev, meshBuffer, meshMem.mem, meshMem.offs);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     VkCommandBuffer cmd = m_pDriver->GetNextCmd();
@@ -3119,7 +3158,7 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
   m_PostVS.Data[eventId].gsout.instData = instData;
 
   m_PostVS.Data[eventId].gsout.idxbuf = VK_NULL_HANDLE;
-  m_PostVS.Data[eventId].gsout.idxbufmem = VK_NULL_HANDLE;
+  m_PostVS.Data[eventId].gsout.idxbufmem = MemoryAllocation();
 
   m_PostVS.Data[eventId].gsout.hasPosOut = true;
 
@@ -3136,12 +3175,21 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
 
 void VulkanReplay::InitPostVSBuffers(uint32_t eventId)
 {
+  // each standalone request starts a new epoch, but all the events in a pass share one so they
+  // can't evict each other
+  if(!m_PostVS.InPass)
+    m_PostVS.Epoch++;
+
   // go through any aliasing
   if(m_PostVS.Alias.find(eventId) != m_PostVS.Alias.end())
     eventId = m_PostVS.Alias[eventId];
 
-  if(m_PostVS.Data.find(eventId) != m_PostVS.Data.end())
+  auto it = m_PostVS.Data.find(eventId);
+  if(it != m_PostVS.Data.end())
+  {
+    it->second.lastUse = m_PostVS.Epoch;
     return;
+  }
 
   const VulkanRenderState &state = m_pDriver->m_RenderState;
   VulkanCreationInfo &creationInfo = m_pDriver->m_CreationInfo;
@@ -3159,12 +3207,18 @@ void VulkanReplay::InitPostVSBuffers(uint32_t eventId)
   if(drawcall == NULL || drawcall->numIndices == 0 || drawcall->numInstances == 0)
     return;
 
+  // make room for the new data before fetching it, by dropping whatever hasn't been looked at in
+  // the longest time.
+  EvictPostVSData(GetPostVSBudget());
+
   VkMarkerRegion::Begin(StringFormat::Fmt("FetchVSOut for %u", eventId));
 
   FetchVSOut(eventId);
 
   VkMarkerRegion::End();
 
+  m_PostVS.Data[eventId].lastUse = m_PostVS.Epoch;
+
   // if there's no tessellation or geometry shader active, bail out now
   if(pipeInfo.shaders[2].module == ResourceId() && pipeInfo.shaders[3].module == ResourceId())
     return;
@@ -3213,17 +3267,58 @@ struct VulkanInitPostVSCallback : public VulkanDrawcallCallback
 
 void VulkanReplay::InitPostVSBuffers(const vector<uint32_t> &events)
 {
-  // first we must replay up to the first event without replaying it. This ensures any
-  // non-command buffer calls like memory unmaps etc all happen correctly before this
-  // command buffer
-  m_pDriver->ReplayLog(0, events.front(), eReplay_WithoutDraw);
+  if(events.empty())
+    return;
+
+  std::vector<std::vector<uint32_t>> passes = SplitEventsByPass(this, events);
+
+  bool continuing = false;
+
+  for(size_t i = 0; i < passes.size(); i++)
+  {
+    const std::vector<uint32_t> &pass = passes[i];
+
+    // first we must replay up to the first event without replaying it. This ensures any
+    // non-command buffer calls like memory unmaps etc all happen correctly before this
+    // command buffer. If we carried on from the previous pass, we're already there.
+    if(!continuing)
+      m_pDriver->ReplayLog(0, pass.front(), eReplay_WithoutDraw);
+
+    // if the next pass is later in the same command buffer, replay right up to it now and carry
+    // on from there, instead of replaying the whole frame up to it again. That's only safe between
+    // whole render passes, where no render pass state is carried from one replay to the next.
+    uint32_t endEvent = pass.back();
+    bool continueNext = false;
+
+    if(i + 1 < passes.size() && IsRenderPassStart(pass.front()) &&
+       IsRenderPassStart(passes[i + 1].front()))
+    {
+      continueNext = m_pDriver->CanContinuePartialReplay(pass.front(), passes[i + 1].front());
+      if(continueNext)
+        endEvent = passes[i + 1].front() - 1;
+    }
+
+    VulkanInitPostVSCallback cb(m_pDriver, pass);
 
-  VulkanInitPostVSCallback cb(m_pDriver, events);
+    m_PostVS.InPass = true;
 
-  // now we replay the events, which are guaranteed (because we generated them in
-  // GetPassEvents above) to come from the same command buffer, so the event IDs are
-  // still locally continuous, even if we jump into replaying.
-  m_pDriver->ReplayLog(events.front(), events.back(), eReplay_Full);
+    // now we replay the events, which are guaranteed (because we generated them in
+    // GetPassEvents above) to come from the same command buffer, so the event IDs are
+    // still locally continuous, even if we jump into replaying.
+    m_pDriver->ReplayLog(pass.front(), endEvent, eReplay_Full);
+
+    m_PostVS.InPass = false;
+
+    continuing =
+        continueNext && m_pDriver->CanContinuePartialReplay(pass.front(), passes[i + 1].front());
+  }
+}
+
+bool VulkanReplay::IsRenderPassStart(uint32_t eventId)
+{
+  // vkCmdNextSubpass begins and ends a pass, so the render pass is still active before it
+  const DrawcallDescription *draw = m_pDriver->GetDrawcall(eventId);
+  return draw && (draw->flags & DrawFlags::BeginPass) && !(draw->flags & DrawFlags::EndPass);
 }
 
 MeshFormat VulkanReplay::GetPostVSBuffers(uint32_t eventId, uint32_t instID, uint32_t viewID,
@@ -3236,8 +3331,12 @@ MeshFormat VulkanReplay::GetPostVSBuffers(uint32_t eventId, uint32_t instID, uin
   VulkanPostVSData postvs;
   RDCEraseEl(postvs);
 
-  if(m_PostVS.Data.find(eventId) != m_PostVS.Data.end())
-    postvs = m_PostVS.Data[eventId];
+  auto it = m_PostVS.Data.find(eventId);
+  if(it != m_PostVS.Data.end())
+  {
+    it->second.lastUse = m_PostVS.Epoch;
+    postvs = it->second;
+  }
 
   const DrawcallDescription *drawcall = m_pDriver->GetDrawcall(eventId);
 
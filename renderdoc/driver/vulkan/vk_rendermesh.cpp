@@ -284,6 +284,8 @@ MeshDisplayPipelines VulkanDebugManager::CacheMeshDisplayPipelines(VkPipelineLay
       0,                 // base pipeline index
   };
 
+  VkPipelineCache pipeCache = Unwrap(m_pDriver->GetShaderCache()->GetPipeCache());
+
   // wireframe pipeline
   stages[0].module = Unwrap(m_pDriver->GetShaderCache()->GetBuiltinModule(BuiltinShader::MeshVS));
   stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -294,13 +296,13 @@ MeshDisplayPipelines VulkanDebugManager::CacheMeshDisplayPipelines(VkPipelineLay
   rs.lineWidth = 1.0f;
   ds.depthTestEnable = false;
 
-  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), pipeCache, 1, &pipeInfo, NULL,
                                     &cache.pipes[MeshDisplayPipelines::ePipe_Wire]);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   ds.depthTestEnable = true;
 
-  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), pipeCache, 1, &pipeInfo, NULL,
                                     &cache.pipes[MeshDisplayPipelines::ePipe_WireDepth]);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
@@ -308,13 +310,13 @@ MeshDisplayPipelines VulkanDebugManager::CacheMeshDisplayPipelines(VkPipelineLay
   rs.polygonMode = VK_POLYGON_MODE_FILL;
   ds.depthTestEnable = false;
 
-  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), pipeCache, 1, &pipeInfo, NULL,
                                     &cache.pipes[MeshDisplayPipelines::ePipe_Solid]);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   ds.depthTestEnable = true;
 
-  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), pipeCache, 1, &pipeInfo, NULL,
                                     &cache.pipes[MeshDisplayPipelines::ePipe_SolidDepth]);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
@@ -327,7 +329,7 @@ MeshDisplayPipelines VulkanDebugManager::CacheMeshDisplayPipelines(VkPipelineLay
 
     vi.vertexBindingDescriptionCount = 2;
 
-    vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+    vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), pipeCache, 1, &pipeInfo, NULL,
                                       &cache.pipes[MeshDisplayPipelines::ePipe_Secondary]);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
@@ -342,7 +344,7 @@ MeshDisplayPipelines VulkanDebugManager::CacheMeshDisplayPipelines(VkPipelineLay
 
   if(stages[2].module != VK_NULL_HANDLE)
   {
-    vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+    vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), pipeCache, 1, &pipeInfo, NULL,
                                       &cache.pipes[MeshDisplayPipelines::ePipe_Lit]);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
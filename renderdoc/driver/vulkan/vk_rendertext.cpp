@@ -272,28 +272,28 @@ VulkanTextRenderer::VulkanTextRenderer(WrappedVulkan *driver)
   pipeInfo.layout = m_TextPipeLayout;
 
   pipeInfo.renderPass = RGBA8sRGBRP;
-  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, shaderCache->GetPipeCache(), 1, &pipeInfo, NULL,
                                              &m_TextPipeline[0]);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   rm->SetInternalResource(GetResID(m_TextPipeline[0]));
 
   pipeInfo.renderPass = RGBA8LinearRP;
-  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, shaderCache->GetPipeCache(), 1, &pipeInfo, NULL,
                                              &m_TextPipeline[1]);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   rm->SetInternalResource(GetResID(m_TextPipeline[1]));
 
   pipeInfo.renderPass = BGRA8sRGBRP;
-  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, shaderCache->GetPipeCache(), 1, &pipeInfo, NULL,
                                              &m_TextPipeline[2]);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   rm->SetInternalResource(GetResID(m_TextPipeline[2]));
 
   pipeInfo.renderPass = BGRA8LinearRP;
-  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, shaderCache->GetPipeCache(), 1, &pipeInfo, NULL,
                                              &m_TextPipeline[3]);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
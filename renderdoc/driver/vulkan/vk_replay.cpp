@@ -40,6 +40,7 @@
 
 static const char *SPIRVDisassemblyTarget = "SPIR-V (RenderDoc)";
 static const char *LiveDriverDisassemblyTarget = "Live driver disassembly";
+static const size_t MaxTextureStatsCacheEntries = 256;
 
 VulkanReplay::VulkanReplay()
 {
@@ -338,9 +339,9 @@ ShaderReflection *VulkanReplay::GetShader(ResourceId shader, ShaderEntryPoint en
     return NULL;
   }
 
-  shad->second.m_Reflections[entry.name].Init(GetResourceManager(), shader, shad->second.spirv,
-                                              entry.name,
+  shad->second.m_Reflections[entry.name].Init(m_pDriver->m_CreationInfo, shader, entry.name,
                                               VkShaderStageFlagBits(1 << uint32_t(entry.stage)));
+  m_pDriver->FlushPendingReflections();
 
   return &shad->second.m_Reflections[entry.name].refl;
 }
@@ -1708,6 +1709,48 @@ void VulkanReplay::FillCBufferVariables(ResourceId shader, string entryPoint, ui
 
 bool VulkanReplay::GetMinMax(ResourceId texid, uint32_t sliceFace, uint32_t mip, uint32_t sample,
                              CompType typeHint, float *minval, float *maxval)
+{
+  HistogramMinMax::CacheKey key;
+  key.texid = texid;
+  key.eventId = m_pDriver->GetReplayedEventID();
+  key.sliceFace = sliceFace;
+  key.mip = mip;
+  key.sample = sample;
+  key.typeHint = typeHint;
+
+  // if the replay isn't at a known event we can't cache the results
+  const bool cacheable = (key.eventId != ~0U);
+
+  if(cacheable)
+  {
+    auto it = m_Histogram.m_MinMaxCache.find(key);
+    if(it != m_Histogram.m_MinMaxCache.end())
+    {
+      memcpy(minval, &it->second.first.x, sizeof(Vec4f));
+      memcpy(maxval, &it->second.second.x, sizeof(Vec4f));
+      return true;
+    }
+  }
+
+  bool success = GetMinMaxUncached(texid, sliceFace, mip, sample, typeHint, minval, maxval);
+
+  if(success && cacheable)
+  {
+    // keep the cache from growing without bound if many different textures are inspected
+    if(m_Histogram.m_MinMaxCache.size() >= MaxTextureStatsCacheEntries)
+      m_Histogram.m_MinMaxCache.clear();
+
+    std::pair<Vec4f, Vec4f> &result = m_Histogram.m_MinMaxCache[key];
+    memcpy(&result.first.x, minval, sizeof(Vec4f));
+    memcpy(&result.second.x, maxval, sizeof(Vec4f));
+  }
+
+  return success;
+}
+
+bool VulkanReplay::GetMinMaxUncached(ResourceId texid, uint32_t sliceFace, uint32_t mip,
+                                     uint32_t sample, CompType typeHint, float *minval,
+                                     float *maxval)
 {
   ImageLayouts &layouts = m_pDriver->m_ImageLayouts[texid];
 
@@ -2065,6 +2108,51 @@ bool VulkanReplay::GetHistogram(ResourceId texid, uint32_t sliceFace, uint32_t m
   if(minval >= maxval)
     return false;
 
+  HistogramMinMax::CacheKey key;
+  key.texid = texid;
+  key.eventId = m_pDriver->GetReplayedEventID();
+  key.sliceFace = sliceFace;
+  key.mip = mip;
+  key.sample = sample;
+  key.typeHint = typeHint;
+  key.channels = (channels[0] ? 0x1 : 0) | (channels[1] ? 0x2 : 0) | (channels[2] ? 0x4 : 0) |
+                 (channels[3] ? 0x8 : 0);
+  key.minval = minval;
+  key.maxval = maxval;
+
+  // if the replay isn't at a known event we can't cache the results
+  const bool cacheable = (key.eventId != ~0U);
+
+  if(cacheable)
+  {
+    auto it = m_Histogram.m_HistogramCache.find(key);
+    if(it != m_Histogram.m_HistogramCache.end())
+    {
+      histogram = it->second;
+      return true;
+    }
+  }
+
+  bool success = GetHistogramUncached(texid, sliceFace, mip, sample, typeHint, minval, maxval,
+                                      channels, histogram);
+
+  if(success && cacheable)
+  {
+    if(m_Histogram.m_HistogramCache.size() >= MaxTextureStatsCacheEntries)
+      m_Histogram.m_HistogramCache.clear();
+
+    m_Histogram.m_HistogramCache[key] = histogram;
+  }
+
+  return success;
+}
+
+bool VulkanReplay::GetHistogramUncached(ResourceId texid, uint32_t sliceFace, uint32_t mip,
+                                        uint32_t sample, CompType typeHint, float minval,
+                                        float maxval, bool channels[4],
+                                        vector<uint32_t> &histogram)
+{
+
   VkDevice dev = m_pDriver->GetDev();
   VkCommandBuffer cmd = m_pDriver->GetNextCmd();
   const VkLayerDispatchTable *vt = ObjDisp(dev);
@@ -2373,19 +2461,25 @@ vector<EventUsage> VulkanReplay::GetUsage(ResourceId id)
   return m_pDriver->GetUsage(id);
 }
 
-void VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
-                                  const GetTextureDataParams &params, bytebuf &data)
+bool VulkanReplay::QueueTextureReadback(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                                        const GetTextureDataParams &params,
+                                        TextureReadback &readback)
 {
   bool wasms = false;
 
   if(m_pDriver->m_CreationInfo.m_Image.find(tex) == m_pDriver->m_CreationInfo.m_Image.end())
   {
     RDCERR("Trying to get texture data for unknown ID %llu!", tex);
-    return;
+    return false;
   }
 
   VulkanCreationInfo::Image &imInfo = m_pDriver->m_CreationInfo.m_Image[tex];
 
+  // remapping and MSAA expansion go through shared descriptor sets and uniform buffers, which we
+  // can't update while a previous readback might still be using them.
+  if(params.remap != RemapTexture::NoRemap || imInfo.samples > 1)
+    m_pDriver->FlushQ();
+
   ImageLayouts &layouts = m_pDriver->m_ImageLayouts[tex];
 
   VkImageCreateInfo imCreateInfo = {
@@ -2414,7 +2508,7 @@ void VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
 
   VkImage srcImage = Unwrap(GetResourceManager()->GetCurrentHandle<VkImage>(tex));
   VkImage tmpImage = VK_NULL_HANDLE;
-  VkDeviceMemory tmpMemory = VK_NULL_HANDLE;
+  MemoryAllocation tmpMemory;
 
   uint32_t srcQueueIndex = layouts.queueFamilyIndex;
 
@@ -2494,15 +2588,10 @@ void VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
     VkMemoryRequirements mrq = {0};
     vt->GetImageMemoryRequirements(Unwrap(dev), tmpImage, &mrq);
 
-    VkMemoryAllocateInfo allocInfo = {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
-        m_pDriver->GetGPULocalMemoryIndex(mrq.memoryTypeBits),
-    };
+    tmpMemory = m_pDriver->AllocateMemoryForResource(false, mrq, MemoryScope::TextureReadback,
+                                                     MemoryType::GPULocal);
 
-    vkr = vt->AllocateMemory(Unwrap(dev), &allocInfo, NULL, &tmpMemory);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    vkr = vt->BindImageMemory(Unwrap(dev), tmpImage, tmpMemory, 0);
+    vkr = vt->BindImageMemory(Unwrap(dev), tmpImage, Unwrap(tmpMemory.mem), tmpMemory.offs);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     VkImageMemoryBarrier dstimBarrier = {
@@ -2701,15 +2790,10 @@ void VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
     VkMemoryRequirements mrq = {0};
     vt->GetImageMemoryRequirements(Unwrap(dev), tmpImage, &mrq);
 
-    VkMemoryAllocateInfo allocInfo = {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
-        m_pDriver->GetGPULocalMemoryIndex(mrq.memoryTypeBits),
-    };
-
-    vkr = vt->AllocateMemory(Unwrap(dev), &allocInfo, NULL, &tmpMemory);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    tmpMemory = m_pDriver->AllocateMemoryForResource(false, mrq, MemoryScope::TextureReadback,
+                                                     MemoryType::GPULocal);
 
-    vkr = vt->BindImageMemory(Unwrap(dev), tmpImage, tmpMemory, 0);
+    vkr = vt->BindImageMemory(Unwrap(dev), tmpImage, Unwrap(tmpMemory.mem), tmpMemory.offs);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     RDCASSERT(!isDepth && !isStencil);
@@ -2870,15 +2954,10 @@ void VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
     VkMemoryRequirements mrq = {0};
     vt->GetImageMemoryRequirements(Unwrap(dev), tmpImage, &mrq);
 
-    VkMemoryAllocateInfo allocInfo = {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
-        m_pDriver->GetGPULocalMemoryIndex(mrq.memoryTypeBits),
-    };
-
-    vkr = vt->AllocateMemory(Unwrap(dev), &allocInfo, NULL, &tmpMemory);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    tmpMemory = m_pDriver->AllocateMemoryForResource(false, mrq, MemoryScope::TextureReadback,
+                                                     MemoryType::GPULocal);
 
-    vkr = vt->BindImageMemory(Unwrap(dev), tmpImage, tmpMemory, 0);
+    vkr = vt->BindImageMemory(Unwrap(dev), tmpImage, Unwrap(tmpMemory.mem), tmpMemory.offs);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     VkImageMemoryBarrier srcimBarrier = {
@@ -3133,16 +3212,10 @@ void VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
 
   vt->GetBufferMemoryRequirements(Unwrap(dev), readbackBuf, &mrq);
 
-  VkMemoryAllocateInfo allocInfo = {
-      VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, dataSize,
-      m_pDriver->GetReadbackMemoryIndex(mrq.memoryTypeBits),
-  };
-
-  VkDeviceMemory readbackMem = VK_NULL_HANDLE;
-  vkr = vt->AllocateMemory(Unwrap(dev), &allocInfo, NULL, &readbackMem);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  MemoryAllocation readbackMem = m_pDriver->AllocateMemoryForResource(
+      true, mrq, MemoryScope::TextureReadback, MemoryType::Readback);
 
-  vkr = vt->BindBufferMemory(Unwrap(dev), readbackBuf, readbackMem, 0);
+  vkr = vt->BindBufferMemory(Unwrap(dev), readbackBuf, Unwrap(readbackMem.mem), readbackMem.offs);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   if(isDepth && isStencil)
@@ -3223,10 +3296,13 @@ void VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
   vt->EndCommandBuffer(Unwrap(cmd));
 
   m_pDriver->SubmitCmds();
-  m_pDriver->FlushQ();
 
   if(extQCmd != VK_NULL_HANDLE)
   {
+    // the source image can only be handed back to its queue once the copy has finished, so this
+    // readback is waited on immediately
+    m_pDriver->FlushQ();
+
     vkr = ObjDisp(extQCmd)->EndCommandBuffer(Unwrap(extQCmd));
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
@@ -3235,13 +3311,76 @@ void VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
     extQCmd = VK_NULL_HANDLE;
   }
 
+  // signal a fence once the copy completes, so the caller can wait on just this readback instead
+  // of idling the queue
+  if(m_ReadbackFences.empty())
+  {
+    VkFenceCreateInfo fenceInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+
+    VkFence fence = VK_NULL_HANDLE;
+    vkr = vt->CreateFence(Unwrap(dev), &fenceInfo, NULL, &fence);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    m_ReadbackFences.push_back(fence);
+  }
+
+  readback.fence = m_ReadbackFences.back();
+  m_ReadbackFences.pop_back();
+
+  VkQueue q = m_pDriver->GetQ();
+  vkr = ObjDisp(q)->QueueSubmit(Unwrap(q), 0, NULL, readback.fence);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  readback.readbackBuf = readbackBuf;
+  readback.readbackMem = readbackMem;
+  readback.dataSize = dataSize;
+
+  readback.format = imCreateInfo.format;
+  readback.isDepth = isDepth;
+  readback.isStencil = isStencil;
+  readback.pixelCount =
+      imCreateInfo.extent.width * imCreateInfo.extent.height * imCreateInfo.extent.depth;
+  readback.stencilOffset = copyregion[1].bufferOffset;
+
+  readback.tmpImage = tmpImage;
+  readback.tmpMemory = tmpMemory;
+  readback.tmpFB = tmpFB;
+  readback.tmpView = tmpView;
+  readback.numFBs = numFBs;
+  readback.tmpRP = tmpRP;
+
+  return true;
+}
+
+void VulkanReplay::FinishTextureReadback(TextureReadback &readback, bytebuf &data)
+{
+  VkDevice dev = m_pDriver->GetDev();
+  const VkLayerDispatchTable *vt = ObjDisp(dev);
+
+  VkResult vkr = vt->WaitForFences(Unwrap(dev), 1, &readback.fence, VK_TRUE, UINT64_MAX);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  vkr = vt->ResetFences(Unwrap(dev), 1, &readback.fence);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  m_ReadbackFences.push_back(readback.fence);
+
+  const uint32_t dataSize = readback.dataSize;
+  const VkFormat format = readback.format;
+  const VkDeviceSize stencilOffset = readback.stencilOffset;
+
   // map the buffer and copy to return buffer
   byte *pData = NULL;
-  vkr = vt->MapMemory(Unwrap(dev), readbackMem, 0, VK_WHOLE_SIZE, 0, (void **)&pData);
+  vkr = vt->MapMemory(Unwrap(dev), Unwrap(readback.readbackMem.mem), readback.readbackMem.offs,
+                      readback.readbackMem.size, 0, (void **)&pData);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   VkMappedMemoryRange range = {
-      VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL, readbackMem, 0, VK_WHOLE_SIZE,
+      VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+      NULL,
+      Unwrap(readback.readbackMem.mem),
+      readback.readbackMem.offs,
+      readback.readbackMem.size,
   };
 
   vkr = vt->InvalidateMappedMemoryRanges(Unwrap(dev), 1, &range);
@@ -3251,21 +3390,20 @@ void VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
 
   data.resize(dataSize);
 
-  if(isDepth && isStencil)
+  if(readback.isDepth && readback.isStencil)
   {
-    size_t pixelCount =
-        imCreateInfo.extent.width * imCreateInfo.extent.height * imCreateInfo.extent.depth;
+    size_t pixelCount = readback.pixelCount;
 
     // for some reason reading direct from mapped memory here is *super* slow on android (1.5s to
     // iterate over the image), so we memcpy to a temporary buffer.
     std::vector<byte> tmp;
-    tmp.resize((size_t)copyregion[1].bufferOffset + pixelCount * sizeof(uint8_t));
+    tmp.resize((size_t)stencilOffset + pixelCount * sizeof(uint8_t));
     memcpy(tmp.data(), pData, tmp.size());
 
-    if(imCreateInfo.format == VK_FORMAT_D16_UNORM_S8_UINT)
+    if(format == VK_FORMAT_D16_UNORM_S8_UINT)
     {
       uint16_t *dSrc = (uint16_t *)tmp.data();
-      uint8_t *sSrc = (uint8_t *)(tmp.data() + copyregion[1].bufferOffset);
+      uint8_t *sSrc = (uint8_t *)(tmp.data() + stencilOffset);
 
       uint16_t *dDst = (uint16_t *)data.data();
       uint16_t *sDst = dDst + 1;    // interleaved, next pixel
@@ -3284,12 +3422,12 @@ void VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
         dSrc++;
       }
     }
-    else if(imCreateInfo.format == VK_FORMAT_D24_UNORM_S8_UINT)
+    else if(format == VK_FORMAT_D24_UNORM_S8_UINT)
     {
       // we can copy the depth from D24 as a 32-bit integer, since the remaining bits are garbage
       // and we overwrite them with stencil
       uint32_t *dSrc = (uint32_t *)tmp.data();
-      uint8_t *sSrc = (uint8_t *)(tmp.data() + copyregion[1].bufferOffset);
+      uint8_t *sSrc = (uint8_t *)(tmp.data() + stencilOffset);
 
       uint32_t *dst = (uint32_t *)data.data();
 
@@ -3306,7 +3444,7 @@ void VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
     else
     {
       uint32_t *dSrc = (uint32_t *)tmp.data();
-      uint8_t *sSrc = (uint8_t *)(tmp.data() + copyregion[1].bufferOffset);
+      uint8_t *sSrc = (uint8_t *)(tmp.data() + stencilOffset);
 
       uint32_t *dDst = (uint32_t *)data.data();
       uint32_t *sDst = dDst + 1;    // interleaved, next pixel
@@ -3332,29 +3470,70 @@ void VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
     memcpy(data.data(), pData, dataSize);
   }
 
-  vt->UnmapMemory(Unwrap(dev), readbackMem);
+  vt->UnmapMemory(Unwrap(dev), Unwrap(readback.readbackMem.mem));
 
   // clean up temporary objects
-  vt->DestroyBuffer(Unwrap(dev), readbackBuf, NULL);
-  vt->FreeMemory(Unwrap(dev), readbackMem, NULL);
+  vt->DestroyBuffer(Unwrap(dev), readback.readbackBuf, NULL);
+  m_pDriver->FreeMemoryAllocation(readback.readbackMem);
 
-  if(tmpImage != VK_NULL_HANDLE)
+  if(readback.tmpImage != VK_NULL_HANDLE)
   {
-    vt->DestroyImage(Unwrap(dev), tmpImage, NULL);
-    vt->FreeMemory(Unwrap(dev), tmpMemory, NULL);
+    vt->DestroyImage(Unwrap(dev), readback.tmpImage, NULL);
+    m_pDriver->FreeMemoryAllocation(readback.tmpMemory);
   }
 
-  if(tmpFB != NULL)
+  if(readback.tmpFB != NULL)
   {
-    for(uint32_t i = 0; i < numFBs; i++)
+    for(uint32_t i = 0; i < readback.numFBs; i++)
     {
-      vt->DestroyFramebuffer(Unwrap(dev), tmpFB[i], NULL);
-      vt->DestroyImageView(Unwrap(dev), tmpView[i], NULL);
+      vt->DestroyFramebuffer(Unwrap(dev), readback.tmpFB[i], NULL);
+      vt->DestroyImageView(Unwrap(dev), readback.tmpView[i], NULL);
     }
-    delete[] tmpFB;
-    delete[] tmpView;
-    vt->DestroyRenderPass(Unwrap(dev), tmpRP, NULL);
+    delete[] readback.tmpFB;
+    delete[] readback.tmpView;
+    vt->DestroyRenderPass(Unwrap(dev), readback.tmpRP, NULL);
+  }
+
+  readback = TextureReadback();
+}
+
+void VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                                  const GetTextureDataParams &params, bytebuf &data)
+{
+  TextureReadback readback;
+
+  if(!QueueTextureReadback(tex, arrayIdx, mip, params, readback))
+    return;
+
+  FinishTextureReadback(readback, data);
+
+  // recycle the command buffers used above
+  m_pDriver->FlushQ();
+}
+
+void VulkanReplay::GetTextureDataBatch(const std::vector<TextureDataRequest> &requests,
+                                       std::vector<bytebuf> &data)
+{
+  data.clear();
+  data.resize(requests.size());
+
+  // keep the next readback in flight while the previous one is copied out and unpacked, so the GPU
+  // copy of each texture overlaps with the CPU work on the one before it.
+  TextureReadback pending[2];
+
+  for(size_t i = 0; i < requests.size(); i++)
+  {
+    const TextureDataRequest &req = requests[i];
+    QueueTextureReadback(req.tex, req.arrayIdx, req.mip, req.params, pending[i % 2]);
+
+    if(i > 0 && pending[(i - 1) % 2].fence != VK_NULL_HANDLE)
+      FinishTextureReadback(pending[(i - 1) % 2], data[i - 1]);
   }
+
+  if(!requests.empty() && pending[(requests.size() - 1) % 2].fence != VK_NULL_HANDLE)
+    FinishTextureReadback(pending[(requests.size() - 1) % 2], data.back());
+
+  m_pDriver->FlushQ();
 }
 
 void VulkanReplay::BuildCustomShader(string source, string entry,
@@ -3468,6 +3647,9 @@ ResourceId VulkanReplay::ApplyCustomShader(ResourceId shader, ResourceId texid,
   m_DebugWidth = oldW;
   m_DebugHeight = oldH;
 
+  // the custom texture has new contents without any replay, so forget anything cached for it
+  m_Histogram.ClearCache(GetResID(GetDebugManager()->GetCustomTexture()));
+
   return GetResID(GetDebugManager()->GetCustomTexture());
 }
 
@@ -3544,6 +3726,12 @@ void VulkanReplay::ReplaceResource(ResourceId from, ResourceId to)
 
   VulkanResourceManager *rm = m_pDriver->GetResourceManager();
 
+  // checkpoints, cached command buffers and decoded commands were made with the old shaders,
+  // they're no longer valid
+  m_pDriver->ClearReplayCheckpoints();
+  m_pDriver->ClearRerecordCache();
+  m_pDriver->ClearDecodedCommands();
+
   // we're passed in the original ID but we want the live ID for comparison
   ResourceId liveid = rm->GetLiveID(from);
 
@@ -3584,8 +3772,8 @@ void VulkanReplay::ReplaceResource(ResourceId from, ResourceId to)
         }
 
         // create the new graphics pipeline
-        VkResult vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeCreateInfo,
-                                                            NULL, &pipe);
+        VkResult vkr = m_pDriver->vkCreateGraphicsPipelines(
+            dev, m_pDriver->GetShaderCache()->GetPipeCache(), 1, &pipeCreateInfo, NULL, &pipe);
         RDCASSERTEQUAL(vkr, VK_SUCCESS);
       }
       else
@@ -3599,8 +3787,8 @@ void VulkanReplay::ReplaceResource(ResourceId from, ResourceId to)
         sh.module = dstShaderModule;
 
         // create the new compute pipeline
-        VkResult vkr = m_pDriver->vkCreateComputePipelines(dev, VK_NULL_HANDLE, 1, &pipeCreateInfo,
-                                                           NULL, &pipe);
+        VkResult vkr = m_pDriver->vkCreateComputePipelines(
+            dev, m_pDriver->GetShaderCache()->GetPipeCache(), 1, &pipeCreateInfo, NULL, &pipe);
         RDCASSERTEQUAL(vkr, VK_SUCCESS);
       }
 
@@ -3615,6 +3803,7 @@ void VulkanReplay::ReplaceResource(ResourceId from, ResourceId to)
   rm->ReplaceResource(liveid, to);
 
   ClearPostVSCache();
+  m_Histogram.ClearCache();
 }
 
 void VulkanReplay::RemoveReplacement(ResourceId id)
@@ -3629,6 +3818,10 @@ void VulkanReplay::RemoveReplacement(ResourceId id)
   if(!rm->HasReplacement(id))
     return;
 
+  m_pDriver->ClearReplayCheckpoints();
+  m_pDriver->ClearRerecordCache();
+  m_pDriver->ClearDecodedCommands();
+
   // remove the actual shader module replacements
   rm->RemoveReplacement(id);
   rm->RemoveReplacement(liveid);
@@ -3661,6 +3854,7 @@ void VulkanReplay::RemoveReplacement(ResourceId id)
   }
 
   ClearPostVSCache();
+  m_Histogram.ClearCache();
 }
 
 vector<PixelModification> VulkanReplay::PixelHistory(vector<EventUsage> events, ResourceId target,
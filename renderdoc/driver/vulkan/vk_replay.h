@@ -137,7 +137,7 @@ struct VulkanPostVSData
   struct StageData
   {
     VkBuffer buf;
-    VkDeviceMemory bufmem;
+    MemoryAllocation bufmem;
     VkPrimitiveTopology topo;
 
     int32_t baseVertex;
@@ -153,7 +153,7 @@ struct VulkanPostVSData
 
     bool useIndices;
     VkBuffer idxbuf;
-    VkDeviceMemory idxbufmem;
+    MemoryAllocation idxbufmem;
     VkIndexType idxFmt;
 
     bool hasPosOut;
@@ -162,6 +162,14 @@ struct VulkanPostVSData
     float farPlane;
   } vsin, vsout, gsout;
 
+  // the PostVS epoch this data was last used in, for LRU eviction
+  uint64_t lastUse = 0;
+
+  VkDeviceSize GetMemorySize() const
+  {
+    return vsout.bufmem.size + vsout.idxbufmem.size + gsout.bufmem.size + gsout.idxbufmem.size;
+  }
+
   VulkanPostVSData()
   {
     RDCEraseEl(vsin);
@@ -259,6 +267,7 @@ public:
 
   void InitPostVSBuffers(uint32_t eventId);
   void InitPostVSBuffers(const std::vector<uint32_t> &passEvents);
+  bool IsRenderPassStart(uint32_t eventId);
 
   // indicates that EID alias is the same as eventId
   void AliasPostVSBuffers(uint32_t eventId, uint32_t alias) { m_PostVS.Alias[alias] = eventId; }
@@ -270,6 +279,8 @@ public:
   void GetBufferData(ResourceId buff, uint64_t offset, uint64_t len, bytebuf &retData);
   void GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                       const GetTextureDataParams &params, bytebuf &data);
+  void GetTextureDataBatch(const std::vector<TextureDataRequest> &requests,
+                           std::vector<bytebuf> &data);
 
   void ReplaceResource(ResourceId from, ResourceId to);
   void RemoveReplacement(ResourceId id);
@@ -349,8 +360,13 @@ private:
 
   bool RenderTextureInternal(TextureDisplay cfg, VkRenderPassBeginInfo rpbegin, int flags);
 
+  bool GetMinMaxUncached(ResourceId texid, uint32_t sliceFace, uint32_t mip, uint32_t sample,
+                         CompType typeHint, float *minval, float *maxval);
   bool GetMinMax(ResourceId texid, uint32_t sliceFace, uint32_t mip, uint32_t sample,
                  CompType typeHint, bool stencil, float *minval, float *maxval);
+  bool GetHistogramUncached(ResourceId texid, uint32_t sliceFace, uint32_t mip, uint32_t sample,
+                            CompType typeHint, float minval, float maxval, bool channels[4],
+                            vector<uint32_t> &histogram);
 
   VulkanDebugManager *GetDebugManager();
   VulkanResourceManager *GetResourceManager();
@@ -594,6 +610,48 @@ private:
     VkPipeline m_MinMaxTilePipe[5][3] = {{VK_NULL_HANDLE}};
     // float, uint, sint
     VkPipeline m_MinMaxResultPipe[3] = {VK_NULL_HANDLE};
+
+    // results only depend on the texture contents, so they're cached against the event those
+    // contents came from. Anything else that changes the contents for an event clears the cache.
+    struct CacheKey
+    {
+      ResourceId texid;
+      uint32_t eventId = 0;
+      uint32_t sliceFace = 0;
+      uint32_t mip = 0;
+      uint32_t sample = 0;
+      CompType typeHint = CompType::Typeless;
+      // histogram only
+      uint32_t channels = 0;
+      float minval = 0.0f, maxval = 0.0f;
+
+      bool operator<(const CacheKey &o) const
+      {
+        if(texid != o.texid)
+          return texid < o.texid;
+        if(eventId != o.eventId)
+          return eventId < o.eventId;
+        if(sliceFace != o.sliceFace)
+          return sliceFace < o.sliceFace;
+        if(mip != o.mip)
+          return mip < o.mip;
+        if(sample != o.sample)
+          return sample < o.sample;
+        if(typeHint != o.typeHint)
+          return typeHint < o.typeHint;
+        if(channels != o.channels)
+          return channels < o.channels;
+        if(minval != o.minval)
+          return minval < o.minval;
+        return maxval < o.maxval;
+      }
+    };
+
+    std::map<CacheKey, std::pair<Vec4f, Vec4f>> m_MinMaxCache;
+    std::map<CacheKey, std::vector<uint32_t>> m_HistogramCache;
+
+    void ClearCache();
+    void ClearCache(ResourceId texid);
   } m_Histogram;
 
   struct PostVS
@@ -605,8 +663,46 @@ private:
 
     std::map<uint32_t, VulkanPostVSData> Data;
     std::map<uint32_t, uint32_t> Alias;
+
+    // incremented for each separate post-VS request. Data used in the current epoch is never
+    // evicted, so that a whole pass can be fetched and displayed together even over the budget.
+    uint64_t Epoch = 1;
+    bool InPass = false;
   } m_PostVS;
 
+  void FreePostVSData(VulkanPostVSData &data);
+  void EvictPostVSData(VkDeviceSize budget);
+
+  // a texture readback that has been recorded and submitted, but not yet waited on and copied out
+  struct TextureReadback
+  {
+    VkFence fence = VK_NULL_HANDLE;
+
+    VkBuffer readbackBuf = VK_NULL_HANDLE;
+    MemoryAllocation readbackMem;
+    uint32_t dataSize = 0;
+
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    bool isDepth = false, isStencil = false;
+    size_t pixelCount = 0;
+    VkDeviceSize stencilOffset = 0;
+
+    VkImage tmpImage = VK_NULL_HANDLE;
+    MemoryAllocation tmpMemory;
+
+    VkFramebuffer *tmpFB = NULL;
+    VkImageView *tmpView = NULL;
+    uint32_t numFBs = 0;
+    VkRenderPass tmpRP = VK_NULL_HANDLE;
+  };
+
+  bool QueueTextureReadback(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                            const GetTextureDataParams &params, TextureReadback &readback);
+  void FinishTextureReadback(TextureReadback &readback, bytebuf &data);
+
+  // unsignalled fences for tracking in-flight texture readbacks, recycled after each wait
+  std::vector<VkFence> m_ReadbackFences;
+
   std::vector<ResourceDescription> m_Resources;
   std::map<ResourceId, size_t> m_ResourceIdx;
 
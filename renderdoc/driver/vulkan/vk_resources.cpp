@@ -2889,6 +2889,161 @@ VkFormat MakeVkFormat(ResourceFormat fmt)
   return ret;
 }
 
+bool ImageLayouts::IsWholeImage(const VkImageSubresourceRange &range, uint32_t nummips,
+                                uint32_t numslices) const
+{
+  return range.baseMipLevel == 0 && range.baseArrayLayer == 0 && nummips == (uint32_t)levelCount &&
+         numslices == (uint32_t)layerCount;
+}
+
+bool ImageLayouts::IsSplit() const
+{
+  size_t count = size_t(levelCount) * size_t(layerCount);
+
+  if(count <= 1 || subresourceStates.size() != count)
+    return false;
+
+  // the first and last subresource are enough to tell it's laid out as we expect, nothing else
+  // creates this many states
+  const VkImageSubresourceRange &first = subresourceStates.front().subresourceRange;
+  const VkImageSubresourceRange &last = subresourceStates.back().subresourceRange;
+
+  return first.baseMipLevel == 0 && first.baseArrayLayer == 0 && first.levelCount == 1 &&
+         first.layerCount == 1 && last.baseMipLevel == uint32_t(levelCount - 1) &&
+         last.baseArrayLayer == uint32_t(layerCount - 1) && last.levelCount == 1 &&
+         last.layerCount == 1;
+}
+
+bool ImageLayouts::ApplyBarrier(ImageRegionState &t, uint32_t nummips, uint32_t numslices)
+{
+  const VkImageSubresourceRange &range = t.subresourceRange;
+
+  if(subresourceStates.size() == 1)
+  {
+    ImageRegionState &state = subresourceStates[0];
+
+    if(!IsWholeImage(state.subresourceRange, state.subresourceRange.levelCount,
+                     state.subresourceRange.layerCount))
+      return false;
+
+    if(IsWholeImage(range, nummips, numslices))
+    {
+      if(state.oldLayout == UNKNOWN_PREV_IMG_LAYOUT)
+        state.oldLayout = t.oldLayout;
+      t.oldLayout = state.newLayout;
+      state.newLayout = t.newLayout;
+      return true;
+    }
+
+    // split into one state per subresource, slice-major
+    ImageRegionState existing = state;
+    existing.subresourceRange.levelCount = 1;
+    existing.subresourceRange.layerCount = 1;
+
+    subresourceStates.assign(size_t(levelCount) * size_t(layerCount), existing);
+
+    size_t i = 0;
+    for(int slice = 0; slice < layerCount; slice++)
+    {
+      for(int mip = 0; mip < levelCount; mip++)
+      {
+        subresourceStates[i].subresourceRange.baseArrayLayer = uint32_t(slice);
+        subresourceStates[i].subresourceRange.baseMipLevel = uint32_t(mip);
+        i++;
+      }
+    }
+  }
+  else if(!IsSplit())
+  {
+    return false;
+  }
+
+  uint32_t endMip = RDCMIN(range.baseMipLevel + nummips, (uint32_t)levelCount);
+  uint32_t endSlice = RDCMIN(range.baseArrayLayer + numslices, (uint32_t)layerCount);
+
+  if(range.baseMipLevel >= endMip || range.baseArrayLayer >= endSlice)
+    return false;
+
+  if(nummips == 1 && numslices == 1)
+  {
+    ImageRegionState &state =
+        subresourceStates[range.baseArrayLayer * levelCount + range.baseMipLevel];
+
+    if(state.oldLayout == UNKNOWN_PREV_IMG_LAYOUT)
+      state.oldLayout = t.oldLayout;
+    t.oldLayout = state.newLayout;
+    state.newLayout = t.newLayout;
+    return true;
+  }
+
+  for(uint32_t slice = range.baseArrayLayer; slice < endSlice; slice++)
+  {
+    ImageRegionState *state = &subresourceStates[slice * levelCount + range.baseMipLevel];
+
+    for(uint32_t mip = range.baseMipLevel; mip < endMip; mip++, state++)
+    {
+      // apply it (prevstate is from the start of all barriers accumulated, so only set once)
+      if(state->oldLayout == UNKNOWN_PREV_IMG_LAYOUT)
+        state->oldLayout = t.oldLayout;
+      state->newLayout = t.newLayout;
+    }
+  }
+
+  // if the whole image has been transitioned it's likely to be back in one state, so merge it back
+  // to keep future barriers cheap
+  if(IsWholeImage(range, nummips, numslices))
+  {
+    const ImageRegionState &first = subresourceStates[0];
+
+    bool allIdentical = true;
+
+    for(size_t i = 1; i < subresourceStates.size(); i++)
+    {
+      if(subresourceStates[i].oldLayout != first.oldLayout ||
+         subresourceStates[i].newLayout != first.newLayout ||
+         subresourceStates[i].dstQueueFamilyIndex != first.dstQueueFamilyIndex)
+      {
+        allIdentical = false;
+        break;
+      }
+    }
+
+    if(allIdentical)
+    {
+      subresourceStates.erase(subresourceStates.begin() + 1, subresourceStates.end());
+      subresourceStates[0].subresourceRange.levelCount = (uint32_t)levelCount;
+      subresourceStates[0].subresourceRange.layerCount = (uint32_t)layerCount;
+    }
+  }
+
+  return true;
+}
+
+uint32_t DescriptorSetData::UpdateFlatRefs()
+{
+  SCOPED_LOCK(flatLock);
+
+  if(flatGeneration == refsGeneration)
+    return flatGeneration;
+
+  flatFrameRefs.assign(bindFrameRefs.begin(), bindFrameRefs.end());
+
+  flatWrittenRefs.clear();
+  flatMemRefs.clear();
+  for(auto it = flatFrameRefs.begin(); it != flatFrameRefs.end(); ++it)
+  {
+    FrameRefType ref = it->second.second;
+    if(ref == eFrameRef_PartialWrite || ref == eFrameRef_ReadBeforeWrite)
+      flatWrittenRefs.push_back(it->first);
+    if(it->second.first & MEMORY_REF_BIT)
+      flatMemRefs.push_back(it->first);
+  }
+
+  flatGeneration = refsGeneration;
+
+  return flatGeneration;
+}
+
 VkResourceRecord::~VkResourceRecord()
 {
   VkResourceType resType = Resource != NULL ? IdentifyTypeByPtr(Resource) : eResUnknown;
@@ -2944,6 +3099,24 @@ void VkResourceRecord::MarkMemoryFrameReferenced(ResourceId mem, VkDeviceSize of
       mem, maxRef, [](FrameRefType x, FrameRefType y) -> FrameRefType { return std::max(x, y); });
 }
 
+void VkResourceRecord::MarkBoundMemoryFrameReferenced(ResourceId mem, FrameRefType refType)
+{
+  if(mem == ResourceId())
+    return;
+
+  MarkResourceFrameReferenced(mem, refType);
+  cmdInfo->memRefIDs.push_back(mem);
+}
+
+void VkResourceRecord::MarkImageFrameReferenced(VkResourceRecord *img, FrameRefType refType)
+{
+  MarkResourceFrameReferenced(img->GetResourceID(), refType);
+  // the memory is only marked as read, the image's own ref tracks the write
+  MarkBoundMemoryFrameReferenced(img->baseResource, eFrameRef_Read);
+  if(img->resInfo)
+    cmdInfo->sparse.insert(img->resInfo);
+}
+
 void VkResourceRecord::MarkBufferFrameReferenced(VkResourceRecord *buf, VkDeviceSize offset,
                                                  VkDeviceSize size, FrameRefType refType)
 {
@@ -2965,7 +3138,7 @@ void VkResourceRecord::MarkBufferImageCopyFrameReferenced(
     const VkBufferImageCopy *regions, FrameRefType bufRefType, FrameRefType imgRefType)
 {
   MarkResourceFrameReferenced(img->GetResourceID(), imgRefType);
-  MarkResourceFrameReferenced(img->baseResource, imgRefType);
+  MarkBoundMemoryFrameReferenced(img->baseResource, imgRefType);
 
   // mark buffer just as read
   MarkResourceFrameReferenced(buf->GetResourceID(), eFrameRef_Read);
@@ -3859,4 +4032,161 @@ TEST_CASE("Vulkan formats", "[format][vulkan]")
   };
 };
 
+static ImageLayouts MakeTestLayouts(int levels, int layers)
+{
+  ImageLayouts ret;
+  ret.levelCount = levels;
+  ret.layerCount = layers;
+
+  VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, (uint32_t)levels, 0,
+                                   (uint32_t)layers};
+  ret.subresourceStates.push_back(ImageRegionState(VK_QUEUE_FAMILY_IGNORED, range,
+                                                   UNKNOWN_PREV_IMG_LAYOUT,
+                                                   VK_IMAGE_LAYOUT_UNDEFINED));
+  return ret;
+}
+
+static ImageRegionState MakeTestBarrier(uint32_t baseMip, uint32_t baseSlice, VkImageLayout from,
+                                        VkImageLayout to)
+{
+  VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, baseMip, 1, baseSlice, 1};
+  return ImageRegionState(VK_QUEUE_FAMILY_IGNORED, range, from, to);
+}
+
+TEST_CASE("Vulkan image layout barriers", "[vulkan]")
+{
+  const int levels = 4, layers = 8;
+
+  ImageLayouts layouts = MakeTestLayouts(levels, layers);
+
+  SECTION("Whole image barrier stays as one state")
+  {
+    ImageRegionState t = layouts.subresourceStates[0];
+    t.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    t.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    CHECK(layouts.ApplyBarrier(t, levels, layers));
+    REQUIRE(layouts.subresourceStates.size() == 1);
+    CHECK(layouts.subresourceStates[0].newLayout == VK_IMAGE_LAYOUT_GENERAL);
+    // the barrier is updated with the layout it came from
+    CHECK(t.oldLayout == VK_IMAGE_LAYOUT_UNDEFINED);
+  };
+
+  SECTION("Single subresource barrier splits the image")
+  {
+    ImageRegionState t =
+        MakeTestBarrier(2, 5, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    CHECK(layouts.ApplyBarrier(t, 1, 1));
+    REQUIRE(layouts.subresourceStates.size() == size_t(levels * layers));
+
+    for(int slice = 0; slice < layers; slice++)
+    {
+      for(int mip = 0; mip < levels; mip++)
+      {
+        const ImageRegionState &state = layouts.subresourceStates[slice * levels + mip];
+
+        CHECK(state.subresourceRange.baseMipLevel == (uint32_t)mip);
+        CHECK(state.subresourceRange.baseArrayLayer == (uint32_t)slice);
+        CHECK(state.subresourceRange.levelCount == 1);
+        CHECK(state.subresourceRange.layerCount == 1);
+
+        if(mip == 2 && slice == 5)
+          CHECK(state.newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        else
+          CHECK(state.newLayout == VK_IMAGE_LAYOUT_UNDEFINED);
+      }
+    }
+
+    SECTION("Range barrier only touches covered subresources")
+    {
+      ImageRegionState range =
+          MakeTestBarrier(1, 2, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+      CHECK(layouts.ApplyBarrier(range, 2, 3));
+      REQUIRE(layouts.subresourceStates.size() == size_t(levels * layers));
+
+      for(int slice = 0; slice < layers; slice++)
+      {
+        for(int mip = 0; mip < levels; mip++)
+        {
+          const ImageRegionState &state = layouts.subresourceStates[slice * levels + mip];
+
+          bool inRange = mip >= 1 && mip < 3 && slice >= 2 && slice < 5;
+
+          if(inRange)
+            CHECK(state.newLayout == VK_IMAGE_LAYOUT_GENERAL);
+          else if(mip == 2 && slice == 5)
+            CHECK(state.newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+          else
+            CHECK(state.newLayout == VK_IMAGE_LAYOUT_UNDEFINED);
+        }
+      }
+    };
+
+    SECTION("Whole image barrier merges identical states")
+    {
+      // bring the other subresources' first layout in line, so they can be merged
+      for(ImageRegionState &state : layouts.subresourceStates)
+        state.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+      ImageRegionState t = layouts.subresourceStates[0];
+      t.subresourceRange.levelCount = levels;
+      t.subresourceRange.layerCount = layers;
+      t.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      t.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+      CHECK(layouts.ApplyBarrier(t, levels, layers));
+      REQUIRE(layouts.subresourceStates.size() == 1);
+      CHECK(layouts.subresourceStates[0].newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+      CHECK(layouts.subresourceStates[0].subresourceRange.levelCount == (uint32_t)levels);
+      CHECK(layouts.subresourceStates[0].subresourceRange.layerCount == (uint32_t)layers);
+    };
+  };
+
+  SECTION("Unrecognised states are left for the general case")
+  {
+    layouts.subresourceStates[0].subresourceRange.levelCount = 2;
+
+    ImageRegionState t = MakeTestBarrier(0, 0, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+    CHECK_FALSE(layouts.ApplyBarrier(t, 1, 1));
+    CHECK(layouts.subresourceStates.size() == 1);
+  };
+};
+
+// not run by default, use the [benchmark] tag to run explicitly
+TEST_CASE("Vulkan image layout barrier benchmark", "[.][benchmark][vulkan]")
+{
+  // a large texture array or shadow atlas
+  const int levels = 12, layers = 2048;
+
+  ImageLayouts layouts = MakeTestLayouts(levels, layers);
+
+  PerformanceTimer timer;
+
+  // transition every subresource individually, back and forth
+  for(int pass = 0; pass < 2; pass++)
+  {
+    VkImageLayout from = pass == 0 ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_GENERAL;
+    VkImageLayout to = pass == 0 ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    for(int slice = 0; slice < layers; slice++)
+    {
+      for(int mip = 0; mip < levels; mip++)
+      {
+        ImageRegionState t = MakeTestBarrier(mip, slice, from, to);
+        layouts.ApplyBarrier(t, 1, 1);
+      }
+    }
+  }
+
+  double ms = timer.GetMilliseconds();
+
+  RDCLOG("%d single-subresource barriers on a %dx%d image took %.3f ms", levels * layers * 2,
+         levels, layers, ms);
+
+  CHECK(layouts.subresourceStates.size() == size_t(levels * layers));
+};
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -929,12 +929,19 @@ struct CmdBufferRecordingInfo
   // a list of descriptor sets that are bound at any point in this command buffer
   // used to look up all the frame refs per-desc set and apply them on queue
   // submit with latest binding refs.
-  set<VkDescriptorSet> boundDescSets;
+  // Along with each is the refsGeneration of the set when its writes were last added to dirtied,
+  // so binding an unchanged set again doesn't need to look at its refs.
+  map<VkDescriptorSet, uint32_t> boundDescSets;
 
   vector<VkResourceRecord *> subcmds;
 
   std::map<ResourceId, MemRefs> memFrameRefs;
 
+  // the IDs of all memory referenced, sorted and flattened from memFrameRefs when baking. Memory
+  // referenced without a range (e.g. behind framebuffer attachments) is added directly. On submit
+  // only these need to be checked against the currently mapped memory.
+  std::vector<ResourceId> memRefIDs;
+
   // AdvanceFrame/Present should be called after this buffer is submitted
   bool present;
 };
@@ -962,9 +969,30 @@ struct DescriptorSetData
   // and then applied in a block on descriptor set bind.
   // the refcount has the high-bit set if this resource has sparse
   // mapping information
+  // similarly the next bit is set if the resource is a memory object
   static const uint32_t SPARSE_REF_BIT = 0x80000000;
+  static const uint32_t MEMORY_REF_BIT = 0x40000000;
+  static const uint32_t REF_COUNT_MASK = ~(SPARSE_REF_BIT | MEMORY_REF_BIT);
   map<ResourceId, pair<uint32_t, FrameRefType> > bindFrameRefs;
   map<ResourceId, MemRefs> bindMemRefs;
+
+  // incremented whenever bindFrameRefs changes
+  uint32_t refsGeneration = 1;
+
+  // flattened copies of bindFrameRefs, sorted by ID, which are much cheaper to walk on every bind
+  // and submit than the map. Only valid after calling UpdateFlatRefs(), which returns the
+  // generation they correspond to.
+  uint32_t UpdateFlatRefs();
+  std::vector<pair<ResourceId, pair<uint32_t, FrameRefType> > > flatFrameRefs;
+  // just the IDs of resources that may be written through this set
+  std::vector<ResourceId> flatWrittenRefs;
+  // just the IDs of memory objects referenced through this set
+  std::vector<ResourceId> flatMemRefs;
+
+private:
+  // the same set can be bound on several threads at once, so rebuilding has to be locked
+  Threading::CriticalSection flatLock;
+  uint32_t flatGeneration = 0;
 };
 
 struct PipelineLayoutData
@@ -980,6 +1008,7 @@ struct MemMapState
         needRefData(false),
         mapFlushed(false),
         mapCoherent(false),
+        writeTracked(false),
         mappedPtr(NULL),
         refData(NULL)
   {
@@ -988,8 +1017,15 @@ struct MemMapState
   bool needRefData;
   bool mapFlushed;
   bool mapCoherent;
+  // if the OS is tracking writes to this map then refData isn't used, instead writtenRanges
+  // accumulates the ranges written since they were last serialised.
+  bool writeTracked;
   byte *mappedPtr;
   byte *refData;
+  // with the hashMappedMemory capture option, a hash per page of the mapping is kept instead of
+  // refData. See HashPages()
+  rdcarray<uint64_t> refHashes;
+  rdcarray<rdcpair<size_t, size_t>> writtenRanges;
 };
 
 struct AttachmentInfo
@@ -1111,6 +1147,14 @@ public:
     cmdInfo->subcmds.swap(bakedCommands->cmdInfo->subcmds);
     cmdInfo->sparse.swap(bakedCommands->cmdInfo->sparse);
     cmdInfo->memFrameRefs.swap(bakedCommands->cmdInfo->memFrameRefs);
+    cmdInfo->memRefIDs.swap(bakedCommands->cmdInfo->memRefIDs);
+
+    std::vector<ResourceId> &memRefIDs = bakedCommands->cmdInfo->memRefIDs;
+    for(auto it = bakedCommands->cmdInfo->memFrameRefs.begin();
+        it != bakedCommands->cmdInfo->memFrameRefs.end(); ++it)
+      memRefIDs.push_back(it->first);
+    std::sort(memRefIDs.begin(), memRefIDs.end());
+    memRefIDs.erase(std::unique(memRefIDs.begin(), memRefIDs.end()), memRefIDs.end());
   }
 
   void AddBindFrameRef(ResourceId id, FrameRefType ref, bool hasSparse = false)
@@ -1120,8 +1164,9 @@ public:
       RDCERR("Unexpected NULL resource ID being added as a bind frame ref");
       return;
     }
+    descInfo->refsGeneration++;
     pair<uint32_t, FrameRefType> &p = descInfo->bindFrameRefs[id];
-    if((p.first & ~DescriptorSetData::SPARSE_REF_BIT) == 0)
+    if((p.first & DescriptorSetData::REF_COUNT_MASK) == 0)
     {
       p.second = ref;
       p.first = 1 | (hasSparse ? DescriptorSetData::SPARSE_REF_BIT : 0);
@@ -1142,8 +1187,9 @@ public:
       RDCERR("Unexpected NULL resource ID being added as a bind frame ref");
       return;
     }
+    descInfo->refsGeneration++;
     pair<uint32_t, FrameRefType> &p = descInfo->bindFrameRefs[mem];
-    if((p.first & ~DescriptorSetData::SPARSE_REF_BIT) == 0)
+    if((p.first & DescriptorSetData::REF_COUNT_MASK) == 0)
     {
       descInfo->bindMemRefs.erase(mem);
       p.first = 1;
@@ -1153,11 +1199,24 @@ public:
     {
       p.first++;
     }
+    p.first |= DescriptorSetData::MEMORY_REF_BIT;
     FrameRefType maxRef = MarkMemoryReferenced(descInfo->bindMemRefs, mem, offset, size, refType,
                                                ComposeFrameRefsUnordered);
     p.second = std::max(p.second, maxRef);
   }
 
+  // memory referenced without a known range, such as the memory behind an image view
+  void AddBindMemoryRef(ResourceId mem, FrameRefType ref)
+  {
+    if(mem == ResourceId())
+    {
+      RDCERR("Unexpected NULL resource ID being added as a bind frame ref");
+      return;
+    }
+    AddBindFrameRef(mem, ref);
+    descInfo->bindFrameRefs[mem].first |= DescriptorSetData::MEMORY_REF_BIT;
+  }
+
   void RemoveBindFrameRef(ResourceId id)
   {
     // ignore any NULL IDs - probably an object that was
@@ -1174,9 +1233,10 @@ public:
     if(it == descInfo->bindFrameRefs.end())
       return;
 
+    descInfo->refsGeneration++;
     it->second.first--;
 
-    if((it->second.first & ~DescriptorSetData::SPARSE_REF_BIT) == 0)
+    if((it->second.first & DescriptorSetData::REF_COUNT_MASK) == 0)
       descInfo->bindFrameRefs.erase(it);
   }
 
@@ -1207,6 +1267,12 @@ public:
 
   void MarkMemoryFrameReferenced(ResourceId mem, VkDeviceSize offset, VkDeviceSize size,
                                  FrameRefType refType);
+  // marks memory that is referenced without a known range, such as the memory an image is bound
+  // to, and records it in memRefIDs so queue submits check it for coherent map changes.
+  void MarkBoundMemoryFrameReferenced(ResourceId mem, FrameRefType refType);
+  // marks an image and the memory it's bound to. Use this rather than marking baseResource
+  // directly, so the memory is never missed from memRefIDs.
+  void MarkImageFrameReferenced(VkResourceRecord *img, FrameRefType refType);
   void MarkBufferFrameReferenced(VkResourceRecord *buf, VkDeviceSize offset, VkDeviceSize size,
                                  FrameRefType refType);
   void MarkBufferImageCopyFrameReferenced(VkResourceRecord *buf, VkResourceRecord *img,
@@ -1321,11 +1387,25 @@ struct ImageLayouts
     extent.width = extent.height = extent.depth = 1;
   }
 
+  // subresourceStates is normally either a single state for the whole image, or once the image
+  // has been split one state per subresource ordered by array slice then mip. In those forms a
+  // barrier can be applied by indexing directly to the subresources it covers, instead of
+  // searching. Returns false if the states aren't in either form and nothing was applied.
+  //
+  // As with the general case, if the barrier covers exactly one state its oldLayout is updated to
+  // the layout the state was in before.
+  bool ApplyBarrier(ImageRegionState &t, uint32_t nummips, uint32_t numslices);
+
   uint32_t queueFamilyIndex = 0;
   vector<ImageRegionState> subresourceStates;
   int layerCount, levelCount, sampleCount;
   VkExtent3D extent;
   VkFormat format;
+
+private:
+  bool IsWholeImage(const VkImageSubresourceRange &range, uint32_t nummips,
+                    uint32_t numslices) const;
+  bool IsSplit() const;
 };
 
 DECLARE_REFLECTION_STRUCT(ImageLayouts);
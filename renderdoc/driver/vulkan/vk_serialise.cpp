@@ -227,6 +227,10 @@ void DoSerialiseViaResourceId(SerialiserType &ser, type &el)
 
     if(id != ResourceId() && rm)
     {
+      // this may be a pipeline that hasn't been created yet while loading
+      if(!rm->HasLiveResource(id))
+        rm->FlushPendingPipelines();
+
       if(rm->HasLiveResource(id))
       {
         // we leave this wrapped.
@@ -23,6 +23,7 @@
  ******************************************************************************/
 
 #include "vk_shader_cache.h"
+#include "api/replay/version.h"
 #include "common/shader_cache.h"
 #include "data/glsl_shaders.h"
 #include "driver/shaders/spirv/spirv_common.h"
@@ -111,6 +112,50 @@ struct VulkanBlobShaderCallbacks
   const byte *GetData(SPIRVBlob blob) const { return (const byte *)blob->data(); }
 } VulkanShaderCacheCallbacks;
 
+struct VulkanReflectionCallbacks
+{
+  bool Create(uint32_t size, byte *data, ReflectionBlob *ret) const
+  {
+    RDCASSERT(ret);
+
+    *ret = new std::vector<byte>(data, data + size);
+
+    return true;
+  }
+
+  void Destroy(ReflectionBlob blob) const { delete blob; }
+  uint32_t GetSize(ReflectionBlob blob) const { return (uint32_t)blob->size(); }
+  const byte *GetData(ReflectionBlob blob) const { return blob->data(); }
+} VulkanReflectionCacheCallbacks;
+
+// shaders with a lot of embedded source can have huge reflection data, don't bloat the cache with
+// them.
+static const size_t MaxCachedReflectionSize = 256 * 1024;
+
+// the on-disk reflection cache is shared by every capture that's opened, so it's capped in total.
+// Beyond this the least recently used entries are dropped when it's saved.
+static const uint64_t MaxReflectionCacheSize = 64 * 1024 * 1024;
+
+DECLARE_REFLECTION_STRUCT(SPIRVPatchData::InterfaceAccess);
+DECLARE_REFLECTION_STRUCT(SPIRVPatchData);
+
+template <typename SerialiserType>
+void DoSerialise(SerialiserType &ser, SPIRVPatchData::InterfaceAccess &el)
+{
+  SERIALISE_MEMBER(ID);
+  SERIALISE_MEMBER(structID);
+  SERIALISE_MEMBER(accessChain);
+  SERIALISE_MEMBER(isMatrix);
+}
+
+template <typename SerialiserType>
+void DoSerialise(SerialiserType &ser, SPIRVPatchData &el)
+{
+  SERIALISE_MEMBER(inputs);
+  SERIALISE_MEMBER(outputs);
+  SERIALISE_MEMBER(outTopo);
+}
+
 VulkanShaderCache::VulkanShaderCache(WrappedVulkan *driver)
 {
   // Load shader cache, if present
@@ -197,6 +242,18 @@ VulkanShaderCache::VulkanShaderCache(WrappedVulkan *driver)
   }
 
   SetCaching(false);
+
+  if(IsReplayMode(driver->GetState()))
+  {
+    LoadPipelineCache();
+
+    LoadShaderCache("vkreflection.cache", m_ReflectionCacheMagic, m_ReflectionCacheVersion,
+                    m_ReflectionCache, VulkanReflectionCacheCallbacks);
+
+    // this session comes after any that used the loaded entries
+    for(auto it = m_ReflectionCache.begin(); it != m_ReflectionCache.end(); ++it)
+      m_ReflectionSession = RDCMAX(m_ReflectionSession, GetReflectionSession(it->second) + 1);
+  }
 }
 
 VulkanShaderCache::~VulkanShaderCache()
@@ -212,8 +269,289 @@ VulkanShaderCache::~VulkanShaderCache()
       VulkanShaderCacheCallbacks.Destroy(it->second);
   }
 
+  if(m_ReflectionCacheDirty)
+  {
+    TrimReflectionCache(m_ReflectionCache, MaxReflectionCacheSize);
+
+    SaveShaderCache("vkreflection.cache", m_ReflectionCacheMagic, m_ReflectionCacheVersion,
+                    m_ReflectionCache, VulkanReflectionCacheCallbacks);
+  }
+  else
+  {
+    for(auto it = m_ReflectionCache.begin(); it != m_ReflectionCache.end(); ++it)
+      VulkanReflectionCacheCallbacks.Destroy(it->second);
+  }
+
   for(size_t i = 0; i < ARRAY_COUNT(m_BuiltinShaderModules); i++)
     m_pDriver->vkDestroyShaderModule(m_Device, m_BuiltinShaderModules[i], NULL);
+
+  if(m_PipelineCache != VK_NULL_HANDLE)
+  {
+    SavePipelineCache();
+
+    m_pDriver->vkDestroyPipelineCache(m_Device, m_PipelineCache, NULL);
+  }
+}
+
+uint64_t VulkanShaderCache::GetReflectionKey(const std::vector<uint32_t> &spirv,
+                                             const std::string &entry, uint32_t stageIndex)
+{
+  // reflection output changes between builds, so include the build in the key
+  uint64_t hash = strhash64(GitVersionHash);
+
+  const byte *data = (const byte *)spirv.data();
+  for(size_t i = 0; i < spirv.size() * sizeof(uint32_t); i++)
+  {
+    hash ^= data[i];
+    hash *= 1099511628211ULL;
+  }
+
+  hash = strhash64(entry.c_str(), hash);
+  hash ^= stageIndex;
+  hash *= 1099511628211ULL;
+
+  return hash;
+}
+
+bool VulkanShaderCache::GetReflection(uint64_t key, ShaderReflection &refl,
+                                      ShaderBindpointMapping &mapping, SPIRVPatchData &patchData)
+{
+  auto it = m_ReflectionCache.find(key);
+  if(it == m_ReflectionCache.end())
+    return false;
+
+  if(!DecodeReflection(it->second, refl, mapping, patchData))
+  {
+    RDCWARN("Corrupt cached shader reflection, discarding");
+
+    VulkanReflectionCacheCallbacks.Destroy(it->second);
+    m_ReflectionCache.erase(it);
+    m_ReflectionCacheDirty = true;
+
+    refl = ShaderReflection();
+    mapping = ShaderBindpointMapping();
+    patchData = SPIRVPatchData();
+
+    return false;
+  }
+
+  if(GetReflectionSession(it->second) != m_ReflectionSession)
+  {
+    SetReflectionSession(it->second, m_ReflectionSession);
+    m_ReflectionCacheDirty = true;
+  }
+
+  return true;
+}
+
+void VulkanShaderCache::SetReflection(uint64_t key, ShaderReflection &refl,
+                                      ShaderBindpointMapping &mapping, SPIRVPatchData &patchData)
+{
+  if(m_ReflectionCache.find(key) != m_ReflectionCache.end())
+    return;
+
+  ReflectionBlob blob = EncodeReflection(m_ReflectionSession, refl, mapping, patchData);
+
+  if(blob->size() > MaxCachedReflectionSize)
+  {
+    VulkanReflectionCacheCallbacks.Destroy(blob);
+    return;
+  }
+
+  m_ReflectionCache[key] = blob;
+  m_ReflectionCacheDirty = true;
+}
+
+ReflectionBlob VulkanShaderCache::EncodeReflection(uint32_t session, ShaderReflection &refl,
+                                                   ShaderBindpointMapping &mapping,
+                                                   SPIRVPatchData &patchData)
+{
+  WriteSerialiser ser(new StreamWriter(StreamWriter::DefaultScratchSize), Ownership::Stream);
+
+  ser.GetWriter()->Write(session);
+
+  ser.Serialise("refl", refl);
+  ser.Serialise("mapping", mapping);
+  ser.Serialise("patchData", patchData);
+
+  StreamWriter *writer = ser.GetWriter();
+
+  return new std::vector<byte>(writer->GetData(), writer->GetData() + writer->GetOffset());
+}
+
+bool VulkanShaderCache::DecodeReflection(ReflectionBlob blob, ShaderReflection &refl,
+                                         ShaderBindpointMapping &mapping, SPIRVPatchData &patchData)
+{
+  ReadSerialiser ser(new StreamReader(*blob), Ownership::Stream);
+
+  // skip the session through the same stream it was written to, so any aligned data matches up
+  uint32_t session = 0;
+  ser.GetReader()->Read(session);
+
+  ser.Serialise("refl", refl);
+  ser.Serialise("mapping", mapping);
+  ser.Serialise("patchData", patchData);
+
+  return !ser.IsErrored();
+}
+
+uint32_t VulkanShaderCache::GetReflectionSession(ReflectionBlob blob)
+{
+  uint32_t session = 0;
+  if(blob->size() >= sizeof(uint32_t))
+    memcpy(&session, blob->data(), sizeof(uint32_t));
+  return session;
+}
+
+void VulkanShaderCache::SetReflectionSession(ReflectionBlob blob, uint32_t session)
+{
+  if(blob->size() >= sizeof(uint32_t))
+    memcpy(blob->data(), &session, sizeof(uint32_t));
+}
+
+void VulkanShaderCache::TrimReflectionCache(std::map<uint64_t, ReflectionBlob> &cache,
+                                            uint64_t maxSize)
+{
+  uint64_t totalSize = 0;
+  for(auto it = cache.begin(); it != cache.end(); ++it)
+    totalSize += it->second->size();
+
+  if(totalSize <= maxSize)
+    return;
+
+  // drop the entries used longest ago first
+  std::vector<rdcpair<uint32_t, uint64_t>> lru;
+  lru.reserve(cache.size());
+  for(auto it = cache.begin(); it != cache.end(); ++it)
+    lru.push_back({GetReflectionSession(it->second), it->first});
+
+  std::sort(lru.begin(), lru.end());
+
+  for(size_t i = 0; i < lru.size() && totalSize > maxSize; i++)
+  {
+    auto it = cache.find(lru[i].second);
+    totalSize -= it->second->size();
+    VulkanReflectionCacheCallbacks.Destroy(it->second);
+    cache.erase(it);
+  }
+}
+
+void VulkanShaderCache::LoadPipelineCache()
+{
+  const VkPhysicalDeviceProperties &props = m_pDriver->GetDeviceProps();
+
+  // the driver would reject data from another device or driver anyway, but keep a separate file for
+  // each so that switching between GPUs doesn't throw the cache away each time.
+  std::string deviceKey =
+      StringFormat::Fmt("%u_%u_%u_", props.vendorID, props.deviceID, props.driverVersion);
+  for(size_t i = 0; i < VK_UUID_SIZE; i++)
+    deviceKey += StringFormat::Fmt("%02x", props.pipelineCacheUUID[i]);
+
+  m_PipelineCacheFile =
+      StringFormat::Fmt("vkpipelines_%016llx.cache", strhash64(deviceKey.c_str()));
+
+  std::vector<byte> data;
+
+  FILE *f = FileIO::fopen(FileIO::GetAppFolderFilename(m_PipelineCacheFile).c_str(), "rb");
+  if(f)
+  {
+    FileIO::fseek64(f, 0, SEEK_END);
+    data.resize((size_t)FileIO::ftell64(f));
+    FileIO::fseek64(f, 0, SEEK_SET);
+    if(FileIO::fread(data.data(), 1, data.size(), f) != data.size())
+      data.clear();
+    FileIO::fclose(f);
+  }
+
+  // validate the VkPipelineCacheHeaderVersionOne header ourselves before handing it to the driver
+  const size_t headerSize = sizeof(uint32_t) * 4 + VK_UUID_SIZE;
+
+  if(!data.empty())
+  {
+    uint32_t header[4];
+    if(data.size() >= headerSize)
+      memcpy(header, data.data(), sizeof(header));
+
+    if(data.size() < headerSize || header[0] < headerSize ||
+       header[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || header[2] != props.vendorID ||
+       header[3] != props.deviceID ||
+       memcmp(data.data() + sizeof(header), props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+      RDCDEBUG("Discarding incompatible pipeline cache %s", m_PipelineCacheFile.c_str());
+      data.clear();
+    }
+  }
+
+  VkPipelineCacheCreateInfo cacheInfo = {
+      VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO, NULL, 0, data.size(), data.data(),
+  };
+
+  // create directly rather than through vkCreatePipelineCache, which strips any initial data
+  VkResult vkr =
+      ObjDisp(m_Device)->CreatePipelineCache(Unwrap(m_Device), &cacheInfo, NULL, &m_PipelineCache);
+
+  if(vkr != VK_SUCCESS && !data.empty())
+  {
+    RDCWARN("Couldn't create pipeline cache from %s: %s", m_PipelineCacheFile.c_str(),
+            ToStr(vkr).c_str());
+
+    data.clear();
+    cacheInfo.initialDataSize = 0;
+    cacheInfo.pInitialData = NULL;
+    vkr = ObjDisp(m_Device)->CreatePipelineCache(Unwrap(m_Device), &cacheInfo, NULL,
+                                                 &m_PipelineCache);
+  }
+
+  if(vkr != VK_SUCCESS)
+  {
+    RDCERR("Couldn't create replay pipeline cache: %s", ToStr(vkr).c_str());
+    m_PipelineCache = VK_NULL_HANDLE;
+    return;
+  }
+
+  ResourceId id = m_pDriver->GetResourceManager()->WrapResource(Unwrap(m_Device), m_PipelineCache);
+  m_pDriver->GetResourceManager()->AddLiveResource(id, m_PipelineCache);
+  m_pDriver->GetResourceManager()->SetInternalResource(id);
+
+  m_PipelineCacheLoadedSize = data.size();
+
+  if(!data.empty())
+    RDCDEBUG("Loaded %zu bytes of pipeline cache from %s", data.size(),
+             m_PipelineCacheFile.c_str());
+}
+
+void VulkanShaderCache::SavePipelineCache()
+{
+  size_t size = 0;
+  VkResult vkr = ObjDisp(m_Device)->GetPipelineCacheData(Unwrap(m_Device), Unwrap(m_PipelineCache),
+                                                         &size, NULL);
+
+  // nothing new was added since we loaded it
+  if(vkr != VK_SUCCESS || size == 0 || size == m_PipelineCacheLoadedSize)
+    return;
+
+  std::vector<byte> data(size);
+  vkr = ObjDisp(m_Device)->GetPipelineCacheData(Unwrap(m_Device), Unwrap(m_PipelineCache), &size,
+                                                data.data());
+
+  if(vkr != VK_SUCCESS)
+  {
+    RDCWARN("Couldn't fetch pipeline cache data: %s", ToStr(vkr).c_str());
+    return;
+  }
+
+  FILE *f = FileIO::fopen(FileIO::GetAppFolderFilename(m_PipelineCacheFile).c_str(), "wb");
+
+  if(!f)
+  {
+    RDCERR("Error opening pipeline cache %s for write", m_PipelineCacheFile.c_str());
+    return;
+  }
+
+  FileIO::fwrite(data.data(), 1, size, f);
+  FileIO::fclose(f);
+
+  RDCDEBUG("Wrote %zu bytes of pipeline cache to %s", size, m_PipelineCacheFile.c_str());
 }
 
 std::string VulkanShaderCache::GetSPIRVBlob(const SPIRVCompilationSettings &settings,
@@ -221,12 +559,12 @@ std::string VulkanShaderCache::GetSPIRVBlob(const SPIRVCompilationSettings &sett
 {
   RDCASSERT(!src.empty());
 
-  uint32_t hash = strhash(src.c_str());
+  uint64_t hash = strhash64(src.c_str());
 
   char typestr[3] = {'a', 'a', 0};
   typestr[0] += (char)settings.stage;
   typestr[1] += (char)settings.lang;
-  hash = strhash(typestr, hash);
+  hash = strhash64(typestr, hash);
 
   if(m_ShaderCache.find(hash) != m_ShaderCache.end())
   {
@@ -593,3 +931,101 @@ void VulkanShaderCache::MakeComputePipelineInfo(VkComputePipelineCreateInfo &pip
 
   pipeCreateInfo = ret;
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#undef None
+
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Vulkan reflection cache", "[vulkan]")
+{
+  SECTION("Reflection round-trips through a cache blob")
+  {
+    ShaderReflection refl;
+    refl.stage = ShaderStage::Pixel;
+    refl.dispatchThreadsDimension[0] = 8;
+    refl.dispatchThreadsDimension[1] = 4;
+    refl.dispatchThreadsDimension[2] = 1;
+    refl.outputSignature.resize(1);
+    refl.outputSignature[0].varName = "outColor";
+    refl.outputSignature[0].regIndex = 2;
+    refl.outputSignature[0].compCount = 4;
+
+    ShaderBindpointMapping mapping;
+    mapping.inputAttributes = {3, -1, 0};
+    mapping.readOnlyResources.push_back(Bindpoint(1, 5));
+
+    SPIRVPatchData patchData;
+    patchData.outTopo = Topology::TriangleStrip;
+    patchData.outputs.resize(1);
+    patchData.outputs[0].ID = 42;
+    patchData.outputs[0].accessChain = {1, 2};
+
+    ReflectionBlob blob = VulkanShaderCache::EncodeReflection(7, refl, mapping, patchData);
+
+    CHECK(VulkanShaderCache::GetReflectionSession(blob) == 7);
+
+    ShaderReflection refl2;
+    ShaderBindpointMapping mapping2;
+    SPIRVPatchData patchData2;
+
+    REQUIRE(VulkanShaderCache::DecodeReflection(blob, refl2, mapping2, patchData2));
+
+    CHECK(refl2.stage == ShaderStage::Pixel);
+    CHECK(refl2.dispatchThreadsDimension[0] == 8);
+    CHECK(refl2.dispatchThreadsDimension[1] == 4);
+    CHECK(refl2.dispatchThreadsDimension[2] == 1);
+    REQUIRE(refl2.outputSignature.size() == 1);
+    CHECK(refl2.outputSignature[0].varName == "outColor");
+    CHECK(refl2.outputSignature[0].regIndex == 2);
+    CHECK(refl2.outputSignature[0].compCount == 4);
+
+    CHECK(mapping2.inputAttributes == mapping.inputAttributes);
+    REQUIRE(mapping2.readOnlyResources.size() == 1);
+    CHECK(mapping2.readOnlyResources[0].bindset == 1);
+    CHECK(mapping2.readOnlyResources[0].bind == 5);
+
+    CHECK(patchData2.outTopo == Topology::TriangleStrip);
+    REQUIRE(patchData2.outputs.size() == 1);
+    CHECK(patchData2.outputs[0].ID == 42);
+    CHECK(patchData2.outputs[0].accessChain == std::vector<uint32_t>({1, 2}));
+
+    // updating the session doesn't disturb the contents
+    VulkanShaderCache::SetReflectionSession(blob, 9);
+    CHECK(VulkanShaderCache::GetReflectionSession(blob) == 9);
+    CHECK(VulkanShaderCache::DecodeReflection(blob, refl2, mapping2, patchData2));
+
+    // a truncated blob fails rather than returning garbage
+    blob->resize(blob->size() / 2);
+    CHECK_FALSE(VulkanShaderCache::DecodeReflection(blob, refl2, mapping2, patchData2));
+
+    delete blob;
+  };
+
+  SECTION("Trimming drops the least recently used entries")
+  {
+    std::map<uint64_t, ReflectionBlob> cache;
+
+    // keys in the opposite order to their sessions, so map order doesn't decide what's dropped
+    for(uint32_t i = 0; i < 4; i++)
+    {
+      ReflectionBlob blob = new std::vector<byte>(100);
+      VulkanShaderCache::SetReflectionSession(blob, 10 + i);
+      cache[100 - i] = blob;
+    }
+
+    VulkanShaderCache::TrimReflectionCache(cache, 400);
+    CHECK(cache.size() == 4);
+
+    VulkanShaderCache::TrimReflectionCache(cache, 250);
+    REQUIRE(cache.size() == 2);
+    CHECK(cache.count(98) == 1);
+    CHECK(cache.count(97) == 1);
+
+    for(auto it = cache.begin(); it != cache.end(); ++it)
+      delete it->second;
+  };
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -29,6 +29,7 @@
 #include "vk_core.h"
 
 typedef std::vector<uint32_t> *SPIRVBlob;
+typedef std::vector<byte> *ReflectionBlob;
 
 enum class BuiltinShader
 {
@@ -74,16 +75,53 @@ public:
   void MakeGraphicsPipelineInfo(VkGraphicsPipelineCreateInfo &pipeCreateInfo, ResourceId pipeline);
   void MakeComputePipelineInfo(VkComputePipelineCreateInfo &pipeCreateInfo, ResourceId pipeline);
 
+  // on replay, a driver pipeline cache that is persisted across sessions for this device. All
+  // pipelines we create on replay, ours and the capture's, should go through this.
+  VkPipelineCache GetPipeCache() { return m_PipelineCache; }
   void SetCaching(bool enabled) { m_CacheShaders = enabled; }
+  // on replay, reflection of the capture's shaders is also persisted across sessions. The key
+  // covers the SPIR-V contents and the build, so identical shaders in any capture share an entry.
+  static uint64_t GetReflectionKey(const std::vector<uint32_t> &spirv, const std::string &entry,
+                                   uint32_t stageIndex);
+  bool GetReflection(uint64_t key, ShaderReflection &refl, ShaderBindpointMapping &mapping,
+                     SPIRVPatchData &patchData);
+  void SetReflection(uint64_t key, ShaderReflection &refl, ShaderBindpointMapping &mapping,
+                     SPIRVPatchData &patchData);
+
+  // each cached reflection blob starts with the session it was last used in, so the least recently
+  // used entries can be dropped when the cache grows too large.
+  static ReflectionBlob EncodeReflection(uint32_t session, ShaderReflection &refl,
+                                         ShaderBindpointMapping &mapping,
+                                         SPIRVPatchData &patchData);
+  static bool DecodeReflection(ReflectionBlob blob, ShaderReflection &refl,
+                               ShaderBindpointMapping &mapping, SPIRVPatchData &patchData);
+  static uint32_t GetReflectionSession(ReflectionBlob blob);
+  static void SetReflectionSession(ReflectionBlob blob, uint32_t session);
+  static void TrimReflectionCache(std::map<uint64_t, ReflectionBlob> &cache, uint64_t maxSize);
+
 private:
+  void LoadPipelineCache();
+  void SavePipelineCache();
+
   static const uint32_t m_ShaderCacheMagic = 0xf00d00d5;
-  static const uint32_t m_ShaderCacheVersion = 1;
+  static const uint32_t m_ShaderCacheVersion = 2;
+
+  static const uint32_t m_ReflectionCacheMagic = 0xf00d5efc;
+  static const uint32_t m_ReflectionCacheVersion = 2;
 
   WrappedVulkan *m_pDriver = NULL;
   VkDevice m_Device = VK_NULL_HANDLE;
 
   bool m_ShaderCacheDirty = false, m_CacheShaders = false;
-  std::map<uint32_t, SPIRVBlob> m_ShaderCache;
+  std::map<uint64_t, SPIRVBlob> m_ShaderCache;
+
+  VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
+  std::string m_PipelineCacheFile;
+  size_t m_PipelineCacheLoadedSize = 0;
+
+  bool m_ReflectionCacheDirty = false;
+  uint32_t m_ReflectionSession = 1;
+  std::map<uint64_t, ReflectionBlob> m_ReflectionCache;
 
   SPIRVBlob m_BuiltinShaderBlobs[arraydim<BuiltinShader>()] = {NULL};
   VkShaderModule m_BuiltinShaderModules[arraydim<BuiltinShader>()] = {VK_NULL_HANDLE};
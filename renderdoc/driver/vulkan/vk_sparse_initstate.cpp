@@ -25,6 +25,10 @@
 #include "vk_core.h"
 #include "vk_debug.h"
 
+// the granularity that sparse contents are de-duplicated at. This is the standard sparse block
+// size, so unbound or cleared blocks line up with whole pages.
+static const VkDeviceSize SparseInitPageSize = 64 * 1024;
+
 template <typename SerialiserType>
 void DoSerialise(SerialiserType &ser, MemIDOffset &el)
 {
@@ -115,6 +119,10 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
   uint32_t memidx = 0;
   for(auto it = boundMems.begin(); it != boundMems.end(); ++it)
   {
+    // each memory's contents start on a page boundary, so that pages never straddle two memories
+    // and can be de-duplicated when serialising
+    bufInfo.size = AlignUp(bufInfo.size, SparseInitPageSize);
+
     // store offset
     it->second = bufInfo.size;
 
@@ -176,21 +184,25 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
 
     ObjDisp(d)->CmdCopyBuffer(Unwrap(cmd), Unwrap(srcBuf), Unwrap(dstBuf), 1, &region);
 
+    // zero the padding before the next memory, so it doesn't stop that last page being elided
+    VkDeviceSize padStart = AlignUp(it->second + bufInfo.size, (VkDeviceSize)4);
+    VkDeviceSize padEnd = AlignUp(it->second + bufInfo.size, SparseInitPageSize);
+    padEnd = RDCMIN(padEnd, initContents.sparseBuffer.totalSize);
+
+    if(padStart < padEnd)
+      ObjDisp(d)->CmdFillBuffer(Unwrap(cmd), Unwrap(dstBuf), padStart, padEnd - padStart, 0);
+
     bufdeletes.push_back(srcBuf);
   }
 
   vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  // INITSTATEBATCH
-  SubmitCmds();
-  FlushQ();
+  m_InitStateBatch.buffers.insert(m_InitStateBatch.buffers.end(), bufdeletes.begin(),
+                                  bufdeletes.end());
 
-  for(size_t i = 0; i < bufdeletes.size(); i++)
-  {
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(bufdeletes[i]), NULL);
-    GetResourceManager()->ReleaseWrappedResource(bufdeletes[i]);
-  }
+  // INITSTATEBATCH
+  BatchInitialStateCopy();
 
   GetResourceManager()->SetInitialContents(id, initContents);
 
@@ -277,6 +289,10 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
   uint32_t memidx = 0;
   for(auto it = boundMems.begin(); it != boundMems.end(); ++it)
   {
+    // each memory's contents start on a page boundary, so that pages never straddle two memories
+    // and can be de-duplicated when serialising
+    bufInfo.size = AlignUp(bufInfo.size, SparseInitPageSize);
+
     // store offset
     it->second = bufInfo.size;
 
@@ -338,21 +354,25 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
 
     ObjDisp(d)->CmdCopyBuffer(Unwrap(cmd), Unwrap(srcBuf), Unwrap(dstBuf), 1, &region);
 
+    // zero the padding before the next memory, so it doesn't stop that last page being elided
+    VkDeviceSize padStart = AlignUp(it->second + bufInfo.size, (VkDeviceSize)4);
+    VkDeviceSize padEnd = AlignUp(it->second + bufInfo.size, SparseInitPageSize);
+    padEnd = RDCMIN(padEnd, sparseInit.totalSize);
+
+    if(padStart < padEnd)
+      ObjDisp(d)->CmdFillBuffer(Unwrap(cmd), Unwrap(dstBuf), padStart, padEnd - padStart, 0);
+
     bufdeletes.push_back(srcBuf);
   }
 
   vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  // INITSTATEBATCH
-  SubmitCmds();
-  FlushQ();
+  m_InitStateBatch.buffers.insert(m_InitStateBatch.buffers.end(), bufdeletes.begin(),
+                                  bufdeletes.end());
 
-  for(size_t i = 0; i < bufdeletes.size(); i++)
-  {
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(bufdeletes[i]), NULL);
-    GetResourceManager()->ReleaseWrappedResource(bufdeletes[i]);
-  }
+  // INITSTATEBATCH
+  BatchInitialStateCopy();
 
   GetResourceManager()->SetInitialContents(id, initContents);
 
@@ -378,6 +398,9 @@ uint32_t WrappedVulkan::GetSize_SparseInitialState(ResourceId id, WrappedVkRes *
     // the list of memory regions to copy
     ret += 8 + sizeof(MemIDOffset) * info.numUniqueMems;
 
+    // the page references
+    ret += 8 + sizeof(uint32_t) * uint32_t(info.totalSize / SparseInitPageSize + 1);
+
     // the actual data
     ret += uint32_t(info.totalSize + WriteSerialiser::GetChunkAlignment());
 
@@ -403,6 +426,9 @@ uint32_t WrappedVulkan::GetSize_SparseInitialState(ResourceId id, WrappedVkRes *
     // the list of memory regions to copy
     ret += sizeof(MemIDOffset) * info.numUniqueMems;
 
+    // the page references
+    ret += 8 + sizeof(uint32_t) * uint32_t(info.totalSize / SparseInitPageSize + 1);
+
     // the actual data
     ret += uint32_t(info.totalSize + WriteSerialiser::GetChunkAlignment());
 
@@ -425,9 +451,7 @@ bool WrappedVulkan::Serialise_SparseBufferInitialState(SerialiserType &ser, Reso
   MemoryAllocation mappedMem;
   byte *Contents = NULL;
   uint64_t ContentsSize = (uint64_t)SparseState.totalSize;
-
-  // Serialise this separately so that it can be used on reading to prepare the upload memory
-  SERIALISE_ELEMENT(ContentsSize);
+  rdcarray<uint32_t> PageRefs;
 
   // the memory/buffer that we allocated on read, to upload the initial contents.
   MemoryAllocation uploadMemory;
@@ -453,15 +477,29 @@ bool WrappedVulkan::Serialise_SparseBufferInitialState(SerialiserType &ser, Reso
 
     vkr = ObjDisp(d)->InvalidateMappedMemoryRanges(Unwrap(d), 1, &range);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    // only write out unique pages. The readback memory isn't used after this so they're packed
+    // down in place.
+    ContentsSize = CompactPages(Contents, (size_t)ContentsSize, SparseInitPageSize, PageRefs);
   }
-  else if(IsReplayingAndReading() && !ser.IsErrored())
+
+  if(ser.VersionAtLeast(0x10))
   {
-    // create a buffer with memory attached, which we will fill with the initial contents
+    SERIALISE_ELEMENT(PageRefs);
+  }
+
+  // Serialise this separately so that it can be used on reading to prepare the upload memory
+  SERIALISE_ELEMENT(ContentsSize);
+
+  if(IsReplayingAndReading() && !ser.IsErrored())
+  {
+    // create a buffer with memory attached, which we will fill with the initial contents. If every
+    // page was elided there's nothing to upload, but keep a valid buffer regardless
     VkBufferCreateInfo bufInfo = {
         VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
         NULL,
         0,
-        ContentsSize,
+        RDCMAX(ContentsSize, (uint64_t)4),
         VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
     };
 
@@ -518,6 +556,13 @@ bool WrappedVulkan::Serialise_SparseBufferInitialState(SerialiserType &ser, Reso
     initContents.mem = uploadMemory;
     initContents.tag = VkInitialContents::Sparse;
     initContents.sparseBuffer = SparseState;
+    initContents.sparseBuffer.numPageRefs = (uint32_t)PageRefs.size();
+    initContents.sparseBuffer.pageRefs = NULL;
+    if(!PageRefs.empty())
+    {
+      initContents.sparseBuffer.pageRefs = new uint32_t[PageRefs.size()];
+      memcpy(initContents.sparseBuffer.pageRefs, PageRefs.data(), PageRefs.byteSize());
+    }
 
     // we steal the serialised arrays here by resetting the struct, then the serialisation won't
     // deallocate them. VkInitialContents::Free() will deallocate them in the same way.
@@ -541,9 +586,7 @@ bool WrappedVulkan::Serialise_SparseImageInitialState(SerialiserType &ser, Resou
   MemoryAllocation mappedMem;
   byte *Contents = NULL;
   uint64_t ContentsSize = (uint64_t)SparseState.totalSize;
-
-  // Serialise this separately so that it can be used on reading to prepare the upload memory
-  SERIALISE_ELEMENT(ContentsSize);
+  rdcarray<uint32_t> PageRefs;
 
   // the memory/buffer that we allocated on read, to upload the initial contents.
   MemoryAllocation uploadMemory;
@@ -556,15 +599,27 @@ bool WrappedVulkan::Serialise_SparseImageInitialState(SerialiserType &ser, Resou
     vkr = ObjDisp(d)->MapMemory(Unwrap(d), Unwrap(mappedMem.mem), mappedMem.offs, mappedMem.size, 0,
                                 (void **)&Contents);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    // only write out unique pages, packed down in place as for buffers
+    ContentsSize = CompactPages(Contents, (size_t)ContentsSize, SparseInitPageSize, PageRefs);
   }
-  else if(IsReplayingAndReading() && !ser.IsErrored())
+
+  if(ser.VersionAtLeast(0x10))
+  {
+    SERIALISE_ELEMENT(PageRefs);
+  }
+
+  // Serialise this separately so that it can be used on reading to prepare the upload memory
+  SERIALISE_ELEMENT(ContentsSize);
+
+  if(IsReplayingAndReading() && !ser.IsErrored())
   {
     // create a buffer with memory attached, which we will fill with the initial contents
     VkBufferCreateInfo bufInfo = {
         VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
         NULL,
         0,
-        ContentsSize,
+        RDCMAX(ContentsSize, (uint64_t)4),
         VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
     };
 
@@ -604,6 +659,13 @@ bool WrappedVulkan::Serialise_SparseImageInitialState(SerialiserType &ser, Resou
     initContents.mem = uploadMemory;
     initContents.tag = VkInitialContents::Sparse;
     initContents.sparseImage = SparseState;
+    initContents.sparseImage.numPageRefs = (uint32_t)PageRefs.size();
+    initContents.sparseImage.pageRefs = NULL;
+    if(!PageRefs.empty())
+    {
+      initContents.sparseImage.pageRefs = new uint32_t[PageRefs.size()];
+      memcpy(initContents.sparseImage.pageRefs, PageRefs.data(), PageRefs.byteSize());
+    }
 
     for(uint32_t a = 0; a < NUM_VK_IMAGE_ASPECTS; a++)
     {
@@ -666,6 +728,95 @@ template bool WrappedVulkan::Serialise_SparseImageInitialState(ReadSerialiser &s
 template bool WrappedVulkan::Serialise_SparseImageInitialState(WriteSerialiser &ser, ResourceId id,
                                                                VkInitialContents contents);
 
+void WrappedVulkan::Apply_SparseMemoryContents(VkCommandBuffer cmd, VkBuffer srcBuf,
+                                               const MemIDOffset *memDataOffs,
+                                               uint32_t numUniqueMems, const uint32_t *pageRefs,
+                                               uint32_t numPageRefs)
+{
+  for(uint32_t i = 0; i < numUniqueMems; i++)
+  {
+    VkDeviceMemory dstMem =
+        GetResourceManager()->GetLiveHandle<VkDeviceMemory>(memDataOffs[i].memory);
+
+    ResourceId id = GetResID(dstMem);
+
+    // since this is short lived it isn't wrapped. Note that we want
+    // to cache this up front, so it will then be wrapped
+    VkBuffer dstBuf = m_CreationInfo.m_Memory[id].wholeMemBuf;
+    VkDeviceSize size = m_CreationInfo.m_Memory[id].size;
+
+    if(dstBuf == VK_NULL_HANDLE)
+    {
+      RDCERR("Whole memory buffer not present for %llu", id);
+      continue;
+    }
+
+    // older captures have no page references, and contain the whole memory from the given offset
+    if(numPageRefs == 0)
+    {
+      VkBufferCopy region = {memDataOffs[i].memOffs, 0, size};
+
+      ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(srcBuf), Unwrap(dstBuf), 1, &region);
+      continue;
+    }
+
+    // each memory's contents start on a page boundary, see Prepare_SparseInitialState
+    const VkDeviceSize firstPage = memDataOffs[i].memOffs / SparseInitPageSize;
+
+    std::vector<VkBufferCopy> regions;
+    VkDeviceSize fillStart = ~0ULL;
+
+    // runs of zero pages are cleared in one fill. The size must be a multiple of 4, which only the
+    // end of the memory might not be, and in that case filling the whole rest is what we want.
+    auto flushFill = [&](VkDeviceSize fillEnd) {
+      if(fillStart == ~0ULL)
+        return;
+
+      ObjDisp(cmd)->CmdFillBuffer(Unwrap(cmd), Unwrap(dstBuf), fillStart,
+                                  (fillEnd - fillStart) % 4 ? VK_WHOLE_SIZE : fillEnd - fillStart,
+                                  0);
+      fillStart = ~0ULL;
+    };
+
+    for(VkDeviceSize offs = 0; offs < size; offs += SparseInitPageSize)
+    {
+      const VkDeviceSize page = firstPage + offs / SparseInitPageSize;
+      const VkDeviceSize len = RDCMIN(SparseInitPageSize, size - offs);
+
+      const uint32_t ref = page < numPageRefs ? pageRefs[page] : CompactedZeroPage;
+
+      if(ref == CompactedZeroPage)
+      {
+        if(fillStart == ~0ULL)
+          fillStart = offs;
+        continue;
+      }
+
+      flushFill(offs);
+
+      const VkDeviceSize srcOffs = VkDeviceSize(ref) * SparseInitPageSize;
+
+      // pages that were unique are packed in order, so extend the last copy where possible
+      if(!regions.empty() && regions.back().srcOffset + regions.back().size == srcOffs &&
+         regions.back().dstOffset + regions.back().size == offs)
+      {
+        regions.back().size += len;
+      }
+      else
+      {
+        VkBufferCopy region = {srcOffs, offs, len};
+        regions.push_back(region);
+      }
+    }
+
+    flushFill(size);
+
+    if(!regions.empty())
+      ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(srcBuf), Unwrap(dstBuf),
+                                  (uint32_t)regions.size(), regions.data());
+  }
+}
+
 bool WrappedVulkan::Apply_SparseInitialState(WrappedVkBuffer *buf, VkInitialContents contents)
 {
   SparseBufferInitState &info = contents.sparseBuffer;
@@ -736,25 +887,8 @@ bool WrappedVulkan::Apply_SparseInitialState(WrappedVkBuffer *buf, VkInitialCont
   vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  for(uint32_t i = 0; i < info.numUniqueMems; i++)
-  {
-    VkDeviceMemory dstMem =
-        GetResourceManager()->GetLiveHandle<VkDeviceMemory>(info.memDataOffs[i].memory);
-
-    ResourceId id = GetResID(dstMem);
-
-    VkBuffer dstBuf = m_CreationInfo.m_Memory[id].wholeMemBuf;
-
-    VkDeviceSize size = m_CreationInfo.m_Memory[id].size;
-
-    // fill the whole memory from the given offset
-    VkBufferCopy region = {info.memDataOffs[i].memOffs, 0, size};
-
-    if(dstBuf != VK_NULL_HANDLE)
-      ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(srcBuf), Unwrap(dstBuf), 1, &region);
-    else
-      RDCERR("Whole memory buffer not present for %llu", id);
-  }
+  Apply_SparseMemoryContents(cmd, srcBuf, info.memDataOffs, info.numUniqueMems, info.pageRefs,
+                             info.numPageRefs);
 
   vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
@@ -872,26 +1006,8 @@ bool WrappedVulkan::Apply_SparseInitialState(WrappedVkImage *im, VkInitialConten
   vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  for(uint32_t i = 0; i < info.numUniqueMems; i++)
-  {
-    VkDeviceMemory dstMem =
-        GetResourceManager()->GetLiveHandle<VkDeviceMemory>(info.memDataOffs[i].memory);
-
-    ResourceId id = GetResID(dstMem);
-
-    // since this is short lived it isn't wrapped. Note that we want
-    // to cache this up front, so it will then be wrapped
-    VkBuffer dstBuf = m_CreationInfo.m_Memory[id].wholeMemBuf;
-    VkDeviceSize size = m_CreationInfo.m_Memory[id].size;
-
-    // fill the whole memory from the given offset
-    VkBufferCopy region = {info.memDataOffs[i].memOffs, 0, size};
-
-    if(dstBuf != VK_NULL_HANDLE)
-      ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(srcBuf), Unwrap(dstBuf), 1, &region);
-    else
-      RDCERR("Whole memory buffer not present for %llu", id);
-  }
+  Apply_SparseMemoryContents(cmd, srcBuf, info.memDataOffs, info.numUniqueMems, info.pageRefs,
+                             info.numPageRefs);
 
   vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
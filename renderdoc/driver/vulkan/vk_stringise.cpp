@@ -214,6 +214,9 @@ std::string DoStringise(const MemoryScope &el)
   {
     STRINGISE_ENUM_CLASS(InitialContents);
     STRINGISE_ENUM_CLASS(IndirectReadback);
+    STRINGISE_ENUM_CLASS(ReplayCheckpoints);
+    STRINGISE_ENUM_CLASS(PostVS);
+    STRINGISE_ENUM_CLASS(TextureReadback);
   }
   END_ENUM_STRINGISE()
 }
@@ -390,6 +390,8 @@ bool WrappedVulkan::Serialise_vkCreateCommandPool(SerialiserType &ser, VkDevice
     {
       ResourceId live = GetResourceManager()->WrapResource(Unwrap(device), pool);
       GetResourceManager()->AddLiveResource(CmdPool, pool);
+
+      m_CommandPoolFamily[live] = CreateInfo.queueFamilyIndex;
     }
 
     AddResource(CmdPool, ResourceType::Pool, "Command Pool");
@@ -697,7 +699,7 @@ bool WrappedVulkan::Serialise_vkBeginCommandBuffer(SerialiserType &ser, VkComman
             partial = true;
             partialType = p;
           }
-          else if(it->baseEvent <= m_LastEventID)
+          else if(it->baseEvent <= m_LastEventID && !IsCheckpointedEvent(it->baseEvent + length))
           {
 #if ENABLED(VERBOSE_PARTIAL_REPLAY)
             RDCDEBUG("vkBegin - full re-record detected %u < %u <= %u, %llu -> %llu", it->baseEvent,
@@ -710,8 +712,45 @@ bool WrappedVulkan::Serialise_vkBeginCommandBuffer(SerialiserType &ser, VkComman
         }
       }
 
-      if(rerecord)
+      // the non-baked ID may have been used by a cached command buffer earlier in the frame
+      m_CachedRerecordCmds.erase(m_LastCmdBufferID);
+
+      // re-records only depend on the event and type of replay, so they can be reused from the
+      // previous time we did the same replay. Partial re-records also need the replay state they
+      // set up to have been saved.
+      const bool cacheable = rerecord && m_CurRerecordCache;
+
+      VkCommandBuffer cached = VK_NULL_HANDLE;
+      if(cacheable && (!partial || m_CurRerecordCache->hasState))
+      {
+        auto it = m_CurRerecordCache->cmds.find(BakedCommandBuffer);
+        if(it != m_CurRerecordCache->cmds.end())
+          cached = it->second;
+      }
+
+      if(cached != VK_NULL_HANDLE)
+      {
+#if ENABLED(VERBOSE_PARTIAL_REPLAY)
+        RDCDEBUG("vkBegin - using cached re-record for %llu -> %llu", m_LastCmdBufferID,
+                 BakedCommandBuffer);
+#endif
+
+        // the command buffer is still looked up the same way for submission, but nothing is
+        // recorded into it.
+        m_RerecordCmds[BakedCommandBuffer] = cached;
+        m_RerecordCmds[m_LastCmdBufferID] = cached;
+
+        m_CachedRerecordCmds.insert(BakedCommandBuffer);
+        m_CachedRerecordCmds.insert(m_LastCmdBufferID);
+
+        if(partial)
+          m_CachedPartialRerecord = true;
+      }
+      else if(rerecord)
       {
+        if(cacheable)
+          AllocateInfo.commandPool = GetRerecordPool(AllocateInfo.commandPool);
+
         VkCommandBuffer cmd = VK_NULL_HANDLE;
         VkCommandBufferAllocateInfo unwrappedInfo = AllocateInfo;
         unwrappedInfo.commandPool = Unwrap(unwrappedInfo.commandPool);
@@ -739,7 +778,22 @@ bool WrappedVulkan::Serialise_vkBeginCommandBuffer(SerialiserType &ser, VkComman
         m_RerecordCmds[BakedCommandBuffer] = cmd;
         m_RerecordCmds[m_LastCmdBufferID] = cmd;
 
-        m_RerecordCmdList.push_back({AllocateInfo.commandPool, cmd});
+        if(cacheable)
+        {
+          m_CurRerecordCache->cmds[BakedCommandBuffer] = cmd;
+          m_CurRerecordCache->rerecords.insert(GetResID(cmd));
+          m_CurRerecordCache->cmdList.push_back({AllocateInfo.commandPool, cmd});
+
+          if(partial)
+            m_CurRerecordCache->partialCmds.push_back(BakedCommandBuffer);
+
+          // this will be submitted again on later replays
+          unwrappedBeginInfo.flags &= ~VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        }
+        else
+        {
+          m_RerecordCmdList.push_back({AllocateInfo.commandPool, cmd});
+        }
 
         m_BakedCmdBufferInfo[GetResID(cmd)].level = AllocateInfo.level;
         m_BakedCmdBufferInfo[GetResID(cmd)].beginFlags = BeginInfo.flags;
@@ -1247,8 +1301,7 @@ void WrappedVulkan::vkCmdBeginRenderPass(VkCommandBuffer commandBuffer,
         break;
 
       record->MarkResourceFrameReferenced(att->baseResource, eFrameRef_ReadBeforeWrite);
-      if(att->baseResourceMem != ResourceId())
-        record->MarkResourceFrameReferenced(att->baseResourceMem, eFrameRef_Read);
+      record->MarkBoundMemoryFrameReferenced(att->baseResourceMem, eFrameRef_Read);
       if(att->resInfo)
         record->cmdInfo->sparse.insert(att->resInfo);
       record->cmdInfo->dirtied.insert(att->baseResource);
@@ -1592,8 +1645,7 @@ void WrappedVulkan::vkCmdBeginRenderPass2KHR(VkCommandBuffer commandBuffer,
         break;
 
       record->MarkResourceFrameReferenced(att->baseResource, eFrameRef_ReadBeforeWrite);
-      if(att->baseResourceMem != ResourceId())
-        record->MarkResourceFrameReferenced(att->baseResourceMem, eFrameRef_Read);
+      record->MarkBoundMemoryFrameReferenced(att->baseResourceMem, eFrameRef_Read);
       if(att->resInfo)
         record->cmdInfo->sparse.insert(att->resInfo);
       record->cmdInfo->dirtied.insert(att->baseResource);
@@ -1850,100 +1902,113 @@ bool WrappedVulkan::Serialise_vkCmdBindPipeline(SerialiserType &ser, VkCommandBu
 
   if(IsReplayingAndReading())
   {
-    m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
+    if(m_CacheDecodedCommands)
+      CacheDecodedCommand(VulkanChunk::vkCmdBindPipeline,
+                          DecodedCmdBindPipeline{commandBuffer, pipelineBindPoint, pipeline});
 
-    if(IsActiveReplaying(m_State))
+    return Replay_vkCmdBindPipeline(commandBuffer, pipelineBindPoint, pipeline);
+  }
+
+  return true;
+}
+
+bool WrappedVulkan::Replay_vkCmdBindPipeline(VkCommandBuffer commandBuffer,
+                                             VkPipelineBindPoint pipelineBindPoint,
+                                             VkPipeline pipeline)
+{
+  m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
+
+  if(IsActiveReplaying(m_State))
+  {
+    if(InRerecordRange(m_LastCmdBufferID))
     {
-      if(InRerecordRange(m_LastCmdBufferID))
-      {
-        commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
+      commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
 
-        ResourceId liveid = GetResID(pipeline);
+      ResourceId liveid = GetResID(pipeline);
 
-        if(ShouldUpdateRenderState(m_LastCmdBufferID))
+      if(ShouldUpdateRenderState(m_LastCmdBufferID))
+      {
+        if(pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE)
+        {
+          m_RenderState.compute.pipeline = liveid;
+        }
+        else
         {
-          if(pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE)
+          m_RenderState.graphics.pipeline = liveid;
+
+          if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicViewport])
           {
-            m_RenderState.compute.pipeline = liveid;
+            m_RenderState.views = m_CreationInfo.m_Pipeline[liveid].viewports;
           }
-          else
+          if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicScissor])
           {
-            m_RenderState.graphics.pipeline = liveid;
-
-            if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicViewport])
-            {
-              m_RenderState.views = m_CreationInfo.m_Pipeline[liveid].viewports;
-            }
-            if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicScissor])
-            {
-              m_RenderState.scissors = m_CreationInfo.m_Pipeline[liveid].scissors;
-            }
-            if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicLineWidth])
-            {
-              m_RenderState.lineWidth = m_CreationInfo.m_Pipeline[liveid].lineWidth;
-            }
-            if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicDepthBias])
-            {
-              m_RenderState.bias.depth = m_CreationInfo.m_Pipeline[liveid].depthBiasConstantFactor;
-              m_RenderState.bias.biasclamp = m_CreationInfo.m_Pipeline[liveid].depthBiasClamp;
-              m_RenderState.bias.slope = m_CreationInfo.m_Pipeline[liveid].depthBiasSlopeFactor;
-            }
-            if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicBlendConstants])
-            {
-              memcpy(m_RenderState.blendConst, m_CreationInfo.m_Pipeline[liveid].blendConst,
-                     sizeof(float) * 4);
-            }
-            if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicDepthBounds])
-            {
-              m_RenderState.mindepth = m_CreationInfo.m_Pipeline[liveid].minDepthBounds;
-              m_RenderState.maxdepth = m_CreationInfo.m_Pipeline[liveid].maxDepthBounds;
-            }
-            if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicStencilCompareMask])
-            {
-              m_RenderState.front.compare = m_CreationInfo.m_Pipeline[liveid].front.compareMask;
-              m_RenderState.back.compare = m_CreationInfo.m_Pipeline[liveid].back.compareMask;
-            }
-            if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicStencilWriteMask])
-            {
-              m_RenderState.front.write = m_CreationInfo.m_Pipeline[liveid].front.writeMask;
-              m_RenderState.back.write = m_CreationInfo.m_Pipeline[liveid].back.writeMask;
-            }
-            if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicStencilReference])
-            {
-              m_RenderState.front.ref = m_CreationInfo.m_Pipeline[liveid].front.reference;
-              m_RenderState.back.ref = m_CreationInfo.m_Pipeline[liveid].back.reference;
-            }
-            if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicSampleLocationsEXT])
-            {
-              m_RenderState.sampleLocations.locations =
-                  m_CreationInfo.m_Pipeline[liveid].sampleLocations.locations;
-              m_RenderState.sampleLocations.gridSize =
-                  m_CreationInfo.m_Pipeline[liveid].sampleLocations.gridSize;
-              m_RenderState.sampleLocations.sampleCount =
-                  m_CreationInfo.m_Pipeline[liveid].rasterizationSamples;
-            }
-            if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicDiscardRectangleEXT])
-            {
-              m_RenderState.discardRectangles = m_CreationInfo.m_Pipeline[liveid].discardRectangles;
-            }
+            m_RenderState.scissors = m_CreationInfo.m_Pipeline[liveid].scissors;
+          }
+          if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicLineWidth])
+          {
+            m_RenderState.lineWidth = m_CreationInfo.m_Pipeline[liveid].lineWidth;
+          }
+          if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicDepthBias])
+          {
+            m_RenderState.bias.depth = m_CreationInfo.m_Pipeline[liveid].depthBiasConstantFactor;
+            m_RenderState.bias.biasclamp = m_CreationInfo.m_Pipeline[liveid].depthBiasClamp;
+            m_RenderState.bias.slope = m_CreationInfo.m_Pipeline[liveid].depthBiasSlopeFactor;
+          }
+          if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicBlendConstants])
+          {
+            memcpy(m_RenderState.blendConst, m_CreationInfo.m_Pipeline[liveid].blendConst,
+                   sizeof(float) * 4);
+          }
+          if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicDepthBounds])
+          {
+            m_RenderState.mindepth = m_CreationInfo.m_Pipeline[liveid].minDepthBounds;
+            m_RenderState.maxdepth = m_CreationInfo.m_Pipeline[liveid].maxDepthBounds;
+          }
+          if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicStencilCompareMask])
+          {
+            m_RenderState.front.compare = m_CreationInfo.m_Pipeline[liveid].front.compareMask;
+            m_RenderState.back.compare = m_CreationInfo.m_Pipeline[liveid].back.compareMask;
+          }
+          if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicStencilWriteMask])
+          {
+            m_RenderState.front.write = m_CreationInfo.m_Pipeline[liveid].front.writeMask;
+            m_RenderState.back.write = m_CreationInfo.m_Pipeline[liveid].back.writeMask;
+          }
+          if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicStencilReference])
+          {
+            m_RenderState.front.ref = m_CreationInfo.m_Pipeline[liveid].front.reference;
+            m_RenderState.back.ref = m_CreationInfo.m_Pipeline[liveid].back.reference;
+          }
+          if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicSampleLocationsEXT])
+          {
+            m_RenderState.sampleLocations.locations =
+                m_CreationInfo.m_Pipeline[liveid].sampleLocations.locations;
+            m_RenderState.sampleLocations.gridSize =
+                m_CreationInfo.m_Pipeline[liveid].sampleLocations.gridSize;
+            m_RenderState.sampleLocations.sampleCount =
+                m_CreationInfo.m_Pipeline[liveid].rasterizationSamples;
+          }
+          if(!m_CreationInfo.m_Pipeline[liveid].dynamicStates[VkDynamicDiscardRectangleEXT])
+          {
+            m_RenderState.discardRectangles = m_CreationInfo.m_Pipeline[liveid].discardRectangles;
           }
         }
       }
-      else
-      {
-        commandBuffer = VK_NULL_HANDLE;
-      }
     }
     else
     {
-      // track while reading, as we need to bind current topology & index byte width in AddDrawcall
-      m_BakedCmdBufferInfo[m_LastCmdBufferID].state.pipeline = GetResID(pipeline);
+      commandBuffer = VK_NULL_HANDLE;
     }
-
-    if(commandBuffer != VK_NULL_HANDLE)
-      ObjDisp(commandBuffer)->CmdBindPipeline(Unwrap(commandBuffer), pipelineBindPoint, Unwrap(pipeline));
+  }
+  else
+  {
+    // track while reading, as we need to bind current topology & index byte width in AddDrawcall
+    m_BakedCmdBufferInfo[m_LastCmdBufferID].state.pipeline = GetResID(pipeline);
   }
 
+  if(commandBuffer != VK_NULL_HANDLE)
+    ObjDisp(commandBuffer)->CmdBindPipeline(Unwrap(commandBuffer), pipelineBindPoint, Unwrap(pipeline));
+
   return true;
 }
 
@@ -1992,107 +2057,129 @@ bool WrappedVulkan::Serialise_vkCmdBindDescriptorSets(
 
   if(IsReplayingAndReading())
   {
-    m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
+    if(m_CacheDecodedCommands)
+      CacheDecodedCommand(
+          VulkanChunk::vkCmdBindDescriptorSets,
+          DecodedCmdBindDescriptorSets{commandBuffer, pipelineBindPoint, layout, firstSet, setCount,
+                                       CopyDecoded(pDescriptorSets, setCount), dynamicOffsetCount,
+                                       CopyDecoded(pDynamicOffsets, dynamicOffsetCount)});
+
+    return Replay_vkCmdBindDescriptorSets(commandBuffer, pipelineBindPoint, layout, firstSet,
+                                          setCount, pDescriptorSets, dynamicOffsetCount,
+                                          pDynamicOffsets);
+  }
 
-    if(IsActiveReplaying(m_State))
+  return true;
+}
+
+bool WrappedVulkan::Replay_vkCmdBindDescriptorSets(VkCommandBuffer commandBuffer,
+                                                   VkPipelineBindPoint pipelineBindPoint,
+                                                   VkPipelineLayout layout, uint32_t firstSet,
+                                                   uint32_t setCount,
+                                                   const VkDescriptorSet *pDescriptorSets,
+                                                   uint32_t dynamicOffsetCount,
+                                                   const uint32_t *pDynamicOffsets)
+{
+  m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
+
+  if(IsActiveReplaying(m_State))
+  {
+    if(InRerecordRange(m_LastCmdBufferID))
     {
-      if(InRerecordRange(m_LastCmdBufferID))
+      commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
+
+      ObjDisp(commandBuffer)
+          ->CmdBindDescriptorSets(Unwrap(commandBuffer), pipelineBindPoint, Unwrap(layout),
+                                  firstSet, setCount, UnwrapArray(pDescriptorSets, setCount),
+                                  dynamicOffsetCount, pDynamicOffsets);
+
+      if(ShouldUpdateRenderState(m_LastCmdBufferID))
       {
-        commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
+        std::vector<VulkanRenderState::Pipeline::DescriptorAndOffsets> &descsets =
+            (pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS)
+                ? m_RenderState.graphics.descSets
+                : m_RenderState.compute.descSets;
 
-        ObjDisp(commandBuffer)
-            ->CmdBindDescriptorSets(Unwrap(commandBuffer), pipelineBindPoint, Unwrap(layout),
-                                    firstSet, setCount, UnwrapArray(pDescriptorSets, setCount),
-                                    dynamicOffsetCount, pDynamicOffsets);
+        // expand as necessary
+        if(descsets.size() < firstSet + setCount)
+          descsets.resize(firstSet + setCount);
 
-        if(ShouldUpdateRenderState(m_LastCmdBufferID))
-        {
-          std::vector<VulkanRenderState::Pipeline::DescriptorAndOffsets> &descsets =
-              (pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS)
-                  ? m_RenderState.graphics.descSets
-                  : m_RenderState.compute.descSets;
+        const std::vector<ResourceId> &descSetLayouts =
+            m_CreationInfo.m_PipelineLayout[GetResID(layout)].descSetLayouts;
 
-          // expand as necessary
-          if(descsets.size() < firstSet + setCount)
-            descsets.resize(firstSet + setCount);
+        const uint32_t *offsIter = pDynamicOffsets;
+        uint32_t dynConsumed = 0;
 
-          const std::vector<ResourceId> &descSetLayouts =
-              m_CreationInfo.m_PipelineLayout[GetResID(layout)].descSetLayouts;
+        // consume the offsets linearly along the descriptor set layouts
+        for(uint32_t i = 0; i < setCount; i++)
+        {
+          descsets[firstSet + i].descSet = GetResID(pDescriptorSets[i]);
+          uint32_t dynCount =
+              m_CreationInfo.m_DescSetLayout[descSetLayouts[firstSet + i]].dynamicCount;
+          descsets[firstSet + i].offsets.assign(offsIter, offsIter + dynCount);
+          offsIter += dynCount;
+          dynConsumed += dynCount;
+          RDCASSERT(dynConsumed <= dynamicOffsetCount);
+        }
 
-          const uint32_t *offsIter = pDynamicOffsets;
-          uint32_t dynConsumed = 0;
+        // if there are dynamic offsets, bake them into the current bindings by alias'ing
+        // the image layout member (which is never used for buffer views).
+        // This lets us look it up easily when we want to show the current pipeline state
+        RDCCOMPILE_ASSERT(sizeof(VkImageLayout) >= sizeof(uint32_t),
+                          "Can't alias image layout for dynamic offset!");
+        if(dynamicOffsetCount > 0)
+        {
+          uint32_t o = 0;
 
-          // consume the offsets linearly along the descriptor set layouts
+          // spec states that dynamic offsets precisely match all the offsets needed for these
+          // sets, in order of set N before set N+1, binding X before binding X+1 within a set,
+          // and in array element order within a binding
           for(uint32_t i = 0; i < setCount; i++)
           {
-            descsets[firstSet + i].descSet = GetResID(pDescriptorSets[i]);
-            uint32_t dynCount =
-                m_CreationInfo.m_DescSetLayout[descSetLayouts[firstSet + i]].dynamicCount;
-            descsets[firstSet + i].offsets.assign(offsIter, offsIter + dynCount);
-            offsIter += dynCount;
-            dynConsumed += dynCount;
-            RDCASSERT(dynConsumed <= dynamicOffsetCount);
-          }
-
-          // if there are dynamic offsets, bake them into the current bindings by alias'ing
-          // the image layout member (which is never used for buffer views).
-          // This lets us look it up easily when we want to show the current pipeline state
-          RDCCOMPILE_ASSERT(sizeof(VkImageLayout) >= sizeof(uint32_t),
-                            "Can't alias image layout for dynamic offset!");
-          if(dynamicOffsetCount > 0)
-          {
-            uint32_t o = 0;
+            ResourceId descId = GetResID(pDescriptorSets[i]);
+            const DescSetLayout &layoutinfo =
+                m_CreationInfo.m_DescSetLayout[descSetLayouts[firstSet + i]];
 
-            // spec states that dynamic offsets precisely match all the offsets needed for these
-            // sets, in order of set N before set N+1, binding X before binding X+1 within a set,
-            // and in array element order within a binding
-            for(uint32_t i = 0; i < setCount; i++)
+            for(size_t b = 0; b < layoutinfo.bindings.size(); b++)
             {
-              ResourceId descId = GetResID(pDescriptorSets[i]);
-              const DescSetLayout &layoutinfo =
-                  m_CreationInfo.m_DescSetLayout[descSetLayouts[firstSet + i]];
+              // not dynamic, doesn't need an offset
+              if(layoutinfo.bindings[b].descriptorType != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC &&
+                 layoutinfo.bindings[b].descriptorType != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+                continue;
 
-              for(size_t b = 0; b < layoutinfo.bindings.size(); b++)
+              // assign every array element an offset according to array size
+              for(uint32_t a = 0; a < layoutinfo.bindings[b].descriptorCount; a++)
               {
-                // not dynamic, doesn't need an offset
-                if(layoutinfo.bindings[b].descriptorType != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC &&
-                   layoutinfo.bindings[b].descriptorType != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
-                  continue;
-
-                // assign every array element an offset according to array size
-                for(uint32_t a = 0; a < layoutinfo.bindings[b].descriptorCount; a++)
-                {
-                  RDCASSERT(o < dynamicOffsetCount);
-                  uint32_t *alias =
-                      (uint32_t *)&m_DescriptorSetState[descId].currentBindings[b][a].imageInfo.imageLayout;
-                  *alias = pDynamicOffsets[o++];
-                }
+                RDCASSERT(o < dynamicOffsetCount);
+                uint32_t *alias =
+                    (uint32_t *)&m_DescriptorSetState[descId].currentBindings[b][a].imageInfo.imageLayout;
+                *alias = pDynamicOffsets[o++];
               }
             }
           }
         }
       }
     }
-    else
-    {
-      // track while reading, as we need to track resource usage
-      std::vector<BakedCmdBufferInfo::CmdBufferState::DescriptorAndOffsets> &descsets =
-          (pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS)
-              ? m_BakedCmdBufferInfo[m_LastCmdBufferID].state.graphicsDescSets
-              : m_BakedCmdBufferInfo[m_LastCmdBufferID].state.computeDescSets;
+  }
+  else
+  {
+    // track while reading, as we need to track resource usage
+    std::vector<BakedCmdBufferInfo::CmdBufferState::DescriptorAndOffsets> &descsets =
+        (pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS)
+            ? m_BakedCmdBufferInfo[m_LastCmdBufferID].state.graphicsDescSets
+            : m_BakedCmdBufferInfo[m_LastCmdBufferID].state.computeDescSets;
 
-      // expand as necessary
-      if(descsets.size() < firstSet + setCount)
-        descsets.resize(firstSet + setCount);
+    // expand as necessary
+    if(descsets.size() < firstSet + setCount)
+      descsets.resize(firstSet + setCount);
 
-      for(uint32_t i = 0; i < setCount; i++)
-        descsets[firstSet + i].descSet = GetResID(pDescriptorSets[i]);
+    for(uint32_t i = 0; i < setCount; i++)
+      descsets[firstSet + i].descSet = GetResID(pDescriptorSets[i]);
 
-      ObjDisp(commandBuffer)
-          ->CmdBindDescriptorSets(Unwrap(commandBuffer), pipelineBindPoint, Unwrap(layout),
-                                  firstSet, setCount, UnwrapArray(pDescriptorSets, setCount),
-                                  dynamicOffsetCount, pDynamicOffsets);
-    }
+    ObjDisp(commandBuffer)
+        ->CmdBindDescriptorSets(Unwrap(commandBuffer), pipelineBindPoint, Unwrap(layout),
+                                firstSet, setCount, UnwrapArray(pDescriptorSets, setCount),
+                                dynamicOffsetCount, pDynamicOffsets);
   }
 
   return true;
@@ -2125,7 +2212,6 @@ void WrappedVulkan::vkCmdBindDescriptorSets(VkCommandBuffer commandBuffer,
 
     record->AddChunk(scope.Get());
     record->MarkResourceFrameReferenced(GetResID(layout), eFrameRef_Read);
-    record->cmdInfo->boundDescSets.insert(pDescriptorSets, pDescriptorSets + setCount);
 
     // conservatively mark all writeable objects in the descriptor set as dirty here.
     // Technically not all might be written although that required verifying what the
@@ -2135,16 +2221,21 @@ void WrappedVulkan::vkCmdBindDescriptorSets(VkCommandBuffer commandBuffer,
     // lower frequency.
     for(uint32_t i = 0; i < setCount; i++)
     {
-      VkResourceRecord *descSet = GetRecord(pDescriptorSets[i]);
+      DescriptorSetData *descInfo = GetRecord(pDescriptorSets[i])->descInfo;
 
-      map<ResourceId, pair<uint32_t, FrameRefType> > &frameRefs = descSet->descInfo->bindFrameRefs;
+      uint32_t &mergedGeneration = record->cmdInfo->boundDescSets[pDescriptorSets[i]];
 
-      for(auto it = frameRefs.begin(); it != frameRefs.end(); ++it)
-      {
-        if(it->second.second == eFrameRef_PartialWrite ||
-           it->second.second == eFrameRef_ReadBeforeWrite)
-          record->cmdInfo->dirtied.insert(it->first);
-      }
+      // if the set hasn't changed since it was last bound here, its writes are already dirtied
+      if(mergedGeneration == descInfo->refsGeneration)
+        continue;
+
+      mergedGeneration = descInfo->UpdateFlatRefs();
+
+      // both are sorted, so insert with a hint to make this a linear merge
+      set<ResourceId> &dirtied = record->cmdInfo->dirtied;
+      auto hint = dirtied.begin();
+      for(ResourceId id : descInfo->flatWrittenRefs)
+        hint = std::next(dirtied.insert(hint, id));
     }
   }
 }
@@ -2168,44 +2259,61 @@ bool WrappedVulkan::Serialise_vkCmdBindVertexBuffers(SerialiserType &ser,
 
   if(IsReplayingAndReading())
   {
-    m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
+    if(m_CacheDecodedCommands)
+      CacheDecodedCommand(VulkanChunk::vkCmdBindVertexBuffers,
+                          DecodedCmdBindVertexBuffers{commandBuffer, firstBinding, bindingCount,
+                                                      CopyDecoded(pBuffers, bindingCount),
+                                                      CopyDecoded(pOffsets, bindingCount)});
+
+    return Replay_vkCmdBindVertexBuffers(commandBuffer, firstBinding, bindingCount, pBuffers,
+                                         pOffsets);
+  }
 
-    if(IsActiveReplaying(m_State))
+  return true;
+}
+
+bool WrappedVulkan::Replay_vkCmdBindVertexBuffers(VkCommandBuffer commandBuffer,
+                                                  uint32_t firstBinding, uint32_t bindingCount,
+                                                  const VkBuffer *pBuffers,
+                                                  const VkDeviceSize *pOffsets)
+{
+  m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
+
+  if(IsActiveReplaying(m_State))
+  {
+    if(InRerecordRange(m_LastCmdBufferID))
     {
-      if(InRerecordRange(m_LastCmdBufferID))
+      commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
+      ObjDisp(commandBuffer)
+          ->CmdBindVertexBuffers(Unwrap(commandBuffer), firstBinding, bindingCount,
+                                 UnwrapArray(pBuffers, bindingCount), pOffsets);
+
+      if(ShouldUpdateRenderState(m_LastCmdBufferID))
       {
-        commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
-        ObjDisp(commandBuffer)
-            ->CmdBindVertexBuffers(Unwrap(commandBuffer), firstBinding, bindingCount,
-                                   UnwrapArray(pBuffers, bindingCount), pOffsets);
+        if(m_RenderState.vbuffers.size() < firstBinding + bindingCount)
+          m_RenderState.vbuffers.resize(firstBinding + bindingCount);
 
-        if(ShouldUpdateRenderState(m_LastCmdBufferID))
+        for(uint32_t i = 0; i < bindingCount; i++)
         {
-          if(m_RenderState.vbuffers.size() < firstBinding + bindingCount)
-            m_RenderState.vbuffers.resize(firstBinding + bindingCount);
-
-          for(uint32_t i = 0; i < bindingCount; i++)
-          {
-            m_RenderState.vbuffers[firstBinding + i].buf = GetResID(pBuffers[i]);
-            m_RenderState.vbuffers[firstBinding + i].offs = pOffsets[i];
-          }
+          m_RenderState.vbuffers[firstBinding + i].buf = GetResID(pBuffers[i]);
+          m_RenderState.vbuffers[firstBinding + i].offs = pOffsets[i];
         }
       }
     }
-    else
-    {
-      // track while reading, as we need to track resource usage
-      if(m_BakedCmdBufferInfo[m_LastCmdBufferID].state.vbuffers.size() < firstBinding + bindingCount)
-        m_BakedCmdBufferInfo[m_LastCmdBufferID].state.vbuffers.resize(firstBinding + bindingCount);
+  }
+  else
+  {
+    // track while reading, as we need to track resource usage
+    if(m_BakedCmdBufferInfo[m_LastCmdBufferID].state.vbuffers.size() < firstBinding + bindingCount)
+      m_BakedCmdBufferInfo[m_LastCmdBufferID].state.vbuffers.resize(firstBinding + bindingCount);
 
-      for(uint32_t i = 0; i < bindingCount; i++)
-        m_BakedCmdBufferInfo[m_LastCmdBufferID].state.vbuffers[firstBinding + i] =
-            GetResID(pBuffers[i]);
+    for(uint32_t i = 0; i < bindingCount; i++)
+      m_BakedCmdBufferInfo[m_LastCmdBufferID].state.vbuffers[firstBinding + i] =
+          GetResID(pBuffers[i]);
 
-      ObjDisp(commandBuffer)
-          ->CmdBindVertexBuffers(Unwrap(commandBuffer), firstBinding, bindingCount,
-                                 UnwrapArray(pBuffers, bindingCount), pOffsets);
-    }
+    ObjDisp(commandBuffer)
+        ->CmdBindVertexBuffers(Unwrap(commandBuffer), firstBinding, bindingCount,
+                               UnwrapArray(pBuffers, bindingCount), pOffsets);
   }
 
   return true;
@@ -2256,35 +2364,47 @@ bool WrappedVulkan::Serialise_vkCmdBindIndexBuffer(SerialiserType &ser,
 
   if(IsReplayingAndReading())
   {
-    m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
+    if(m_CacheDecodedCommands)
+      CacheDecodedCommand(VulkanChunk::vkCmdBindIndexBuffer,
+                          DecodedCmdBindIndexBuffer{commandBuffer, buffer, offset, indexType});
 
-    if(IsActiveReplaying(m_State))
+    return Replay_vkCmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+  }
+
+  return true;
+}
+
+bool WrappedVulkan::Replay_vkCmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer,
+                                                VkDeviceSize offset, VkIndexType indexType)
+{
+  m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
+
+  if(IsActiveReplaying(m_State))
+  {
+    if(InRerecordRange(m_LastCmdBufferID))
     {
-      if(InRerecordRange(m_LastCmdBufferID))
-      {
-        commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
-        ObjDisp(commandBuffer)
-            ->CmdBindIndexBuffer(Unwrap(commandBuffer), Unwrap(buffer), offset, indexType);
+      commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
+      ObjDisp(commandBuffer)
+          ->CmdBindIndexBuffer(Unwrap(commandBuffer), Unwrap(buffer), offset, indexType);
 
-        if(ShouldUpdateRenderState(m_LastCmdBufferID))
-        {
-          m_RenderState.ibuffer.buf = GetResID(buffer);
-          m_RenderState.ibuffer.offs = offset;
-          m_RenderState.ibuffer.bytewidth = indexType == VK_INDEX_TYPE_UINT32 ? 4 : 2;
-        }
+      if(ShouldUpdateRenderState(m_LastCmdBufferID))
+      {
+        m_RenderState.ibuffer.buf = GetResID(buffer);
+        m_RenderState.ibuffer.offs = offset;
+        m_RenderState.ibuffer.bytewidth = indexType == VK_INDEX_TYPE_UINT32 ? 4 : 2;
       }
     }
-    else
-    {
-      // track while reading, as we need to bind current topology & index byte width in AddDrawcall
-      m_BakedCmdBufferInfo[m_LastCmdBufferID].state.idxWidth =
-          (indexType == VK_INDEX_TYPE_UINT32 ? 4 : 2);
+  }
+  else
+  {
+    // track while reading, as we need to bind current topology & index byte width in AddDrawcall
+    m_BakedCmdBufferInfo[m_LastCmdBufferID].state.idxWidth =
+        (indexType == VK_INDEX_TYPE_UINT32 ? 4 : 2);
 
-      // track while reading, as we need to track resource usage
-      m_BakedCmdBufferInfo[m_LastCmdBufferID].state.ibuffer = GetResID(buffer);
+    // track while reading, as we need to track resource usage
+    m_BakedCmdBufferInfo[m_LastCmdBufferID].state.ibuffer = GetResID(buffer);
 
-      ObjDisp(commandBuffer)->CmdBindIndexBuffer(Unwrap(commandBuffer), Unwrap(buffer), offset, indexType);
-    }
+    ObjDisp(commandBuffer)->CmdBindIndexBuffer(Unwrap(commandBuffer), Unwrap(buffer), offset, indexType);
   }
 
   return true;
@@ -2539,6 +2659,51 @@ bool WrappedVulkan::Serialise_vkCmdPipelineBarrier(
 
   SERIALISE_CHECK_READ_ERRORS();
 
+  if(IsReplayingAndReading())
+  {
+    if(m_CacheDecodedCommands)
+    {
+      // next chains would need a deep copy, so barriers with them are always read from the
+      // serialiser
+      bool nextChains = false;
+      for(uint32_t i = 0; i < memoryBarrierCount; i++)
+        nextChains |= pMemoryBarriers[i].pNext != NULL;
+      for(uint32_t i = 0; i < bufferMemoryBarrierCount; i++)
+        nextChains |= pBufferMemoryBarriers[i].pNext != NULL;
+      for(uint32_t i = 0; i < imageMemoryBarrierCount; i++)
+        nextChains |= pImageMemoryBarriers[i].pNext != NULL;
+
+      if(!nextChains)
+        CacheDecodedCommand(
+            VulkanChunk::vkCmdPipelineBarrier,
+            DecodedCmdPipelineBarrier{
+                commandBuffer, srcStageMask, destStageMask, dependencyFlags, memoryBarrierCount,
+                CopyDecoded(pMemoryBarriers, memoryBarrierCount), bufferMemoryBarrierCount,
+                CopyDecoded(pBufferMemoryBarriers, bufferMemoryBarrierCount),
+                imageMemoryBarrierCount,
+                CopyDecoded(pImageMemoryBarriers, imageMemoryBarrierCount)});
+    }
+
+    return Replay_vkCmdPipelineBarrier(commandBuffer, srcStageMask, destStageMask, dependencyFlags,
+                                       memoryBarrierCount, pMemoryBarriers,
+                                       bufferMemoryBarrierCount, pBufferMemoryBarriers,
+                                       imageMemoryBarrierCount, pImageMemoryBarriers);
+  }
+
+  return true;
+}
+
+bool WrappedVulkan::Replay_vkCmdPipelineBarrier(VkCommandBuffer commandBuffer,
+                                                VkPipelineStageFlags srcStageMask,
+                                                VkPipelineStageFlags destStageMask,
+                                                VkDependencyFlags dependencyFlags,
+                                                uint32_t memoryBarrierCount,
+                                                const VkMemoryBarrier *pMemoryBarriers,
+                                                uint32_t bufferMemoryBarrierCount,
+                                                const VkBufferMemoryBarrier *pBufferMemoryBarriers,
+                                                uint32_t imageMemoryBarrierCount,
+                                                const VkImageMemoryBarrier *pImageMemoryBarriers)
+{
   std::vector<VkImageMemoryBarrier> imgBarriers;
   std::vector<VkBufferMemoryBarrier> bufBarriers;
 
@@ -2547,69 +2712,66 @@ bool WrappedVulkan::Serialise_vkCmdPipelineBarrier(
   // not exist, then it's safe to skip this barrier.
   //
   // Since it's a convenient place, we unwrap at the same time.
-  if(IsReplayingAndReading())
-  {
-    m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
+  m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
 
-    for(uint32_t i = 0; i < bufferMemoryBarrierCount; i++)
+  for(uint32_t i = 0; i < bufferMemoryBarrierCount; i++)
+  {
+    if(pBufferMemoryBarriers[i].buffer != VK_NULL_HANDLE)
     {
-      if(pBufferMemoryBarriers[i].buffer != VK_NULL_HANDLE)
-      {
-        bufBarriers.push_back(pBufferMemoryBarriers[i]);
-        bufBarriers.back().buffer = Unwrap(bufBarriers.back().buffer);
+      bufBarriers.push_back(pBufferMemoryBarriers[i]);
+      bufBarriers.back().buffer = Unwrap(bufBarriers.back().buffer);
 
-        RemapQueueFamilyIndices(bufBarriers.back().srcQueueFamilyIndex,
-                                bufBarriers.back().dstQueueFamilyIndex);
+      RemapQueueFamilyIndices(bufBarriers.back().srcQueueFamilyIndex,
+                              bufBarriers.back().dstQueueFamilyIndex);
 
-        if(IsLoading(m_State))
-        {
-          m_BakedCmdBufferInfo[m_LastCmdBufferID].resourceUsage.push_back(std::make_pair(
-              GetResID(pBufferMemoryBarriers[i].buffer),
-              EventUsage(m_BakedCmdBufferInfo[m_LastCmdBufferID].curEventID, ResourceUsage::Barrier)));
-        }
+      if(IsLoading(m_State))
+      {
+        m_BakedCmdBufferInfo[m_LastCmdBufferID].resourceUsage.push_back(std::make_pair(
+            GetResID(pBufferMemoryBarriers[i].buffer),
+            EventUsage(m_BakedCmdBufferInfo[m_LastCmdBufferID].curEventID, ResourceUsage::Barrier)));
       }
     }
+  }
 
-    for(uint32_t i = 0; i < imageMemoryBarrierCount; i++)
+  for(uint32_t i = 0; i < imageMemoryBarrierCount; i++)
+  {
+    if(pImageMemoryBarriers[i].image != VK_NULL_HANDLE)
     {
-      if(pImageMemoryBarriers[i].image != VK_NULL_HANDLE)
-      {
-        imgBarriers.push_back(pImageMemoryBarriers[i]);
-        imgBarriers.back().image = Unwrap(imgBarriers.back().image);
-        ReplacePresentableImageLayout(imgBarriers.back().oldLayout);
-        ReplacePresentableImageLayout(imgBarriers.back().newLayout);
+      imgBarriers.push_back(pImageMemoryBarriers[i]);
+      imgBarriers.back().image = Unwrap(imgBarriers.back().image);
+      ReplacePresentableImageLayout(imgBarriers.back().oldLayout);
+      ReplacePresentableImageLayout(imgBarriers.back().newLayout);
 
-        RemapQueueFamilyIndices(imgBarriers.back().srcQueueFamilyIndex,
-                                imgBarriers.back().dstQueueFamilyIndex);
+      RemapQueueFamilyIndices(imgBarriers.back().srcQueueFamilyIndex,
+                              imgBarriers.back().dstQueueFamilyIndex);
 
-        if(IsLoading(m_State))
-        {
-          m_BakedCmdBufferInfo[m_LastCmdBufferID].resourceUsage.push_back(std::make_pair(
-              GetResID(pImageMemoryBarriers[i].image),
-              EventUsage(m_BakedCmdBufferInfo[m_LastCmdBufferID].curEventID, ResourceUsage::Barrier)));
-        }
+      if(IsLoading(m_State))
+      {
+        m_BakedCmdBufferInfo[m_LastCmdBufferID].resourceUsage.push_back(std::make_pair(
+            GetResID(pImageMemoryBarriers[i].image),
+            EventUsage(m_BakedCmdBufferInfo[m_LastCmdBufferID].curEventID, ResourceUsage::Barrier)));
       }
     }
+  }
 
-    if(IsActiveReplaying(m_State))
-    {
-      if(InRerecordRange(m_LastCmdBufferID))
-        commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
-      else
-        commandBuffer = VK_NULL_HANDLE;
-    }
-
-    if(commandBuffer != VK_NULL_HANDLE)
-    {
-      ObjDisp(commandBuffer)
-          ->CmdPipelineBarrier(Unwrap(commandBuffer), srcStageMask, destStageMask, dependencyFlags,
-                               memoryBarrierCount, pMemoryBarriers, (uint32_t)bufBarriers.size(),
-                               bufBarriers.data(), (uint32_t)imgBarriers.size(), imgBarriers.data());
+  if(IsActiveReplaying(m_State))
+  {
+    if(InRerecordRange(m_LastCmdBufferID))
+      commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
+    else
+      commandBuffer = VK_NULL_HANDLE;
+  }
 
-      ResourceId cmd = GetResID(commandBuffer);
-      GetResourceManager()->RecordBarriers(m_BakedCmdBufferInfo[cmd].imgbarriers, m_ImageLayouts,
-                                           (uint32_t)imgBarriers.size(), imgBarriers.data());
-    }
+  if(commandBuffer != VK_NULL_HANDLE)
+  {
+    ObjDisp(commandBuffer)
+        ->CmdPipelineBarrier(Unwrap(commandBuffer), srcStageMask, destStageMask, dependencyFlags,
+                             memoryBarrierCount, pMemoryBarriers, (uint32_t)bufBarriers.size(),
+                             bufBarriers.data(), (uint32_t)imgBarriers.size(), imgBarriers.data());
+
+    ResourceId cmd = GetResID(commandBuffer);
+    GetResourceManager()->RecordBarriers(m_BakedCmdBufferInfo[cmd].imgbarriers, m_ImageLayouts,
+                                         (uint32_t)imgBarriers.size(), imgBarriers.data());
   }
 
   return true;
@@ -3275,6 +3437,8 @@ void WrappedVulkan::vkCmdExecuteCommands(VkCommandBuffer commandBuffer, uint32_t
       {
         record->cmdInfo->dirtied.insert(execRecord->bakedCommands->cmdInfo->dirtied.begin(),
                                         execRecord->bakedCommands->cmdInfo->dirtied.end());
+        // sets already bound in this command buffer keep their own generation, which at worst
+        // means they're merged again on the next bind
         record->cmdInfo->boundDescSets.insert(
             execRecord->bakedCommands->cmdInfo->boundDescSets.begin(),
             execRecord->bakedCommands->cmdInfo->boundDescSets.end());
@@ -4899,7 +5063,7 @@ void WrappedVulkan::vkCmdBeginConditionalRenderingEXT(
     VkResourceRecord *buf = GetRecord(pConditionalRenderingBegin->buffer);
 
     record->MarkResourceFrameReferenced(buf->GetResourceID(), eFrameRef_Read);
-    record->MarkResourceFrameReferenced(buf->baseResource, eFrameRef_Read);
+    record->MarkBoundMemoryFrameReferenced(buf->baseResource, eFrameRef_Read);
   }
 }
 
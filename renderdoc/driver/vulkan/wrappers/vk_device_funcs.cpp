@@ -637,6 +637,10 @@ void WrappedVulkan::Shutdown()
 
   m_PersistentEvents.clear();
 
+  // cached re-recorded command buffers are allocated from our own pools, free them before the pools
+  // are destroyed below
+  ClearRerecordCache();
+
   // since we didn't create proper registered resources for our command buffers,
   // they won't be taken down properly with the pool. So we release them (just our
   // data) here.
@@ -670,6 +674,13 @@ void WrappedVulkan::Shutdown()
     }
   }
 
+  // if loading failed part-way there may still be pipelines waiting, finish them so they're
+  // released below along with everything else
+  FlushPendingPipelines();
+
+  ClearReplayCheckpoints();
+  ClearDecodedCommands();
+
   FreeAllMemory(MemoryScope::InitialContents);
 
   // we do more in Shutdown than the equivalent vkDestroyInstance since on replay there's
@@ -194,56 +194,70 @@ bool WrappedVulkan::Serialise_vkCmdDraw(SerialiserType &ser, VkCommandBuffer com
 
   if(IsReplayingAndReading())
   {
-    m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
+    if(m_CacheDecodedCommands)
+      CacheDecodedCommand(VulkanChunk::vkCmdDraw,
+                          DecodedCmdDraw{commandBuffer, vertexCount, instanceCount, firstVertex,
+                                         firstInstance});
 
-    if(IsActiveReplaying(m_State))
-    {
-      if(InRerecordRange(m_LastCmdBufferID) && IsDrawInRenderPass())
-      {
-        commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
+    return Replay_vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+  }
 
-        uint32_t eventId = HandlePreCallback(commandBuffer);
+  return true;
+}
 
-        ObjDisp(commandBuffer)
-            ->CmdDraw(Unwrap(commandBuffer), vertexCount, instanceCount, firstVertex, firstInstance);
+bool WrappedVulkan::Replay_vkCmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCount,
+                                     uint32_t instanceCount, uint32_t firstVertex,
+                                     uint32_t firstInstance)
+{
+  m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
 
-        if(eventId && m_DrawcallCallback->PostDraw(eventId, commandBuffer))
-        {
-          ObjDisp(commandBuffer)
-              ->CmdDraw(Unwrap(commandBuffer), vertexCount, instanceCount, firstVertex,
-                        firstInstance);
-          m_DrawcallCallback->PostRedraw(eventId, commandBuffer);
-        }
-      }
-    }
-    else
+  if(IsActiveReplaying(m_State))
+  {
+    if(InRerecordRange(m_LastCmdBufferID) && IsDrawInRenderPass())
     {
+      commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
+
+      uint32_t eventId = HandlePreCallback(commandBuffer);
+
       ObjDisp(commandBuffer)
           ->CmdDraw(Unwrap(commandBuffer), vertexCount, instanceCount, firstVertex, firstInstance);
 
-      if(!IsDrawInRenderPass())
+      if(eventId && m_DrawcallCallback->PostDraw(eventId, commandBuffer))
       {
-        AddDebugMessage(MessageCategory::Execution, MessageSeverity::High,
-                        MessageSource::IncorrectAPIUse,
-                        "Drawcall in happening outside of render pass, or in secondary command "
-                        "buffer without RENDER_PASS_CONTINUE_BIT");
+        ObjDisp(commandBuffer)
+            ->CmdDraw(Unwrap(commandBuffer), vertexCount, instanceCount, firstVertex,
+                      firstInstance);
+        m_DrawcallCallback->PostRedraw(eventId, commandBuffer);
       }
+    }
+  }
+  else
+  {
+    ObjDisp(commandBuffer)
+        ->CmdDraw(Unwrap(commandBuffer), vertexCount, instanceCount, firstVertex, firstInstance);
 
-      {
-        AddEvent();
+    if(!IsDrawInRenderPass())
+    {
+      AddDebugMessage(MessageCategory::Execution, MessageSeverity::High,
+                      MessageSource::IncorrectAPIUse,
+                      "Drawcall in happening outside of render pass, or in secondary command "
+                      "buffer without RENDER_PASS_CONTINUE_BIT");
+    }
 
-        DrawcallDescription draw;
-        draw.name = StringFormat::Fmt("vkCmdDraw(%u, %u)", vertexCount, instanceCount);
-        draw.numIndices = vertexCount;
-        draw.numInstances = instanceCount;
-        draw.indexOffset = 0;
-        draw.vertexOffset = firstVertex;
-        draw.instanceOffset = firstInstance;
+    {
+      AddEvent();
+
+      DrawcallDescription draw;
+      draw.name = StringFormat::Fmt("vkCmdDraw(%u, %u)", vertexCount, instanceCount);
+      draw.numIndices = vertexCount;
+      draw.numInstances = instanceCount;
+      draw.indexOffset = 0;
+      draw.vertexOffset = firstVertex;
+      draw.instanceOffset = firstInstance;
 
-        draw.flags |= DrawFlags::Drawcall | DrawFlags::Instanced;
+      draw.flags |= DrawFlags::Drawcall | DrawFlags::Instanced;
 
-        AddDrawcall(draw, true);
-      }
+      AddDrawcall(draw, true);
     }
   }
 
@@ -292,58 +306,73 @@ bool WrappedVulkan::Serialise_vkCmdDrawIndexed(SerialiserType &ser, VkCommandBuf
 
   if(IsReplayingAndReading())
   {
-    m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
+    if(m_CacheDecodedCommands)
+      CacheDecodedCommand(VulkanChunk::vkCmdDrawIndexed,
+                          DecodedCmdDrawIndexed{commandBuffer, indexCount, instanceCount,
+                                                firstIndex, vertexOffset, firstInstance});
 
-    if(IsActiveReplaying(m_State))
-    {
-      if(InRerecordRange(m_LastCmdBufferID) && IsDrawInRenderPass())
-      {
-        commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
+    return Replay_vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex,
+                                   vertexOffset, firstInstance);
+  }
 
-        uint32_t eventId = HandlePreCallback(commandBuffer);
+  return true;
+}
 
-        ObjDisp(commandBuffer)
-            ->CmdDrawIndexed(Unwrap(commandBuffer), indexCount, instanceCount, firstIndex,
-                             vertexOffset, firstInstance);
+bool WrappedVulkan::Replay_vkCmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount,
+                                            uint32_t instanceCount, uint32_t firstIndex,
+                                            int32_t vertexOffset, uint32_t firstInstance)
+{
+  m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
 
-        if(eventId && m_DrawcallCallback->PostDraw(eventId, commandBuffer))
-        {
-          ObjDisp(commandBuffer)
-              ->CmdDrawIndexed(Unwrap(commandBuffer), indexCount, instanceCount, firstIndex,
-                               vertexOffset, firstInstance);
-          m_DrawcallCallback->PostRedraw(eventId, commandBuffer);
-        }
-      }
-    }
-    else
+  if(IsActiveReplaying(m_State))
+  {
+    if(InRerecordRange(m_LastCmdBufferID) && IsDrawInRenderPass())
     {
+      commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
+
+      uint32_t eventId = HandlePreCallback(commandBuffer);
+
       ObjDisp(commandBuffer)
           ->CmdDrawIndexed(Unwrap(commandBuffer), indexCount, instanceCount, firstIndex,
                            vertexOffset, firstInstance);
 
-      if(!IsDrawInRenderPass())
+      if(eventId && m_DrawcallCallback->PostDraw(eventId, commandBuffer))
       {
-        AddDebugMessage(MessageCategory::Execution, MessageSeverity::High,
-                        MessageSource::IncorrectAPIUse,
-                        "Drawcall in happening outside of render pass, or in secondary command "
-                        "buffer without RENDER_PASS_CONTINUE_BIT");
+        ObjDisp(commandBuffer)
+            ->CmdDrawIndexed(Unwrap(commandBuffer), indexCount, instanceCount, firstIndex,
+                             vertexOffset, firstInstance);
+        m_DrawcallCallback->PostRedraw(eventId, commandBuffer);
       }
+    }
+  }
+  else
+  {
+    ObjDisp(commandBuffer)
+        ->CmdDrawIndexed(Unwrap(commandBuffer), indexCount, instanceCount, firstIndex,
+                         vertexOffset, firstInstance);
 
-      {
-        AddEvent();
+    if(!IsDrawInRenderPass())
+    {
+      AddDebugMessage(MessageCategory::Execution, MessageSeverity::High,
+                      MessageSource::IncorrectAPIUse,
+                      "Drawcall in happening outside of render pass, or in secondary command "
+                      "buffer without RENDER_PASS_CONTINUE_BIT");
+    }
 
-        DrawcallDescription draw;
-        draw.name = StringFormat::Fmt("vkCmdDrawIndexed(%u, %u)", indexCount, instanceCount);
-        draw.numIndices = indexCount;
-        draw.numInstances = instanceCount;
-        draw.indexOffset = firstIndex;
-        draw.baseVertex = vertexOffset;
-        draw.instanceOffset = firstInstance;
+    {
+      AddEvent();
 
-        draw.flags |= DrawFlags::Drawcall | DrawFlags::Indexed | DrawFlags::Instanced;
+      DrawcallDescription draw;
+      draw.name = StringFormat::Fmt("vkCmdDrawIndexed(%u, %u)", indexCount, instanceCount);
+      draw.numIndices = indexCount;
+      draw.numInstances = instanceCount;
+      draw.indexOffset = firstIndex;
+      draw.baseVertex = vertexOffset;
+      draw.instanceOffset = firstInstance;
 
-        AddDrawcall(draw, true);
-      }
+      draw.flags |= DrawFlags::Drawcall | DrawFlags::Indexed | DrawFlags::Instanced;
+
+      AddDrawcall(draw, true);
     }
   }
 
@@ -1143,42 +1172,53 @@ bool WrappedVulkan::Serialise_vkCmdDispatch(SerialiserType &ser, VkCommandBuffer
 
   if(IsReplayingAndReading())
   {
-    m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
+    if(m_CacheDecodedCommands)
+      CacheDecodedCommand(VulkanChunk::vkCmdDispatch, DecodedCmdDispatch{commandBuffer, x, y, z});
 
-    if(IsActiveReplaying(m_State))
-    {
-      if(InRerecordRange(m_LastCmdBufferID))
-      {
-        commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
+    return Replay_vkCmdDispatch(commandBuffer, x, y, z);
+  }
 
-        uint32_t eventId = HandlePreCallback(commandBuffer, DrawFlags::Dispatch);
+  return true;
+}
 
-        ObjDisp(commandBuffer)->CmdDispatch(Unwrap(commandBuffer), x, y, z);
+bool WrappedVulkan::Replay_vkCmdDispatch(VkCommandBuffer commandBuffer, uint32_t x, uint32_t y,
+                                         uint32_t z)
+{
+  m_LastCmdBufferID = GetResourceManager()->GetOriginalID(GetResID(commandBuffer));
 
-        if(eventId && m_DrawcallCallback->PostDispatch(eventId, commandBuffer))
-        {
-          ObjDisp(commandBuffer)->CmdDispatch(Unwrap(commandBuffer), x, y, z);
-          m_DrawcallCallback->PostRedispatch(eventId, commandBuffer);
-        }
-      }
-    }
-    else
+  if(IsActiveReplaying(m_State))
+  {
+    if(InRerecordRange(m_LastCmdBufferID))
     {
+      commandBuffer = RerecordCmdBuf(m_LastCmdBufferID);
+
+      uint32_t eventId = HandlePreCallback(commandBuffer, DrawFlags::Dispatch);
+
       ObjDisp(commandBuffer)->CmdDispatch(Unwrap(commandBuffer), x, y, z);
 
+      if(eventId && m_DrawcallCallback->PostDispatch(eventId, commandBuffer))
       {
-        AddEvent();
+        ObjDisp(commandBuffer)->CmdDispatch(Unwrap(commandBuffer), x, y, z);
+        m_DrawcallCallback->PostRedispatch(eventId, commandBuffer);
+      }
+    }
+  }
+  else
+  {
+    ObjDisp(commandBuffer)->CmdDispatch(Unwrap(commandBuffer), x, y, z);
 
-        DrawcallDescription draw;
-        draw.name = StringFormat::Fmt("vkCmdDispatch(%u, %u, %u)", x, y, z);
-        draw.dispatchDimension[0] = x;
-        draw.dispatchDimension[1] = y;
-        draw.dispatchDimension[2] = z;
+    {
+      AddEvent();
 
-        draw.flags |= DrawFlags::Dispatch;
+      DrawcallDescription draw;
+      draw.name = StringFormat::Fmt("vkCmdDispatch(%u, %u, %u)", x, y, z);
+      draw.dispatchDimension[0] = x;
+      draw.dispatchDimension[1] = y;
+      draw.dispatchDimension[2] = z;
 
-        AddDrawcall(draw, true);
-      }
+      draw.flags |= DrawFlags::Dispatch;
+
+      AddDrawcall(draw, true);
     }
   }
 
@@ -1411,15 +1451,9 @@ void WrappedVulkan::vkCmdBlitImage(VkCommandBuffer commandBuffer, VkImage srcIma
 
     record->AddChunk(scope.Get());
 
-    record->MarkResourceFrameReferenced(GetResID(srcImage), eFrameRef_Read);
-    record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
-    record->MarkResourceFrameReferenced(GetResID(destImage), eFrameRef_PartialWrite);
-    record->MarkResourceFrameReferenced(GetRecord(destImage)->baseResource, eFrameRef_Read);
+    record->MarkImageFrameReferenced(GetRecord(srcImage), eFrameRef_Read);
+    record->MarkImageFrameReferenced(GetRecord(destImage), eFrameRef_PartialWrite);
     record->cmdInfo->dirtied.insert(GetResID(destImage));
-    if(GetRecord(srcImage)->resInfo)
-      record->cmdInfo->sparse.insert(GetRecord(srcImage)->resInfo);
-    if(GetRecord(destImage)->resInfo)
-      record->cmdInfo->sparse.insert(GetRecord(destImage)->resInfo);
   }
 }
 
@@ -1535,15 +1569,9 @@ void WrappedVulkan::vkCmdResolveImage(VkCommandBuffer commandBuffer, VkImage src
 
     record->AddChunk(scope.Get());
 
-    record->MarkResourceFrameReferenced(GetResID(srcImage), eFrameRef_Read);
-    record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
-    record->MarkResourceFrameReferenced(GetResID(destImage), eFrameRef_PartialWrite);
-    record->MarkResourceFrameReferenced(GetRecord(destImage)->baseResource, eFrameRef_Read);
+    record->MarkImageFrameReferenced(GetRecord(srcImage), eFrameRef_Read);
+    record->MarkImageFrameReferenced(GetRecord(destImage), eFrameRef_PartialWrite);
     record->cmdInfo->dirtied.insert(GetResID(destImage));
-    if(GetRecord(srcImage)->resInfo)
-      record->cmdInfo->sparse.insert(GetRecord(srcImage)->resInfo);
-    if(GetRecord(destImage)->resInfo)
-      record->cmdInfo->sparse.insert(GetRecord(destImage)->resInfo);
   }
 }
 
@@ -1657,15 +1685,9 @@ void WrappedVulkan::vkCmdCopyImage(VkCommandBuffer commandBuffer, VkImage srcIma
                              destImageLayout, regionCount, pRegions);
 
     record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(srcImage), eFrameRef_Read);
-    record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
-    record->MarkResourceFrameReferenced(GetResID(destImage), eFrameRef_PartialWrite);
-    record->MarkResourceFrameReferenced(GetRecord(destImage)->baseResource, eFrameRef_Read);
+    record->MarkImageFrameReferenced(GetRecord(srcImage), eFrameRef_Read);
+    record->MarkImageFrameReferenced(GetRecord(destImage), eFrameRef_PartialWrite);
     record->cmdInfo->dirtied.insert(GetResID(destImage));
-    if(GetRecord(srcImage)->resInfo)
-      record->cmdInfo->sparse.insert(GetRecord(srcImage)->resInfo);
-    if(GetRecord(destImage)->resInfo)
-      record->cmdInfo->sparse.insert(GetRecord(destImage)->resInfo);
   }
 }
 
@@ -2096,10 +2118,7 @@ void WrappedVulkan::vkCmdClearColorImage(VkCommandBuffer commandBuffer, VkImage
                                    pRanges);
 
     record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(image), eFrameRef_PartialWrite);
-    record->MarkResourceFrameReferenced(GetRecord(image)->baseResource, eFrameRef_Read);
-    if(GetRecord(image)->resInfo)
-      record->cmdInfo->sparse.insert(GetRecord(image)->resInfo);
+    record->MarkImageFrameReferenced(GetRecord(image), eFrameRef_PartialWrite);
   }
 }
 
@@ -2203,10 +2222,7 @@ void WrappedVulkan::vkCmdClearDepthStencilImage(VkCommandBuffer commandBuffer, V
                                           rangeCount, pRanges);
 
     record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(image), eFrameRef_PartialWrite);
-    record->MarkResourceFrameReferenced(GetRecord(image)->baseResource, eFrameRef_Read);
-    if(GetRecord(image)->resInfo)
-      record->cmdInfo->sparse.insert(GetRecord(image)->resInfo);
+    record->MarkImageFrameReferenced(GetRecord(image), eFrameRef_PartialWrite);
   }
 }
 
@@ -339,6 +339,14 @@ bool WrappedVulkan::Serialise_vkQueueSubmit(SerialiserType &ser, VkQueue queue,
         {
           // do nothing, don't bother with the logic below
         }
+        else if(IsCheckpointedEvent(m_RootEventID))
+        {
+          // the results of this submit were restored from a replay checkpoint
+#if ENABLED(VERBOSE_PARTIAL_REPLAY)
+          RDCDEBUG("Queue Submit restored from checkpoint %u <= %u", m_RootEventID,
+                   m_ReplayCheckpoints.resumeEventID);
+#endif
+        }
         else if(m_LastEventID <= startEID)
         {
 #if ENABLED(VERBOSE_PARTIAL_REPLAY)
@@ -704,6 +712,26 @@ void WrappedVulkan::InsertDrawsAndRefreshIDs(BakedCmdBufferInfo &cmdBufInfo)
   }
 }
 
+// sorts and merges the written ranges accumulated for a write tracked map, moving them into ranges.
+static bool TakeWrittenRanges(rdcarray<rdcpair<size_t, size_t>> &written,
+                              rdcarray<rdcpair<size_t, size_t>> &ranges)
+{
+  std::sort(written.begin(), written.end());
+
+  ranges.clear();
+  for(const rdcpair<size_t, size_t> &r : written)
+  {
+    if(!ranges.empty() && r.first <= ranges.back().second)
+      ranges.back().second = RDCMAX(ranges.back().second, r.second);
+    else
+      ranges.push_back(r);
+  }
+
+  written.clear();
+
+  return !ranges.empty();
+}
+
 VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
                                       const VkSubmitInfo *pSubmits, VkFence fence)
 {
@@ -781,7 +809,13 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
   bool capframe = false;
   bool present = false;
 
-  set<ResourceId> refdIDs;
+  // the memory referenced by this batch, used to find which coherent maps need to be checked
+  std::vector<ResourceId> refdMems;
+
+#if ENABLED(RDOC_DEVEL)
+  // every resource referenced by the batch. Used to check that refdMems hasn't missed any memory
+  std::set<ResourceId> refdIDs;
+#endif
 
   VkResourceRecord *queueRecord = GetRecord(queue);
 
@@ -840,16 +874,21 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
         for(auto it = record->bakedCommands->cmdInfo->boundDescSets.begin();
             it != record->bakedCommands->cmdInfo->boundDescSets.end(); ++it)
         {
-          GetResourceManager()->MarkResourceFrameReferenced(GetResID(*it), eFrameRef_Read);
+          GetResourceManager()->MarkResourceFrameReferenced(GetResID(it->first), eFrameRef_Read);
 
-          VkResourceRecord *setrecord = GetRecord(*it);
+          VkResourceRecord *setrecord = GetRecord(it->first);
 
-          for(auto refit = setrecord->descInfo->bindFrameRefs.begin();
-              refit != setrecord->descInfo->bindFrameRefs.end(); ++refit)
+          setrecord->descInfo->UpdateFlatRefs();
+
+          for(auto refit = setrecord->descInfo->flatFrameRefs.begin();
+              refit != setrecord->descInfo->flatFrameRefs.end(); ++refit)
           {
-            refdIDs.insert(refit->first);
             GetResourceManager()->MarkResourceFrameReferenced(refit->first, refit->second.second);
 
+#if ENABLED(RDOC_DEVEL)
+            refdIDs.insert(refit->first);
+#endif
+
             if(refit->second.first & DescriptorSetData::SPARSE_REF_BIT)
             {
               VkResourceRecord *sparserecord = GetResourceManager()->GetResourceRecord(refit->first);
@@ -858,6 +897,9 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
             }
           }
           GetResourceManager()->MergeReferencedMemory(setrecord->descInfo->bindMemRefs);
+
+          refdMems.insert(refdMems.end(), setrecord->descInfo->flatMemRefs.begin(),
+                          setrecord->descInfo->flatMemRefs.end());
         }
 
         for(auto it = record->bakedCommands->cmdInfo->sparse.begin();
@@ -866,7 +908,11 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
 
         // pull in frame refs from this baked command buffer
         record->bakedCommands->AddResourceReferences(GetResourceManager());
+        refdMems.insert(refdMems.end(), record->bakedCommands->cmdInfo->memRefIDs.begin(),
+                        record->bakedCommands->cmdInfo->memRefIDs.end());
+#if ENABLED(RDOC_DEVEL)
         record->bakedCommands->AddReferencedIDs(refdIDs);
+#endif
 
         GetResourceManager()->MergeReferencedMemory(record->bakedCommands->cmdInfo->memFrameRefs);
 
@@ -878,7 +924,12 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
         {
           record->bakedCommands->cmdInfo->subcmds[sub]->bakedCommands->AddResourceReferences(
               GetResourceManager());
+          const std::vector<ResourceId> &subMemRefs =
+              record->bakedCommands->cmdInfo->subcmds[sub]->bakedCommands->cmdInfo->memRefIDs;
+          refdMems.insert(refdMems.end(), subMemRefs.begin(), subMemRefs.end());
+#if ENABLED(RDOC_DEVEL)
           record->bakedCommands->cmdInfo->subcmds[sub]->bakedCommands->AddReferencedIDs(refdIDs);
+#endif
           GetResourceManager()->MergeReferencedMemory(
               record->bakedCommands->cmdInfo->subcmds[sub]->bakedCommands->cmdInfo->memFrameRefs);
           GetResourceManager()->MarkResourceFrameReferenced(
@@ -909,13 +960,87 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
     if(fence != VK_NULL_HANDLE)
       GetResourceManager()->MarkResourceFrameReferenced(GetResID(fence), eFrameRef_Read);
 
+    // only coherent maps referenced by this batch can affect it. Look up each referenced memory to
+    // mark its map in a bitset, so this scales with the memory referenced rather than the number of
+    // maps, and each map is only visited once however many times it's referenced.
     std::vector<VkResourceRecord *> maps;
+    std::vector<VkResourceRecord *> refdMaps;
+    std::vector<uint64_t> refdMapBits;
     {
       SCOPED_LOCK(m_CoherentMapsLock);
-      maps = m_CoherentMaps;
+
+      refdMapBits.resize((m_CoherentMaps.size() + 63) / 64);
+
+      for(ResourceId id : refdMems)
+      {
+        auto it = m_CoherentMapIndex.find(id);
+        if(it != m_CoherentMapIndex.end())
+          refdMapBits[it->second / 64] |= 1ULL << (it->second % 64);
+      }
+
+      for(size_t i = 0; i < refdMapBits.size(); i++)
+      {
+        for(uint64_t b = 0; b < 64 && (refdMapBits[i] >> b); b++)
+        {
+          if(refdMapBits[i] & (1ULL << b))
+            refdMaps.push_back(m_CoherentMaps[i * 64 + b]);
+        }
+      }
+
+#if ENABLED(RDOC_DEVEL)
+      // refdMems must cover every map that any frame reference in the batch would have matched,
+      // otherwise a reference site has marked memory without adding it to memRefIDs.
+      for(size_t i = 0; i < m_CoherentMaps.size(); i++)
+      {
+        if(refdIDs.find(m_CoherentMaps[i]->GetResourceID()) != refdIDs.end() &&
+           (refdMapBits[i / 64] & (1ULL << (i % 64))) == 0)
+          RDCERR("Memory %llu is referenced in submit but missing from referenced memory IDs",
+                 m_CoherentMaps[i]->GetResourceID());
+      }
+#endif
+
+      // write tracking needs to look at every map, see below. The indices in refdMapBits match.
+      if(m_TrackMapWrites)
+        maps = m_CoherentMaps;
+    }
+
+    if(m_TrackMapWrites)
+    {
+      // page write tracking is reset for the whole process at once, so before resetting we gather
+      // the writes for every tracked map - not just the ones referenced in this submit. Any maps
+      // about to be serialised for the first time in this frame start being tracked now, so
+      // everything written after they're serialised is caught.
+      bool anyTracked = false;
+
+      for(size_t i = 0; i < maps.size(); i++)
+      {
+        VkResourceRecord *record = maps[i];
+        MemMapState &state = *record->memMapState;
+
+        if(!state.mapCoherent || !state.mappedPtr)
+          continue;
+
+        byte *mapBase = state.mappedPtr + (size_t)state.mapOffset;
+
+        if(state.writeTracked)
+        {
+          Process::GetWrittenPages(mapBase, (size_t)state.mapSize, state.writtenRanges);
+          anyTracked = true;
+        }
+        else if(!state.needRefData && !state.mapFlushed &&
+                (refdMapBits[i / 64] & (1ULL << (i % 64))))
+        {
+          state.writeTracked = Process::CanTrackPageWrites(mapBase, (size_t)state.mapSize);
+          anyTracked |= state.writeTracked;
+        }
+      }
+
+      if(anyTracked)
+        Process::ResetPageWrites();
     }
 
-    for(auto it = maps.begin(); it != maps.end(); ++it)
+    // only need to flush memory that could affect this submitted batch of work
+    for(auto it = refdMaps.begin(); it != refdMaps.end(); ++it)
     {
       VkResourceRecord *record = *it;
       MemMapState &state = *record->memMapState;
@@ -923,15 +1048,7 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
       // potential persistent map
       if(state.mapCoherent && state.mappedPtr && !state.mapFlushed)
       {
-        // only need to flush memory that could affect this submitted batch of work
-        if(refdIDs.find(record->GetResourceID()) == refdIDs.end())
-        {
-          RDCDEBUG("Map of memory %llu not referenced in this queue - not flushing",
-                   record->GetResourceID());
-          continue;
-        }
-
-        size_t diffStart = 0, diffEnd = 0;
+        rdcarray<rdcpair<size_t, size_t>> diffRanges;
         bool found = true;
 
 // enabled as this is necessary for programs with very large coherent mappings
@@ -944,7 +1061,7 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
         // the buffer and whenever we then copy into the ref data, e.g. below.
         // during this time, data could be written to the buffer and it won't have
         // been caught in the serialised snapshot, and if it doesn't change then
-        // it *also* won't be caught in any future FindDiffRange() calls.
+        // it *also* won't be caught in any future FindDiffRanges() calls.
         //
         // Likewise once refData is allocated, the call below will also update it
         // with the data serialised out for the same reason.
@@ -955,16 +1072,31 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
         // data that would be needed by the GPU in this submit. As long as the
         // refdata we use for future use is identical to what was serialised, we
         // shouldn't miss anything
+        bool firstFlush = !state.needRefData;
         state.needRefData = true;
 
-        // if we have a previous set of data, compare.
+        // if we have a previous set of data or page hashes, compare.
         // otherwise just serialise it all
-        if(state.refData)
-          found = FindDiffRange((byte *)state.mappedPtr, state.refData, (size_t)state.mapSize,
-                                diffStart, diffEnd);
+        //
+        // If the map is write tracked then we don't keep refData at all. The first flush in the
+        // frame serialises everything and after that only the pages written since.
+        //
+        // refData and the ranges found are relative to the start of the mapping, whereas
+        // mappedPtr is relative to the start of the memory.
+        if(state.writeTracked && !firstFlush)
+          found = TakeWrittenRanges(state.writtenRanges, diffRanges);
+        else if(state.refData)
+          found = FindDiffRanges(state.mappedPtr + (size_t)state.mapOffset, state.refData,
+                                 (size_t)state.mapSize, diffRanges);
+        else if(!state.refHashes.empty())
+          found = FindChangedPages(state.mappedPtr + (size_t)state.mapOffset, (size_t)state.mapSize,
+                                   state.refHashes.data(), diffRanges);
         else
 #endif
-          diffEnd = (size_t)state.mapSize;
+          diffRanges.push_back(make_rdcpair<size_t, size_t>(0, (size_t)state.mapSize));
+
+        if(state.writeTracked)
+          state.writtenRanges.clear();
 
         if(found)
         {
@@ -973,12 +1105,30 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
           VkDevice dev = GetDev();
 
           {
-            RDCLOG("Persistent map flush forced for %llu (%llu -> %llu)", record->GetResourceID(),
-                   (uint64_t)diffStart, (uint64_t)diffEnd);
-            VkMappedMemoryRange range = {VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL,
-                                         (VkDeviceMemory)(uint64_t)record->Resource,
-                                         state.mapOffset + diffStart, diffEnd - diffStart};
-            vkFlushMappedMemoryRanges(dev, 1, &range);
+            // flush each disjoint range separately, so writes at opposite ends of a large mapping
+            // don't serialise everything in between. Each range gets its own chunk.
+            SCOPED_LOCK(m_CoherentFlushRangesLock);
+
+            std::vector<VkMappedMemoryRange> &ranges = m_CoherentFlushRanges;
+            ranges.resize(diffRanges.size());
+
+            uint64_t totalSize = 0;
+            for(size_t r = 0; r < diffRanges.size(); r++)
+            {
+              ranges[r].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+              ranges[r].pNext = NULL;
+              ranges[r].memory = (VkDeviceMemory)(uint64_t)record->Resource;
+              ranges[r].offset = state.mapOffset + diffRanges[r].first;
+              ranges[r].size = diffRanges[r].second - diffRanges[r].first;
+
+              totalSize += ranges[r].size;
+            }
+
+            RDCLOG("Persistent map flush forced for %llu (%llu -> %llu, %llu bytes in %zu ranges)",
+                   record->GetResourceID(), (uint64_t)diffRanges[0].first,
+                   (uint64_t)diffRanges.back().second, totalSize, diffRanges.size());
+
+            vkFlushMappedMemoryRanges(dev, (uint32_t)ranges.size(), ranges.data());
             state.mapFlushed = false;
           }
 
@@ -1036,6 +1186,10 @@ bool WrappedVulkan::Serialise_vkQueueBindSparse(SerialiserType &ser, VkQueue que
 
   if(IsReplayingAndReading())
   {
+    // replay checkpoints don't snapshot sparse page tables, so they can't restore across this
+    if(IsLoading(m_State))
+      m_ReplayCheckpoints.sparseBinds = true;
+
     // similar to vkQueueSubmit we don't need semaphores at all, just whether we waited on any.
     // For waiting semaphores, since we don't track state we have to just conservatively
     // wait for queue idle. Since we do that, there's equally no point in signalling semaphores
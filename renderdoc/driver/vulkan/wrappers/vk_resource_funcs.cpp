@@ -494,12 +494,12 @@ void WrappedVulkan::vkFreeMemory(VkDevice device, VkDeviceMemory memory,
       wrapped->record->memMapState->refData = NULL;
     }
 
+    if(wrapped->record->memMapState)
+      wrapped->record->memMapState->refHashes.clear();
+
     {
       SCOPED_LOCK(m_CoherentMapsLock);
-
-      auto it = std::find(m_CoherentMaps.begin(), m_CoherentMaps.end(), wrapped->record);
-      if(it != m_CoherentMaps.end())
-        m_CoherentMaps.erase(it);
+      RemoveCoherentMap(wrapped->record);
     }
   }
 
@@ -534,6 +534,9 @@ VkResult WrappedVulkan::vkMapMemory(VkDevice device, VkDeviceMemory mem, VkDevic
 
       state.mappedPtr = (byte *)realData - (size_t)offset;
       state.refData = NULL;
+      state.refHashes.clear();
+      state.writeTracked = false;
+      state.writtenRanges.clear();
 
       state.mapOffset = offset;
       state.mapSize = size == VK_WHOLE_SIZE ? (memrecord->Length - offset) : size;
@@ -544,7 +547,7 @@ VkResult WrappedVulkan::vkMapMemory(VkDevice device, VkDeviceMemory mem, VkDevic
       if(state.mapCoherent)
       {
         SCOPED_LOCK(m_CoherentMapsLock);
-        m_CoherentMaps.push_back(memrecord);
+        AddCoherentMap(memrecord);
       }
     }
     else
@@ -585,6 +588,11 @@ bool WrappedVulkan::Serialise_vkUnmapMemory(SerialiserType &ser, VkDevice device
   SERIALISE_ELEMENT(MapOffset);
   SERIALISE_ELEMENT(MapSize);
 
+  // if we resumed from a replay checkpoint after this point, the memory already has the right
+  // contents. Leaving MapData as NULL skips over the data.
+  if(IsActiveReplaying(m_State) && IsCheckpointedEvent(m_RootEventID))
+    memory = VK_NULL_HANDLE;
+
   if(IsReplayingAndReading() && memory != VK_NULL_HANDLE)
   {
     VkResult vkr = ObjDisp(device)->MapMemory(Unwrap(device), Unwrap(memory), MapOffset, MapSize, 0,
@@ -666,16 +674,14 @@ void WrappedVulkan::vkUnmapMemory(VkDevice device, VkDeviceMemory mem)
 
     FreeAlignedBuffer(state.refData);
     state.refData = NULL;
+    state.refHashes.clear();
 
     if(state.mapCoherent)
     {
       SCOPED_LOCK(m_CoherentMapsLock);
 
-      auto it = std::find(m_CoherentMaps.begin(), m_CoherentMaps.end(), memrecord);
-      if(it == m_CoherentMaps.end())
+      if(!RemoveCoherentMap(memrecord))
         RDCERR("vkUnmapMemory for memory handle that's not currently mapped");
-      else
-        m_CoherentMaps.erase(it);
     }
   }
 
@@ -710,6 +716,10 @@ bool WrappedVulkan::Serialise_vkFlushMappedMemoryRanges(SerialiserType &ser, VkD
     MappedData = state->mappedPtr + (size_t)MemRange.offset;
   }
 
+  // as in vkUnmapMemory, skip the data if a replay checkpoint already contains it
+  if(IsActiveReplaying(m_State) && IsCheckpointedEvent(m_RootEventID))
+    MemRange.memory = VK_NULL_HANDLE;
+
   if(IsReplayingAndReading() && MemRange.memory != VK_NULL_HANDLE)
   {
     VkResult ret =
@@ -730,15 +740,26 @@ bool WrappedVulkan::Serialise_vkFlushMappedMemoryRanges(SerialiserType &ser, VkD
 
   // if we need to save off this serialised buffer as reference for future comparison,
   // do so now. See the call to vkFlushMappedMemoryRanges in WrappedVulkan::vkQueueSubmit()
-  if(ser.IsWriting() && state->needRefData)
+  if(ser.IsWriting() && state->needRefData && !state->writeTracked)
   {
-    if(!state->refData)
+    // when first creating the reference, decide whether to keep a copy or page hashes
+    bool hashed = !state->refHashes.empty();
+
+    if(!state->refData && !hashed)
     {
-      // if we're in this case, the range should be for the whole memory region.
-      RDCASSERT(MemRange.offset == 0 && memRangeSize == state->mapSize);
+      // if we're in this case, the range should be for the whole mapped region.
+      RDCASSERT(MemRange.offset == state->mapOffset && memRangeSize == state->mapSize);
 
       // allocate ref data so we can compare next time to minimise serialised data
-      state->refData = AllocAlignedBuffer((size_t)state->mapSize);
+      if(RenderDoc::Inst().GetCaptureOptions().hashMappedMemory)
+      {
+        state->refHashes.resize(NumHashedPages((size_t)state->mapSize));
+        hashed = true;
+      }
+      else
+      {
+        state->refData = AllocAlignedBuffer((size_t)state->mapSize);
+      }
     }
 
     // it's no longer safe to use state->mappedPtr, we need to save *precisely* what
@@ -748,7 +769,14 @@ bool WrappedVulkan::Serialise_vkFlushMappedMemoryRanges(SerialiserType &ser, VkD
 
     const byte *serialisedData = ser.GetWriter()->GetData() + offs;
 
-    memcpy(state->refData, serialisedData, (size_t)memRangeSize);
+    // the flush can be for any sub-range of the mapping, refData begins at the map offset
+    size_t refOffset = (size_t)(MemRange.offset - state->mapOffset);
+
+    if(hashed)
+      HashPages(serialisedData, refOffset, (size_t)memRangeSize, (size_t)state->mapSize,
+                state->refHashes.data());
+    else
+      memcpy(state->refData + refOffset, serialisedData, (size_t)memRangeSize);
   }
 
   return true;
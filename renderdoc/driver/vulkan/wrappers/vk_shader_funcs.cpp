@@ -23,6 +23,7 @@
  ******************************************************************************/
 
 #include "../vk_core.h"
+#include "../vk_shader_cache.h"
 #include "driver/shaders/spirv/spirv_common.h"
 
 template <>
@@ -92,6 +93,303 @@ VkPipelineLayoutCreateInfo WrappedVulkan::UnwrapInfo(const VkPipelineLayoutCreat
   return ret;
 }
 
+// pipelines and reflections are only worth processing in parallel if there are a few of them,
+// otherwise the threads cost more than they save
+static const size_t loadParallelThreshold = 4;
+static const size_t loadParallelThreads = 8;
+
+// calls func for every index in [0, count), on several threads including this one if there are
+// enough to be worth it. Returns once all are done.
+static void LoadParallelFor(WrappedVulkan *driver, size_t count,
+                            const std::function<void(size_t)> &func)
+{
+  if(count < loadParallelThreshold)
+  {
+    for(size_t i = 0; i < count; i++)
+      func(i);
+    return;
+  }
+
+  // each thread takes the next index in turn
+  volatile int32_t next = -1;
+
+  auto worker = [&func, &next, count]() {
+    for(;;)
+    {
+      int32_t idx = Atomic::Inc32(&next);
+      if(idx >= (int32_t)count)
+        break;
+
+      func((size_t)idx);
+    }
+  };
+
+  size_t numThreads = RDCMIN(count, loadParallelThreads);
+
+  std::vector<Threading::ThreadHandle> threads;
+  for(size_t i = 0; i < numThreads - 1; i++)
+  {
+    // the threads only live for this call, so free any temporary memory they allocated rather than
+    // leaving it to pile up in the driver until shutdown
+    threads.push_back(Threading::CreateThread([&worker, driver]() {
+      worker();
+      driver->FreeTempMemory();
+    }));
+  }
+
+  worker();
+
+  for(Threading::ThreadHandle t : threads)
+  {
+    Threading::JoinThread(t);
+    Threading::CloseThread(t);
+  }
+}
+
+bool WrappedVulkan::DeferPipelineCreation()
+{
+  // only while reading the resources before the frame, pipelines created in the frame or after the
+  // capture is opened must be usable immediately
+  return IsLoading(m_State) && m_FrameReader == NULL;
+}
+
+void WrappedVulkan::CreatePendingPipeline(PendingPipeline &pending)
+{
+  // this can be called on any thread, so it only creates the driver objects and touches nothing
+  // else. Any wrapping or bookkeeping happens in FinishPendingPipeline.
+  VkDevice device = pending.device;
+
+  // don't use the application's pipeline caches on replay, use our own persistent one instead
+  VkPipelineCache pipelineCache = GetShaderCache()->GetPipeCache();
+
+  if(pending.compute)
+  {
+    VkComputePipelineCreateInfo *unwrapped = UnwrapInfos(&pending.computeInfo, 1);
+    pending.ret = ObjDisp(device)->CreateComputePipelines(Unwrap(device), Unwrap(pipelineCache), 1,
+                                                          unwrapped, NULL, &pending.pipe);
+    return;
+  }
+
+  VkGraphicsPipelineCreateInfo *unwrapped = UnwrapInfos(&pending.graphicsInfo, 1);
+  pending.ret = ObjDisp(device)->CreateGraphicsPipelines(Unwrap(device), Unwrap(pipelineCache), 1,
+                                                         unwrapped, NULL, &pending.pipe);
+
+  if(pending.ret != VK_SUCCESS)
+    return;
+
+  // also create the variant used to replay from part-way through a render pass. If this pipeline
+  // turns out to be a duplicate this is destroyed again.
+  VkGraphicsPipelineCreateInfo subpass0Info = pending.graphicsInfo;
+  subpass0Info.renderPass = pending.subpass0RP;
+  subpass0Info.subpass = 0;
+
+  unwrapped = UnwrapInfos(&subpass0Info, 1);
+  VkResult ret = ObjDisp(device)->CreateGraphicsPipelines(Unwrap(device), Unwrap(pipelineCache), 1,
+                                                          unwrapped, NULL, &pending.subpass0pipe);
+  RDCASSERTEQUAL(ret, VK_SUCCESS);
+}
+
+bool WrappedVulkan::FinishPendingPipeline(PendingPipeline &pending)
+{
+  VkDevice device = pending.device;
+  ResourceId Pipeline = pending.Pipeline;
+  VkPipeline pipe = pending.pipe;
+
+  bool ret = true;
+
+  if(pending.ret != VK_SUCCESS)
+  {
+    RDCERR("Failed on resource serialise-creation, VkResult: %s", ToStr(pending.ret).c_str());
+    ret = false;
+  }
+  else
+  {
+    ResourceId live;
+
+    if(GetResourceManager()->HasWrapper(ToTypedHandle(pipe)))
+    {
+      live = GetResourceManager()->GetNonDispWrapper(pipe)->id;
+
+      // destroy this instance of the duplicate, as we must have matching create/destroy
+      // calls and there won't be a wrapped resource hanging around to destroy this one.
+      ObjDisp(device)->DestroyPipeline(Unwrap(device), pipe, NULL);
+
+      if(pending.subpass0pipe != VK_NULL_HANDLE)
+        ObjDisp(device)->DestroyPipeline(Unwrap(device), pending.subpass0pipe, NULL);
+
+      // whenever the new ID is requested, return the old ID, via replacements.
+      GetResourceManager()->ReplaceResource(Pipeline, GetResourceManager()->GetOriginalID(live));
+    }
+    else
+    {
+      live = GetResourceManager()->WrapResource(Unwrap(device), pipe);
+      GetResourceManager()->AddLiveResource(Pipeline, pipe);
+
+      VulkanCreationInfo::Pipeline &pipeInfo = m_CreationInfo.m_Pipeline[live];
+
+      if(pending.compute)
+      {
+        pipeInfo.Init(GetResourceManager(), m_CreationInfo, &pending.computeInfo);
+      }
+      else
+      {
+        pipeInfo.Init(GetResourceManager(), m_CreationInfo, &pending.graphicsInfo);
+
+        pipeInfo.subpass0pipe = pending.subpass0pipe;
+
+        ResourceId subpass0id =
+            GetResourceManager()->WrapResource(Unwrap(device), pipeInfo.subpass0pipe);
+
+        // register as a live-only resource, so it is cleaned up properly
+        GetResourceManager()->AddLiveResource(subpass0id, pipeInfo.subpass0pipe);
+      }
+    }
+
+    AddResource(Pipeline, ResourceType::PipelineState, "Graphics Pipeline");
+    DerivedResource(device, Pipeline);
+    if(pending.origCache != VK_NULL_HANDLE)
+      DerivedResource(pending.origCache, Pipeline);
+
+    if(pending.compute)
+    {
+      const VkComputePipelineCreateInfo &CreateInfo = pending.computeInfo;
+
+      if(CreateInfo.flags & VK_PIPELINE_CREATE_DERIVATIVE_BIT)
+      {
+        if(CreateInfo.basePipelineHandle != VK_NULL_HANDLE)
+          DerivedResource(CreateInfo.basePipelineHandle, Pipeline);
+      }
+      DerivedResource(CreateInfo.layout, Pipeline);
+      DerivedResource(CreateInfo.stage.module, Pipeline);
+    }
+    else
+    {
+      const VkGraphicsPipelineCreateInfo &CreateInfo = pending.graphicsInfo;
+
+      if(CreateInfo.flags & VK_PIPELINE_CREATE_DERIVATIVE_BIT)
+      {
+        if(CreateInfo.basePipelineHandle != VK_NULL_HANDLE)
+          DerivedResource(CreateInfo.basePipelineHandle, Pipeline);
+      }
+      DerivedResource(pending.origRP, Pipeline);
+      DerivedResource(CreateInfo.layout, Pipeline);
+      for(uint32_t i = 0; i < CreateInfo.stageCount; i++)
+        DerivedResource(CreateInfo.pStages[i].module, Pipeline);
+    }
+  }
+
+  if(pending.compute)
+    Deserialise(pending.computeInfo);
+  else
+    Deserialise(pending.graphicsInfo);
+
+  return ret;
+}
+
+bool WrappedVulkan::FlushPendingPipelines()
+{
+  if(m_PendingPipelines.empty())
+    return !m_PendingPipelinesFailed;
+
+  // take the list, so nothing below can see a half-finished batch
+  std::vector<PendingPipeline> pending;
+  pending.swap(m_PendingPipelines);
+
+  // the driver calls are the expensive part and don't need any synchronisation
+  LoadParallelFor(this, pending.size(),
+                  [this, &pending](size_t i) { CreatePendingPipeline(pending[i]); });
+
+  // wrap and register them in the order they were serialised, so IDs are deterministic. A failure
+  // is remembered, as this may be called from deserialisation where it can't be returned.
+  for(PendingPipeline &p : pending)
+  {
+    if(!FinishPendingPipeline(p))
+      m_PendingPipelinesFailed = true;
+  }
+
+  FlushPendingReflections();
+
+  return !m_PendingPipelinesFailed;
+}
+
+void WrappedVulkan::FlushPendingReflections()
+{
+  typedef VulkanCreationInfo::ShaderModule::Reflection Reflection;
+
+  if(m_CreationInfo.m_PendingReflections.empty())
+    return;
+
+  std::vector<std::pair<ResourceId, Reflection *>> pending;
+  pending.swap(m_CreationInfo.m_PendingReflections);
+
+  VulkanShaderCache *cache = GetShaderCache();
+
+  // fetch what we can from the cache, and group the rest by module. Reflecting caches some data
+  // on the module, so only one thread at a time can work on a given module.
+  std::vector<uint64_t> keys(pending.size());
+  std::map<ResourceId, std::vector<size_t>> moduleReflections;
+
+  for(size_t i = 0; i < pending.size(); i++)
+  {
+    const SPVModule &spv = m_CreationInfo.m_ShaderModule[pending[i].first].spirv;
+    Reflection &r = *pending[i].second;
+
+    keys[i] = 0;
+
+    if(cache && !spv.spirv.empty())
+    {
+      keys[i] = VulkanShaderCache::GetReflectionKey(spv.spirv, r.entryPoint, r.stageIndex);
+
+      if(cache->GetReflection(keys[i], r.refl, r.mapping, r.patchData))
+        continue;
+    }
+
+    moduleReflections[pending[i].first].push_back(i);
+  }
+
+  std::vector<std::pair<const SPVModule *, std::vector<size_t>>> jobs;
+  for(auto it = moduleReflections.begin(); it != moduleReflections.end(); ++it)
+    jobs.push_back({&m_CreationInfo.m_ShaderModule[it->first].spirv, it->second});
+
+  LoadParallelFor(this, jobs.size(), [&pending, &jobs](size_t j) {
+    for(size_t i : jobs[j].second)
+    {
+      Reflection &r = *pending[i].second;
+      jobs[j].first->MakeReflection(GraphicsAPI::Vulkan, ShaderStage(r.stageIndex), r.entryPoint,
+                                    r.refl, r.mapping, r.patchData);
+    }
+  });
+
+  for(size_t j = 0; j < jobs.size(); j++)
+  {
+    if(!cache)
+      break;
+
+    for(size_t i : jobs[j].second)
+    {
+      Reflection &r = *pending[i].second;
+      if(keys[i] != 0)
+        cache->SetReflection(keys[i], r.refl, r.mapping, r.patchData);
+    }
+  }
+
+  // the per-capture details aren't cached
+  for(size_t i = 0; i < pending.size(); i++)
+  {
+    const SPVModule &spv = m_CreationInfo.m_ShaderModule[pending[i].first].spirv;
+    Reflection &r = *pending[i].second;
+
+    r.refl.resourceId = GetResourceManager()->GetOriginalID(pending[i].first);
+    r.refl.entryPoint = r.entryPoint;
+
+    if(!spv.spirv.empty())
+    {
+      r.refl.encoding = ShaderEncoding::SPIRV;
+      r.refl.rawBytes.assign((byte *)spv.spirv.data(), spv.spirv.size() * sizeof(uint32_t));
+    }
+  }
+}
+
 // Shader functions
 template <typename SerialiserType>
 bool WrappedVulkan::Serialise_vkCreatePipelineLayout(SerialiserType &ser, VkDevice device,
@@ -412,78 +710,28 @@ bool WrappedVulkan::Serialise_vkCreateGraphicsPipelines(
 
   if(IsReplayingAndReading())
   {
-    VkPipeline pipe = VK_NULL_HANDLE;
-
-    VkRenderPass origRP = CreateInfo.renderPass;
-    VkPipelineCache origCache = pipelineCache;
-
-    // don't use pipeline caches on replay
-    pipelineCache = VK_NULL_HANDLE;
-
-    VkGraphicsPipelineCreateInfo *unwrapped = UnwrapInfos(&CreateInfo, 1);
-    VkResult ret = ObjDisp(device)->CreateGraphicsPipelines(Unwrap(device), Unwrap(pipelineCache),
-                                                            1, unwrapped, NULL, &pipe);
-
-    if(ret != VK_SUCCESS)
+    PendingPipeline pending;
+    pending.Pipeline = Pipeline;
+    pending.device = device;
+    pending.origCache = pipelineCache;
+    pending.origRP = CreateInfo.renderPass;
+    pending.subpass0RP =
+        m_CreationInfo.m_RenderPass[GetResID(CreateInfo.renderPass)].loadRPs[CreateInfo.subpass];
+
+    // take ownership of the deserialised data, it's freed when the pipeline is finished
+    pending.graphicsInfo = CreateInfo;
+    CreateInfo = VkGraphicsPipelineCreateInfo();
+
+    if(DeferPipelineCreation())
     {
-      RDCERR("Failed on resource serialise-creation, VkResult: %s", ToStr(ret).c_str());
-      return false;
+      m_PendingPipelines.push_back(pending);
+      return true;
     }
-    else
-    {
-      ResourceId live;
-
-      if(GetResourceManager()->HasWrapper(ToTypedHandle(pipe)))
-      {
-        live = GetResourceManager()->GetNonDispWrapper(pipe)->id;
-
-        // destroy this instance of the duplicate, as we must have matching create/destroy
-        // calls and there won't be a wrapped resource hanging around to destroy this one.
-        ObjDisp(device)->DestroyPipeline(Unwrap(device), pipe, NULL);
 
-        // whenever the new ID is requested, return the old ID, via replacements.
-        GetResourceManager()->ReplaceResource(Pipeline, GetResourceManager()->GetOriginalID(live));
-      }
-      else
-      {
-        live = GetResourceManager()->WrapResource(Unwrap(device), pipe);
-        GetResourceManager()->AddLiveResource(Pipeline, pipe);
-
-        VulkanCreationInfo::Pipeline &pipeInfo = m_CreationInfo.m_Pipeline[live];
-
-        pipeInfo.Init(GetResourceManager(), m_CreationInfo, &CreateInfo);
-
-        ResourceId renderPassID = GetResID(CreateInfo.renderPass);
-
-        CreateInfo.renderPass = m_CreationInfo.m_RenderPass[renderPassID].loadRPs[CreateInfo.subpass];
-        CreateInfo.subpass = 0;
-
-        unwrapped = UnwrapInfos(&CreateInfo, 1);
-        ret = ObjDisp(device)->CreateGraphicsPipelines(Unwrap(device), Unwrap(pipelineCache), 1,
-                                                       unwrapped, NULL, &pipeInfo.subpass0pipe);
-        RDCASSERTEQUAL(ret, VK_SUCCESS);
-
-        ResourceId subpass0id =
-            GetResourceManager()->WrapResource(Unwrap(device), pipeInfo.subpass0pipe);
-
-        // register as a live-only resource, so it is cleaned up properly
-        GetResourceManager()->AddLiveResource(subpass0id, pipeInfo.subpass0pipe);
-      }
-    }
-
-    AddResource(Pipeline, ResourceType::PipelineState, "Graphics Pipeline");
-    DerivedResource(device, Pipeline);
-    if(origCache != VK_NULL_HANDLE)
-      DerivedResource(origCache, Pipeline);
-    if(CreateInfo.flags & VK_PIPELINE_CREATE_DERIVATIVE_BIT)
-    {
-      if(CreateInfo.basePipelineHandle != VK_NULL_HANDLE)
-        DerivedResource(CreateInfo.basePipelineHandle, Pipeline);
-    }
-    DerivedResource(origRP, Pipeline);
-    DerivedResource(CreateInfo.layout, Pipeline);
-    for(uint32_t i = 0; i < CreateInfo.stageCount; i++)
-      DerivedResource(CreateInfo.pStages[i].module, Pipeline);
+    CreatePendingPipeline(pending);
+    bool success = FinishPendingPipeline(pending);
+    FlushPendingReflections();
+    return success;
   }
 
   return true;
@@ -583,6 +831,11 @@ VkResult WrappedVulkan::vkCreateGraphicsPipelines(VkDevice device, VkPipelineCac
         m_CreationInfo.m_Pipeline[id].Init(GetResourceManager(), m_CreationInfo, &pCreateInfos[i]);
       }
     }
+
+    // pipelines created during replay, e.g. for edited shaders, need their reflection filled in
+    // straight away since there's no later point where it would be flushed.
+    if(!IsCaptureMode(m_State))
+      FlushPendingReflections();
   }
 
   return ret;
@@ -606,57 +859,26 @@ bool WrappedVulkan::Serialise_vkCreateComputePipelines(SerialiserType &ser, VkDe
 
   if(IsReplayingAndReading())
   {
-    VkPipeline pipe = VK_NULL_HANDLE;
+    PendingPipeline pending;
+    pending.Pipeline = Pipeline;
+    pending.device = device;
+    pending.origCache = pipelineCache;
+    pending.compute = true;
 
-    VkPipelineCache origCache = pipelineCache;
+    // take ownership of the deserialised data, it's freed when the pipeline is finished
+    pending.computeInfo = CreateInfo;
+    CreateInfo = VkComputePipelineCreateInfo();
 
-    // don't use pipeline caches on replay
-    pipelineCache = VK_NULL_HANDLE;
-
-    VkComputePipelineCreateInfo *unwrapped = UnwrapInfos(&CreateInfo, 1);
-    VkResult ret = ObjDisp(device)->CreateComputePipelines(Unwrap(device), Unwrap(pipelineCache), 1,
-                                                           unwrapped, NULL, &pipe);
-
-    if(ret != VK_SUCCESS)
+    if(DeferPipelineCreation())
     {
-      RDCERR("Failed on resource serialise-creation, VkResult: %s", ToStr(ret).c_str());
-      return false;
+      m_PendingPipelines.push_back(pending);
+      return true;
     }
-    else
-    {
-      ResourceId live;
-
-      if(GetResourceManager()->HasWrapper(ToTypedHandle(pipe)))
-      {
-        live = GetResourceManager()->GetNonDispWrapper(pipe)->id;
-
-        // destroy this instance of the duplicate, as we must have matching create/destroy
-        // calls and there won't be a wrapped resource hanging around to destroy this one.
-        ObjDisp(device)->DestroyPipeline(Unwrap(device), pipe, NULL);
 
-        // whenever the new ID is requested, return the old ID, via replacements.
-        GetResourceManager()->ReplaceResource(Pipeline, GetResourceManager()->GetOriginalID(live));
-      }
-      else
-      {
-        live = GetResourceManager()->WrapResource(Unwrap(device), pipe);
-        GetResourceManager()->AddLiveResource(Pipeline, pipe);
-
-        m_CreationInfo.m_Pipeline[live].Init(GetResourceManager(), m_CreationInfo, &CreateInfo);
-      }
-    }
-
-    AddResource(Pipeline, ResourceType::PipelineState, "Graphics Pipeline");
-    DerivedResource(device, Pipeline);
-    if(origCache != VK_NULL_HANDLE)
-      DerivedResource(origCache, Pipeline);
-    if(CreateInfo.flags & VK_PIPELINE_CREATE_DERIVATIVE_BIT)
-    {
-      if(CreateInfo.basePipelineHandle != VK_NULL_HANDLE)
-        DerivedResource(CreateInfo.basePipelineHandle, Pipeline);
-    }
-    DerivedResource(CreateInfo.layout, Pipeline);
-    DerivedResource(CreateInfo.stage.module, Pipeline);
+    CreatePendingPipeline(pending);
+    bool success = FinishPendingPipeline(pending);
+    FlushPendingReflections();
+    return success;
   }
 
   return true;
@@ -746,6 +968,11 @@ VkResult WrappedVulkan::vkCreateComputePipelines(VkDevice device, VkPipelineCach
         m_CreationInfo.m_Pipeline[id].Init(GetResourceManager(), m_CreationInfo, &pCreateInfos[i]);
       }
     }
+
+    // pipelines created during replay, e.g. for edited shaders, need their reflection filled in
+    // straight away since there's no later point where it would be flushed.
+    if(!IsCaptureMode(m_State))
+      FlushPendingReflections();
   }
 
   return ret;
@@ -804,8 +804,9 @@ bool WrappedVulkan::Serialise_vkCmdWaitEvents(
       else
         commandBuffer = VK_NULL_HANDLE;
 
-      // register to clean this event up once we're done replaying this section of the log
-      m_CleanupEvents.push_back(ev);
+      // register to clean this event up once we're done replaying this section of the log, or once
+      // the command buffer using it is evicted from the re-record cache
+      AddRerecordEvent(commandBuffer, ev);
     }
     else
     {
@@ -157,6 +157,18 @@ string Callstack::AddressDetails::formattedString(const char *commonPath)
   return fmt;
 }
 
+static volatile int64_t totalLockWait = 0;
+
+void Threading::RecordLockWait(uint64_t ticks)
+{
+  Atomic::ExchAdd64(&totalLockWait, int64_t(ticks));
+}
+
+uint64_t Threading::GetTotalLockWait()
+{
+  return (uint64_t)Atomic::ExchAdd64(&totalLockWait, 0);
+}
+
 string OSUtility::MakeMachineIdentString(uint64_t ident)
 {
   string ret = "";
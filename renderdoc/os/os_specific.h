@@ -57,6 +57,19 @@ const char *GetEnvVariable(const char *name);
 
 uint64_t GetMemoryUsage();
 
+// OS-assisted tracking of which pages in the process have been written to, so that callers can find
+// what changed in a range of memory without keeping a copy to compare against.
+//
+// Returns true if writes to all of [base, base+size) can be tracked.
+bool CanTrackPageWrites(void *base, size_t size);
+// Appends the ranges within [base, base+size) that have been written to since the last call to
+// ResetPageWrites(), as byte offsets relative to base. The ranges are page-granular, clamped to the
+// queried range.
+void GetWrittenPages(void *base, size_t size, rdcarray<rdcpair<size_t, size_t>> &ranges);
+// Resets the written state of every page in the process, not just a particular range. Any writes
+// not yet fetched with GetWrittenPages() for ranges of interest will be lost.
+void ResetPageWrites();
+
 bool CanGlobalHook();
 bool StartGlobalHook(const char *pathmatch, const char *capturefile, const CaptureOptions &opts);
 bool IsGlobalHookActive();
@@ -138,6 +151,11 @@ void Init();
 void Shutdown();
 uint64_t AllocateTLSSlot();
 
+// accumulated time in ticks (see Timing::GetTickFrequency) that threads have spent blocked waiting
+// on a contended lock
+void RecordLockWait(uint64_t ticks);
+uint64_t GetTotalLockWait();
+
 void *GetTLSValue(uint64_t slot);
 void SetTLSValue(uint64_t slot, void *value);
 
@@ -307,6 +325,12 @@ void fseek64(FILE *f, uint64_t offset, int origin);
 
 void ftruncateat(FILE *f, uint64_t length);
 
+// read or write at an absolute offset, bypassing the FILE's buffering and without moving its
+// position. Calls on different ranges of the same file can be made from several threads at once,
+// but they shouldn't be mixed with the buffered functions above on the same FILE.
+bool freadat(void *buf, size_t size, uint64_t offset, FILE *f);
+bool fwriteat(const void *buf, size_t size, uint64_t offset, FILE *f);
+
 bool fflush(FILE *f);
 
 bool feof(FILE *f);
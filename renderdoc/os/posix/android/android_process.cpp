@@ -178,4 +178,17 @@ uint64_t Process::GetMemoryUsage()
     return vmPages * (uint64_t)sysconf(_SC_PAGESIZE);
 
   return 0;
+}
+
+bool Process::CanTrackPageWrites(void *base, size_t size)
+{
+  return false;
+}
+
+void Process::GetWrittenPages(void *base, size_t size, rdcarray<rdcpair<size_t, size_t>> &ranges)
+{
+}
+
+void Process::ResetPageWrites()
+{
 }
\ No newline at end of file
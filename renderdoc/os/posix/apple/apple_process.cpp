@@ -182,4 +182,17 @@ uint64_t Process::GetMemoryUsage()
     return 0;
 
   return taskInfo.resident_size;
+}
+
+bool Process::CanTrackPageWrites(void *base, size_t size)
+{
+  return false;
+}
+
+void Process::GetWrittenPages(void *base, size_t size, rdcarray<rdcpair<size_t, size_t>> &ranges)
+{
+}
+
+void Process::ResetPageWrites()
+{
 }
\ No newline at end of file
@@ -22,6 +22,8 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <algorithm>
 #include "os/os_specific.h"
@@ -195,4 +197,181 @@ uint64_t Process::GetMemoryUsage()
     return vmPages * (uint64_t)sysconf(_SC_PAGESIZE);
 
   return 0;
+}
+
+// we track page writes with the kernel's soft-dirty bits. Writing 4 to clear_refs clears the bit on
+// every page in the process and write-protects them, so the next write to each page faults and sets
+// it again. The bits are read from pagemap, bit 55 of each page's entry.
+static const uint64_t pagemapSoftDirtyBit = 1ULL << 55;
+
+static bool ClearSoftDirty()
+{
+  int fd = open("/proc/self/clear_refs", O_WRONLY);
+  if(fd < 0)
+    return false;
+
+  bool ret = write(fd, "4", 1) == 1;
+  close(fd);
+  return ret;
+}
+
+static bool ReadPagemap(uintptr_t firstPage, size_t numPages, uint64_t *entries)
+{
+  int fd = open("/proc/self/pagemap", O_RDONLY);
+  if(fd < 0)
+    return false;
+
+  size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+  off_t offs = off_t(firstPage / pageSize) * sizeof(uint64_t);
+  size_t bytes = numPages * sizeof(uint64_t);
+
+  bool ret = pread(fd, entries, bytes, offs) == (ssize_t)bytes;
+  close(fd);
+  return ret;
+}
+
+static bool SoftDirtySupported()
+{
+  // checked once. The static is initialised under the compiler's guard, so threads that ask at the
+  // same time all wait for the one check.
+  static const bool supported = []() {
+    // the kernel may not be built with soft-dirty support, in which case clearing succeeds but the
+    // bits are never set. Check on a page of our own that they're cleared and set as expected.
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    void *mem = mmap(NULL, pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if(mem == MAP_FAILED)
+      return false;
+
+    volatile byte *page = (volatile byte *)mem;
+
+    page[0] = 1;
+
+    bool ret = false;
+
+    uint64_t clean = 0, dirty = 0;
+    if(ClearSoftDirty() && ReadPagemap((uintptr_t)mem, 1, &clean))
+    {
+      page[0] = 2;
+
+      if(ReadPagemap((uintptr_t)mem, 1, &dirty))
+        ret = (clean & pagemapSoftDirtyBit) == 0 && (dirty & pagemapSoftDirtyBit) != 0;
+    }
+
+    munmap(mem, pageSize);
+
+    if(!ret)
+      RDCLOG("Soft-dirty page tracking is not available");
+
+    return ret;
+  }();
+
+  return supported;
+}
+
+bool Process::CanTrackPageWrites(void *base, size_t size)
+{
+  if(!SoftDirtySupported())
+    return false;
+
+  // soft-dirty bits aren't tracked for raw PFN or IO mappings, which is what some drivers give us
+  // for device memory. Check that the range is entirely covered by mappings without those flags.
+  FILE *f = FileIO::fopen("/proc/self/smaps", "r");
+
+  if(f == NULL)
+  {
+    RDCWARN("Couldn't open /proc/self/smaps");
+    return false;
+  }
+
+  uintptr_t start = (uintptr_t)base;
+  uintptr_t end = start + size;
+
+  // how far we've verified, and whether the current mapping overlaps the range
+  uintptr_t covered = start;
+  bool overlapping = false;
+  bool ret = true;
+
+  char line[512] = {};
+  while(ret && fgets(line, 511, f))
+  {
+    unsigned long long vmaStart = 0, vmaEnd = 0;
+    char c = 0;
+
+    // mapping headers start with the address range, other lines start with a field name
+    if(sscanf(line, "%llx-%llx %c", &vmaStart, &vmaEnd, &c) == 3)
+    {
+      // once we've passed the end of the range there's nothing more to check
+      if(covered >= end)
+        break;
+
+      overlapping = vmaStart < end && vmaEnd > covered;
+
+      if(overlapping)
+      {
+        // a gap before this mapping means part of the range isn't mapped
+        if(vmaStart > covered)
+          ret = false;
+        else
+          covered = (uintptr_t)vmaEnd;
+      }
+    }
+    else if(overlapping && strncmp(line, "VmFlags:", 8) == 0)
+    {
+      if(strstr(line, " pf") || strstr(line, " io"))
+        ret = false;
+    }
+  }
+
+  FileIO::fclose(f);
+
+  return ret && covered >= end;
+}
+
+void Process::GetWrittenPages(void *base, size_t size, rdcarray<rdcpair<size_t, size_t>> &ranges)
+{
+  if(size == 0)
+    return;
+
+  size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+
+  uintptr_t start = (uintptr_t)base;
+  uintptr_t end = start + size;
+  uintptr_t firstPage = start & ~uintptr_t(pageSize - 1);
+  size_t numPages = (end - firstPage + pageSize - 1) / pageSize;
+
+  uint64_t *entries = new uint64_t[numPages];
+
+  if(!ReadPagemap(firstPage, numPages, entries))
+  {
+    // if we can't read the bits, conservatively report everything as written
+    RDCERR("Couldn't read /proc/self/pagemap");
+    ranges.push_back(make_rdcpair<size_t, size_t>(0, size));
+    SAFE_DELETE_ARRAY(entries);
+    return;
+  }
+
+  for(size_t p = 0; p < numPages; p++)
+  {
+    if((entries[p] & pagemapSoftDirtyBit) == 0)
+      continue;
+
+    uintptr_t pageStart = RDCMAX(firstPage + p * pageSize, start);
+    uintptr_t pageEnd = RDCMIN(firstPage + (p + 1) * pageSize, end);
+
+    rdcpair<size_t, size_t> range = make_rdcpair<size_t, size_t>(pageStart - start, pageEnd - start);
+
+    if(!ranges.empty() && ranges.back().second == range.first)
+      ranges.back().second = range.second;
+    else
+      ranges.push_back(range);
+  }
+
+  SAFE_DELETE_ARRAY(entries);
+}
+
+void Process::ResetPageWrites()
+{
+  if(!ClearSoftDirty())
+    RDCERR("Couldn't clear soft-dirty bits");
 }
\ No newline at end of file
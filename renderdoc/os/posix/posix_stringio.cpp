@@ -455,6 +455,52 @@ void ftruncateat(FILE *f, uint64_t length)
   ::ftruncate(fd, (off_t)length);
 }
 
+bool freadat(void *buf, size_t size, uint64_t offset, FILE *f)
+{
+  int fd = ::fileno(f);
+  char *dst = (char *)buf;
+
+  while(size > 0)
+  {
+    ssize_t ret = ::pread(fd, dst, size, (off_t)offset);
+
+    if(ret < 0 && errno == EINTR)
+      continue;
+
+    if(ret <= 0)
+      return false;
+
+    dst += ret;
+    size -= (size_t)ret;
+    offset += (uint64_t)ret;
+  }
+
+  return true;
+}
+
+bool fwriteat(const void *buf, size_t size, uint64_t offset, FILE *f)
+{
+  int fd = ::fileno(f);
+  const char *src = (const char *)buf;
+
+  while(size > 0)
+  {
+    ssize_t ret = ::pwrite(fd, src, size, (off_t)offset);
+
+    if(ret < 0 && errno == EINTR)
+      continue;
+
+    if(ret <= 0)
+      return false;
+
+    src += ret;
+    size -= (size_t)ret;
+    offset += (uint64_t)ret;
+  }
+
+  return true;
+}
+
 bool fflush(FILE *f)
 {
   return ::fflush(f) == 0;
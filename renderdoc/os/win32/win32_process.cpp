@@ -209,6 +209,19 @@ uint64_t Process::GetMemoryUsage()
   return ret;
 }
 
+bool Process::CanTrackPageWrites(void *base, size_t size)
+{
+  return false;
+}
+
+void Process::GetWrittenPages(void *base, size_t size, rdcarray<rdcpair<size_t, size_t>> &ranges)
+{
+}
+
+void Process::ResetPageWrites()
+{
+}
+
 // helpers for various shims and dlls etc, not part of the public API
 extern "C" __declspec(dllexport) void __cdecl INTERNAL_GetTargetControlIdent(uint32_t *ident)
 {
@@ -653,6 +653,57 @@ void ftruncateat(FILE *f, uint64_t length)
   ::_chsize_s(fd, (int64_t)length);
 }
 
+bool freadat(void *buf, size_t size, uint64_t offset, FILE *f)
+{
+  HANDLE h = (HANDLE)::_get_osfhandle(::_fileno(f));
+  char *dst = (char *)buf;
+
+  while(size > 0)
+  {
+    // an explicit offset in the OVERLAPPED reads from there, even on a synchronous handle
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = DWORD(offset & 0xffffffff);
+    overlapped.OffsetHigh = DWORD(offset >> 32);
+
+    DWORD toRead = (DWORD)RDCMIN(size, (size_t)0x40000000);
+    DWORD numRead = 0;
+
+    if(!::ReadFile(h, dst, toRead, &numRead, &overlapped) || numRead == 0)
+      return false;
+
+    dst += numRead;
+    size -= numRead;
+    offset += numRead;
+  }
+
+  return true;
+}
+
+bool fwriteat(const void *buf, size_t size, uint64_t offset, FILE *f)
+{
+  HANDLE h = (HANDLE)::_get_osfhandle(::_fileno(f));
+  const char *src = (const char *)buf;
+
+  while(size > 0)
+  {
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = DWORD(offset & 0xffffffff);
+    overlapped.OffsetHigh = DWORD(offset >> 32);
+
+    DWORD toWrite = (DWORD)RDCMIN(size, (size_t)0x40000000);
+    DWORD numWritten = 0;
+
+    if(!::WriteFile(h, src, toWrite, &numWritten, &overlapped) || numWritten == 0)
+      return false;
+
+    src += numWritten;
+    size -= numWritten;
+    offset += numWritten;
+  }
+
+  return true;
+}
+
 bool fflush(FILE *f)
 {
   return ::fflush(f) == 0;
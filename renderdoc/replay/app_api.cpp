@@ -74,11 +74,16 @@ static const char *GetCaptureFilePathTemplate()
 
 static uint32_t GetNumCaptures()
 {
+  // captures are written in the background, make sure any the application has ended are listed
+  RenderDoc::Inst().FlushCaptureWriting();
+
   return (uint32_t)RenderDoc::Inst().GetCaptures().size();
 }
 
 static uint32_t GetCapture(uint32_t idx, char *filename, uint32_t *pathlength, uint64_t *timestamp)
 {
+  RenderDoc::Inst().FlushCaptureWriting();
+
   vector<CaptureData> caps = RenderDoc::Inst().GetCaptures();
 
   if(idx >= (uint32_t)caps.size())
@@ -106,6 +111,9 @@ static uint32_t GetCapture(uint32_t idx, char *filename, uint32_t *pathlength, u
 
 static void SetCaptureFileComments(const char *filePath, const char *comments)
 {
+  // the capture must be completely written before we can modify it
+  RenderDoc::Inst().FlushCaptureWriting();
+
   std::string path;
   if(filePath == NULL || filePath[0] == 0)
   {
@@ -244,22 +252,22 @@ int RENDERDOC_CC SetCaptureOptionF32(RENDERDOC_CaptureOption opt, float val);
 uint32_t RENDERDOC_CC GetCaptureOptionU32(RENDERDOC_CaptureOption opt);
 float RENDERDOC_CC GetCaptureOptionF32(RENDERDOC_CaptureOption opt);
 
-void RENDERDOC_CC GetAPIVersion_1_4_0(int *major, int *minor, int *patch)
+void RENDERDOC_CC GetAPIVersion_1_5_0(int *major, int *minor, int *patch)
 {
   if(major)
     *major = 1;
   if(minor)
-    *minor = 4;
+    *minor = 5;
   if(patch)
     *patch = 0;
 }
 
-RENDERDOC_API_1_4_0 api_1_4_0;
-void Init_1_4_0()
+RENDERDOC_API_1_5_0 api_1_5_0;
+void Init_1_5_0()
 {
-  RENDERDOC_API_1_4_0 &api = api_1_4_0;
+  RENDERDOC_API_1_5_0 &api = api_1_5_0;
 
-  api.GetAPIVersion = &GetAPIVersion_1_4_0;
+  api.GetAPIVersion = &GetAPIVersion_1_5_0;
 
   api.SetCaptureOptionU32 = &SetCaptureOptionU32;
   api.SetCaptureOptionF32 = &SetCaptureOptionF32;
@@ -324,15 +332,16 @@ extern "C" RENDERDOC_API int RENDERDOC_CC RENDERDOC_GetAPI(RENDERDOC_Version ver
     ret = 1;                                                       \
   }
 
-  API_VERSION_HANDLE(1_0_0, 1_4_0);
-  API_VERSION_HANDLE(1_0_1, 1_4_0);
-  API_VERSION_HANDLE(1_0_2, 1_4_0);
-  API_VERSION_HANDLE(1_1_0, 1_4_0);
-  API_VERSION_HANDLE(1_1_1, 1_4_0);
-  API_VERSION_HANDLE(1_1_2, 1_4_0);
-  API_VERSION_HANDLE(1_2_0, 1_4_0);
-  API_VERSION_HANDLE(1_3_0, 1_4_0);
-  API_VERSION_HANDLE(1_4_0, 1_4_0);
+  API_VERSION_HANDLE(1_0_0, 1_5_0);
+  API_VERSION_HANDLE(1_0_1, 1_5_0);
+  API_VERSION_HANDLE(1_0_2, 1_5_0);
+  API_VERSION_HANDLE(1_1_0, 1_5_0);
+  API_VERSION_HANDLE(1_1_1, 1_5_0);
+  API_VERSION_HANDLE(1_1_2, 1_5_0);
+  API_VERSION_HANDLE(1_2_0, 1_5_0);
+  API_VERSION_HANDLE(1_3_0, 1_5_0);
+  API_VERSION_HANDLE(1_4_0, 1_5_0);
+  API_VERSION_HANDLE(1_5_0, 1_5_0);
 
 #undef API_VERSION_HANDLE
 
@@ -50,6 +50,8 @@ int RENDERDOC_CC SetCaptureOptionU32(RENDERDOC_CaptureOption opt, uint32_t val)
       break;
     case eRENDERDOC_Option_CaptureAllCmdLists: opts.captureAllCmdLists = (val != 0); break;
     case eRENDERDOC_Option_DebugOutputMute: opts.debugOutputMute = (val != 0); break;
+    case eRENDERDOC_Option_HashMappedMemory: opts.hashMappedMemory = (val != 0); break;
+    case eRENDERDOC_Option_CaptureMemoryBudgetMB: opts.captureMemoryBudgetMB = val; break;
     case eRENDERDOC_Option_AllowUnsupportedVendorExtensions:
       if(val == 0x10DE)
         RenderDoc::Inst().EnableVendorExtensions(VendorExtensions::NvAPI);
@@ -85,6 +87,10 @@ int RENDERDOC_CC SetCaptureOptionF32(RENDERDOC_CaptureOption opt, float val)
       break;
     case eRENDERDOC_Option_CaptureAllCmdLists: opts.captureAllCmdLists = (val != 0.0f); break;
     case eRENDERDOC_Option_DebugOutputMute: opts.debugOutputMute = (val != 0.0f); break;
+    case eRENDERDOC_Option_HashMappedMemory: opts.hashMappedMemory = (val != 0.0f); break;
+    case eRENDERDOC_Option_CaptureMemoryBudgetMB:
+      opts.captureMemoryBudgetMB = (uint32_t)val;
+      break;
     case eRENDERDOC_Option_AllowUnsupportedVendorExtensions:
       RDCWARN("AllowUnsupportedVendorExtensions unexpected parameter %f", val);
       break;
@@ -124,6 +130,10 @@ uint32_t RENDERDOC_CC GetCaptureOptionU32(RENDERDOC_CaptureOption opt)
       return (RenderDoc::Inst().GetCaptureOptions().captureAllCmdLists ? 1 : 0);
     case eRENDERDOC_Option_DebugOutputMute:
       return (RenderDoc::Inst().GetCaptureOptions().debugOutputMute ? 1 : 0);
+    case eRENDERDOC_Option_HashMappedMemory:
+      return (RenderDoc::Inst().GetCaptureOptions().hashMappedMemory ? 1 : 0);
+    case eRENDERDOC_Option_CaptureMemoryBudgetMB:
+      return (RenderDoc::Inst().GetCaptureOptions().captureMemoryBudgetMB);
     case eRENDERDOC_Option_AllowUnsupportedVendorExtensions: return 0;
     default: break;
   }
@@ -161,6 +171,10 @@ float RENDERDOC_CC GetCaptureOptionF32(RENDERDOC_CaptureOption opt)
       return (RenderDoc::Inst().GetCaptureOptions().captureAllCmdLists ? 1.0f : 0.0f);
     case eRENDERDOC_Option_DebugOutputMute:
       return (RenderDoc::Inst().GetCaptureOptions().debugOutputMute ? 1.0f : 0.0f);
+    case eRENDERDOC_Option_HashMappedMemory:
+      return (RenderDoc::Inst().GetCaptureOptions().hashMappedMemory ? 1.0f : 0.0f);
+    case eRENDERDOC_Option_CaptureMemoryBudgetMB:
+      return (RenderDoc::Inst().GetCaptureOptions().captureMemoryBudgetMB * 1.0f);
     case eRENDERDOC_Option_AllowUnsupportedVendorExtensions: return 0.0f;
     default: break;
   }
@@ -182,4 +196,6 @@ CaptureOptions::CaptureOptions()
   refAllResources = false;
   captureAllCmdLists = false;
   debugOutputMute = true;
+  hashMappedMemory = false;
+  captureMemoryBudgetMB = 0;
 }
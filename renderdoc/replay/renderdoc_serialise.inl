@@ -86,6 +86,30 @@ void DoSerialise(SerialiserType &ser, SectionProperties &el)
   SIZE_CHECK(56);
 }
 
+template <class SerialiserType>
+void DoSerialise(SerialiserType &ser, ChunkOverheadStats &el)
+{
+  SERIALISE_MEMBER(chunkID);
+  SERIALISE_MEMBER(name);
+  SERIALISE_MEMBER(count);
+  SERIALISE_MEMBER(byteSize);
+  SERIALISE_MEMBER(serialiseMicroseconds);
+
+  SIZE_CHECK(56);
+}
+
+template <class SerialiserType>
+void DoSerialise(SerialiserType &ser, CaptureOverheadData &el)
+{
+  SERIALISE_MEMBER(frameCount);
+  SERIALISE_MEMBER(chunkMemory);
+  SERIALISE_MEMBER(liveChunks);
+  SERIALISE_MEMBER(lockWaitMicroseconds);
+  SERIALISE_MEMBER(chunks);
+
+  SIZE_CHECK(56);
+}
+
 template <class SerialiserType>
 void DoSerialise(SerialiserType &ser, EnvironmentModification &el)
 {
@@ -111,8 +135,10 @@ void DoSerialise(SerialiserType &ser, CaptureOptions &el)
   SERIALISE_MEMBER(refAllResources);
   SERIALISE_MEMBER(captureAllCmdLists);
   SERIALISE_MEMBER(debugOutputMute);
+  SERIALISE_MEMBER(hashMappedMemory);
+  SERIALISE_MEMBER(captureMemoryBudgetMB);
 
-  SIZE_CHECK(20);
+  SIZE_CHECK(24);
 }
 
 template <typename SerialiserType>
@@ -2184,6 +2210,8 @@ void DoSerialise(SerialiserType &ser, VKPipe::State &el)
 INSTANTIATE_SERIALISE_TYPE(ExecuteResult)
 INSTANTIATE_SERIALISE_TYPE(PathEntry)
 INSTANTIATE_SERIALISE_TYPE(SectionProperties)
+INSTANTIATE_SERIALISE_TYPE(ChunkOverheadStats)
+INSTANTIATE_SERIALISE_TYPE(CaptureOverheadData)
 INSTANTIATE_SERIALISE_TYPE(EnvironmentModification)
 INSTANTIATE_SERIALISE_TYPE(CaptureOptions)
 INSTANTIATE_SERIALISE_TYPE(ResourceFormat)
@@ -24,6 +24,7 @@
  ******************************************************************************/
 
 #include "replay_controller.h"
+#include <algorithm>
 #include <string.h>
 #include <time.h>
 #include "common/dds_readwrite.h"
@@ -628,6 +629,70 @@ MeshFormat ReplayController::GetPostVSData(uint32_t instID, uint32_t viewID, Mes
   return m_pDevice->GetPostVSBuffers(draw->eventId, instID, viewID, stage);
 }
 
+rdcarray<MeshFormat> ReplayController::GetPostVSDataForEvents(const rdcarray<uint32_t> &eventIds,
+                                                              uint32_t instID, uint32_t viewID,
+                                                              MeshDataStage stage)
+{
+  CHECK_REPLAY_THREAD();
+
+  rdcarray<MeshFormat> ret;
+  ret.resize(eventIds.size());
+
+  std::vector<uint32_t> draws;
+  draws.reserve(eventIds.size());
+
+  for(uint32_t eid : eventIds)
+  {
+    DrawcallDescription *draw = GetDrawcallByEID(eid);
+
+    if(draw && (draw->flags & DrawFlags::Drawcall))
+      draws.push_back(eid);
+  }
+
+  std::sort(draws.begin(), draws.end());
+  draws.erase(std::unique(draws.begin(), draws.end()), draws.end());
+
+  // the drivers can fetch all of the draws in a pass with one replay, and carry on replaying
+  // forward from one pass to the next. Each run of draws in a pass starts with the beginning of
+  // the pass, the same as when the whole pass is displayed in the mesh viewer.
+  std::vector<uint32_t> batch;
+  uint32_t curPass = 0;
+
+  for(uint32_t eid : draws)
+  {
+    std::vector<uint32_t> passEvents = m_pDevice->GetPassEvents(eid);
+
+    uint32_t pass = passEvents.empty() ? 0 : passEvents.front();
+
+    if(pass != 0 && pass != curPass)
+      batch.push_back(pass);
+
+    curPass = pass;
+
+    batch.push_back(eid);
+  }
+
+  if(!batch.empty())
+    m_pDevice->InitPostVSBuffers(batch);
+
+  // the fetches replayed around the frame, so get back to the current event
+  if(!draws.empty())
+    SetFrameEvent(m_EventID, true);
+
+  for(size_t i = 0; i < eventIds.size(); i++)
+  {
+    DrawcallDescription *draw = GetDrawcallByEID(eventIds[i]);
+
+    if(draw == NULL || !(draw->flags & DrawFlags::Drawcall))
+      continue;
+
+    ret[i] = m_pDevice->GetPostVSBuffers(draw->eventId, RDCMIN(instID, draw->numInstances - 1),
+                                         viewID, stage);
+  }
+
+  return ret;
+}
+
 bytebuf ReplayController::GetBufferData(ResourceId buff, uint64_t offset, uint64_t len)
 {
   CHECK_REPLAY_THREAD();
@@ -669,6 +734,45 @@ bytebuf ReplayController::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint
   return ret;
 }
 
+rdcarray<bytebuf> ReplayController::GetTextureDataBatch(const rdcarray<ResourceId> &textures,
+                                                        uint32_t arrayIdx, uint32_t mip)
+{
+  CHECK_REPLAY_THREAD();
+
+  rdcarray<bytebuf> ret;
+  ret.resize(textures.size());
+
+  std::vector<TextureDataRequest> requests;
+  std::vector<size_t> indices;
+
+  for(size_t i = 0; i < textures.size(); i++)
+  {
+    ResourceId liveId = m_pDevice->GetLiveID(textures[i]);
+
+    if(liveId == ResourceId())
+    {
+      RDCERR("Couldn't get Live ID for %llu getting texture data", textures[i]);
+      continue;
+    }
+
+    TextureDataRequest req;
+    req.tex = liveId;
+    req.arrayIdx = arrayIdx;
+    req.mip = mip;
+
+    requests.push_back(req);
+    indices.push_back(i);
+  }
+
+  std::vector<bytebuf> data;
+  m_pDevice->GetTextureDataBatch(requests, data);
+
+  for(size_t i = 0; i < indices.size() && i < data.size(); i++)
+    ret[indices[i]].swap(data[i]);
+
+  return ret;
+}
+
 bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path)
 {
   CHECK_REPLAY_THREAD();
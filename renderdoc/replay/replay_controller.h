@@ -107,6 +107,8 @@ private:
   float m_ContextY;
   OutputPair m_PixelContext;
 
+  MeshPickCache m_PickCache;
+
   uint32_t m_EventID;
   ReplayOutputType m_Type;
 
@@ -188,11 +190,15 @@ public:
   void FreeTrace(ShaderDebugTrace *trace);
 
   MeshFormat GetPostVSData(uint32_t instID, uint32_t viewID, MeshDataStage stage);
+  rdcarray<MeshFormat> GetPostVSDataForEvents(const rdcarray<uint32_t> &eventIds, uint32_t instID,
+                                              uint32_t viewID, MeshDataStage stage);
 
   rdcarray<EventUsage> GetUsage(ResourceId id);
 
   bytebuf GetBufferData(ResourceId buff, uint64_t offset, uint64_t len);
   bytebuf GetTextureData(ResourceId buff, uint32_t arrayIdx, uint32_t mip);
+  rdcarray<bytebuf> GetTextureDataBatch(const rdcarray<ResourceId> &textures, uint32_t arrayIdx,
+                                        uint32_t mip);
 
   bool SaveTexture(const TextureSave &saveData, const char *path);
 
@@ -23,7 +23,11 @@
  ******************************************************************************/
 
 #include "replay_driver.h"
+#include <float.h>
+#include <algorithm>
+#include "maths/camera.h"
 #include "maths/formatpacking.h"
+#include "maths/matrix.h"
 #include "serialise/serialiser.h"
 
 template <>
@@ -494,6 +498,28 @@ uint64_t CalcMeshOutputSize(uint64_t curSize, uint64_t requiredOutput)
   return curSize;
 }
 
+std::vector<std::vector<uint32_t>> SplitEventsByPass(IRemoteDriver *driver,
+                                                     const std::vector<uint32_t> &events)
+{
+  std::vector<std::vector<uint32_t>> passes;
+  uint32_t curPass = 0;
+
+  for(uint32_t eid : events)
+  {
+    // the beginning of a pass has no pass events of its own, so it starts a new run
+    std::vector<uint32_t> passEvents = driver->GetPassEvents(eid);
+    uint32_t pass = passEvents.empty() ? eid : passEvents.front();
+
+    if(passes.empty() || pass != curPass)
+      passes.push_back({});
+
+    passes.back().push_back(eid);
+    curPass = pass;
+  }
+
+  return passes;
+}
+
 FloatVector HighlightCache::InterpretVertex(const byte *data, uint32_t vert, const MeshDisplay &cfg,
                                             const byte *end, bool useidx, bool &valid)
 {
@@ -608,114 +634,122 @@ uint64_t inthash(ResourceId id, uint64_t seed)
   return (seed << 5) + seed + val; /* hash * 33 + c */
 }
 
-void HighlightCache::CacheHighlightingData(uint32_t eventId, const MeshDisplay &cfg)
+uint64_t HighlightCache::FetchIndices(IRemoteDriver *driver, const MeshDisplay &cfg, bool &idxData,
+                                     std::vector<uint32_t> &indices)
 {
-  std::string ident;
-
-  uint64_t newKey = 5381;
+  uint32_t bytesize = cfg.position.indexByteStride;
+  uint64_t maxIndex = cfg.position.numIndices - 1;
 
-  // hash all the properties of cfg that we use
-  newKey = inthash(eventId, newKey);
-  newKey = inthash(cfg.position.indexByteStride, newKey);
-  newKey = inthash(cfg.position.numIndices, newKey);
-  newKey = inthash((uint64_t)cfg.type, newKey);
-  newKey = inthash((uint64_t)cfg.position.baseVertex, newKey);
-  newKey = inthash((uint64_t)cfg.position.topology, newKey);
-  newKey = inthash(cfg.position.vertexByteOffset, newKey);
-  newKey = inthash(cfg.position.vertexByteStride, newKey);
-  newKey = inthash(cfg.position.indexResourceId, newKey);
-  newKey = inthash(cfg.position.vertexResourceId, newKey);
-
-  if(cacheKey != newKey)
+  if(cfg.position.indexByteStride == 0 || cfg.type == MeshDataStage::GSOut)
   {
-    cacheKey = newKey;
-
-    uint32_t bytesize = cfg.position.indexByteStride;
-    uint64_t maxIndex = cfg.position.numIndices - 1;
-
-    if(cfg.position.indexByteStride == 0 || cfg.type == MeshDataStage::GSOut)
-    {
-      indices.clear();
-      idxData = false;
-    }
-    else
-    {
-      idxData = true;
+    indices.clear();
+    idxData = false;
+  }
+  else
+  {
+    idxData = true;
 
-      bytebuf idxdata;
-      if(cfg.position.indexResourceId != ResourceId())
-        driver->GetBufferData(cfg.position.indexResourceId, cfg.position.indexByteOffset,
-                              cfg.position.numIndices * bytesize, idxdata);
+    bytebuf idxdata;
+    if(cfg.position.indexResourceId != ResourceId())
+      driver->GetBufferData(cfg.position.indexResourceId, cfg.position.indexByteOffset,
+                            cfg.position.numIndices * bytesize, idxdata);
 
-      uint8_t *idx8 = (uint8_t *)&idxdata[0];
-      uint16_t *idx16 = (uint16_t *)&idxdata[0];
-      uint32_t *idx32 = (uint32_t *)&idxdata[0];
+    uint8_t *idx8 = (uint8_t *)&idxdata[0];
+    uint16_t *idx16 = (uint16_t *)&idxdata[0];
+    uint32_t *idx32 = (uint32_t *)&idxdata[0];
 
-      uint32_t numIndices = RDCMIN(cfg.position.numIndices, uint32_t(idxdata.size() / bytesize));
+    uint32_t numIndices = RDCMIN(cfg.position.numIndices, uint32_t(idxdata.size() / bytesize));
 
-      indices.resize(numIndices);
+    indices.resize(numIndices);
 
-      if(bytesize == 1)
+    if(bytesize == 1)
+    {
+      for(uint32_t i = 0; i < numIndices; i++)
       {
-        for(uint32_t i = 0; i < numIndices; i++)
-        {
-          indices[i] = uint32_t(idx8[i]);
-          maxIndex = RDCMAX(maxIndex, (uint64_t)indices[i]);
-        }
+        indices[i] = uint32_t(idx8[i]);
+        maxIndex = RDCMAX(maxIndex, (uint64_t)indices[i]);
       }
-      else if(bytesize == 2)
+    }
+    else if(bytesize == 2)
+    {
+      for(uint32_t i = 0; i < numIndices; i++)
       {
-        for(uint32_t i = 0; i < numIndices; i++)
-        {
-          indices[i] = uint32_t(idx16[i]);
-          maxIndex = RDCMAX(maxIndex, (uint64_t)indices[i]);
-        }
+        indices[i] = uint32_t(idx16[i]);
+        maxIndex = RDCMAX(maxIndex, (uint64_t)indices[i]);
       }
-      else if(bytesize == 4)
+    }
+    else if(bytesize == 4)
+    {
+      for(uint32_t i = 0; i < numIndices; i++)
       {
-        for(uint32_t i = 0; i < numIndices; i++)
-        {
-          indices[i] = idx32[i];
-          maxIndex = RDCMAX(maxIndex, (uint64_t)indices[i]);
-        }
+        indices[i] = idx32[i];
+        maxIndex = RDCMAX(maxIndex, (uint64_t)indices[i]);
       }
+    }
 
-      uint32_t sub = uint32_t(-cfg.position.baseVertex);
-      uint32_t add = uint32_t(cfg.position.baseVertex);
+    uint32_t sub = uint32_t(-cfg.position.baseVertex);
+    uint32_t add = uint32_t(cfg.position.baseVertex);
 
-      if(cfg.position.baseVertex > 0)
-        maxIndex += add;
+    if(cfg.position.baseVertex > 0)
+      maxIndex += add;
 
-      uint32_t primRestart = 0;
-      if(IsStrip(cfg.position.topology))
+    uint32_t primRestart = 0;
+    if(IsStrip(cfg.position.topology))
+    {
+      if(cfg.position.indexByteStride == 1)
+        primRestart = 0xff;
+      else if(cfg.position.indexByteStride == 2)
+        primRestart = 0xffff;
+      else
+        primRestart = 0xffffffff;
+    }
+
+    for(uint32_t i = 0; cfg.position.baseVertex != 0 && i < numIndices; i++)
+    {
+      // don't modify primitive restart indices
+      if(primRestart && indices[i] == primRestart)
+        continue;
+
+      if(cfg.position.baseVertex < 0)
       {
-        if(cfg.position.indexByteStride == 1)
-          primRestart = 0xff;
-        else if(cfg.position.indexByteStride == 2)
-          primRestart = 0xffff;
+        if(indices[i] < sub)
+          indices[i] = 0;
         else
-          primRestart = 0xffffffff;
+          indices[i] -= sub;
       }
-
-      for(uint32_t i = 0; cfg.position.baseVertex != 0 && i < numIndices; i++)
+      else
       {
-        // don't modify primitive restart indices
-        if(primRestart && indices[i] == primRestart)
-          continue;
-
-        if(cfg.position.baseVertex < 0)
-        {
-          if(indices[i] < sub)
-            indices[i] = 0;
-          else
-            indices[i] -= sub;
-        }
-        else
-        {
-          indices[i] += add;
-        }
+        indices[i] += add;
       }
     }
+  }
+
+  return maxIndex;
+}
+
+void HighlightCache::CacheHighlightingData(uint32_t eventId, const MeshDisplay &cfg)
+{
+  std::string ident;
+
+  uint64_t newKey = 5381;
+
+  // hash all the properties of cfg that we use
+  newKey = inthash(eventId, newKey);
+  newKey = inthash(cfg.position.indexByteStride, newKey);
+  newKey = inthash(cfg.position.numIndices, newKey);
+  newKey = inthash((uint64_t)cfg.type, newKey);
+  newKey = inthash((uint64_t)cfg.position.baseVertex, newKey);
+  newKey = inthash((uint64_t)cfg.position.topology, newKey);
+  newKey = inthash(cfg.position.vertexByteOffset, newKey);
+  newKey = inthash(cfg.position.vertexByteStride, newKey);
+  newKey = inthash(cfg.position.indexResourceId, newKey);
+  newKey = inthash(cfg.position.vertexResourceId, newKey);
+
+  if(cacheKey != newKey)
+  {
+    cacheKey = newKey;
+
+    uint64_t maxIndex = FetchIndices(driver, cfg, idxData, indices);
 
     driver->GetBufferData(cfg.position.vertexResourceId, cfg.position.vertexByteOffset,
                           (maxIndex + 1) * cfg.position.vertexByteStride, vertexData);
@@ -1047,6 +1081,650 @@ bool HighlightCache::FetchHighlightPositions(const MeshDisplay &cfg, FloatVector
   return valid;
 }
 
+static float AxisComponent(const Vec3f &v, int axis)
+{
+  return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+static Vec3f MinVec(const Vec3f &a, const Vec3f &b)
+{
+  return Vec3f(RDCMIN(a.x, b.x), RDCMIN(a.y, b.y), RDCMIN(a.z, b.z));
+}
+
+static Vec3f MaxVec(const Vec3f &a, const Vec3f &b)
+{
+  return Vec3f(RDCMAX(a.x, b.x), RDCMAX(a.y, b.y), RDCMAX(a.z, b.z));
+}
+
+// matches TriangleRayIntersect in the mesh picking shaders, so CPU and GPU picking agree
+static bool TriangleRayIntersect(const Vec3f &A, const Vec3f &B, const Vec3f &C,
+                                 const Vec3f &rayPos, const Vec3f &rayDir, float &t)
+{
+  Vec3f v0v1 = B - A;
+  Vec3f v0v2 = C - A;
+  Vec3f pvec = rayDir.Cross(v0v2);
+  float det = v0v1.Dot(pvec);
+
+  // if the determinant is negative the triangle is backfacing, but we still take those!
+  // if the determinant is close to 0, the ray misses the triangle
+  if(fabsf(det) > 0.0f)
+  {
+    float invDet = 1.0f / det;
+
+    Vec3f tvec = rayPos - A;
+    Vec3f qvec = tvec.Cross(v0v1);
+    float u = tvec.Dot(pvec) * invDet;
+    float v = rayDir.Dot(qvec) * invDet;
+
+    if(u >= 0.0f && u <= 1.0f && v >= 0.0f && u + v <= 1.0f)
+    {
+      t = v0v2.Dot(qvec) * invDet;
+      return t > 0.0f;
+    }
+  }
+
+  return false;
+}
+
+// slab test, returning true if the ray enters the box somewhere between its origin and maxT
+static bool RayBoxIntersect(const Vec3f &boundsMin, const Vec3f &boundsMax, const Vec3f &rayPos,
+                            const Vec3f &rayDir, float maxT)
+{
+  float tmin = 0.0f;
+  float tmax = maxT;
+
+  for(int axis = 0; axis < 3; axis++)
+  {
+    float pos = AxisComponent(rayPos, axis);
+    float dir = AxisComponent(rayDir, axis);
+    float lo = AxisComponent(boundsMin, axis);
+    float hi = AxisComponent(boundsMax, axis);
+
+    // parallel to this pair of planes, so it's either always between them or never
+    if(dir == 0.0f)
+    {
+      if(pos < lo || pos > hi)
+        return false;
+      continue;
+    }
+
+    float t1 = (lo - pos) / dir;
+    float t2 = (hi - pos) / dir;
+
+    tmin = RDCMAX(tmin, RDCMIN(t1, t2));
+    tmax = RDCMIN(tmax, RDCMAX(t1, t2));
+
+    if(tmin > tmax)
+      return false;
+  }
+
+  return true;
+}
+
+void TriangleBVH::Clear()
+{
+  m_Triangles.clear();
+  m_Order.clear();
+  m_Nodes.clear();
+}
+
+uint64_t TriangleBVH::EstimateBytes(uint64_t numTriangles)
+{
+  // a binary tree with at least one triangle per leaf has fewer than two nodes per triangle
+  return numTriangles * (3 * sizeof(Vec3f) + sizeof(uint32_t) + 2 * sizeof(Node));
+}
+
+void TriangleBVH::Build(std::vector<Vec3f> &triangles)
+{
+  // small enough that testing every triangle in a leaf is cheaper than descending further
+  const uint32_t LeafSize = 4;
+
+  Clear();
+
+  m_Triangles.swap(triangles);
+
+  const uint32_t numTris = uint32_t(m_Triangles.size() / 3);
+
+  if(numTris == 0)
+    return;
+
+  std::vector<Vec3f> centroids(numTris);
+  m_Order.resize(numTris);
+
+  for(uint32_t t = 0; t < numTris; t++)
+  {
+    const Vec3f *v = &m_Triangles[t * 3];
+    centroids[t] = (v[0] + v[1] + v[2]) * (1.0f / 3.0f);
+    m_Order[t] = t;
+  }
+
+  m_Nodes.reserve(numTris / 2 + 1);
+
+  Node root;
+  root.first = 0;
+  root.count = numTris;
+  m_Nodes.push_back(root);
+
+  std::vector<uint32_t> pending;
+  pending.push_back(0);
+
+  while(!pending.empty())
+  {
+    uint32_t n = pending.back();
+    pending.pop_back();
+
+    const uint32_t first = m_Nodes[n].first;
+    const uint32_t count = m_Nodes[n].count;
+
+    Vec3f boundsMin(FLT_MAX, FLT_MAX, FLT_MAX), boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    Vec3f centroidMin = boundsMin, centroidMax = boundsMax;
+
+    for(uint32_t i = first; i < first + count; i++)
+    {
+      const uint32_t t = m_Order[i];
+
+      for(uint32_t c = 0; c < 3; c++)
+      {
+        boundsMin = MinVec(boundsMin, m_Triangles[t * 3 + c]);
+        boundsMax = MaxVec(boundsMax, m_Triangles[t * 3 + c]);
+      }
+
+      centroidMin = MinVec(centroidMin, centroids[t]);
+      centroidMax = MaxVec(centroidMax, centroids[t]);
+    }
+
+    m_Nodes[n].boundsMin = boundsMin;
+    m_Nodes[n].boundsMax = boundsMax;
+
+    if(count <= LeafSize)
+      continue;
+
+    // split at the median along the longest axis of the centroids. If they all coincide there's
+    // nothing to gain from splitting, so leave this as a leaf.
+    Vec3f extent = centroidMax - centroidMin;
+
+    int axis = 2;
+    if(extent.x >= extent.y && extent.x >= extent.z)
+      axis = 0;
+    else if(extent.y >= extent.z)
+      axis = 1;
+
+    if(AxisComponent(extent, axis) <= 0.0f)
+      continue;
+
+    const uint32_t mid = count / 2;
+
+    std::nth_element(m_Order.begin() + first, m_Order.begin() + first + mid,
+                     m_Order.begin() + first + count, [&centroids, axis](uint32_t a, uint32_t b) {
+                       return AxisComponent(centroids[a], axis) < AxisComponent(centroids[b], axis);
+                     });
+
+    Node left, right;
+    left.first = first;
+    left.count = mid;
+    right.first = first + mid;
+    right.count = count - mid;
+
+    m_Nodes[n].first = (uint32_t)m_Nodes.size();
+    m_Nodes[n].count = 0;
+
+    m_Nodes.push_back(left);
+    m_Nodes.push_back(right);
+
+    pending.push_back(m_Nodes[n].first);
+    pending.push_back(m_Nodes[n].first + 1);
+  }
+}
+
+uint32_t TriangleBVH::Intersect(const Vec3f &rayPos, const Vec3f &rayDir, Vec3f &hitPosition) const
+{
+  uint32_t ret = ~0U;
+  float closest = FLT_MAX;
+
+  if(m_Nodes.empty())
+    return ret;
+
+  std::vector<uint32_t> pending;
+  pending.push_back(0);
+
+  while(!pending.empty())
+  {
+    const Node &node = m_Nodes[pending.back()];
+    pending.pop_back();
+
+    if(!RayBoxIntersect(node.boundsMin, node.boundsMax, rayPos, rayDir, closest))
+      continue;
+
+    if(node.count == 0)
+    {
+      pending.push_back(node.first);
+      pending.push_back(node.first + 1);
+      continue;
+    }
+
+    for(uint32_t i = node.first; i < node.first + node.count; i++)
+    {
+      const uint32_t t = m_Order[i];
+
+      float dist = 0.0f;
+      if(TriangleRayIntersect(m_Triangles[t * 3 + 0], m_Triangles[t * 3 + 1],
+                              m_Triangles[t * 3 + 2], rayPos, rayDir, dist) &&
+         dist < closest)
+      {
+        closest = dist;
+        ret = t;
+      }
+    }
+  }
+
+  if(ret != ~0U)
+    hitPosition = rayPos + rayDir * closest;
+
+  return ret;
+}
+
+// the memory used for CPU picking is capped, counting both the data fetched and what the cache
+// expands it to. Beyond this we leave it to the GPU
+static const uint64_t MaxMeshPickCacheBytes = 256 * 1024 * 1024;
+
+// how long the cache is kept once nothing is being picked, in milliseconds
+static const double MeshPickCacheIdleTime = 10000.0;
+
+static bool IsTriangleTopology(Topology topo)
+{
+  return topo == Topology::TriangleList || topo == Topology::TriangleStrip ||
+         topo == Topology::TriangleFan || topo == Topology::TriangleList_Adj ||
+         topo == Topology::TriangleStrip_Adj;
+}
+
+static uint32_t PositionByteSize(const ResourceFormat &fmt)
+{
+  if(fmt.type == ResourceFormatType::R10G10B10A2 || fmt.type == ResourceFormatType::R11G11B10)
+    return 4;
+
+  return fmt.compCount * fmt.compByteWidth;
+}
+
+void MeshPickCache::Clear()
+{
+  cacheKey = 0;
+  idxData = false;
+  maxIndex = 0;
+  std::vector<uint32_t>().swap(indices);
+  instances.clear();
+}
+
+void MeshPickCache::ClearIfIdle()
+{
+  if(cacheKey != 0 && lastUse.GetMilliseconds() > MeshPickCacheIdleTime)
+    Clear();
+}
+
+uint64_t MeshPickCache::EstimateInstanceBytes(const MeshDisplay &cfg) const
+{
+  uint64_t ret = (maxIndex + 1) * sizeof(FloatVector);
+
+  if(IsTriangleTopology(cfg.position.topology))
+  {
+    const uint64_t numVerts = idxData ? indices.size() : cfg.position.numIndices;
+
+    // every topology has at most one triangle per vertex
+    ret += numVerts * 3 * sizeof(uint32_t) + TriangleBVH::EstimateBytes(numVerts);
+  }
+
+  return ret;
+}
+
+void MeshPickCache::FetchInstances(const MeshDisplay &cfg,
+                                   const std::vector<uint64_t> &instanceOffsets)
+{
+  std::vector<uint64_t> missing;
+  for(uint64_t offs : instanceOffsets)
+    if(instances.find(offs) == instances.end())
+      missing.push_back(offs);
+
+  if(missing.empty())
+    return;
+
+  std::sort(missing.begin(), missing.end());
+  missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+
+  const uint64_t instanceSize =
+      (maxIndex + 1) * RDCMAX(cfg.position.vertexByteStride, PositionByteSize(cfg.position.format));
+
+  // instances are normally packed together in the same buffer, so fetch them all at once
+  bytebuf data;
+  driver->GetBufferData(cfg.position.vertexResourceId, missing.front(),
+                        missing.back() + instanceSize - missing.front(), data);
+
+  const byte *dataEnd = data.data() + data.size();
+
+  for(uint64_t offs : missing)
+  {
+    InstanceData &inst = instances[offs];
+
+    const uint64_t rel = offs - missing.front();
+
+    if(rel < data.size())
+    {
+      inst.positions.reserve(size_t(maxIndex + 1));
+
+      for(uint64_t v = 0; v <= maxIndex; v++)
+      {
+        bool valid = true;
+        FloatVector pos =
+            HighlightCache::InterpretVertex(data.data() + rel, uint32_t(v),
+                                            cfg.position.vertexByteStride, cfg.position.format,
+                                            dataEnd, valid);
+
+        if(!valid)
+          break;
+
+        if(flipY && cfg.position.unproject)
+          pos.y = -pos.y;
+
+        inst.positions.push_back(pos);
+      }
+    }
+
+    if(IsTriangleTopology(cfg.position.topology))
+      BuildTriangles(cfg, inst);
+  }
+}
+
+void MeshPickCache::BuildTriangles(const MeshDisplay &cfg, InstanceData &inst)
+{
+  const uint32_t numVerts = idxData ? (uint32_t)indices.size() : cfg.position.numIndices;
+
+  uint32_t primRestart = 0;
+  if(idxData && IsStrip(cfg.position.topology))
+  {
+    if(cfg.position.indexByteStride == 1)
+      primRestart = 0xff;
+    else if(cfg.position.indexByteStride == 2)
+      primRestart = 0xffff;
+    else
+      primRestart = 0xffffffff;
+  }
+
+  std::vector<Vec3f> triangles;
+
+  auto addTriangle = [&](uint32_t v0, uint32_t v1, uint32_t v2) {
+    const uint32_t verts[3] = {v0, v1, v2};
+    Vec3f pos[3];
+
+    for(int c = 0; c < 3; c++)
+    {
+      if(verts[c] >= numVerts)
+        return;
+
+      uint32_t idx = idxData ? indices[verts[c]] : verts[c];
+
+      if((primRestart && idx == primRestart) || idx >= inst.positions.size())
+        return;
+
+      const FloatVector &p = inst.positions[idx];
+      if(cfg.position.unproject)
+        pos[c] = Vec3f(p.x / p.w, p.y / p.w, p.z / p.w);
+      else
+        pos[c] = Vec3f(p.x, p.y, p.z);
+    }
+
+    for(int c = 0; c < 3; c++)
+    {
+      triangles.push_back(pos[c]);
+      inst.triVerts.push_back(verts[c]);
+    }
+  };
+
+  // same primitive assembly as the mesh picking shaders
+  switch(cfg.position.topology)
+  {
+    case Topology::TriangleList:
+      for(uint32_t v = 0; v + 2 < numVerts; v += 3)
+        addTriangle(v, v + 1, v + 2);
+      break;
+    case Topology::TriangleStrip:
+      for(uint32_t v = 0; v + 2 < numVerts; v++)
+        addTriangle(v, v + 1, v + 2);
+      break;
+    case Topology::TriangleFan:
+      for(uint32_t v = 0; v + 2 < numVerts; v++)
+        addTriangle(0, v + 1, v + 2);
+      break;
+    case Topology::TriangleList_Adj:
+      for(uint32_t v = 0; v + 4 < numVerts; v += 6)
+        addTriangle(v, v + 2, v + 4);
+      break;
+    case Topology::TriangleStrip_Adj:
+      for(uint32_t v = 0; v + 4 < numVerts; v += 2)
+        addTriangle(v, v + 2, v + 4);
+      break;
+    default: break;
+  }
+
+  inst.bvh.Build(triangles);
+}
+
+bool MeshPickCache::PickVertex(uint32_t eventId, int32_t width, int32_t height,
+                               const MeshDisplay &cfg, const std::vector<uint64_t> &instanceOffsets,
+                               uint32_t x, uint32_t y, uint32_t &vert, uint32_t &instance)
+{
+  vert = ~0U;
+  instance = 0;
+
+  if(driver == NULL || cfg.position.vertexResourceId == ResourceId() ||
+     cfg.position.numIndices == 0 || instanceOffsets.empty() || width <= 0 || height <= 0)
+    return false;
+
+  uint64_t newKey = 5381;
+
+  // hash all the properties of cfg that we use, except the offset which identifies the instance
+  newKey = inthash(eventId, newKey);
+  newKey = inthash(cfg.position.indexByteStride, newKey);
+  newKey = inthash(cfg.position.indexByteOffset, newKey);
+  newKey = inthash(cfg.position.numIndices, newKey);
+  newKey = inthash((uint64_t)cfg.type, newKey);
+  newKey = inthash((uint64_t)cfg.position.baseVertex, newKey);
+  newKey = inthash((uint64_t)cfg.position.topology, newKey);
+  newKey = inthash(cfg.position.vertexByteStride, newKey);
+  newKey = inthash((uint64_t)cfg.position.format.type, newKey);
+  newKey = inthash((uint64_t)cfg.position.format.compType, newKey);
+  newKey = inthash(cfg.position.format.compCount, newKey);
+  newKey = inthash(cfg.position.format.compByteWidth, newKey);
+  newKey = inthash(cfg.position.unproject ? 1 : 0, newKey);
+  newKey = inthash(cfg.position.indexResourceId, newKey);
+  newKey = inthash(cfg.position.vertexResourceId, newKey);
+
+  if(cacheKey != newKey)
+  {
+    Clear();
+
+    cacheKey = newKey;
+
+    maxIndex = HighlightCache::FetchIndices(driver, cfg, idxData, indices);
+  }
+
+  lastUse.Restart();
+
+  const uint64_t instanceSize =
+      (maxIndex + 1) * RDCMAX(cfg.position.vertexByteStride, PositionByteSize(cfg.position.format));
+
+  uint64_t numMissing = 0;
+  for(uint64_t offs : instanceOffsets)
+    if(instances.find(offs) == instances.end())
+      numMissing++;
+
+  // the fetched data is only alive while the missing instances are unpacked, but the unpacked
+  // positions and BVHs stay in the cache
+  const uint64_t instanceBytes = EstimateInstanceBytes(cfg);
+
+  if((instances.size() + numMissing) * instanceBytes + numMissing * instanceSize >
+     MaxMeshPickCacheBytes)
+    return false;
+
+  FetchInstances(cfg, instanceOffsets);
+
+  Matrix4f projMat = Matrix4f::Perspective(90.0f, 0.1f, 100000.0f, float(width) / float(height));
+
+  Matrix4f camMat = cfg.cam ? ((Camera *)cfg.cam)->GetMatrix() : Matrix4f::Identity();
+  Matrix4f pickMVP = projMat.Mul(camMat);
+
+  Matrix4f pickMVPProj;
+  if(cfg.position.unproject)
+  {
+    // the derivation of the projection matrix might not be right (hell, it could be an
+    // orthographic projection). But it'll be close enough likely.
+    Matrix4f guessProj =
+        cfg.position.farPlane != FLT_MAX
+            ? Matrix4f::Perspective(cfg.fov, cfg.position.nearPlane, cfg.position.farPlane,
+                                    cfg.aspect)
+            : Matrix4f::ReversePerspective(cfg.fov, cfg.position.nearPlane, cfg.aspect);
+
+    if(cfg.ortho)
+      guessProj = Matrix4f::Orthographic(cfg.position.nearPlane, cfg.position.farPlane);
+
+    pickMVPProj = projMat.Mul(camMat.Mul(guessProj.Inverse()));
+  }
+
+  Vec3f rayPos;
+  Vec3f rayDir;
+  // convert mouse pos to world space ray
+  {
+    Matrix4f inversePickMVP = pickMVP.Inverse();
+
+    float pickX = ((float)x) / ((float)width);
+    float pickXCanonical = RDCLERP(-1.0f, 1.0f, pickX);
+
+    float pickY = ((float)y) / ((float)height);
+    // flip the Y axis
+    float pickYCanonical = RDCLERP(1.0f, -1.0f, pickY);
+
+    Vec3f cameraToWorldNearPosition =
+        inversePickMVP.Transform(Vec3f(pickXCanonical, pickYCanonical, -1), 1);
+
+    Vec3f cameraToWorldFarPosition =
+        inversePickMVP.Transform(Vec3f(pickXCanonical, pickYCanonical, 1), 1);
+
+    Vec3f testDir = (cameraToWorldFarPosition - cameraToWorldNearPosition);
+    testDir.Normalise();
+
+    // see the drivers' PickVertex for why the ray direction is calculated this way
+    if(cfg.position.unproject)
+    {
+      Matrix4f inversePickMVPGuess = pickMVPProj.Inverse();
+
+      Vec3f nearPosProj =
+          inversePickMVPGuess.Transform(Vec3f(pickXCanonical, pickYCanonical, -1), 1);
+
+      Vec3f farPosProj = inversePickMVPGuess.Transform(Vec3f(pickXCanonical, pickYCanonical, 1), 1);
+
+      rayDir = (farPosProj - nearPosProj);
+      rayDir.Normalise();
+
+      if(testDir.z < 0)
+      {
+        rayDir = -rayDir;
+      }
+      rayPos = nearPosProj;
+    }
+    else
+    {
+      rayDir = testDir;
+      rayPos = cameraToWorldNearPosition;
+    }
+  }
+
+  const Matrix4f &mvp = cfg.position.unproject ? pickMVPProj : pickMVP;
+
+  const uint32_t numVerts = idxData ? (uint32_t)indices.size() : cfg.position.numIndices;
+
+  for(size_t i = 0; i < instanceOffsets.size(); i++)
+  {
+    auto it = instances.find(instanceOffsets[i]);
+    if(it == instances.end())
+      continue;
+
+    const InstanceData &inst = it->second;
+
+    if(IsTriangleTopology(cfg.position.topology))
+    {
+      Vec3f hitPosition;
+      uint32_t tri = inst.bvh.Intersect(rayPos, rayDir, hitPosition);
+
+      if(tri != ~0U)
+      {
+        // return the vertex that was closest to the triangle/ray intersection point
+        float dist[3];
+        for(uint32_t c = 0; c < 3; c++)
+        {
+          uint32_t v = inst.triVerts[tri * 3 + c];
+          const FloatVector &p = inst.positions[idxData ? indices[v] : v];
+          dist[c] = (Vec3f(p.x / p.w, p.y / p.w, p.z / p.w) - hitPosition).Length();
+        }
+
+        vert = inst.triVerts[tri * 3 + 0];
+        if(dist[1] < dist[0] && dist[1] < dist[2])
+          vert = inst.triVerts[tri * 3 + 1];
+        else if(dist[2] < dist[0] && dist[2] < dist[1])
+          vert = inst.triVerts[tri * 3 + 2];
+      }
+    }
+    else
+    {
+      float closestLen = FLT_MAX;
+      float closestDepth = FLT_MAX;
+
+      for(uint32_t v = 0; v < numVerts; v++)
+      {
+        uint32_t idx = idxData ? indices[v] : v;
+
+        if(idx >= inst.positions.size())
+          continue;
+
+        const FloatVector &p = inst.positions[idx];
+
+        // mvp * pos without the perspective divide that Matrix4f::Transform does
+        Vec4f wpos(mvp[0] * p.x + mvp[4] * p.y + mvp[8] * p.z + mvp[12] * p.w,
+                   mvp[1] * p.x + mvp[5] * p.y + mvp[9] * p.z + mvp[13] * p.w,
+                   mvp[2] * p.x + mvp[6] * p.y + mvp[10] * p.z + mvp[14] * p.w,
+                   mvp[3] * p.x + mvp[7] * p.y + mvp[11] * p.z + mvp[15] * p.w);
+
+        if(cfg.position.unproject)
+        {
+          wpos.x /= wpos.w;
+          wpos.y /= wpos.w;
+          wpos.z /= wpos.w;
+        }
+
+        float scrX = (wpos.x + 1.0f) * 0.5f * float(width);
+        float scrY = (1.0f - wpos.y) * 0.5f * float(height);
+
+        float dx = scrX - float(x);
+        float dy = scrY - float(y);
+        float len = sqrtf(dx * dx + dy * dy);
+
+        // close to target co-ords? take it if it's the closest, then the nearest. Ties go to the
+        // lowest vertex, as vertices are visited in order
+        if(len < 35.0f && (len < closestLen || (len == closestLen && wpos.z < closestDepth)))
+        {
+          closestLen = len;
+          closestDepth = wpos.z;
+          vert = v;
+        }
+      }
+    }
+
+    if(vert != ~0U)
+    {
+      instance = uint32_t(i);
+      return true;
+    }
+  }
+
+  return true;
+}
+
 // colour ramp from http://www.ncl.ucar.edu/Document/Graphics/ColorTables/GMT_wysiwyg.shtml
 const Vec4f colorRamp[22] = {
     Vec4f(0.000000f, 0.000000f, 0.000000f, 0.0f), Vec4f(0.250980f, 0.000000f, 0.250980f, 1.0f),
@@ -1061,3 +1739,94 @@ const Vec4f colorRamp[22] = {
     Vec4f(1.000000f, 0.376471f, 0.752941f, 1.0f), Vec4f(1.000000f, 0.627451f, 1.000000f, 1.0f),
     Vec4f(1.000000f, 0.878431f, 1.000000f, 1.0f), Vec4f(1.000000f, 1.000000f, 1.000000f, 1.0f),
 };
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Check TriangleBVH matches brute force ray intersection", "[meshpick]")
+{
+  // a bumpy grid of quads, with a second grid partly behind it
+  std::vector<Vec3f> triangles;
+  for(int layer = 0; layer < 2; layer++)
+  {
+    for(int gy = 0; gy < 20; gy++)
+    {
+      for(int gx = 0; gx < 20; gx++)
+      {
+        float z = float(layer * 5) + float((gx * 7 + gy * 3) % 5) * 0.1f;
+        float off = float(layer) * 0.5f;
+        Vec3f a(gx + off, gy + off, z), b(gx + 1 + off, gy + off, z + 0.2f);
+        Vec3f c(gx + off, gy + 1 + off, z - 0.1f), d(gx + 1 + off, gy + 1 + off, z + 0.3f);
+
+        triangles.push_back(a);
+        triangles.push_back(b);
+        triangles.push_back(c);
+        triangles.push_back(c);
+        triangles.push_back(b);
+        triangles.push_back(d);
+      }
+    }
+  }
+
+  const std::vector<Vec3f> reference = triangles;
+
+  TriangleBVH bvh;
+  bvh.Build(triangles);
+
+  CHECK(triangles.empty());
+
+  uint32_t hits = 0;
+  uint32_t seed = 12345;
+  auto rand01 = [&seed]() {
+    seed = seed * 1103515245U + 12345U;
+    return float((seed >> 8) & 0xffff) / 65535.0f;
+  };
+
+  for(int i = 0; i < 500; i++)
+  {
+    Vec3f rayPos(rand01() * 24.0f - 2.0f, rand01() * 24.0f - 2.0f, -10.0f);
+    Vec3f rayDir(rand01() - 0.5f, rand01() - 0.5f, 2.0f);
+    rayDir.Normalise();
+
+    // rays straight down the z axis exercise the parallel case of the box test
+    if(i % 5 == 0)
+      rayDir = Vec3f(0.0f, 0.0f, 1.0f);
+
+    uint32_t expected = ~0U;
+    float closest = FLT_MAX;
+    for(uint32_t t = 0; t < reference.size() / 3; t++)
+    {
+      float dist = 0.0f;
+      if(TriangleRayIntersect(reference[t * 3 + 0], reference[t * 3 + 1], reference[t * 3 + 2],
+                              rayPos, rayDir, dist) &&
+         dist < closest)
+      {
+        closest = dist;
+        expected = t;
+      }
+    }
+
+    Vec3f hitPosition;
+    uint32_t tri = bvh.Intersect(rayPos, rayDir, hitPosition);
+
+    CHECK(tri == expected);
+
+    if(expected != ~0U)
+    {
+      hits++;
+      CHECK((hitPosition - (rayPos + rayDir * closest)).Length() < 1.0e-4f);
+    }
+  }
+
+  // make sure the test actually exercised both hits and misses
+  CHECK(hits > 100);
+  CHECK(hits < 500);
+
+  bvh.Clear();
+
+  Vec3f hitPosition;
+  CHECK(bvh.Intersect(Vec3f(0.0f, 0.0f, -1.0f), Vec3f(0.0f, 0.0f, 1.0f), hitPosition) == ~0U);
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
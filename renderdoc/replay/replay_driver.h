@@ -71,6 +71,14 @@ struct GetTextureDataParams
 
 DECLARE_REFLECTION_STRUCT(GetTextureDataParams);
 
+struct TextureDataRequest
+{
+  ResourceId tex;
+  uint32_t arrayIdx = 0;
+  uint32_t mip = 0;
+  GetTextureDataParams params;
+};
+
 class RDCFile;
 
 class AMDRGPControl;
@@ -126,6 +134,8 @@ public:
   virtual vector<uint32_t> GetPassEvents(uint32_t eventId) = 0;
 
   virtual void InitPostVSBuffers(uint32_t eventId) = 0;
+  // the events are in increasing order and can cover several passes, each run of events in a pass
+  // starting with the beginning of that pass as returned from GetPassEvents.
   virtual void InitPostVSBuffers(const vector<uint32_t> &passEvents) = 0;
 
   virtual ResourceId GetLiveID(ResourceId id) = 0;
@@ -136,6 +146,18 @@ public:
   virtual void GetBufferData(ResourceId buff, uint64_t offset, uint64_t len, bytebuf &retData) = 0;
   virtual void GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                               const GetTextureDataParams &params, bytebuf &data) = 0;
+  // fetches each texture in turn by default, drivers that can overlap readbacks override this
+  virtual void GetTextureDataBatch(const std::vector<TextureDataRequest> &requests,
+                                   std::vector<bytebuf> &data)
+  {
+    data.resize(requests.size());
+
+    for(size_t i = 0; i < requests.size(); i++)
+    {
+      const TextureDataRequest &req = requests[i];
+      GetTextureData(req.tex, req.arrayIdx, req.mip, req.params, data[i]);
+    }
+  }
 
   virtual void BuildTargetShader(ShaderEncoding sourceEncoding, bytebuf source, string entry,
                                  const ShaderCompileFlags &compileFlags, ShaderStage type,
@@ -238,6 +260,10 @@ void PatchLineStripIndexBuffer(const DrawcallDescription *draw, uint8_t *idx8, u
 
 uint64_t CalcMeshOutputSize(uint64_t curSize, uint64_t requiredOutput);
 
+// split a list of events passed to InitPostVSBuffers into the runs of events in each pass
+std::vector<std::vector<uint32_t>> SplitEventsByPass(IRemoteDriver *driver,
+                                                     const std::vector<uint32_t> &events);
+
 void StandardFillCBufferVariable(uint32_t dataOffset, const bytebuf &data, ShaderVariable &outvar,
                                  uint32_t matStride);
 void StandardFillCBufferVariables(const rdcarray<ShaderConstant> &invars,
@@ -259,6 +285,11 @@ struct HighlightCache
 
   void CacheHighlightingData(uint32_t eventId, const MeshDisplay &cfg);
 
+  // fetches the index data for cfg, with the base vertex applied, and returns the highest vertex
+  // index that may be referenced.
+  static uint64_t FetchIndices(IRemoteDriver *driver, const MeshDisplay &cfg, bool &idxData,
+                               std::vector<uint32_t> &indices);
+
   bool FetchHighlightPositions(const MeshDisplay &cfg, FloatVector &activeVertex,
                                vector<FloatVector> &activePrim,
                                vector<FloatVector> &adjacentPrimVertices,
@@ -271,4 +302,74 @@ struct HighlightCache
                               const byte *end, bool useidx, bool &valid);
 };
 
+// bounding volume hierarchy over a list of triangles, for picking against meshes on the CPU
+struct TriangleBVH
+{
+  // takes the positions, three per triangle, swapping them out of the passed-in vector
+  void Build(std::vector<Vec3f> &triangles);
+  void Clear();
+
+  // an upper bound on the memory used by a BVH over this many triangles
+  static uint64_t EstimateBytes(uint64_t numTriangles);
+
+  // returns the index of the closest triangle hit in front of the ray origin, or ~0U for no hit
+  uint32_t Intersect(const Vec3f &rayPos, const Vec3f &rayDir, Vec3f &hitPosition) const;
+
+private:
+  struct Node
+  {
+    Vec3f boundsMin, boundsMax;
+    // leaves contain count triangles starting at first in m_Order. Interior nodes have a count of
+    // 0, and their two children are at first and first + 1.
+    uint32_t first = 0;
+    uint32_t count = 0;
+  };
+
+  std::vector<Vec3f> m_Triangles;
+  std::vector<uint32_t> m_Order;
+  std::vector<Node> m_Nodes;
+};
+
+// caches the unpacked positions and a TriangleBVH for each instance of a mesh, so vertices can be
+// picked on the CPU instead of with a GPU dispatch and readback for every instance.
+struct MeshPickCache
+{
+  IRemoteDriver *driver = NULL;
+
+  // Vulkan's post-projection positions are flipped in Y compared to the other APIs
+  bool flipY = false;
+
+  // tests each instance in turn, identified by the byte offset of its position data, and returns
+  // the first hit. Returns false if the mesh couldn't be handled and the driver's PickVertex
+  // should be used instead.
+  bool PickVertex(uint32_t eventId, int32_t width, int32_t height, const MeshDisplay &cfg,
+                  const std::vector<uint64_t> &instanceOffsets, uint32_t x, uint32_t y,
+                  uint32_t &vert, uint32_t &instance);
+
+  void Clear();
+  // releases the cached data if nothing has been picked for a while
+  void ClearIfIdle();
+
+private:
+  struct InstanceData
+  {
+    // indexed by vertex, only as many as were available in the buffer
+    std::vector<FloatVector> positions;
+    // the three vertex ids (positions in the index stream) of each triangle in the BVH
+    std::vector<uint32_t> triVerts;
+    TriangleBVH bvh;
+  };
+
+  uint64_t cacheKey = 0;
+  bool idxData = false;
+  uint64_t maxIndex = 0;
+  std::vector<uint32_t> indices;
+  std::map<uint64_t, InstanceData> instances;
+  PerformanceTimer lastUse;
+
+  uint64_t EstimateInstanceBytes(const MeshDisplay &cfg) const;
+  void FetchInstances(const MeshDisplay &cfg, const std::vector<uint64_t> &instanceOffsets);
+  void BuildTriangles(const MeshDisplay &cfg, InstanceData &inst);
+};
+
 extern const Vec4f colorRamp[22];
\ No newline at end of file
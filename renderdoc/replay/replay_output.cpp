@@ -87,6 +87,9 @@ ReplayOutput::ReplayOutput(ReplayController *parent, WindowingData window, Repla
 
   m_pDevice = parent->GetDevice();
 
+  m_PickCache.driver = m_pDevice;
+  m_PickCache.flipY = parent->m_APIProps.pipelineType == GraphicsAPI::Vulkan;
+
   m_EventID = parent->m_EventID;
 
   m_OverlayResourceId = ResourceId();
@@ -137,6 +140,8 @@ ReplayOutput::~ReplayOutput()
   m_CustomShaderResourceId = ResourceId();
 
   ClearThumbnails();
+
+  m_PickCache.Clear();
 }
 
 void ReplayOutput::Shutdown()
@@ -186,6 +191,8 @@ void ReplayOutput::SetFrameEvent(int eventId)
   m_OverlayDirty = true;
   m_MainOutput.dirty = true;
 
+  m_PickCache.Clear();
+
   for(size_t i = 0; i < m_Thumbnails.size(); i++)
     m_Thumbnails[i].dirty = true;
 
@@ -489,15 +496,35 @@ rdcpair<uint32_t, uint32_t> ReplayOutput::PickVertex(uint32_t eventId, uint32_t
                                     m_RenderData.meshDisplay.curView, m_RenderData.meshDisplay.type);
     uint64_t elemOffset = cfg.position.vertexByteOffset - fmt.vertexByteOffset;
 
+    std::vector<uint64_t> instanceOffsets;
+
     for(uint32_t inst = firstInst; inst < maxInst; inst++)
     {
-      // find the start of this buffer, and apply the element offset, then pick in that instance
+      // find the start of this buffer, and apply the element offset
       fmt = m_pDevice->GetPostVSBuffers(draw->eventId, inst, m_RenderData.meshDisplay.curView,
                                         m_RenderData.meshDisplay.type);
       if(fmt.vertexResourceId != ResourceId())
         cfg.position.vertexByteOffset = fmt.vertexByteOffset + elemOffset;
 
-      uint32_t vert = m_pDevice->PickVertex(m_EventID, m_Width, m_Height, cfg, x, y);
+      instanceOffsets.push_back(cfg.position.vertexByteOffset);
+    }
+
+    // try to pick across all instances at once on the CPU
+    uint32_t vert = ~0U, inst = 0;
+    if(m_PickCache.PickVertex(m_EventID, m_Width, m_Height, cfg, instanceOffsets, x, y, vert, inst))
+    {
+      if(vert != ~0U)
+        return make_rdcpair(vert, firstInst + inst);
+
+      return errorReturn;
+    }
+
+    // otherwise pick in each instance in turn
+    for(inst = firstInst; inst < maxInst; inst++)
+    {
+      cfg.position.vertexByteOffset = instanceOffsets[inst - firstInst];
+
+      vert = m_pDevice->PickVertex(m_EventID, m_Width, m_Height, cfg, x, y);
       if(vert != ~0U)
       {
         return make_rdcpair(vert, inst);
@@ -508,8 +535,12 @@ rdcpair<uint32_t, uint32_t> ReplayOutput::PickVertex(uint32_t eventId, uint32_t
   }
   else
   {
-    return make_rdcpair(m_pDevice->PickVertex(m_EventID, m_Width, m_Height, cfg, x, y),
-                        m_RenderData.meshDisplay.curInstance);
+    uint32_t vert = ~0U, inst = 0;
+    if(!m_PickCache.PickVertex(m_EventID, m_Width, m_Height, cfg, {cfg.position.vertexByteOffset},
+                               x, y, vert, inst))
+      vert = m_pDevice->PickVertex(m_EventID, m_Width, m_Height, cfg, x, y);
+
+    return make_rdcpair(vert, m_RenderData.meshDisplay.curInstance);
   }
 }
 
@@ -614,6 +645,8 @@ void ReplayOutput::Display()
 {
   CHECK_REPLAY_THREAD();
 
+  m_PickCache.ClearIfIdle();
+
   if(m_pDevice->CheckResizeOutputWindow(m_MainOutput.outputID))
   {
     m_pDevice->GetOutputWindowDimensions(m_MainOutput.outputID, m_Width, m_Height);
@@ -82,6 +82,7 @@ public:
   // creates a new file with current properties, file will be overwritten if it already exists
   void Create(const char *filename);
 
+  const std::string &GetFilename() const { return m_Filename; }
   ContainerError ErrorCode() const { return m_Error; }
   std::string ErrorString() const { return m_ErrorString; }
   RDCDriver GetDriver() const { return m_Driver; }
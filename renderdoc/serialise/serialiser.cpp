@@ -29,12 +29,269 @@
 #include "core/core.h"
 #include "strings/string_utils.h"
 
-#if !defined(RELEASE)
-
 int64_t Chunk::m_LiveChunks = 0;
 int64_t Chunk::m_TotalMem = 0;
+int64_t Chunk::m_TotalSpilled = 0;
 
-#endif
+/////////////////////////////////////////////////////////////
+// Chunk spilling
+
+// chunks spilled to disk are appended to a single temporary file, and each chunk remembers its own
+// offset. Space isn't reclaimed as individual chunks are freed, but once no spilled chunks are left
+// the file is deleted.
+//
+// The lock covers the spill file's size and lifetime as well as every change to a chunk's m_Data
+// or m_Pinned, so a chunk can't be spilled while another thread is fetching or writing its data.
+// Once a chunk is pinned its data never moves again, so it can be read without the lock.
+//
+// File I/O isn't done under the lock, so a thread spilling or reading back a large chunk doesn't
+// block every other thread fetching chunk data. Space is reserved in the file under the lock, then
+// written or read with positional I/O. Each spilled chunk and each read or write in flight holds a
+// reference on the file, so it can't be closed and deleted under them.
+static Threading::CriticalSection &spillLock()
+{
+  static Threading::CriticalSection lock;
+  return lock;
+}
+
+static FILE *spillFile = NULL;
+static std::string spillFilename;
+static uint64_t spillFileSize = 0;
+static int64_t spillFileRefs = 0;
+
+// must be called with the spill lock held. Returns NULL if the file couldn't be opened
+static FILE *AcquireSpillFile()
+{
+  if(spillFile == NULL)
+  {
+    spillFilename =
+        StringFormat::Fmt("%srdoc_chunks_%u.tmp", FileIO::GetTempFolderFilename().c_str(),
+                          Process::GetCurrentPID());
+    spillFile = FileIO::fopen(spillFilename.c_str(), "w+b");
+    spillFileSize = 0;
+
+    if(spillFile == NULL)
+    {
+      RDCERR("Couldn't open chunk spill file '%s', keeping chunks in memory: %s",
+             spillFilename.c_str(), FileIO::ErrorString().c_str());
+      return NULL;
+    }
+  }
+
+  spillFileRefs++;
+
+  return spillFile;
+}
+
+static void ReleaseSpillFile()
+{
+  SCOPED_LOCK(spillLock());
+
+  spillFileRefs--;
+
+  if(spillFileRefs == 0 && spillFile)
+  {
+    FileIO::fclose(spillFile);
+    FileIO::Delete(spillFilename.c_str());
+    spillFile = NULL;
+    spillFileSize = 0;
+  }
+}
+
+void Chunk::SpillIfOverBudget()
+{
+  if(IsPinned() || m_Length == 0)
+    return;
+
+  uint64_t budget = uint64_t(RenderDoc::Inst().GetCaptureOptions().captureMemoryBudgetMB) << 20;
+  if(budget == 0 || uint64_t(m_TotalMem) <= budget)
+    return;
+
+  FILE *file = NULL;
+  uint64_t offset = 0;
+  byte *data = NULL;
+
+  {
+    SCOPED_LOCK(spillLock());
+
+    // check again now that we hold the lock, another thread may have pinned or spilled the chunk
+    if(IsPinned() || m_Data == NULL || m_SpillPending)
+      return;
+
+    file = AcquireSpillFile();
+
+    if(file == NULL)
+      return;
+
+    offset = spillFileSize;
+    spillFileSize += m_Length;
+
+    m_SpillPending = true;
+    data = m_Data;
+  }
+
+  // the data stays allocated while it's written - it's only freed below, or by the destructor which
+  // can't run while our caller holds a reference.
+  bool success = FileIO::fwriteat(data, m_Length, offset, file);
+
+  {
+    SCOPED_LOCK(spillLock());
+
+    m_SpillPending = false;
+
+    // if the chunk was pinned while we were writing, its data has been handed out and must stay in
+    // memory. The space we wrote is just left unused.
+    if(success && !IsPinned())
+    {
+      m_SpillOffset = offset;
+
+      FreeAlignedBuffer(m_Data);
+      m_Data = NULL;
+
+      Atomic::ExchAdd64(&m_TotalMem, -int64_t(m_Length));
+      Atomic::ExchAdd64(&m_TotalSpilled, int64_t(m_Length));
+
+      // the file reference now belongs to the spilled data
+      return;
+    }
+  }
+
+  if(!success)
+    RDCERR("Failed to write %u bytes to chunk spill file: %s", m_Length,
+           FileIO::ErrorString().c_str());
+
+  ReleaseSpillFile();
+}
+
+// must be called with the spill lock held, when m_Data is NULL. Once a chunk is spilled its offset
+// doesn't change - if it's read back it's pinned, and never spilled again.
+FILE *Chunk::AcquireSpilledData(uint64_t &offset)
+{
+  offset = m_SpillOffset;
+  return AcquireSpillFile();
+}
+
+byte *Chunk::PinData()
+{
+  FILE *file = NULL;
+  uint64_t offset = 0;
+
+  {
+    SCOPED_LOCK(spillLock());
+
+    if(m_Data != NULL || m_Length == 0)
+    {
+      Atomic::CmpExch32(&m_Pinned, 0, 1);
+      return m_Data;
+    }
+
+    file = AcquireSpilledData(offset);
+  }
+
+  byte *data = AllocAlignedBuffer(m_Length);
+
+  if(!FileIO::freadat(data, m_Length, offset, file))
+    RDCERR("Failed to read %u bytes back from chunk spill file", m_Length);
+
+  ReleaseSpillFile();
+
+  SCOPED_LOCK(spillLock());
+
+  // another thread may have read the data back while we were
+  if(m_Data != NULL)
+  {
+    FreeAlignedBuffer(data);
+  }
+  else
+  {
+    m_Data = data;
+    Atomic::ExchAdd64(&m_TotalMem, int64_t(m_Length));
+    ReleaseSpill();
+  }
+
+  Atomic::CmpExch32(&m_Pinned, 0, 1);
+
+  return m_Data;
+}
+
+void Chunk::WriteUnpinned(Serialiser<SerialiserMode::Writing> &ser)
+{
+  byte *data = NULL;
+  FILE *file = NULL;
+  uint64_t offset = 0;
+
+  {
+    SCOPED_LOCK(spillLock());
+
+    if(m_Data == NULL && m_Length > 0)
+    {
+      file = AcquireSpilledData(offset);
+    }
+    else
+    {
+      // pin the data so it can be written without holding the lock. Chunks are only written once
+      // the capture is being saved, so there's no more use in spilling it after this.
+      Atomic::CmpExch32(&m_Pinned, 0, 1);
+      data = m_Data;
+    }
+  }
+
+  if(file == NULL)
+  {
+    ser.GetWriter()->Write((const void *)data, (size_t)m_Length);
+    return;
+  }
+
+  // stream spilled data straight from the spill file without bringing it back into memory, in
+  // slices rather than loading the whole chunk
+  const uint32_t sliceSize = 1024 * 1024;
+  byte *slice = AllocAlignedBuffer(RDCMIN(sliceSize, m_Length));
+
+  for(uint32_t offs = 0; offs < m_Length; offs += sliceSize)
+  {
+    uint32_t len = RDCMIN(sliceSize, m_Length - offs);
+    if(!FileIO::freadat(slice, len, offset + offs, file))
+    {
+      RDCERR("Failed to read %u bytes back from chunk spill file", len);
+      memset(slice, 0, len);
+    }
+    ser.GetWriter()->Write(slice, len);
+  }
+
+  FreeAlignedBuffer(slice);
+
+  ReleaseSpillFile();
+}
+
+void Chunk::CopyData(byte *dst)
+{
+  FILE *file = NULL;
+  uint64_t offset = 0;
+
+  {
+    SCOPED_LOCK(spillLock());
+
+    if(m_Data)
+    {
+      memcpy(dst, m_Data, (size_t)m_Length);
+      return;
+    }
+
+    file = AcquireSpilledData(offset);
+  }
+
+  if(!FileIO::freadat(dst, m_Length, offset, file))
+    RDCERR("Failed to read %u bytes back from chunk spill file", m_Length);
+
+  ReleaseSpillFile();
+}
+
+void Chunk::ReleaseSpill()
+{
+  Atomic::ExchAdd64(&m_TotalSpilled, -int64_t(m_Length));
+
+  ReleaseSpillFile();
+}
 
 /////////////////////////////////////////////////////////////
 // Read Serialiser functions
@@ -266,6 +523,14 @@ uint32_t Serialiser<SerialiserMode::Writing>::BeginChunk(uint32_t chunkID, uint3
     // chunk index needs to be valid
     RDCASSERT(chunkID > 0);
 
+    // serialisers recording call durations are those a driver uses to record API calls while
+    // capturing, so we track the overhead of those chunks.
+    if(m_ChunkFlags & ChunkDuration)
+    {
+      m_ChunkStartOffset = m_Write->GetOffset();
+      m_ChunkStartTick = Timing::GetTick();
+    }
+
     {
       uint32_t c = chunkID & ChunkIndexMask;
       RDCASSERT(chunkID <= ChunkIndexMask);
@@ -414,6 +679,11 @@ void Serialiser<SerialiserMode::Writing>::EndChunk()
   // align to the natural chunk alignment
   m_Write->AlignTo<ChunkAlignment>();
 
+  if(m_ChunkFlags & ChunkDuration)
+    RenderDoc::Inst().AddChunkOverhead(m_ChunkDriver, m_ChunkMetadata.chunkID,
+                                       m_Write->GetOffset() - m_ChunkStartOffset,
+                                       Timing::GetTick() - m_ChunkStartTick);
+
   m_ChunkMetadata = SDChunkMetaData();
 
   m_Write->Flush();
@@ -53,6 +53,8 @@ void Deserialise(const T &el)
 
 typedef std::string (*ChunkLookup)(uint32_t chunkType);
 
+enum class RDCDriver;
+
 enum class SerialiserFlags
 {
   NoFlags = 0x0,
@@ -114,6 +116,8 @@ public:
   StreamReader *GetReader() { return m_Read; }
   uint32_t GetChunkMetadataRecording() { return m_ChunkFlags; }
   void SetChunkMetadataRecording(uint32_t flags);
+  // the driver whose chunk IDs this serialiser writes, so that capture overhead can be named
+  void SetChunkDriver(RDCDriver driver) { m_ChunkDriver = driver; }
 
   SDChunkMetaData &ChunkMetadata() { return m_ChunkMetadata; }
   //////////////////////////////////////////
@@ -1595,6 +1599,11 @@ private:
   uint64_t m_LastChunkOffset = 0;
   uint64_t m_ChunkFixup = 0;
 
+  // only used for tracking capture overhead, see RenderDoc::AddChunkOverhead
+  uint64_t m_ChunkStartOffset = 0;
+  uint64_t m_ChunkStartTick = 0;
+  RDCDriver m_ChunkDriver = RDCDriver(0);
+
   bool m_ExportStructured = false;
   bool m_ExportBuffers = false;
   bool m_InternalElement = false;
@@ -1743,14 +1752,13 @@ class ScopedChunk;
 class Chunk
 {
 public:
-  ~Chunk()
+  // chunks can still be waiting to be written out by a capture on a background thread after the
+  // record that created them is done with them, so they're reference counted rather than deleted.
+  void AddRef() { Atomic::Inc32(&m_RefCount); }
+  void Release()
   {
-    FreeAlignedBuffer(m_Data);
-
-#if !defined(RELEASE)
-    Atomic::Dec64(&m_LiveChunks);
-    Atomic::ExchAdd64(&m_TotalMem, -int64_t(m_Length));
-#endif
+    if(Atomic::Dec32(&m_RefCount) == 0)
+      delete this;
   }
 
   template <typename ChunkType>
@@ -1758,13 +1766,12 @@ public:
   {
     return (ChunkType)m_ChunkType;
   }
-#if !defined(RELEASE)
+  uint32_t GetLength() const { return m_Length; }
+  // these are always tracked, as they're reported over target control as part of the capture
+  // overhead statistics
   static uint64_t NumLiveChunks() { return m_LiveChunks; }
   static uint64_t TotalMem() { return m_TotalMem; }
-#else
-  static uint64_t NumLiveChunks() { return 0; }
-  static uint64_t TotalMem() { return 0; }
-#endif
+  static uint64_t TotalSpilled() { return m_TotalSpilled; }
 
   // grab current contents of the serialiser into this chunk
   Chunk(Serialiser<SerialiserMode::Writing> &ser, uint32_t chunkType)
@@ -1781,13 +1788,17 @@ public:
 
     ser.GetWriter()->Rewind();
 
-#if !defined(RELEASE)
     Atomic::Inc64(&m_LiveChunks);
     Atomic::ExchAdd64(&m_TotalMem, int64_t(m_Length));
-#endif
   }
 
-  byte *GetData() const { return m_Data; }
+  // the returned pointer may be held onto, so once it's been fetched the chunk won't be spilled
+  byte *GetData()
+  {
+    if(IsPinned())
+      return m_Data;
+    return PinData();
+  }
   Chunk *Duplicate()
   {
     Chunk *ret = new Chunk();
@@ -1796,36 +1807,87 @@ public:
 
     ret->m_Data = AllocAlignedBuffer(m_Length);
 
-    memcpy(ret->m_Data, m_Data, (size_t)m_Length);
+    if(IsPinned())
+      memcpy(ret->m_Data, m_Data, (size_t)m_Length);
+    else
+      CopyData(ret->m_Data);
 
-#if !defined(RELEASE)
     Atomic::Inc64(&m_LiveChunks);
     Atomic::ExchAdd64(&m_TotalMem, int64_t(m_Length));
-#endif
 
     return ret;
   }
 
+  // returns a reference to hand to a capture being written in the background. Once a chunk's data
+  // has been handed out it can be written through that pointer (e.g. a buffer's backing store being
+  // updated on orphaning), so those chunks are copied rather than shared.
+  Chunk *Share()
+  {
+    if(IsPinned())
+      return Duplicate();
+
+    AddRef();
+    return this;
+  }
+
   void Write(Serialiser<SerialiserMode::Writing> &ser)
   {
-    ser.GetWriter()->Write((const void *)m_Data, (size_t)m_Length);
+    if(IsPinned())
+      ser.GetWriter()->Write((const void *)m_Data, (size_t)m_Length);
+    else
+      WriteUnpinned(ser);
   }
 
+  // if the memory held by all chunks is over the capture memory budget, move this chunk's data out
+  // to the on-disk spill file. It's read back in when the chunk is written or its data is needed.
+  // The budget is set in MB by the captureMemoryBudgetMB capture option, and spilling is disabled
+  // if it's 0.
+  void SpillIfOverBudget();
+
 private:
   Chunk() = default;
+  ~Chunk()
+  {
+    if(m_Data)
+    {
+      FreeAlignedBuffer(m_Data);
+      Atomic::ExchAdd64(&m_TotalMem, -int64_t(m_Length));
+    }
+    else if(m_Length > 0)
+    {
+      ReleaseSpill();
+    }
+
+    Atomic::Dec64(&m_LiveChunks);
+  }
   Chunk(const Chunk &) = delete;
   Chunk &operator=(const Chunk &) = delete;
 
   friend class ScopedChunk;
 
+  bool IsPinned() { return Atomic::CmpExch32(&m_Pinned, 1, 1) == 1; }
+  byte *PinData();
+  void WriteUnpinned(Serialiser<SerialiserMode::Writing> &ser);
+  void CopyData(byte *dst);
+  FILE *AcquireSpilledData(uint64_t &offset);
+  void ReleaseSpill();
+
   uint32_t m_ChunkType;
 
   uint32_t m_Length;
   byte *m_Data;
 
-#if !defined(RELEASE)
-  static int64_t m_LiveChunks, m_TotalMem;
-#endif
+  // offset in the spill file when m_Data is NULL
+  uint64_t m_SpillOffset = 0;
+  // set under the spill lock while the data is being written to the spill file
+  bool m_SpillPending = false;
+  // set once the data has been handed out and must stay in memory. Only changed under the spill
+  // lock, but read atomically so pinned chunks can be accessed without it
+  int32_t m_Pinned = 0;
+
+  int32_t m_RefCount = 1;
+
+  static int64_t m_LiveChunks, m_TotalMem, m_TotalSpilled;
 };
 
 #ifndef SERIALISER_IMPL
@@ -23,6 +23,7 @@
  ******************************************************************************/
 
 #include "serialiser.h"
+#include "core/core.h"
 
 #if ENABLED(ENABLE_UNIT_TESTS)
 
@@ -641,7 +642,7 @@ TEST_CASE("Verify multiple chunks can be merged", "[serialiser][chunks]")
   }
 
   for(Chunk *c : chunks)
-    delete c;
+    c->Release();
 
   // now read the data "dynamically" and ensure it's all correct
   {
@@ -720,6 +721,161 @@ TEST_CASE("Verify multiple chunks can be merged", "[serialiser][chunks]")
   delete buf;
 };
 
+TEST_CASE("Verify chunks are freed once the last reference is released", "[serialiser][chunks]")
+{
+  enum ChunkType
+  {
+    FLOAT4 = 5,
+  };
+
+  uint64_t liveChunks = Chunk::NumLiveChunks();
+
+  Chunk *chunk = NULL;
+  {
+    WriteSerialiser ser(new StreamWriter(StreamWriter::DefaultScratchSize), Ownership::Stream);
+
+    SCOPED_SERIALISE_CHUNK(FLOAT4);
+
+    float vec4[4] = {1.1f, 2.2f, 3.3f, 4.4f};
+
+    SERIALISE_ELEMENT(vec4);
+
+    chunk = scope.Get();
+  }
+
+  REQUIRE(chunk);
+  CHECK(chunk->GetLength() > 0);
+  CHECK(Chunk::NumLiveChunks() == liveChunks + 1);
+
+  // a second reference, as held by a capture being written in the background
+  chunk->AddRef();
+  chunk->Release();
+
+  CHECK(Chunk::NumLiveChunks() == liveChunks + 1);
+
+  // the data is still intact for the remaining reference
+  {
+    StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
+    WriteSerialiser ser(buf, Ownership::Stream);
+
+    chunk->Write(ser);
+
+    CHECK(buf->GetOffset() == chunk->GetLength());
+  }
+
+  chunk->Release();
+
+  CHECK(Chunk::NumLiveChunks() == liveChunks);
+};
+
+// writing a chunk from memory pins it, so this writes a copy to leave the chunk free to be spilled
+static std::vector<byte> GetChunkContents(Chunk *chunk)
+{
+  StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
+  WriteSerialiser ser(buf, Ownership::Stream);
+
+  Chunk *dup = chunk->Duplicate();
+  dup->Write(ser);
+  dup->Release();
+
+  return std::vector<byte>(buf->GetData(), buf->GetData() + buf->GetOffset());
+}
+
+TEST_CASE("Verify chunks can be spilled and read back concurrently", "[serialiser][chunks]")
+{
+  CaptureOptions prevOpts = RenderDoc::Inst().GetCaptureOptions();
+
+  CaptureOptions opts = prevOpts;
+  opts.captureMemoryBudgetMB = 1;
+  RenderDoc::Inst().SetCaptureOptions(opts);
+
+  uint64_t prevSpilled = Chunk::TotalSpilled();
+
+  const size_t numChunks = 64;
+  const size_t chunkSize = 64 * 1024;
+
+  std::vector<Chunk *> chunks;
+  std::vector<std::vector<byte>> expected;
+
+  for(size_t i = 0; i < numChunks; i++)
+  {
+    WriteSerialiser ser(new StreamWriter(StreamWriter::DefaultScratchSize), Ownership::Stream);
+
+    SCOPED_SERIALISE_CHUNK(5);
+
+    std::vector<uint32_t> contents(chunkSize / sizeof(uint32_t));
+    for(size_t c = 0; c < contents.size(); c++)
+      contents[c] = uint32_t(i * 0x10000 + c);
+    SERIALISE_ELEMENT(contents);
+
+    chunks.push_back(scope.Get());
+    expected.push_back(GetChunkContents(chunks.back()));
+  }
+
+  // half the threads spill, the other half copy and read chunks back while that's happening. Every
+  // third chunk is pinned partway through, which can race with it being spilled.
+  volatile int32_t mismatches = 0;
+
+  std::vector<Threading::ThreadHandle> threads;
+
+  for(size_t t = 0; t < 4; t++)
+  {
+    threads.push_back(Threading::CreateThread([&chunks, t]() {
+      for(size_t i = t; i < chunks.size(); i += 4)
+        chunks[i]->SpillIfOverBudget();
+    }));
+
+    threads.push_back(Threading::CreateThread([&chunks, &expected, &mismatches, t]() {
+      for(size_t i = t; i < chunks.size(); i += 4)
+      {
+        if(GetChunkContents(chunks[i]) != expected[i])
+          Atomic::Inc32(&mismatches);
+
+        if((i % 3) == 0)
+          chunks[i]->GetData();
+      }
+    }));
+  }
+
+  for(Threading::ThreadHandle thread : threads)
+  {
+    Threading::JoinThread(thread);
+    Threading::CloseThread(thread);
+  }
+
+  CHECK(mismatches == 0);
+  CHECK(Chunk::TotalSpilled() > prevSpilled);
+
+  // write half the chunks, straight from the spill file if they're spilled, and read the rest back
+  // into memory
+  for(size_t i = 0; i < numChunks; i++)
+  {
+    CAPTURE(i);
+
+    if(i & 1)
+    {
+      CHECK(memcmp(chunks[i]->GetData(), expected[i].data(), expected[i].size()) == 0);
+    }
+    else
+    {
+      StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
+      WriteSerialiser ser(buf, Ownership::Stream);
+
+      chunks[i]->Write(ser);
+
+      CHECK(buf->GetOffset() == expected[i].size());
+      CHECK(memcmp(buf->GetData(), expected[i].data(), expected[i].size()) == 0);
+    }
+  }
+
+  for(Chunk *chunk : chunks)
+    chunk->Release();
+
+  CHECK(Chunk::TotalSpilled() == prevSpilled);
+
+  RenderDoc::Inst().SetCaptureOptions(prevOpts);
+};
+
 TEST_CASE("Read/write container types", "[serialiser][structured]")
 {
   StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
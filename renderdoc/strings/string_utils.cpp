@@ -49,6 +49,23 @@ uint32_t strhash(const char *str, uint32_t seed)
   return hash;
 }
 
+uint64_t strhash64(const char *str, uint64_t seed)
+{
+  if(str == NULL)
+    return seed;
+
+  uint64_t hash = seed;
+
+  while(*str)
+  {
+    hash ^= (uint8_t)*str;
+    hash *= 1099511628211ULL;
+    str++;
+  }
+
+  return hash;
+}
+
 // since tolower is int -> int, this warns below. make a char -> char alternative
 char toclower(char c)
 {
@@ -246,6 +263,43 @@ TEST_CASE("String hashing", "[string]")
   };
 };
 
+TEST_CASE("64-bit string hashing", "[string]")
+{
+  SECTION("Same value returns the same hash")
+  {
+    CHECK(strhash64("foobar") == strhash64("foobar"));
+    CHECK(strhash64("test of a long string for strhash") ==
+          strhash64("test of a long string for strhash"));
+  };
+
+  SECTION("Different inputs have different hashes")
+  {
+    CHECK(strhash64("foobar") != strhash64("blah"));
+    CHECK(strhash64("test1") != strhash64("test2"));
+    CHECK(strhash64("") != strhash64("a"));
+  };
+
+  SECTION("Known values")
+  {
+    CHECK(strhash64("") == 0xcbf29ce484222325ULL);
+    CHECK(strhash64("a") == 0xaf63dc4c8601ec8cULL);
+    CHECK(strhash64("foobar") == 0x85944171f73967e8ULL);
+  };
+
+  SECTION("Incremental hashing")
+  {
+    uint64_t complete = strhash64("test of a long string for strhash");
+
+    uint64_t partial = strhash64("test of");
+    partial = strhash64(" a long", partial);
+    partial = strhash64(" string", partial);
+    partial = strhash64(" for ", partial);
+    partial = strhash64("strhash", partial);
+
+    CHECK(partial == complete);
+  };
+};
+
 TEST_CASE("String manipulation", "[string]")
 {
   SECTION("strlower")
@@ -36,6 +36,8 @@ std::string trim(const std::string &str);
 std::string removeFromEnd(const std::string &value, const std::string &ending);
 
 uint32_t strhash(const char *str, uint32_t existingHash = 5381);
+// 64-bit FNV-1a, for when collisions in the 32-bit hash above would be a problem
+uint64_t strhash64(const char *str, uint64_t existingHash = 14695981039346656037ULL);
 
 bool endswith(const std::string &value, const std::string &ending);
 
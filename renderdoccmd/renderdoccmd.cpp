@@ -1281,6 +1281,12 @@ int renderdoccmd(const GlobalEnvironment &env, std::vector<std::string> &argv)
               "Capturing Option: Include all live resources, not just those used by a frame.");
       cmd.add("opt-capture-all-cmd-lists", 0,
               "Capturing Option: In D3D11, record all command lists from application start.");
+      cmd.add("opt-hash-mapped-memory", 0,
+              "Capturing Option: In Vulkan, detect changes to mapped memory with per-page hashes "
+              "instead of a full copy.");
+      cmd.add<int>("opt-capture-memory-budget", 0,
+                   "Capturing Option: Spill capture data to disk beyond this many MB.", false, 0,
+                   cmdline::range(0, 1024 * 1024));
     }
 
     cmd.parse_check(argv, true);
@@ -1310,8 +1316,11 @@ int renderdoccmd(const GlobalEnvironment &env, std::vector<std::string> &argv)
         opts.refAllResources = true;
       if(cmd.exist("opt-capture-all-cmd-lists"))
         opts.captureAllCmdLists = true;
+      if(cmd.exist("opt-hash-mapped-memory"))
+        opts.hashMappedMemory = true;
 
       opts.delayForDebugger = (uint32_t)cmd.get<int>("opt-delay-for-debugger");
+      opts.captureMemoryBudgetMB = (uint32_t)cmd.get<int>("opt-capture-memory-budget");
     }
 
     if(!it->second->HandlesUsageManually() && cmd.exist("help"))
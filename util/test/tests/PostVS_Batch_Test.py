@@ -0,0 +1,89 @@
+import rdtest
+import os
+import renderdoc as rd
+
+
+class PostVS_Batch_Test(rdtest.TestCase):
+    slow_test = True
+
+    def decode_postvs(self, draw: rd.DrawcallDescription, mesh: rd.MeshFormat):
+        if mesh.numIndices == 0:
+            return []
+
+        self.controller.SetFrameEvent(draw.eventId, True)
+
+        indices = rdtest.fetch_indices(self.controller, mesh, 0, 0, mesh.numIndices)
+
+        attrs = rdtest.get_postvs_attrs(self.controller, mesh, rd.MeshDataStage.VSOut)
+
+        return rdtest.decode_mesh_data(self.controller, indices, attrs, 0)
+
+    def get_draws(self):
+        draws = []
+
+        draw = self.get_first_draw()
+
+        while draw:
+            if draw.flags & rd.DrawFlags.Drawcall:
+                draws.append(draw)
+
+            draw = draw.next
+
+        return draws
+
+    def batch_test(self, path):
+        try:
+            self.controller = rdtest.open_capture(path)
+        except RuntimeError as err:
+            rdtest.log.print("Skipping. Can't open {}: {}".format(path, err))
+            return
+
+        draws = self.get_draws()
+
+        # Fetch everything in one batch, then decode it
+        meshes = self.controller.GetPostVSDataForEvents([d.eventId for d in draws], 0, 0, rd.MeshDataStage.VSOut)
+
+        batched = [self.decode_postvs(draws[i], meshes[i]) for i in range(len(draws))]
+
+        self.controller.Shutdown()
+
+        # Use a fresh controller so nothing fetched in the batch is cached, then fetch each draw on its own
+        self.controller = rdtest.open_capture(path)
+
+        for i in range(len(draws)):
+            self.controller.SetFrameEvent(draws[i].eventId, True)
+
+            mesh: rd.MeshFormat = self.controller.GetPostVSData(0, 0, rd.MeshDataStage.VSOut)
+
+            single = self.decode_postvs(draws[i], mesh)
+
+            if len(single) != len(batched[i]):
+                raise rdtest.TestFailureException("{} - {}: batched postvs has {} vertices, expected {}"
+                                                  .format(draws[i].eventId, draws[i].name, len(batched[i]),
+                                                          len(single)))
+
+            for idx in range(len(single)):
+                for key in single[idx]:
+                    if not rdtest.value_compare(single[idx][key], batched[i][idx].get(key, None)):
+                        raise rdtest.TestFailureException("{} - {}: batched postvs data[{}] '{}': {} is not as expected: {}"
+                                                          .format(draws[i].eventId, draws[i].name, idx, key,
+                                                                  batched[i][idx].get(key, None), single[idx][key]))
+
+        rdtest.log.success("Batched postvs data matches for {} draws".format(len(draws)))
+
+        self.controller.Shutdown()
+
+    def run(self):
+        dir_path = self.get_ref_path('', extra=True)
+
+        for file in os.scandir(dir_path):
+            if '.rdc' not in file.name:
+                continue
+
+            rdtest.log.print('Checking batched postvs in {}'.format(file.name))
+
+            self.batch_test(file.path)
+
+            rdtest.log.success("Checked {}".format(file.name))
+
+        rdtest.log.success("Checked batched postvs in all files")